@@ -590,6 +590,7 @@ SRC_C += ./beken378/func/misc/fake_clock.c
 SRC_C += ./beken378/func/misc/target_util.c
 SRC_C += ./beken378/func/misc/start_type.c
 SRC_C += ./beken378/func/misc/soft_encrypt.c
+SRC_C += ./beken378/func/misc/irq_trace.c
 SRC_C += ./beken378/func/power_save/power_save.c
 SRC_C += ./beken378/func/power_save/manual_ps.c
 SRC_C += ./beken378/func/power_save/mcu_ps.c
@@ -597,6 +598,7 @@ SRC_C += ./beken378/func/rf_test/rx_sensitivity.c
 SRC_C += ./beken378/func/rf_test/tx_evm.c
 SRC_C += ./beken378/func/rwnx_intf/rw_ieee80211.c
 SRC_C += ./beken378/func/rwnx_intf/rw_msdu.c
+SRC_C += ./beken378/func/rwnx_intf/rw_msdu_pool.c
 SRC_C += ./beken378/func/rwnx_intf/rw_msg_rx.c
 SRC_C += ./beken378/func/rwnx_intf/rw_msg_tx.c
 SRC_C += ./beken378/func/sim_uart/gpio_uart.c
@@ -604,6 +606,9 @@ SRC_C += ./beken378/func/sim_uart/pwm_uart.c
 SRC_C += ./beken378/func/spidma_intf/spidma_intf.c
 SRC_C += ./beken378/func/temp_detect/temp_detect.c
 SRC_C += ./beken378/func/uart_debug/cmd_evm.c
+SRC_C += ./beken378/func/uart_debug/cmd_heap.c
+SRC_C += ./beken378/func/uart_debug/cmd_top.c
+SRC_C += ./beken378/func/uart_debug/cmd_irqtrace.c
 SRC_C += ./beken378/func/uart_debug/cmd_help.c
 SRC_C += ./beken378/func/uart_debug/cmd_reg.c
 SRC_C += ./beken378/func/uart_debug/cmd_rx_sensitivity.c
@@ -716,6 +721,7 @@ SRC_OS += ./beken378/os/FreeRTOSv9.0.0/FreeRTOS/Source/queue.c
 SRC_OS += ./beken378/os/FreeRTOSv9.0.0/FreeRTOS/Source/tasks.c
 SRC_OS += ./beken378/os/FreeRTOSv9.0.0/FreeRTOS/Source/timers.c
 SRC_OS += ./beken378/os/FreeRTOSv9.0.0/rtos_pub.c
+SRC_OS += ./beken378/os/FreeRTOSv9.0.0/rtos_stats.c
 SRC_C += ./beken378/os/mem_arch.c
 SRC_C += ./beken378/os/platform_stub.c
 SRC_C += ./beken378/os/str_arch.c
@@ -857,6 +863,7 @@ endif
 
 	$(NM) $(TY_OUTPUT)/$(APP_BIN_NAME)_$(APP_VERSION).axf | sort > $(TY_OUTPUT)/$(APP_BIN_NAME)_$(APP_VERSION).map
 	$(OBJDUMP) -d $(TY_OUTPUT)/$(APP_BIN_NAME)_$(APP_VERSION).axf > $(TY_OUTPUT)/$(APP_BIN_NAME)_$(APP_VERSION).asm
+	-python3 ./tools/log_decode.py -e $(TY_OUTPUT)/$(APP_BIN_NAME)_$(APP_VERSION).axf --save $(TY_OUTPUT)/$(APP_BIN_NAME)_$(APP_VERSION).fmt.json
 	$(OBJCOPY) -O binary $(TY_OUTPUT)/$(APP_BIN_NAME)_$(APP_VERSION).axf $(TY_OUTPUT)/$(APP_BIN_NAME)_$(APP_VERSION).bin
 # Generate build info
 # -------------------------------------------------------------------	
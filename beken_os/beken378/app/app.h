@@ -53,6 +53,12 @@ typedef struct bus_message
 } BUS_MSG_T;
 
 #define CORE_QITEM_COUNT          (64)
+
+/* tx pbufs and rx signals are parked outside io_queue and drained by the core
+ * thread in batches, one queue message wakes it for a whole burst */
+#define CORE_BATCH_DISPATCH       1
+#define CORE_TX_PEND_COUNT        (32)  /* parked tx pbufs, overflow goes through io_queue */
+#define CORE_TX_BATCH_LIMIT       (16)  /* tx pbufs sent per pass before other messages run */
 #if CFG_SUPPORT_ALIOS
 #define CORE_STACK_SIZE           (4 * 1024)
 #else
@@ -72,6 +78,17 @@ typedef struct _wifi_core_
     uint32_t stack_size;
 } WIFI_CORE_T;
 
+typedef struct _bus_msg_stats_
+{
+    uint32_t tx_queued;     /* pbufs parked for batch dispatch */
+    uint32_t tx_wakeups;    /* queue messages posted for them */
+    uint32_t tx_fallback;   /* pbufs sent as single messages */
+    uint32_t tx_batches;    /* drain passes that sent something */
+    uint32_t tx_batch_max;  /* largest single pass */
+    uint32_t rx_signals;
+    uint32_t rx_coalesced;  /* rx signals folded into a pending one */
+} BUS_MSG_STATS_T;
+
 typedef struct _bus_msg_param_
 {
    uint8_t channel;
@@ -83,6 +100,7 @@ int bmsg_tx_beacon_sender(BUS_MSG_PARAM_T *bcn_param);
 void app_start(void);
 void app_pre_start(void);
 int bmsg_is_empty(void);
+void bmsg_get_stats(BUS_MSG_STATS_T *stats);
 void core_thread_uninit(void);
 
 #endif // _APP_H_
@@ -60,6 +60,22 @@ xTaskHandle  app_thread_handle;
 beken_semaphore_t app_sema = NULL;
 WIFI_CORE_T g_wifi_core = {0};
 volatile int32_t bmsg_rx_count = 0;
+static BUS_MSG_STATS_T bmsg_stats = {0};
+
+#if CORE_BATCH_DISPATCH
+typedef struct _core_tx_pend_
+{
+    struct pbuf *p;
+    uint32_t vif_idx;
+} CORE_TX_PEND_T;
+
+static CORE_TX_PEND_T core_tx_pend[CORE_TX_PEND_COUNT];
+static uint32_t core_tx_pend_head = 0;
+static volatile uint32_t core_tx_pend_cnt = 0;
+/* single tx messages still in io_queue, newer pbufs queue behind them */
+static uint32_t core_tx_fallback_cnt = 0;
+static volatile uint8_t bmsg_rx_pending = 0;
+#endif
 
 extern void net_wlan_initial(void);
 extern void wpas_thread_start(void);
@@ -121,10 +137,15 @@ void bmsg_rx_handler(BUS_MSG_T *msg)
     GLOBAL_INT_DECLARATION();
 
     GLOBAL_INT_DISABLE();
+#if CORE_BATCH_DISPATCH
+    // frames arriving from now on need another pass
+    bmsg_rx_pending = 0;
+#else
     if(bmsg_rx_count > 0)
     {
         bmsg_rx_count -= 1;
     }
+#endif
     GLOBAL_INT_RESTORE();
 
     rxl_cntrl_evt((int)msg->arg);
@@ -135,31 +156,97 @@ void bmsg_skt_tx_handler(BUS_MSG_T *msg)
     hapd_intf_ke_rx_handle(msg->arg);
 }
 
-void bmsg_tx_handler(BUS_MSG_T *msg)
+static void bmsg_tx_pbuf(struct pbuf *p, uint8_t vif_idx)
 {
-    struct pbuf *p = (struct pbuf *)msg->arg;
-    struct pbuf *q = p;
-    uint8_t vif_idx = (uint8_t)msg->len;
+    ps_set_data_prevent();
+#if CFG_USE_STA_PS
+    bmsg_ps_handler_rf_ps_mode_real_wakeup();
+    bk_wlan_dtim_rf_ps_mode_do_wakeup();
+#endif
+    // the msdu node takes its own reference if it sends from the pbuf
+    rwm_transfer_pbuf(vif_idx, p);
+
+    pbuf_free(p);
+}
 
-    if(p->next)
+#if CORE_BATCH_DISPATCH
+static uint32_t bmsg_tx_batch_handler(uint32_t limit)
+{
+    uint32_t count = 0;
+    CORE_TX_PEND_T pend;
+    GLOBAL_INT_DECLARATION();
+
+    while(count < limit)
     {
-        q = pbuf_coalesce(p, PBUF_RAW);
-        if(q == p)
+        GLOBAL_INT_DISABLE();
+        if(0 == core_tx_pend_cnt)
         {
-            // must be out of memory
-            goto tx_handler_exit;
+            GLOBAL_INT_RESTORE();
+            break;
         }
+
+        pend = core_tx_pend[core_tx_pend_head];
+        core_tx_pend_head = (core_tx_pend_head + 1) % CORE_TX_PEND_COUNT;
+        core_tx_pend_cnt -= 1;
+        GLOBAL_INT_RESTORE();
+
+        bmsg_tx_pbuf(pend.p, (uint8_t)pend.vif_idx);
+        count ++;
     }
 
-    ps_set_data_prevent();
-#if CFG_USE_STA_PS
-    bmsg_ps_handler_rf_ps_mode_real_wakeup();
-    bk_wlan_dtim_rf_ps_mode_do_wakeup();
+    if(count)
+    {
+        bmsg_stats.tx_batches ++;
+        if(count > bmsg_stats.tx_batch_max)
+        {
+            bmsg_stats.tx_batch_max = count;
+        }
+    }
+
+    return count;
+}
+
+// on teardown the parked pbufs are dropped instead of sent
+static void bmsg_tx_pend_free(void)
+{
+    struct pbuf *p;
+    GLOBAL_INT_DECLARATION();
+
+    while(1)
+    {
+        GLOBAL_INT_DISABLE();
+        if(0 == core_tx_pend_cnt)
+        {
+            GLOBAL_INT_RESTORE();
+            break;
+        }
+
+        p = core_tx_pend[core_tx_pend_head].p;
+        core_tx_pend_head = (core_tx_pend_head + 1) % CORE_TX_PEND_COUNT;
+        core_tx_pend_cnt -= 1;
+        GLOBAL_INT_RESTORE();
+
+        pbuf_free(p);
+    }
+}
+#endif
+
+void bmsg_tx_handler(BUS_MSG_T *msg)
+{
+    struct pbuf *p = (struct pbuf *)msg->arg;
+    uint8_t vif_idx = (uint8_t)msg->len;
+#if CORE_BATCH_DISPATCH
+    GLOBAL_INT_DECLARATION();
+
+    // the parked pbufs are all older than this one
+    bmsg_tx_batch_handler(CORE_TX_PEND_COUNT);
+
+    GLOBAL_INT_DISABLE();
+    core_tx_fallback_cnt -= 1;
+    GLOBAL_INT_RESTORE();
 #endif
-    rwm_transfer(vif_idx, q->payload, q->len, 0, 0);
-tx_handler_exit:
 
-    pbuf_free(q);
+    bmsg_tx_pbuf(p, vif_idx);
 }
 
 void bmsg_tx_raw_cb_handler(BUS_MSG_T *msg)
@@ -212,7 +299,7 @@ static void tx_raw_data(uint8_t *pkt, int16_t len)
 
     txdesc_new->status = TXDESC_STA_USED;
     txdesc_new->host.flags = TXU_CNTRL_MGMT;
-    txdesc_new->host.msdu_node = (void *)node;
+    rwm_txdesc_bind_node(txdesc_new, node, NULL, NULL);
     txdesc_new->host.orig_addr = (UINT32)node->msdu_ptr;
     txdesc_new->host.packet_addr = (UINT32)content_ptr;
     txdesc_new->host.packet_len = len;
@@ -443,6 +530,18 @@ void bmsg_rx_sender(void *arg)
     msg.sema = NULL;
 
     GLOBAL_INT_DISABLE();
+#if CORE_BATCH_DISPATCH
+    bmsg_stats.rx_signals ++;
+    if(bmsg_rx_pending)
+    {
+        // the pending pass picks up these frames as well
+        bmsg_stats.rx_coalesced ++;
+        GLOBAL_INT_RESTORE();
+        return;
+    }
+
+    bmsg_rx_pending = 1;
+#else
     if(bmsg_rx_count >= 2)
     {
         GLOBAL_INT_RESTORE();
@@ -450,11 +549,15 @@ void bmsg_rx_sender(void *arg)
     }
 
     bmsg_rx_count += 1;
+#endif
     GLOBAL_INT_RESTORE();
 
     ret = rtos_push_to_queue(&g_wifi_core.io_queue, &msg, BEKEN_NO_WAIT);
     if(kNoErr != ret)
     {
+#if CORE_BATCH_DISPATCH
+        bmsg_rx_pending = 0;
+#endif
         APP_PRT("bmsg_rx_sender_failed\r\n");
     }
 }
@@ -463,17 +566,54 @@ int bmsg_tx_sender(struct pbuf *p, uint32_t vif_idx)
 {
     OSStatus ret;
     BUS_MSG_T msg;
+#if CORE_BATCH_DISPATCH
+    uint32_t tail, was_empty;
+    GLOBAL_INT_DECLARATION();
+#endif
+
+    pbuf_ref(p);
+
+#if CORE_BATCH_DISPATCH
+    GLOBAL_INT_DISABLE();
+    if((0 == core_tx_fallback_cnt) && (core_tx_pend_cnt < CORE_TX_PEND_COUNT))
+    {
+        tail = (core_tx_pend_head + core_tx_pend_cnt) % CORE_TX_PEND_COUNT;
+        core_tx_pend[tail].p = p;
+        core_tx_pend[tail].vif_idx = vif_idx;
+        was_empty = (0 == core_tx_pend_cnt);
+        core_tx_pend_cnt += 1;
+        bmsg_stats.tx_queued ++;
+        GLOBAL_INT_RESTORE();
+
+        // the core thread drains after every message, only an idle one needs a kick
+        if(was_empty && rtos_is_queue_empty(&g_wifi_core.io_queue))
+        {
+            bmsg_stats.tx_wakeups ++;
+            bmsg_null_sender();
+        }
+
+        return kNoErr;
+    }
+
+    core_tx_fallback_cnt += 1;
+    bmsg_stats.tx_fallback ++;
+    GLOBAL_INT_RESTORE();
+#endif
 
     msg.type = BMSG_TX_TYPE;
     msg.arg = (uint32_t)p;
     msg.len = vif_idx;
     msg.sema = NULL;
 
-    pbuf_ref(p);
     ret = rtos_push_to_queue(&g_wifi_core.io_queue, &msg, 1 * SECONDS);
     if(kNoErr != ret)
     {
         APP_PRT("bmsg_tx_sender failed\r\n");
+#if CORE_BATCH_DISPATCH
+        GLOBAL_INT_DISABLE();
+        core_tx_fallback_cnt -= 1;
+        GLOBAL_INT_RESTORE();
+#endif
         pbuf_free(p);
     }
 
@@ -643,7 +783,13 @@ static void core_thread_main( void *arg )
 
     while(1)
     {
+#if CORE_BATCH_DISPATCH
+        // do not block while parked pbufs are waiting
+        ret = rtos_pop_from_queue(&g_wifi_core.io_queue, &msg,
+                                  core_tx_pend_cnt ? BEKEN_NO_WAIT : BEKEN_WAIT_FOREVER);
+#else
         ret = rtos_pop_from_queue(&g_wifi_core.io_queue, &msg, BEKEN_WAIT_FOREVER);
+#endif
         if(kNoErr == ret)
         {
             switch(msg.type)
@@ -724,6 +870,13 @@ static void core_thread_main( void *arg )
                 ke_skip = 0;
         }
 
+#if CORE_BATCH_DISPATCH
+        if(bmsg_tx_batch_handler(CORE_TX_BATCH_LIMIT))
+        {
+            ke_evt_core_scheduler();
+        }
+#endif
+
 #if CFG_USE_STA_PS
         if(ps_flag == 1)
         {
@@ -778,12 +931,35 @@ fail:
 
 void core_thread_uninit(void)
 {
+#if CORE_BATCH_DISPATCH
+    BUS_MSG_T msg;
+    GLOBAL_INT_DECLARATION();
+#endif
+
     if(g_wifi_core.handle)
     {
         rtos_delete_thread(&g_wifi_core.handle);
         g_wifi_core.handle = 0;
     }
 
+#if CORE_BATCH_DISPATCH
+    bmsg_tx_pend_free();
+
+    // the fallback pbufs queued behind the parked ones go with them
+    while(g_wifi_core.io_queue
+          && (kNoErr == rtos_pop_from_queue(&g_wifi_core.io_queue, &msg, BEKEN_NO_WAIT)))
+    {
+        if(BMSG_TX_TYPE == msg.type)
+        {
+            GLOBAL_INT_DISABLE();
+            core_tx_fallback_cnt -= 1;
+            GLOBAL_INT_RESTORE();
+
+            pbuf_free((struct pbuf *)msg.arg);
+        }
+    }
+#endif
+
     if(g_wifi_core.io_queue)
     {
         rtos_deinit_queue(&g_wifi_core.io_queue);
@@ -906,11 +1082,26 @@ int bmsg_is_empty(void)
     {
         return 0;
     }
+#if CORE_BATCH_DISPATCH
+    else if(core_tx_pend_cnt)
+    {
+        return 0;
+    }
+#endif
     else
     {
         return 1;
     }
 }
 
+void bmsg_get_stats(BUS_MSG_STATS_T *stats)
+{
+    GLOBAL_INT_DECLARATION();
+
+    GLOBAL_INT_DISABLE();
+    os_memcpy(stats, &bmsg_stats, sizeof(BUS_MSG_STATS_T));
+    GLOBAL_INT_RESTORE();
+}
+
 // eof
 
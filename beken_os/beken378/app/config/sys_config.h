@@ -86,6 +86,20 @@
 #define CFG_MSDU_RESV_HEAD_LEN                    96
 #define CFG_MSDU_RESV_TAIL_LEN                    16
 
+/* tx straight out of the lwip pbuf instead of copying it into an msdu node.
+ * needs lwip to reserve CFG_MSDU_RESV_HEAD_LEN bytes of headroom in front of
+ * the ethernet header (PBUF_LINK_ENCAPSULATION_HLEN); pbufs without the
+ * headroom, and frames to a tkip peer that need the mic tail, fall back to a
+ * single copy. tx_ref in rwm_get_tx_stats counts the frames sent in place.
+ * off until the lwipopts.h of the build sets that headroom, which costs
+ * CFG_MSDU_RESV_HEAD_LEN bytes in every pbuf; without it no pbuf qualifies. */
+#define CFG_MSDU_TX_ZERO_COPY                     0
+
+/* tx msdu buffers up to CFG_MSDU_POOL_FRAME_LEN bytes of frame are recycled
+ * through a pool of CFG_MSDU_POOL_NUM blocks, bigger frames use the heap */
+#define CFG_MSDU_POOL_NUM                         4
+#define CFG_MSDU_POOL_FRAME_LEN                   1536
+
 #define CFG_USE_USB_HOST                           0
 
 #define CFG_USB                                    0
@@ -99,6 +113,10 @@
 /*section 4-----DEBUG macro config-----*/
 #define CFG_UART_DEBUG                             0
 #define CFG_UART_DEBUG_COMMAND_LINE                1
+/* time every masked interrupt section and scheduler suspension per call site,
+ * costs a timer read on each outermost GLOBAL_INT_DISABLE/RESTORE pair, the
+ * timer is the one of configGENERATE_RUN_TIME_STATS */
+#define CFG_IRQ_TRACE                              0
 #define CFG_SUPPORT_BKREG                          0
 #define CFG_ENABLE_WPA_LOG                         0
 #define CFG_IPERF_TEST                             0
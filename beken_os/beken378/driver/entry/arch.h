@@ -63,6 +63,38 @@
                                         rt_hw_interrupt_enable(irq_level);\
                                    }while(0)
 
+#elif CFG_IRQ_TRACE
+
+/* the outermost masked section is timed per call site, see irq_trace.c */
+extern void irq_trace_begin(const char *file, int line);
+extern void irq_trace_end(void);
+
+#define GLOBAL_INT_DECLARATION()   uint32_t fiq_tmp, irq_tmp
+#define GLOBAL_INT_DISABLE()       do{\
+										fiq_tmp = portDISABLE_FIQ();\
+										irq_tmp = portDISABLE_IRQ();\
+										if(!irq_tmp)           \
+										{                      \
+											irq_trace_begin(__FILE__, __LINE__);\
+										}                      \
+									}while(0)
+
+
+#define GLOBAL_INT_RESTORE()       do{                         \
+                                        if(!irq_tmp)           \
+                                        {                      \
+                                            irq_trace_end();   \
+                                        }                      \
+                                        if(!fiq_tmp)           \
+                                        {                      \
+                                            portENABLE_FIQ();  \
+                                        }                      \
+                                        if(!irq_tmp)           \
+                                        {                      \
+                                            portENABLE_IRQ();  \
+                                        }                      \
+                                   }while(0)
+
 #else
 
 #define GLOBAL_INT_DECLARATION()   uint32_t fiq_tmp, irq_tmp
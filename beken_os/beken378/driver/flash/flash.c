@@ -465,23 +465,34 @@ static void flash_set_hpm(void)
     while(REG_READ(REG_FLASH_OPERATE_SW) & BUSY_SW);
 }
 
+/*
+ * read through the sw operate register one 32-byte line at a time.
+ * interrupts are only held off for a single line, so long reads do not
+ * stall the system; aligned lines land in the caller's buffer as words.
+ */
 static void flash_read_data(UINT8 *buffer, UINT32 address, UINT32 len)
 {
-    UINT32 i, reg_value;
+    UINT32 i, reg_value, count;
     UINT32 addr = address & (~0x1F);
+    UINT32 offset = address & 0x1F;
     UINT32 buf[8];
-    UINT8 *pb = (UINT8 *)&buf[0];
+    UINT32 *pw;
     GLOBAL_INT_DECLARATION();
 
-    if(len == 0)
-    {
-        return;
-    }
-
-    GLOBAL_INT_DISABLE();
-    while(REG_READ(REG_FLASH_OPERATE_SW) & BUSY_SW);
     while(len)
     {
+        count = MIN(32 - offset, len);
+        if((0 == offset) && (32 == count) && (0 == ((UINT32)buffer & 0x3)))
+        {
+            pw = (UINT32 *)buffer;
+        }
+        else
+        {
+            pw = buf;
+        }
+
+        GLOBAL_INT_DISABLE();
+        while(REG_READ(REG_FLASH_OPERATE_SW) & BUSY_SW);
         reg_value = REG_READ(REG_FLASH_OPERATE_SW);
         reg_value = ((addr << ADDR_SW_REG_POSI)
                      | (FLASH_OPCODE_READ << OP_TYPE_SW_POSI)
@@ -489,25 +500,23 @@ static void flash_read_data(UINT8 *buffer, UINT32 address, UINT32 len)
                      | (reg_value & WP_VALUE));
         REG_WRITE(REG_FLASH_OPERATE_SW, reg_value);
         while(REG_READ(REG_FLASH_OPERATE_SW) & BUSY_SW);
-        addr += 32;
 
         for(i = 0; i < 8; i++)
         {
-            buf[i] = REG_READ(REG_FLASH_DATA_FLASH_SW);
+            pw[i] = REG_READ(REG_FLASH_DATA_FLASH_SW);
         }
+        GLOBAL_INT_RESTORE();
 
-        for(i = address % 32; i < 32; i++)
+        if(pw == buf)
         {
-            *buffer++ = pb[i];
-            address++;
-            len--;
-            if(len == 0)
-            {
-                break;
-            }
+            memcpy(buffer, (UINT8 *)buf + offset, count);
         }
+
+        buffer += count;
+        len -= count;
+        addr += 32;
+        offset = 0;
     }
-    GLOBAL_INT_RESTORE();
 }
 
 static void flash_write_data(UINT8 *buffer, UINT32 address, UINT32 len)
@@ -5,6 +5,9 @@
 
 #define TIMER_DEV_NAME                "bk_timer"
 
+/* wrap period of the free running channel */
+#define BK_TIMER_FREE_RUN_PERIOD_US     100000000
+
 #define BK_TIMER_FAILURE                (1)
 #define BK_TIMER_SUCCESS                (0)
 
@@ -42,6 +45,9 @@ typedef struct
 void bk_timer_init(void);
 void bk_timer_exit(void);
 void bk_timer_isr(void);
+UINT32 bk_timer_free_run_init(UINT8 channel, UINT32 unit_us);
+UINT32 bk_timer_free_run_get(void);
+UINT32 bk_timer_free_run_raw(void);
 
 
 #endif //_TIMER_PUB_H_
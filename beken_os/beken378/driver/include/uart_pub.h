@@ -115,6 +115,8 @@ extern void uart2_isr(void);
 #define os_null_printf(...)
 extern void fatal_print(const char *fmt, ...);
 extern void bk_printf(const char *fmt, ...);
+extern void bk_print_raw(const char *str);
+extern void bk_print_bin(const UINT8 *buf, UINT32 len);
 extern void uart_send_byte(UINT8 ch, UINT8 data);
 extern void bk_send_string(UINT8 uport, const char *string);
 extern void uart_wait_tx_over();
@@ -122,6 +124,14 @@ extern UINT8 uart_is_tx_fifo_empty(UINT8 uport);
 extern UINT8 uart_is_tx_fifo_full(UINT8 uport);
 extern int uart_read_byte(int uport);
 extern int uart_write_byte(int uport, char c);
+extern UINT32 uart_write_fifo_buf(UINT8 uport, const UINT8 *buf, UINT32 len);
+extern UINT32 uart_tx_fifo_port(UINT8 uport);
+extern UINT32 uart_read_fifo_buf(UINT8 uport, UINT8 *buf, UINT32 len);
+extern UINT8 uart_rx_is_stop_end(UINT8 uport);
+extern UINT32 uart_rx_overflow_get(UINT8 uport);
+extern void uart_set_rx_stop_detect_time(UINT8 uport, UINT8 sel);
+extern int uart_tx_fifo_needwr_callback_set(int uport, uart_callback callback, void *param);
+extern void uart_set_tx_fifo_needwr_int(UINT8 uport, UINT8 set);
 extern void print_hex_dump(const char *prefix, void *b, int len);
 extern void bk_send_string(UINT8 uport, const char *string);
 extern UINT8 get_printf_port(void);
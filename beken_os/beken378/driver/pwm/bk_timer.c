@@ -263,6 +263,84 @@ UINT32 bk_timer_ctrl(UINT32 cmd, void *param)
     return ret;
 }
 
+/*
+ * free running counter on one 26m channel. the channel wraps every
+ * BK_TIMER_FREE_RUN_PERIOD_US, the wrap interrupt advances a software base so
+ * the value read wraps at 2^32 units.
+ */
+static UINT8 free_run_channel = TIMER_CHANNEL_NO;
+static UINT32 free_run_unit_cnt = 26;
+static UINT32 free_run_period_units = BK_TIMER_FREE_RUN_PERIOD_US;
+static volatile UINT32 free_run_base = 0;
+
+static void bk_timer_free_run_isr(UINT8 channel)
+{
+    free_run_base += free_run_period_units;
+}
+
+/* unit_us has to divide BK_TIMER_FREE_RUN_PERIOD_US */
+UINT32 bk_timer_free_run_init(UINT8 channel, UINT32 unit_us)
+{
+    timer_param_t param;
+
+    if((channel > BKTIMER2) || (0 == unit_us) || (BK_TIMER_FREE_RUN_PERIOD_US % unit_us))
+    {
+        return BK_TIMER_FAILURE;
+    }
+
+    free_run_unit_cnt = unit_us * 26;
+    free_run_period_units = BK_TIMER_FREE_RUN_PERIOD_US / unit_us;
+    free_run_base = 0;
+    free_run_channel = channel;
+
+    param.channel = channel;
+    param.div = 1;
+    param.period = BK_TIMER_FREE_RUN_PERIOD_US;
+    param.t_Int_Handler = bk_timer_free_run_isr;
+
+    return init_timer_param_us(&param);
+}
+
+/* channel count in 26m clocks, call with interrupts disabled */
+UINT32 bk_timer_free_run_raw(void)
+{
+    if(free_run_channel > BKTIMER2)
+    {
+        return 0;
+    }
+
+    REG_WRITE(TIMER0_2_READ_CTL, (free_run_channel << TIMER0_2_READ_INDEX_POSI) | TIMER0_2_READ_OP_BIT);
+    while(REG_READ(TIMER0_2_READ_CTL) & TIMER0_2_READ_OP_BIT);
+
+    return REG_READ(TIMER0_2_READ_VALUE);
+}
+
+/* counter value in units of unit_us, cheap enough for every context switch */
+UINT32 bk_timer_free_run_get(void)
+{
+    UINT32 cnt, base;
+    GLOBAL_INT_DECLARATION();
+
+    if(free_run_channel > BKTIMER2)
+    {
+        return 0;
+    }
+
+    GLOBAL_INT_DISABLE();
+    cnt = bk_timer_free_run_raw();
+    base = free_run_base;
+
+    /* wrapped, but the interrupt is not served yet */
+    if((REG_READ(TIMER0_2_CTL) & (1 << (TIMERCTLA_INT_POSI + free_run_channel)))
+            && (cnt < BK_TIMER_FREE_RUN_PERIOD_US / 2 * 26))
+    {
+        base += free_run_period_units;
+    }
+    GLOBAL_INT_RESTORE();
+
+    return base + cnt / free_run_unit_cnt;
+}
+
 void bk_timer_init(void)
 {
     REG_WRITE(TIMER0_2_CTL, (7 << TIMERCTLA_CLKDIV_MASK));
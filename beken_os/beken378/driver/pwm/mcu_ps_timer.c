@@ -101,15 +101,23 @@ UINT32 ps_pwm_int_status(void )
 
 
 #if (CFG_SOC_NAME != SOC_BK7231)
-void ps_timer3_enable(UINT32 period)
+/* returns the 32k counts already elapsed in the tick period that is cut short */
+UINT32 ps_timer3_enable(UINT32 period)
 {
-    UINT32 reg;
+    UINT32 reg, phase = 0;
 
 #if (CFG_SOC_NAME == SOC_BK7231U) || (SOC_BK7231N == CFG_SOC_NAME)
     reg = REG_READ(TIMER3_5_READ_CTL);
     reg &= ~(TIMER3_5_READ_INDEX_MASK << TIMER3_5_READ_INDEX_POSI);
     reg |= (TIMER3_5_READ_INDEX_3 << TIMER3_5_READ_INDEX_POSI);
     REG_WRITE(TIMER3_5_READ_CTL,reg);
+
+    if(! (REG_READ(TIMER3_5_CTL)&(TIMERCTL3_INT_BIT)))
+    {
+        REG_WRITE(TIMER3_5_READ_CTL,reg | TIMER3_5_READ_OP_BIT);
+        while(REG_READ(TIMER3_5_READ_CTL) & TIMER3_5_READ_OP_BIT);
+        phase = REG_READ(TIMER3_5_READ_VALUE);
+    }
 #endif
 
     reg = REG_READ(TIMER3_5_CTL);
@@ -122,6 +130,8 @@ void ps_timer3_enable(UINT32 period)
     reg |= (TIMERCTL3_EN_BIT);
     reg &= ~(0x7 << TIMERCTLB_INT_POSI);
     REG_WRITE(TIMER3_5_CTL,reg);
+
+    return phase;
 }
 
 void ps_timer3_measure_prepare(void)
@@ -137,7 +147,8 @@ void ps_timer3_measure_prepare(void)
 #endif
 }
 
-UINT32 ps_timer3_disable(void)
+/* returns the 32k counts slept, the full period if the timer expired */
+UINT32 ps_timer3_disable_cnt(void)
 {
     UINT32 reg,less;
     if(REG_READ(TIMER3_5_CTL)&(TIMERCTL3_INT_BIT))
@@ -165,7 +176,12 @@ UINT32 ps_timer3_disable(void)
     reg |= (TIMERCTL3_EN_BIT);
     REG_WRITE(TIMER3_5_CTL,reg);
 
-    return (less/32);
+    return less;
+}
+
+UINT32 ps_timer3_disable(void)
+{
+    return (ps_timer3_disable_cnt()/32);
 }
 #endif
 
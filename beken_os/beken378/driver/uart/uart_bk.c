@@ -28,6 +28,9 @@
 static struct uart_callback_des uart_receive_callback[2] = {{NULL}, {NULL}};
 static struct uart_callback_des uart_txfifo_needwr_callback[2] = {{NULL}, {NULL}};
 static struct uart_callback_des uart_tx_end_callback[2] = {{NULL}, {NULL}};
+static UINT32 uart_rx_isr_status[2] = {0, 0};
+static UINT32 uart_rx_overflow_cnt[2] = {0, 0};
+static UINT8 uart_rx_stop_time[2] = {RX_STOP_DETECT_TIME32, RX_STOP_DETECT_TIME32};
 
 extern uint32_t get_ate_mode_state(void);
 
@@ -118,9 +121,8 @@ void set_printf_port(UINT8 port)
 char string[256];
 void *print_handle = NULL;
 
-void bk_printf(const char *fmt, ...)
+static BaseType_t bk_print_lock(void)
 {
-    va_list ap;
     bool is_interrupt = false;
     BaseType_t state = 0;
 
@@ -140,33 +142,75 @@ void bk_printf(const char *fmt, ...)
 
         if (is_interrupt == false) {
             xSemaphoreTakeRecursive(print_handle, portMAX_DELAY);
+            return pdTRUE;
         }
     }
-    
-    va_start(ap, fmt);
-    vsnprintf(string, sizeof(string) - 1, fmt, ap);
-    string[255] = 0;
 
+    return pdFALSE;
+}
+
+static void bk_print_unlock(BaseType_t locked)
+{
+    if (locked) {
+        xSemaphoreGiveRecursive(print_handle);
+    }
+}
+
+static UINT8 bk_print_uport(void)
+{
 #if ATE_APP_FUN
 	if(get_ate_mode_state())
 	{
-    	bk_send_string(UART1_PORT, string);
+    	return UART1_PORT;
 	}
-	else
 #endif
-	{
-        if(get_printf_port() == 1)
-        	bk_send_string(UART1_PORT, string);
-        else
-            bk_send_string(UART2_PORT, string);
-	}
+    return (get_printf_port() == 1) ? UART1_PORT : UART2_PORT;
+}
+
+static void bk_print_send(const char *buf)
+{
+    bk_send_string(bk_print_uport(), buf);
+}
+
+void bk_printf(const char *fmt, ...)
+{
+    va_list ap;
+    BaseType_t locked;
+
+    locked = bk_print_lock();
+    
+    va_start(ap, fmt);
+    vsnprintf(string, sizeof(string) - 1, fmt, ap);
+    string[255] = 0;
+    bk_print_send(string);
     va_end(ap);
 
-    if (state != taskSCHEDULER_NOT_STARTED) {
-        if (is_interrupt == false) {
-            xSemaphoreGiveRecursive(print_handle);
-        }
+    bk_print_unlock(locked);
+}
+
+/* print a string that is already formatted, without going through the shared buffer */
+void bk_print_raw(const char *str)
+{
+    BaseType_t locked;
+
+    locked = bk_print_lock();
+    bk_print_send(str);
+    bk_print_unlock(locked);
+}
+
+/* print bytes as they are, no '\r' is inserted, for binary log frames */
+void bk_print_bin(const UINT8 *buf, UINT32 len)
+{
+    BaseType_t locked;
+    UINT8 uport;
+    UINT32 i;
+
+    locked = bk_print_lock();
+    uport = bk_print_uport();
+    for (i = 0; i < len; i++) {
+        bk_send_byte(uport, buf[i]);
     }
+    bk_print_unlock(locked);
 }
 
 void print_hex_dump(const char *prefix, void *buf, int len)
@@ -222,7 +266,7 @@ void uart_hw_init(UINT8 uport)
 
     reg = ((TX_FIFO_THRD & TX_FIFO_THRESHOLD_MASK) << TX_FIFO_THRESHOLD_POSI)
           | ((RX_FIFO_THRD & RX_FIFO_THRESHOLD_MASK) << RX_FIFO_THRESHOLD_POSI)
-          | ((RX_STOP_DETECT_TIME32 & RX_STOP_DETECT_TIME_MASK) << RX_STOP_DETECT_TIME_POSI);
+          | ((uart_rx_stop_time[uport] & RX_STOP_DETECT_TIME_MASK) << RX_STOP_DETECT_TIME_POSI);
     REG_WRITE(fifo_conf_reg_addr, reg);
 
     REG_WRITE(flow_conf_reg_addr, 0);
@@ -298,7 +342,7 @@ void uart_hw_set_change(UINT8 uport, uart_config_t *uart_config)
 
     reg = ((TX_FIFO_THRD & TX_FIFO_THRESHOLD_MASK) << TX_FIFO_THRESHOLD_POSI)
           | ((RX_FIFO_THRD & RX_FIFO_THRESHOLD_MASK) << RX_FIFO_THRESHOLD_POSI)
-          | ((RX_STOP_DETECT_TIME32 & RX_STOP_DETECT_TIME_MASK) << RX_STOP_DETECT_TIME_POSI);
+          | ((uart_rx_stop_time[uport] & RX_STOP_DETECT_TIME_MASK) << RX_STOP_DETECT_TIME_POSI);
     REG_WRITE(fifi_conf_reg_addr, reg);
 
     REG_WRITE(flow_conf_reg_addr, 0);
@@ -432,55 +476,132 @@ UINT32 uart_write_fifo_frame(UINT8 uport, KFIFO_PTR tx_ptr, UINT32 count)
 {
     UINT32 len;
     UINT32 ret;
-    UINT32 val;
+    UINT32 i;
+    UINT8 buf[32];
 
     len = 0;
 
-    while(1)
+    while(len < count)
     {
-        ret = kfifo_get(tx_ptr, (UINT8 *)&val, 1);
+        ret = kfifo_get(tx_ptr, buf, min(sizeof(buf), count - len));
         if(0 == ret)
         {
             break;
         }
 
-
+        for(i = 0; i < ret; i ++)
+        {
 #if __CC_ARM
-        uart_send_byte(uport, (UINT8)val);
+            uart_send_byte(uport, buf[i]);
 #else
-        bk_send_byte(uport, (UINT8)val);
+            bk_send_byte(uport, buf[i]);
 #endif
+        }
 
         len += ret;
-        if(len >= count)
-        {
-            break;
-        }
     }
 
     return len;
 }
 
-UINT32 uart_read_fifo_frame(UINT8 uport, KFIFO_PTR rx_ptr)
+/* fill the tx fifo from buf without waiting, returns the bytes taken */
+UINT32 uart_write_fifo_buf(UINT8 uport, const UINT8 *buf, UINT32 len)
 {
     UINT32 val;
-    UINT32 rx_count, fifo_status_reg;
+    UINT32 count;
+    UINT32 fifo_status_reg;
 
     if(UART1_PORT == uport)
         fifo_status_reg = REG_UART1_FIFO_STATUS;
     else
         fifo_status_reg = REG_UART2_FIFO_STATUS;
 
+    count = 0;
+    while((count < len) && (REG_READ(fifo_status_reg) & FIFO_WR_READY))
+    {
+        val = buf[count ++];
+        UART_WRITE_BYTE(uport, val);
+    }
+
+    return count;
+}
+
+UINT32 uart_tx_fifo_port(UINT8 uport)
+{
+    if(UART1_PORT == uport)
+        return REG_UART1_FIFO_PORT;
+    else
+        return REG_UART2_FIFO_PORT;
+}
+
+UINT32 uart_read_fifo_frame(UINT8 uport, KFIFO_PTR rx_ptr)
+{
+    UINT32 len;
+    UINT32 rx_count;
+    UINT8 buf[32];
+
     rx_count = 0;
-    while(REG_READ(fifo_status_reg) & FIFO_RD_READY)
+    do
     {
-        UART_READ_BYTE(uport, val);
-        rx_count += kfifo_put(rx_ptr, (UINT8 *)&val, 1);
+        len = uart_read_fifo_buf(uport, buf, sizeof(buf));
+        rx_count += kfifo_put(rx_ptr, buf, len);
     }
+    while(len == sizeof(buf));
 
     return rx_count;
 }
 
+/* drain the rx fifo into buf, returns the bytes taken */
+UINT32 uart_read_fifo_buf(UINT8 uport, UINT8 *buf, UINT32 len)
+{
+    UINT32 val;
+    UINT32 count;
+    UINT32 fifo_status_reg;
+
+    if(UART1_PORT == uport)
+        fifo_status_reg = REG_UART1_FIFO_STATUS;
+    else
+        fifo_status_reg = REG_UART2_FIFO_STATUS;
+
+    count = 0;
+    while((count < len) && (REG_READ(fifo_status_reg) & FIFO_RD_READY))
+    {
+        UART_READ_BYTE(uport, val);
+        buf[count ++] = (UINT8)val;
+    }
+
+    return count;
+}
+
+/* for the rx callback: the interrupt being served saw the line go idle */
+UINT8 uart_rx_is_stop_end(UINT8 uport)
+{
+    return (uart_rx_isr_status[uport] & UART_RX_STOP_END_STA) ? 1 : 0;
+}
+
+UINT32 uart_rx_overflow_get(UINT8 uport)
+{
+    return uart_rx_overflow_cnt[uport];
+}
+
+/* idle time before UART_RX_STOP_END_STA, RX_STOP_DETECT_TIME32..256 bit times */
+void uart_set_rx_stop_detect_time(UINT8 uport, UINT8 sel)
+{
+    UINT32 reg, fifo_conf_reg_addr;
+
+    if(UART1_PORT == uport)
+        fifo_conf_reg_addr = REG_UART1_FIFO_CONFIG;
+    else
+        fifo_conf_reg_addr = REG_UART2_FIFO_CONFIG;
+
+    uart_rx_stop_time[uport] = sel & RX_STOP_DETECT_TIME_MASK;
+
+    reg = REG_READ(fifo_conf_reg_addr);
+    reg &= ~(RX_STOP_DETECT_TIME_MASK << RX_STOP_DETECT_TIME_POSI);
+    reg |= (uart_rx_stop_time[uport] << RX_STOP_DETECT_TIME_POSI);
+    REG_WRITE(fifo_conf_reg_addr, reg);
+}
+
 void uart_set_tx_fifo_needwr_int(UINT8 uport, UINT8 set)
 {
 	UINT32 reg;
@@ -563,8 +684,15 @@ void uart1_isr(void)
     REG_WRITE(REG_UART1_INTR_STATUS, intr_status);
     status = intr_status & intr_en;
 
+    /* the overflow interrupt stays masked, the raw status is enough to count it */
+    if(intr_status & RX_FIFO_OVER_FLOW_STA)
+    {
+        uart_rx_overflow_cnt[UART1_PORT] ++;
+    }
+
     if(status & (RX_FIFO_NEED_READ_STA | UART_RX_STOP_END_STA))
     {
+        uart_rx_isr_status[UART1_PORT] = status;
 #if ATE_APP_FUN
 		if(get_ate_mode_state())
 		{
@@ -582,6 +710,7 @@ void uart1_isr(void)
         {
         	uart_read_byte(UART1_PORT); /*drop data for rtt*/
         }
+        uart_rx_isr_status[UART1_PORT] = 0;
     }
 	
     if(status & TX_FIFO_NEED_WRITE_STA)
@@ -802,8 +931,14 @@ void uart2_isr(void)
     REG_WRITE(REG_UART2_INTR_STATUS, intr_status);
     status = intr_status & intr_en;
 
+    if(intr_status & RX_FIFO_OVER_FLOW_STA)
+    {
+        uart_rx_overflow_cnt[UART2_PORT] ++;
+    }
+
     if(status & (RX_FIFO_NEED_READ_STA | UART_RX_STOP_END_STA))
     {
+        uart_rx_isr_status[UART2_PORT] = status;
 	#if (!CFG_SUPPORT_RTT)
 		uart_read_fifo_frame(UART2_PORT, uart[UART2_PORT].rx);
 	#endif
@@ -818,6 +953,7 @@ void uart2_isr(void)
 		{
 			uart_read_byte(UART2_PORT); /*drop data for rtt*/
 		}
+        uart_rx_isr_status[UART2_PORT] = 0;
     }
 
 	if(status & TX_FIFO_NEED_WRITE_STA)
@@ -1024,6 +1024,7 @@ void hapd_intf_ke_rx_handle(int dummy)
 {
     int payload_size;
     unsigned char *buf;
+    SOCKET_MSG *sk_msg;
     S_TYPE_PTR type_ptr = (S_TYPE_PTR)dummy;
 
     if(type_ptr->type == HOSTAPD_MGMT
@@ -1036,14 +1037,16 @@ void hapd_intf_ke_rx_handle(int dummy)
         struct ke_msg *kmsg_dst;
         struct me_mgmt_tx_req *mgmt_tx_ptr;
 
-        payload_size = ke_mgmt_peek_rxed_next_payload_size(type_ptr->vif_index);
-        ASSERT(payload_size);
-        buf = (unsigned char *)os_malloc(payload_size);
+        /* the frame buffer of the socket message goes to ME as it is */
+        sk_msg = ke_mgmt_packet_rx_msg(type_ptr->vif_index);
+        ASSERT(sk_msg);
+        payload_size = sk_msg->len;
+        buf = sk_msg_detach(sk_msg);
+        sk_msg_free(sk_msg);
         if(0 == buf)
         {
             goto exit;
         }
-        ke_mgmt_packet_rx(buf, payload_size, type_ptr->vif_index);
         param_len = sizeof(struct me_mgmt_tx_req);
         kmsg_dst = (struct ke_msg *)os_malloc(sizeof(struct ke_msg)
                                               + param_len);
@@ -1073,18 +1076,13 @@ void hapd_intf_ke_rx_handle(int dummy)
     }
     else if(type_ptr->type == HOSTAPD_DATA)
     {
-        UINT8 *pd_ptr;
-
-        payload_size = ke_data_peek_rxed_next_payload_size(type_ptr->vif_index);
-        pd_ptr = (UINT8 *)os_malloc(payload_size);
-        if(NULL == pd_ptr)
+        sk_msg = ke_l2_packet_rx_msg(type_ptr->vif_index);
+        if(NULL == sk_msg)
         {
             WPAS_WPRT("hapd_intf_tx_error\r\n");
             goto exit;
         }
 
-        ke_l2_packet_rx(pd_ptr, payload_size, type_ptr->vif_index);
-
         ps_set_data_prevent();
 
 #if CFG_USE_STA_PS
@@ -1093,9 +1091,9 @@ void hapd_intf_ke_rx_handle(int dummy)
         bk_wlan_dtim_rf_ps_mode_do_wakeup();
 #endif
 
-        rwm_transfer(type_ptr->vif_index, pd_ptr, payload_size, type_ptr->sync, type_ptr->args);
+        rwm_transfer(type_ptr->vif_index, sk_msg->msg, sk_msg->len, type_ptr->sync, type_ptr->args);
 
-        os_free(pd_ptr);
+        sk_msg_free(sk_msg);
     }
 
     os_free(type_ptr);
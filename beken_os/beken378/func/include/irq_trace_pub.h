@@ -0,0 +1,47 @@
+#ifndef _IRQ_TRACE_PUB_H_
+#define _IRQ_TRACE_PUB_H_
+
+#include "typedef.h"
+
+/*
+ * masked interrupt and scheduler suspension tracer, see CFG_IRQ_TRACE.
+ * durations are taken on the free running BKTIMER1 counter of the run time
+ * stats, they read 0 without it.
+ */
+#define IRQ_TRACE_SITE_NUM          64
+#define IRQ_TRACE_HIST_NUM          8   // <16us <64us <256us <1ms <4ms <16ms <64ms >=64ms
+
+typedef struct
+{
+    const char *file;               // NULL for a scheduler suspension, line is the caller address then
+    UINT32 line;
+    UINT32 count;
+    UINT32 max_us;
+    UINT64 total_us;
+    UINT32 hist[IRQ_TRACE_HIST_NUM];
+} irq_trace_site_t;
+
+typedef struct
+{
+    UINT32 irq_count;
+    UINT32 irq_max_us;
+    UINT32 irq_hist[IRQ_TRACE_HIST_NUM];
+    UINT32 sched_count;
+    UINT32 sched_max_us;
+    UINT32 sched_hist[IRQ_TRACE_HIST_NUM];
+    UINT32 lost;                    // sections not recorded because the site table was full
+} irq_trace_state_t;
+
+/* hooks of GLOBAL_INT_DISABLE/RESTORE and vTaskSuspendAll/xTaskResumeAll */
+void irq_trace_begin(const char *file, int line);
+void irq_trace_end(void);
+void irq_trace_suspend_begin(void *caller);
+void irq_trace_suspend_end(void);
+
+void irq_trace_state(irq_trace_state_t *state);
+int irq_trace_site_state(int idx, irq_trace_site_t *site);
+void irq_trace_clear(void);
+
+#endif // _IRQ_TRACE_PUB_H_
+// eof
+
@@ -22,6 +22,10 @@ typedef struct  sctrl_mcu_ps{
 #define     MCU_PS_CONNECT      CO_BIT(0)
 #define     MCU_PS_ADD_KEY      CO_BIT(1)
 #define     MCU_PS_BLE_FROBID      (1UL<<(2))
+#define     MCU_PS_TKL_VOTE        (1UL<<(3))
+
+/* run with interrupts disabled, right before the mcu sleeps and right after it wakes */
+typedef void (*MCU_PS_SLEEP_CB)(void);
 
 #define CHIP_U_MCU_WKUP_USE_TIMER  1
 
@@ -36,6 +40,7 @@ extern void peri_busy_count_dec(void );
 extern void peri_busy_count_add(void );
 extern UINT32 peri_busy_count_get(void );
 extern UINT32 mcu_prevent_get(void );
+extern void mcu_ps_sleep_cb_register(MCU_PS_SLEEP_CB pre_sleep, MCU_PS_SLEEP_CB post_wakeup);
 extern UINT32 fclk_update_tick(UINT32 tick);
 extern void mcu_ps_dump(void);
 extern void ps_pwm_reconfig(UINT32 ,UINT8 );
@@ -52,7 +52,34 @@ typedef struct item_ip_config_st
     char gateway_ip_addr[16];    
 }ITEM_IP_CONFIG_ST,*ITEM_IP_CONFIG_ST_PTR;
 
+/*
+ * the info table is kept below NET_PARAM_TBL_MAX, the rest of the sector is an
+ * append only log of fixed size slots. slots are only programmed, never erased
+ * on their own, so a log write cannot touch the table; the log is emptied
+ * whenever save_info_item rewrites the sector, and net_param_log_rewrite
+ * erases it to compact a full log.
+ */
+#define NET_PARAM_SECTOR_SIZE     0x1000
+#define NET_PARAM_TBL_MAX         0x800
+#define NET_PARAM_LOG_SLOT_SIZE   64
+#define NET_PARAM_LOG_SLOTS       ((NET_PARAM_SECTOR_SIZE - NET_PARAM_TBL_MAX) / NET_PARAM_LOG_SLOT_SIZE)
+
+#define PSK_CACHE_TAG_LEN         16
+#define PSK_CACHE_REC_MAGIC       (0x4b535021)   // ASCII !PSK
+
+typedef struct psk_cache_rec_st
+{
+	UINT32 magic;					// programmed last, the record is valid once it is set
+	UINT8 tag[PSK_CACHE_TAG_LEN];	// hmac of ssid and passphrase, keyed per device
+	UINT8 psk[32];
+	UINT32 check;					// sum of tag and psk words, catches a torn write
+	UINT8 reserved[NET_PARAM_LOG_SLOT_SIZE - 56];
+}PSK_CACHE_REC_ST;
+
 UINT32 test_get_whole_tbl(UINT8 *ptr);
 UINT32 save_info_item(NET_INFO_ITEM item,UINT8 *ptr0,UINT8*ptr1,UINT8 *ptr2);
 UINT32 get_info_item(NET_INFO_ITEM item,UINT8 *ptr0,UINT8 *ptr1, UINT8 *ptr2);
+UINT32 net_param_log_read(UINT32 slot,UINT8 *buf);
+UINT32 net_param_log_write(UINT32 slot,UINT32 offset,UINT8 *buf,UINT32 len);
+UINT32 net_param_log_rewrite(UINT8 *buf,UINT32 count);
 #endif
@@ -95,6 +95,8 @@ typedef struct sta_scan_res
     /* Followed by ie_len of IE data */
 }SCAN_RST_ITEM_T, *SCAN_RST_ITEM_PTR;
 
+typedef void (*SCANU_BSS_CB)(void *ctxt, SCAN_RST_ITEM_PTR item);
+
 
 typedef struct 
 {  
@@ -243,6 +245,7 @@ extern UINT32 mr_kmsg_fuzzy_handle(void);
 extern UINT32 mr_kmsg_exact_handle(UINT16 rsp);
 extern void mhdr_assoc_cfm_cb(FUNC_2PARAM_PTR ind_cb, void *ctxt);
 extern void mhdr_scanu_reg_cb(FUNC_2PARAM_PTR ind_cb, void *ctxt);
+extern void mhdr_scanu_reg_bss_cb(SCANU_BSS_CB ind_cb, void *ctxt);
 extern void mhdr_connect_user_cb(FUNC_2PARAM_PTR ind_cb, void *ctxt);
 extern UINT32 rw_ieee80211_init(void);
 extern UINT32 rw_ieee80211_get_centre_frequency(UINT32 chan_id);
@@ -501,6 +501,7 @@ typedef     UINT32      BK_PS_LEVEL;
 
 void bk_wlan_connection_loss(void);
 int bk_wlan_start_assign_scan(UINT8 **ssid_ary, UINT8 ssid_num);
+int bk_wlan_start_chan_scan(UINT8 **ssid_ary, UINT8 ssid_num, UINT8 *chans, UINT8 chan_num);
 
 void bk_wlan_scan_ap_reg_cb(FUNC_2PARAM_PTR ind_cb);
 unsigned char bk_wlan_get_scan_ap_result_numbers(void);
@@ -0,0 +1,229 @@
+#include "include.h"
+#include "arch.h"
+#include "irq_trace_pub.h"
+#include "bk_timer_pub.h"
+#include "mem_pub.h"
+
+#if CFG_IRQ_TRACE
+/* GLOBAL_INT_DISABLE/RESTORE call into this file, so it masks with the port calls */
+#define IRQ_TRACE_DECLARATION()     uint32_t fiq_tmp, irq_tmp
+#define IRQ_TRACE_DISABLE()         do{                             \
+                                        fiq_tmp = portDISABLE_FIQ();\
+                                        irq_tmp = portDISABLE_IRQ();\
+                                    }while(0)
+#define IRQ_TRACE_RESTORE()         do{                             \
+                                        if(!fiq_tmp)                \
+                                        {                           \
+                                            portENABLE_FIQ();       \
+                                        }                           \
+                                        if(!irq_tmp)                \
+                                        {                           \
+                                            portENABLE_IRQ();       \
+                                        }                           \
+                                    }while(0)
+
+#define IRQ_TRACE_CLK_PER_US        26
+#define IRQ_TRACE_WRAP_CLK          ((UINT32)BK_TIMER_FREE_RUN_PERIOD_US * IRQ_TRACE_CLK_PER_US)
+
+static irq_trace_site_t irq_trace_site[IRQ_TRACE_SITE_NUM];
+static irq_trace_state_t irq_trace_total;
+
+static const char *irq_trace_cur_file;
+static UINT32 irq_trace_cur_line;
+static UINT32 irq_trace_cur_start;
+
+static void *irq_trace_sched_caller;
+static UINT32 irq_trace_sched_start;
+
+static UINT32 irq_trace_elapsed_us(UINT32 start)
+{
+    UINT32 now = bk_timer_free_run_raw();
+
+    if(now < start)
+    {
+        return (IRQ_TRACE_WRAP_CLK - start + now) / IRQ_TRACE_CLK_PER_US;
+    }
+
+    return (now - start) / IRQ_TRACE_CLK_PER_US;
+}
+
+static UINT32 irq_trace_bucket(UINT32 us)
+{
+    UINT32 i;
+
+    us >>= 4;
+    for(i = 0; (i < IRQ_TRACE_HIST_NUM - 1) && us; i ++)
+    {
+        us >>= 2;
+    }
+
+    return i;
+}
+
+static irq_trace_site_t *irq_trace_site_get(const char *file, UINT32 line)
+{
+    UINT32 i, idx;
+    irq_trace_site_t *site;
+
+    idx = ((UINT32)file ^ (line * 2654435761u)) >> 16;
+    for(i = 0; i < IRQ_TRACE_SITE_NUM; i ++)
+    {
+        site = &irq_trace_site[(idx + i) & (IRQ_TRACE_SITE_NUM - 1)];
+        if((site->file == file) && (site->line == line))
+        {
+            return site;
+        }
+
+        if(0 == site->count)
+        {
+            site->file = file;
+            site->line = line;
+            return site;
+        }
+    }
+
+    return NULL;
+}
+
+/* interrupts are masked */
+static void irq_trace_record(const char *file, UINT32 line, UINT32 us)
+{
+    UINT32 bucket = irq_trace_bucket(us);
+    irq_trace_site_t *site;
+
+    if(file)
+    {
+        irq_trace_total.irq_count ++;
+        irq_trace_total.irq_hist[bucket] ++;
+        if(us > irq_trace_total.irq_max_us)
+        {
+            irq_trace_total.irq_max_us = us;
+        }
+    }
+    else
+    {
+        irq_trace_total.sched_count ++;
+        irq_trace_total.sched_hist[bucket] ++;
+        if(us > irq_trace_total.sched_max_us)
+        {
+            irq_trace_total.sched_max_us = us;
+        }
+    }
+
+    site = irq_trace_site_get(file, line);
+    if(NULL == site)
+    {
+        irq_trace_total.lost ++;
+        return;
+    }
+
+    site->count ++;
+    site->total_us += us;
+    site->hist[bucket] ++;
+    if(us > site->max_us)
+    {
+        site->max_us = us;
+    }
+}
+
+/* outermost GLOBAL_INT_DISABLE, interrupts are already masked */
+void irq_trace_begin(const char *file, int line)
+{
+    irq_trace_cur_file = file;
+    irq_trace_cur_line = line;
+    irq_trace_cur_start = bk_timer_free_run_raw();
+}
+
+/* outermost GLOBAL_INT_RESTORE, interrupts are still masked */
+void irq_trace_end(void)
+{
+    if(irq_trace_cur_file)
+    {
+        irq_trace_record(irq_trace_cur_file, irq_trace_cur_line, irq_trace_elapsed_us(irq_trace_cur_start));
+        irq_trace_cur_file = NULL;
+    }
+}
+
+void irq_trace_suspend_begin(void *caller)
+{
+    IRQ_TRACE_DECLARATION();
+
+    IRQ_TRACE_DISABLE();
+    irq_trace_sched_caller = caller;
+    irq_trace_sched_start = bk_timer_free_run_raw();
+    IRQ_TRACE_RESTORE();
+}
+
+void irq_trace_suspend_end(void)
+{
+    IRQ_TRACE_DECLARATION();
+
+    IRQ_TRACE_DISABLE();
+    if(irq_trace_sched_caller)
+    {
+        irq_trace_record(NULL, (UINT32)irq_trace_sched_caller, irq_trace_elapsed_us(irq_trace_sched_start));
+        irq_trace_sched_caller = NULL;
+    }
+    IRQ_TRACE_RESTORE();
+}
+
+void irq_trace_state(irq_trace_state_t *state)
+{
+    IRQ_TRACE_DECLARATION();
+
+    IRQ_TRACE_DISABLE();
+    os_memcpy(state, &irq_trace_total, sizeof(*state));
+    IRQ_TRACE_RESTORE();
+}
+
+/* sites in table order, 0 on success and -1 past the last one */
+int irq_trace_site_state(int idx, irq_trace_site_t *site)
+{
+    int i;
+    IRQ_TRACE_DECLARATION();
+
+    for(i = 0; i < IRQ_TRACE_SITE_NUM; i ++)
+    {
+        if(0 == irq_trace_site[i].count)
+        {
+            continue;
+        }
+
+        if(0 == idx --)
+        {
+            IRQ_TRACE_DISABLE();
+            os_memcpy(site, &irq_trace_site[i], sizeof(*site));
+            IRQ_TRACE_RESTORE();
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+void irq_trace_clear(void)
+{
+    IRQ_TRACE_DECLARATION();
+
+    IRQ_TRACE_DISABLE();
+    os_memset(irq_trace_site, 0, sizeof(irq_trace_site));
+    os_memset(&irq_trace_total, 0, sizeof(irq_trace_total));
+    IRQ_TRACE_RESTORE();
+}
+#else
+void irq_trace_state(irq_trace_state_t *state)
+{
+    os_memset(state, 0, sizeof(*state));
+}
+
+int irq_trace_site_state(int idx, irq_trace_site_t *site)
+{
+    return -1;
+}
+
+void irq_trace_clear(void)
+{
+}
+#endif // CFG_IRQ_TRACE
+// eof
+
@@ -220,6 +220,11 @@ UINT32 save_info_item(NET_INFO_ITEM item,UINT8 *ptr0,UINT8*ptr1,UINT8 *ptr2)
 		{
 			addr_offset -= pt->partition_start_addr;
 		}
+		if(cfg_tbl_len > NET_PARAM_TBL_MAX)
+		{
+			os_printf("net param tbl full: %d\r\n", cfg_tbl_len);
+			return 0;
+		}
 		wrbuf = os_zalloc(cfg_tbl_len);
 		if(wrbuf == NULL)
 			return 0;
@@ -287,6 +292,81 @@ UINT32 save_info_item(NET_INFO_ITEM item,UINT8 *ptr0,UINT8*ptr1,UINT8 *ptr2)
 	
 	return 1;
 }
+UINT32 net_param_log_read(UINT32 slot,UINT8 *buf)
+{
+	if(slot >= NET_PARAM_LOG_SLOTS)
+		return 0;
+
+#if CFG_SUPPORT_ALIOS
+	return 0;
+#else
+	bk_flash_read(BK_PARTITION_NET_PARAM,NET_PARAM_TBL_MAX + slot * NET_PARAM_LOG_SLOT_SIZE,
+		buf,NET_PARAM_LOG_SLOT_SIZE);
+	return 1;
+#endif
+}
+
+/* programs erased bytes of a slot, the sector is not erased */
+UINT32 net_param_log_write(UINT32 slot,UINT32 offset,UINT8 *buf,UINT32 len)
+{
+	if((slot >= NET_PARAM_LOG_SLOTS) || (offset + len > NET_PARAM_LOG_SLOT_SIZE))
+		return 0;
+
+#if CFG_SUPPORT_ALIOS
+	return 0;
+#else
+	hal_flash_lock();
+	bk_flash_enable_security(FLASH_PROTECT_NONE);
+	bk_flash_write(BK_PARTITION_NET_PARAM,NET_PARAM_TBL_MAX + slot * NET_PARAM_LOG_SLOT_SIZE + offset,
+		buf,len);
+	bk_flash_enable_security(FLASH_PROTECT_ALL);
+	hal_flash_unlock();
+	return 1;
+#endif
+}
+
+/*
+ * erases the sector and programs the table back, with count slots from buf as
+ * the start of an empty log. a cut in between loses the table the way a cut
+ * in save_info_item does.
+ */
+UINT32 net_param_log_rewrite(UINT8 *buf,UINT32 count)
+{
+	UINT32 tbl_len = 0;
+	UINT8 *tbl = NULL;
+
+	if(count > NET_PARAM_LOG_SLOTS)
+		return 0;
+
+#if CFG_SUPPORT_ALIOS
+	return 0;
+#else
+	if(search_info_tbl(NULL,&tbl_len))
+	{
+		if(tbl_len > NET_PARAM_TBL_MAX)
+			return 0;
+		tbl = os_malloc(tbl_len);
+		if(tbl == NULL)
+			return 0;
+		search_info_tbl(tbl,&tbl_len);
+	}
+
+	hal_flash_lock();
+	bk_flash_enable_security(FLASH_PROTECT_NONE);
+	bk_flash_erase(BK_PARTITION_NET_PARAM,0,NET_PARAM_SECTOR_SIZE);
+	if(tbl)
+		bk_flash_write(BK_PARTITION_NET_PARAM,0,tbl,tbl_len);
+	if(count)
+		bk_flash_write(BK_PARTITION_NET_PARAM,NET_PARAM_TBL_MAX,buf,count * NET_PARAM_LOG_SLOT_SIZE);
+	bk_flash_enable_security(FLASH_PROTECT_ALL);
+	hal_flash_unlock();
+
+	if(tbl)
+		os_free(tbl);
+	return 1;
+#endif
+}
+
 /////////////////////for test purpose/////////////////
 UINT32 test_get_whole_tbl(UINT8 *ptr)
 {
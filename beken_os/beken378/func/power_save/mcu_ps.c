@@ -30,13 +30,39 @@ int increase_tick = 0;
 extern UINT8 sctrl_if_mcu_can_sleep(void);
 
 #if (CHIP_U_MCU_WKUP_USE_TIMER && ((CFG_SOC_NAME == SOC_BK7231U) || (CFG_SOC_NAME == SOC_BK7231N)))
+extern UINT32 ps_timer3_enable(UINT32 period);
 extern UINT32 ps_timer3_disable(void);
+extern UINT32 ps_timer3_disable_cnt(void);
+
+/* 32k counts per tick, and the part of a tick slept but not yet given to the os */
+#define MCU_PS_TICK_CNT         (FCLK_DURATION_MS * 32)
+#define MCU_PS_US_TO_CNT(us)    ((us) * 32 / 1000)
+static UINT32 mcu_ps_carry_cnt = 0;
+
+/* whole ticks in cnt plus the carry, at most max_ticks, the rest is carried to the next sleep */
+static UINT32 mcu_ps_carry_ticks(UINT32 cnt, UINT32 max_ticks)
+{
+    UINT32 ticks;
+
+    cnt += mcu_ps_carry_cnt;
+    ticks = cnt / MCU_PS_TICK_CNT;
+    if(ticks > max_ticks)
+    {
+        ticks = max_ticks;
+    }
+    mcu_ps_carry_cnt = cnt - ticks * MCU_PS_TICK_CNT;
+
+    return ticks;
+}
 #endif
 
 #if (CFG_SUPPORT_ALIOS & CFG_USE_MCU_PS)
 static UINT32 sleep_pwm_t, wkup_type;
 #endif
 
+static MCU_PS_SLEEP_CB mcu_ps_pre_sleep_cb = NULL;
+static MCU_PS_SLEEP_CB mcu_ps_post_wakeup_cb = NULL;
+
 void mcu_ps_cal_increase_tick(UINT32 *lost_p);
 
 void peri_busy_count_add(void )
@@ -81,6 +107,15 @@ UINT32 mcu_prevent_get(void )
     return mcu_ps_info.mcu_prevent;
 }
 
+void mcu_ps_sleep_cb_register(MCU_PS_SLEEP_CB pre_sleep, MCU_PS_SLEEP_CB post_wakeup)
+{
+    GLOBAL_INT_DECLARATION();
+    GLOBAL_INT_DISABLE();
+    mcu_ps_pre_sleep_cb = pre_sleep;
+    mcu_ps_post_wakeup_cb = post_wakeup;
+    GLOBAL_INT_RESTORE();
+}
+
 void mcu_ps_enable(void )
 {
     GLOBAL_INT_DECLARATION();
@@ -100,7 +135,7 @@ void mcu_ps_disable(void )
 UINT32 mcu_power_save(UINT32 sleep_tick)
 {
     UINT32 sleep_ms, sleep_pwm_t, param, uart_miss_us = 0, miss_ticks = 0;
-    UINT32 wkup_type, wastage = 0;
+    UINT32 wkup_type, wastage = 0, phase = 0, slept;
     GLOBAL_INT_DECLARATION();
     GLOBAL_INT_DISABLE();
 
@@ -136,11 +171,15 @@ UINT32 mcu_power_save(UINT32 sleep_tick)
                 if(sleep_pwm_t < 64)
                     sleep_pwm_t = 64;
 
+            if(mcu_ps_pre_sleep_cb)
+            {
+                mcu_ps_pre_sleep_cb();
+            }
+
             if(sctrl_if_mcu_can_sleep())
             {
 #if (CHIP_U_MCU_WKUP_USE_TIMER && ((CFG_SOC_NAME == SOC_BK7231U) || (SOC_BK7231N == CFG_SOC_NAME)))
-                extern void ps_timer3_enable(UINT32 period);
-                ps_timer3_enable(sleep_pwm_t);
+                phase = ps_timer3_enable(sleep_pwm_t);
 #else
                 extern void ps_pwm_suspend_tick(UINT32 period);
                 ps_pwm_suspend_tick(sleep_pwm_t);
@@ -174,7 +213,18 @@ UINT32 mcu_power_save(UINT32 sleep_tick)
                 }
                 else
                 {
-                    miss_ticks =  (ps_timer3_disable() + (uart_miss_us + wastage) / 1000) / FCLK_DURATION_MS;
+                    /*
+                     * keep the fraction of a tick instead of truncating it on every wakeup.
+                     * an expired timer leaves the tick interrupt pending, which counts the
+                     * early wakeup tick itself.
+                     */
+                    slept = ps_timer3_disable_cnt();
+                    if(slept >= sleep_pwm_t)
+                    {
+                        slept -= MCU_PS_TICK_CNT;
+                    }
+                    slept += phase + MCU_PS_US_TO_CNT(uart_miss_us + wastage);
+                    miss_ticks = mcu_ps_carry_ticks(slept, sleep_tick - 1);
                 }
             }
 
@@ -207,6 +257,10 @@ UINT32 mcu_power_save(UINT32 sleep_tick)
             ps_pwm_resume_tick();
 
 #endif
+            if(mcu_ps_post_wakeup_cb)
+            {
+                mcu_ps_post_wakeup_cb();
+            }
         }
         while(0);
     }
@@ -556,5 +610,9 @@ void mcu_prevent_clear(UINT32 prevent )
 {
 }
 
+void mcu_ps_sleep_cb_register(MCU_PS_SLEEP_CB pre_sleep, MCU_PS_SLEEP_CB post_wakeup)
+{
+}
+
 #endif
 
@@ -4,6 +4,8 @@
 #include "str_pub.h"
 #include "mem_pub.h"
 #include "txu_cntrl.h"
+#include "sta_mgmt.h"
+#include "mac_frame.h"
 #include "lwip/pbuf.h"
 #include "prot/ip4.h"
 #include "prot/ip6.h"
@@ -25,6 +27,8 @@ extern UINT32 rwm_transfer_node(MSDU_NODE_T *node, u8 flag);
 
 LIST_HEAD_DEFINE(msdu_rx_list);
 
+static MSDU_TX_STATS_T msdu_tx_stats = {0};
+
 #if CFG_USE_AP_PS
 #include "ps.h"
 #include "app.h"
@@ -95,6 +99,40 @@ void rwm_flush_rx_list(void)
     }
 }
 
+/*
+ * the lmac runs host.callback and then os_free's whatever is left in
+ * host.msdu_node when it flushes a txdesc, so the node is released here
+ * and detached before the lmac can see it.
+ */
+static void rwm_tx_node_done(void *param)
+{
+	struct txdesc *txdesc = (struct txdesc *)param;
+	MSDU_NODE_T *node = (MSDU_NODE_T *)txdesc->host.msdu_node;
+
+	if(NULL == node)
+	{
+		return;
+	}
+
+	if(node->tx_cb)
+	{
+		(*node->tx_cb)(node->tx_cb_param);
+	}
+
+	txdesc->host.msdu_node = NULL;
+	rwm_node_free(node);
+}
+
+void rwm_txdesc_bind_node(struct txdesc *txdesc, MSDU_NODE_T *node, mgmt_tx_cb_t cb, void *param)
+{
+	node->tx_cb = cb;
+	node->tx_cb_param = param;
+
+	txdesc->host.msdu_node = (void *)node;
+	txdesc->host.callback = rwm_tx_node_done;
+	txdesc->host.param = (void *)txdesc;
+}
+
 void rwm_tx_confirm(void *param)
 {
 	struct txdesc *txdesc = (struct txdesc *)param;
@@ -107,9 +145,12 @@ void rwm_tx_confirm(void *param)
 		{
 			(*txdesc->host.callback)(txdesc->host.param);
 		}
-		
-		os_free(txdesc->host.msdu_node);
-		txdesc->host.msdu_node = NULL;
+
+		if(txdesc->host.msdu_node)
+		{
+			rwm_node_free((MSDU_NODE_T *)txdesc->host.msdu_node);
+			txdesc->host.msdu_node = NULL;
+		}
 	}
 }
 
@@ -169,9 +210,7 @@ int rwm_raw_frame_with_cb(uint8_t *buffer, int len, void *cb, void *param)
 	txdesc_new->host.packet_len = len;
 	txdesc_new->host.status_desc_addr = (UINT32)content_ptr;
 	txdesc_new->host.tid = 0xff;
-	txdesc_new->host.callback = (mgmt_tx_cb_t)cb;
-	txdesc_new->host.param = param;
-	txdesc_new->host.msdu_node = (void *)node;
+	rwm_txdesc_bind_node(txdesc_new, node, (mgmt_tx_cb_t)cb, param);
 
 	umac = &txdesc_new->umac;
 	umac->payl_len = len;
@@ -198,34 +237,86 @@ exit:
 	return ret;
 }
 
-MSDU_NODE_T *rwm_tx_node_alloc(UINT32 len)
+#if CFG_MSDU_TX_ZERO_COPY
+/* tkip appends its mic behind the payload, a pbuf has no room reserved there */
+static int rwm_tx_need_mic_tail(UINT8 vif_idx, ETH_HDR_PTR eth_hdr_ptr)
+{
+    UINT8 staid;
+    VIF_INF_PTR vif_entry;
+    struct key_info_tag *key;
+
+    vif_entry = rwm_mgmt_vif_idx2ptr(vif_idx);
+    if(NULL == vif_entry)
+    {
+        return 1;
+    }
+
+    key = vif_entry->default_key;
+    if(key && (MAC_RSNIE_CIPHER_TKIP == key->cipher))
+    {
+        return 1;
+    }
+
+    staid = rwm_mgmt_tx_get_staidx(vif_idx, &eth_hdr_ptr->e_dest);
+    if(staid >= STA_MAX)
+    {
+        return 1;
+    }
+
+    key = sta_info_tab[staid].sta_sec_info.pairwise_key;
+
+    return key && (MAC_RSNIE_CIPHER_TKIP == key->cipher);
+}
+
+/* the reserved head has to fit in front of the payload of a single contiguous pbuf */
+static int rwm_tx_pbuf_can_ref(UINT8 vif_idx, struct pbuf *p)
 {
-    UINT8 *buff_ptr;
-    MSDU_NODE_T *node_ptr = 0;
+    UINT8 *data_start;
 
-    node_ptr = (MSDU_NODE_T *)os_malloc(sizeof(MSDU_NODE_T)
-                                        + CFG_MSDU_RESV_HEAD_LEN
-                                        + len
-                                        + CFG_MSDU_RESV_TAIL_LEN);
+    if(p->next || !(p->type_internal & PBUF_TYPE_FLAG_STRUCT_DATA_CONTIGUOUS))
+    {
+        return 0;
+    }
 
-    if(NULL == node_ptr)
+    if(rwm_tx_need_mic_tail(vif_idx, (ETH_HDR_PTR)p->payload))
     {
-        goto alloc_exit;
+        return 0;
     }
 
-    buff_ptr = (UINT8 *)((UINT32)node_ptr + sizeof(MSDU_NODE_T));
+    data_start = (UINT8 *)p + LWIP_MEM_ALIGN_SIZE(sizeof(struct pbuf));
 
-    node_ptr->msdu_ptr = buff_ptr;
-    node_ptr->len = len;
+    return ((UINT8 *)p->payload - data_start) >= CFG_MSDU_RESV_HEAD_LEN;
+}
+
+static MSDU_NODE_T *rwm_tx_node_ref(struct pbuf *p)
+{
+    MSDU_NODE_T *node_ptr;
+
+    node_ptr = (MSDU_NODE_T *)os_malloc(sizeof(MSDU_NODE_T));
+    if(NULL == node_ptr)
+    {
+        return NULL;
+    }
+
+    /* held until the tx confirm, msdu_ptr is the head of the reserved room */
+    pbuf_ref(p);
+    node_ptr->pooled = 0;
+    node_ptr->pbuf = p;
+    node_ptr->tx_cb = NULL;
+    node_ptr->msdu_ptr = (UINT8 *)p->payload - CFG_MSDU_RESV_HEAD_LEN;
+    node_ptr->len = p->len;
 
-alloc_exit:
     return node_ptr;
 }
+#endif
 
-void rwm_node_free(MSDU_NODE_T *node)
+void rwm_get_tx_stats(MSDU_TX_STATS_T *stats)
 {
-    ASSERT(node);
-    os_free(node);
+    GLOBAL_INT_DECLARATION();
+
+    GLOBAL_INT_DISABLE();
+    os_memcpy(stats, &msdu_tx_stats, sizeof(MSDU_TX_STATS_T));
+    GLOBAL_INT_RESTORE();
 }
 
 UINT8 *rwm_rx_buf_alloc(UINT32 len)
@@ -338,7 +429,7 @@ void rwm_flush_txing_list(UINT8 sta_idx)
         while(1) {
             node_ptr = rwm_pop_txing_list(sta_idx);
             if(node_ptr)
-                os_free(node_ptr);     
+                rwm_node_free(node_ptr);
             else
                 break;
         }
@@ -490,6 +581,8 @@ void rwm_msdu_ap_ps_timeout(void *data)
 
 void rwm_msdu_init(void)
 {
+    rwm_pool_init();
+
     #if CFG_USE_AP_PS
     g_ap_ps.active = true;
 
@@ -556,16 +649,15 @@ uint8_t classify8021d(UINT8 *buf)
 #endif
 }
 
-UINT32 rwm_transfer(UINT8 vif_idx, UINT8 *buf, UINT32 len, int sync, void *args)
+static UINT32 rwm_transfer_msdu(MSDU_NODE_T *node, UINT8 vif_idx, int sync, void *args)
 {
-    UINT32 ret = 0;
-    MSDU_NODE_T *node;
+    UINT32 ret = RW_FAILURE;
     ETH_HDR_PTR eth_hdr_ptr;
 
-    ret = RW_FAILURE;
-    node = rwm_tx_node_alloc(len);
     if(NULL == node)
     {
+        msdu_tx_stats.tx_no_node ++;
+
         #if NX_POWERSAVE
         txl_cntrl_dec_pck_cnt();
         #endif
@@ -573,9 +665,8 @@ UINT32 rwm_transfer(UINT8 vif_idx, UINT8 *buf, UINT32 len, int sync, void *args)
         os_printf("rwm_transfer no node\r\n");
         goto tx_exit;
     }
-    rwm_tx_msdu_renew(buf, len, node->msdu_ptr);
 
-    eth_hdr_ptr = (ETH_HDR_PTR)buf;
+    eth_hdr_ptr = (ETH_HDR_PTR)rwm_get_msdu_content_ptr(node);
     node->vif_idx = vif_idx;
 	node->sync = sync;
 	node->args = args;
@@ -592,6 +683,58 @@ tx_exit:
     return ret;
 }
 
+UINT32 rwm_transfer(UINT8 vif_idx, UINT8 *buf, UINT32 len, int sync, void *args)
+{
+    MSDU_NODE_T *node;
+
+    msdu_tx_stats.tx_pkts ++;
+    node = rwm_tx_node_alloc(len);
+    if(node)
+    {
+        rwm_tx_msdu_renew(buf, len, node->msdu_ptr);
+        msdu_tx_stats.tx_copy ++;
+        msdu_tx_stats.tx_copy_bytes += len;
+    }
+
+    return rwm_transfer_msdu(node, vif_idx, sync, args);
+}
+
+/*
+ * send an ethernet frame held in a pbuf chain.
+ * the frame goes out of the pbuf itself when it has the reserved head room,
+ * otherwise the chain is gathered into a new msdu node with a single copy.
+ * the caller keeps its own reference.
+ */
+UINT32 rwm_transfer_pbuf(UINT8 vif_idx, struct pbuf *p)
+{
+    MSDU_NODE_T *node;
+
+    msdu_tx_stats.tx_pkts ++;
+
+#if CFG_MSDU_TX_ZERO_COPY
+    if(rwm_tx_pbuf_can_ref(vif_idx, p))
+    {
+        node = rwm_tx_node_ref(p);
+        if(node)
+        {
+            msdu_tx_stats.tx_ref ++;
+        }
+
+        return rwm_transfer_msdu(node, vif_idx, 0, 0);
+    }
+#endif
+
+    node = rwm_tx_node_alloc(p->tot_len);
+    if(node)
+    {
+        pbuf_copy_partial(p, rwm_get_msdu_content_ptr(node), p->tot_len, 0);
+        msdu_tx_stats.tx_copy ++;
+        msdu_tx_stats.tx_copy_bytes += p->tot_len;
+    }
+
+    return rwm_transfer_msdu(node, vif_idx, 0, 0);
+}
+
 void ieee80211_data_tx_cb(void *param)
 {
 	struct txdesc *txdesc_new = (struct txdesc *)param;
@@ -764,16 +907,14 @@ UINT32 rwm_transfer_node(MSDU_NODE_T *node, u8 flag)
 
     txdesc_new->host.vif_idx          = node->vif_idx;
     txdesc_new->host.staid            = node->sta_idx;   
-	txdesc_new->host.msdu_node		  = (void *)node;
 
 	if (node->sync) 
 	{
-		txdesc_new->host.callback		  = (mgmt_tx_cb_t)ieee80211_data_tx_cb;
-		txdesc_new->host.param			  = (void *)txdesc_new;
+		rwm_txdesc_bind_node(txdesc_new, node, (mgmt_tx_cb_t)ieee80211_data_tx_cb, (void *)txdesc_new);
 	} 
 	else 
 	{
-		txdesc_new->host.callback = 0;
+		rwm_txdesc_bind_node(txdesc_new, node, NULL, NULL);
 	}
 
     txdesc_new->lmac.agg_desc = NULL;
@@ -38,23 +38,53 @@ typedef struct _msdu_node_
 
     UINT8 vif_idx;
     UINT8 sta_idx;
+    UINT8 pooled;       /* pool block, recycled by rwm_node_free */
 	void *args;
 	int sync;
+
+    struct pbuf *pbuf;  /* referenced pbuf when msdu_ptr points into it, released on free */
+    mgmt_tx_cb_t tx_cb; /* sender callback, run by rwm_tx_node_done before the release */
+    void *tx_cb_param;
 } MSDU_NODE_T, *MSDU_NODE_PTR;
 
+typedef struct _msdu_tx_stats_
+{
+    UINT32 tx_pkts;         /* frames handed to rwm_transfer* */
+    UINT32 tx_ref;          /* sent from the pbuf itself, no copy */
+    UINT32 tx_copy;         /* copied once into an msdu node */
+    UINT32 tx_copy_bytes;
+    UINT32 tx_no_node;      /* dropped, no memory for the node */
+} MSDU_TX_STATS_T;
+
 extern void rwm_push_rx_list(MSDU_NODE_T *node);
 extern MSDU_NODE_T *rwm_pop_rx_list(void);
 extern void rwm_tx_confirm(void *);
 extern void rwm_tx_msdu_renew(UINT8 *buf, UINT32 len, UINT8 *orig_addr);
 extern UINT8 *rwm_get_msdu_content_ptr(MSDU_NODE_T *node);
 extern void rwm_txdesc_copy(struct txdesc *dst_local, ETH_HDR_PTR eth_hdr_ptr);
+extern void rwm_pool_init(void);
 extern MSDU_NODE_T *rwm_tx_node_alloc(UINT32 len);
 extern void rwm_node_free(MSDU_NODE_T *node);
+extern void rwm_txdesc_bind_node(struct txdesc *txdesc, MSDU_NODE_T *node, mgmt_tx_cb_t cb, void *param);
 extern UINT8 *rwm_rx_buf_alloc(UINT32 len);
 extern UINT32 rwm_upload_data(RW_RXIFO_PTR rx_info);
 extern UINT32 rwm_get_rx_free_node(struct pbuf **p_ret, UINT32 len);
 extern UINT32 rwm_get_rx_valid(void);
 extern int rwm_raw_frame_with_cb(uint8_t *buffer, int len, void *cb, void *param);
+typedef struct _msdu_pool_stats_
+{
+    UINT32 free_cnt;        /* blocks parked in the pool */
+    UINT32 get_cnt;         /* pool blocks handed out */
+    UINT32 put_cnt;         /* pool blocks given back, in use is get_cnt - put_cnt */
+    UINT32 in_use_max;
+    UINT32 hit;             /* served from the pool */
+    UINT32 miss;            /* pool empty, a frame sized heap block instead */
+    UINT32 oversize;        /* frame too big for a pool block */
+} MSDU_POOL_STATS_T;
+
+extern UINT32 rwm_transfer_pbuf(UINT8 vif_idx, struct pbuf *p);
+extern void rwm_get_pool_stats(MSDU_POOL_STATS_T *stats);
+extern void rwm_get_tx_stats(MSDU_TX_STATS_T *stats);
 
 #endif // _RW_MSDU_H_
 // eof
@@ -0,0 +1,159 @@
+#include "include.h"
+#include "rw_msdu.h"
+#include "mem_pub.h"
+#include "uart_pub.h"
+#include "lwip/pbuf.h"
+
+#define MSDU_POOL_BUF_LEN          (sizeof(MSDU_NODE_T)            \
+                                    + CFG_MSDU_RESV_HEAD_LEN        \
+                                    + CFG_MSDU_POOL_FRAME_LEN       \
+                                    + CFG_MSDU_RESV_TAIL_LEN)
+
+/*
+ * the pool holds the CFG_MSDU_POOL_NUM blocks taken at init and nothing else.
+ * a frame that finds it empty gets a heap block of its own size, which goes
+ * back to the heap on free, so a burst does not leave the pool holding more
+ * than it was given. blocks handed out and given back are counted separately,
+ * so a block comes back to the stats only when it really goes through
+ * rwm_node_free, which the txdesc binding guarantees.
+ */
+LIST_HEAD_DEFINE(msdu_pool_list);
+static MSDU_POOL_STATS_T msdu_pool_stats = {0};
+
+static MSDU_NODE_T *rwm_pool_get(void)
+{
+    MSDU_NODE_T *node_ptr = NULL;
+    GLOBAL_INT_DECLARATION();
+
+    GLOBAL_INT_DISABLE();
+    if(!list_empty(&msdu_pool_list))
+    {
+        node_ptr = list_entry(msdu_pool_list.next, MSDU_NODE_T, hdr);
+        list_del(&node_ptr->hdr);
+        msdu_pool_stats.free_cnt --;
+        msdu_pool_stats.hit ++;
+        msdu_pool_stats.get_cnt ++;
+        if((UINT32)(msdu_pool_stats.get_cnt - msdu_pool_stats.put_cnt) > msdu_pool_stats.in_use_max)
+        {
+            msdu_pool_stats.in_use_max = msdu_pool_stats.get_cnt - msdu_pool_stats.put_cnt;
+        }
+    }
+    else
+    {
+        msdu_pool_stats.miss ++;
+    }
+    GLOBAL_INT_RESTORE();
+
+    return node_ptr;
+}
+
+static void rwm_pool_put(MSDU_NODE_T *node_ptr)
+{
+    GLOBAL_INT_DECLARATION();
+
+    GLOBAL_INT_DISABLE();
+    msdu_pool_stats.put_cnt ++;
+
+    if(msdu_pool_stats.free_cnt < CFG_MSDU_POOL_NUM)
+    {
+        list_add_head(&node_ptr->hdr, &msdu_pool_list);
+        msdu_pool_stats.free_cnt ++;
+        node_ptr = NULL;
+    }
+    GLOBAL_INT_RESTORE();
+
+    if(node_ptr)
+    {
+        os_free(node_ptr);
+    }
+}
+
+void rwm_pool_init(void)
+{
+    MSDU_NODE_T *node_ptr;
+
+    while(msdu_pool_stats.free_cnt < CFG_MSDU_POOL_NUM)
+    {
+        node_ptr = (MSDU_NODE_T *)os_malloc(MSDU_POOL_BUF_LEN);
+        if(NULL == node_ptr)
+        {
+            os_printf("msdu pool short: %d\r\n", msdu_pool_stats.free_cnt);
+            break;
+        }
+
+        list_add_head(&node_ptr->hdr, &msdu_pool_list);
+        msdu_pool_stats.free_cnt ++;
+    }
+}
+
+void rwm_get_pool_stats(MSDU_POOL_STATS_T *stats)
+{
+    GLOBAL_INT_DECLARATION();
+
+    GLOBAL_INT_DISABLE();
+    os_memcpy(stats, &msdu_pool_stats, sizeof(MSDU_POOL_STATS_T));
+    GLOBAL_INT_RESTORE();
+}
+
+MSDU_NODE_T *rwm_tx_node_alloc(UINT32 len)
+{
+    UINT8 *buff_ptr;
+    UINT8 pooled = 0;
+    MSDU_NODE_T *node_ptr = 0;
+    GLOBAL_INT_DECLARATION();
+
+    if(len <= CFG_MSDU_POOL_FRAME_LEN)
+    {
+        node_ptr = rwm_pool_get();
+        pooled = (NULL != node_ptr);
+    }
+    else
+    {
+        GLOBAL_INT_DISABLE();
+        msdu_pool_stats.oversize ++;
+        GLOBAL_INT_RESTORE();
+    }
+
+    if(NULL == node_ptr)
+    {
+        node_ptr = (MSDU_NODE_T *)os_malloc(sizeof(MSDU_NODE_T)
+                                            + CFG_MSDU_RESV_HEAD_LEN
+                                            + len
+                                            + CFG_MSDU_RESV_TAIL_LEN);
+        if(NULL == node_ptr)
+        {
+            goto alloc_exit;
+        }
+    }
+
+    buff_ptr = (UINT8 *)node_ptr + sizeof(MSDU_NODE_T);
+
+    node_ptr->msdu_ptr = buff_ptr;
+    node_ptr->len = len;
+    node_ptr->pooled = pooled;
+    node_ptr->pbuf = NULL;
+    node_ptr->tx_cb = NULL;
+
+alloc_exit:
+    return node_ptr;
+}
+
+void rwm_node_free(MSDU_NODE_T *node)
+{
+    ASSERT(node);
+    if(node->pbuf)
+    {
+        pbuf_free(node->pbuf);
+    }
+
+    if(node->pooled)
+    {
+        rwm_pool_put(node);
+    }
+    else
+    {
+        os_free(node);
+    }
+}
+
+// eof
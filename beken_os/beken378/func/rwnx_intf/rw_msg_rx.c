@@ -50,6 +50,8 @@ IND_CALLBACK_T assoc_cfm_cb = {0};
 IND_CALLBACK_T deassoc_evt_cb = {0};
 IND_CALLBACK_T deauth_evt_cb = {0};
 IND_CALLBACK_T wlan_connect_user_cb = {0};
+static SCANU_BSS_CB scan_bss_cb = NULL;
+static void *scan_bss_cb_arg = NULL;
 
 extern void app_set_sema(void);
 extern int get_security_type_from_ie(u8 *, int, u16);
@@ -240,6 +242,17 @@ void mhdr_scanu_reg_cb(FUNC_2PARAM_PTR ind_cb, void *ctxt)
 
 
 
+/* called with every bss stored in the scan result set as it arrives */
+void mhdr_scanu_reg_bss_cb(SCANU_BSS_CB ind_cb, void *ctxt)
+{
+    GLOBAL_INT_DECLARATION();
+
+    GLOBAL_INT_DISABLE();
+    scan_bss_cb = ind_cb;
+    scan_bss_cb_arg = ctxt;
+    GLOBAL_INT_RESTORE();
+}
+
 void mhdr_deauth_evt_cb(FUNC_2PARAM_PTR ind_cb, void *ctxt)
 {
     deauth_evt_cb.cb = ind_cb;
@@ -670,6 +683,20 @@ UINT32 mhdr_scanu_result_ind(SCAN_RST_UPLOAD_T *scan_rst, void *msg, UINT32 len)
         //    MAC2STR(probe_rsp_ieee80211_ptr->bssid), framectrl, item->ie_len);
     }
 
+    {
+        SCANU_BSS_CB cb;
+        void *cb_arg;
+        GLOBAL_INT_DECLARATION();
+
+        GLOBAL_INT_DISABLE();
+        cb = scan_bss_cb;
+        cb_arg = scan_bss_cb_arg;
+        GLOBAL_INT_RESTORE();
+
+        if (cb)
+            cb(cb_arg, item);
+    }
+
 scan_rst_exit:
 #if CFG_WPA_CTRL_IFACE
     if (ies)
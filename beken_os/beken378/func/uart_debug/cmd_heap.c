@@ -0,0 +1,66 @@
+#include "include.h"
+#include "uart_debug_pub.h"
+#include "cmd_heap.h"
+#include "mem_pub.h"
+#include "str_pub.h"
+#include "tuya_mem_heap.h"
+
+static void cmd_heap_show_state(void)
+{
+    UINT32 i;
+    heap_state_t state;
+
+    tuya_mem_heap_state(0, &state);
+
+    os_printf("total:%d free:%d min_ever_free:%d max_free_block:%d\r\n",
+              state.total_size, state.free_size, state.free_watermark, state.max_free_block_size);
+    os_printf("malloc:%d free:%d fail:%d\r\n",
+              state.malloc_cnt, state.free_cnt, state.fail_cnt);
+    os_printf("free blocks:%d [<=32:%d <=128:%d <=512:%d <=2K:%d <=8K:%d >8K:%d]\r\n",
+              state.free_block_num,
+              state.free_block_hist[0], state.free_block_hist[1], state.free_block_hist[2],
+              state.free_block_hist[3], state.free_block_hist[4], state.free_block_hist[5]);
+
+    for(i = 0; i < state.region_num; i ++)
+    {
+        os_printf("region%d %s total:%d free:%d min_ever_free:%d max_free_block:%d\r\n", i,
+                  (state.region[i].flags & MEM_HEAP_FLAG_FAST) ? "fast" : "normal",
+                  state.region[i].total_size, state.region[i].free_size,
+                  state.region[i].free_watermark, state.region[i].max_free_block_size);
+    }
+}
+
+static void cmd_heap_show_site(void)
+{
+    int i;
+    heap_site_state_t site;
+
+    for(i = 0; 0 == tuya_mem_heap_site_state(i, &site); i ++)
+    {
+        /* wolfssl allocates without a caller name, its sites are told apart by line only */
+        os_printf("%s:%d cur:%d peak:%d malloc:%d\r\n",
+                  site.filename ? site.filename : "?", site.line, site.cur_size, site.peak_size, site.malloc_cnt);
+    }
+
+    if(0 == i)
+    {
+        os_printf("no call site recorded, set OSMALLOC_STATISTICAL to track os_malloc\r\n");
+    }
+}
+
+int do_heap(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+    if((argc > 1) && (0 == os_strcmp(argv[1], "-s")))
+    {
+        cmd_heap_show_site();
+    }
+    else
+    {
+        cmd_heap_show_state();
+    }
+
+    return 0;
+}
+
+// eof
+
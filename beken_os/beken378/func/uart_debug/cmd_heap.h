@@ -0,0 +1,24 @@
+#ifndef _CMD_HEAP_H_
+#define _CMD_HEAP_H_
+
+#include "command_table.h"
+
+extern int do_heap(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[]);
+
+#define CMD_HEAP_MAXARG                     2
+
+#define ENTRY_CMD_HEAP                      \
+	ENTRY_CMD(heap,                         \
+				CMD_HEAP_MAXARG,            \
+				1,                          \
+				do_heap,                    \
+				"heap [-s]\r\n",\
+				"\r\n"\
+				"	print heap telemetry: free, min-ever free, largest block, free block histogram\r\n"\
+				"Options:\r\n"\
+				"     -s                                 per call-site usage of the debug allocator\r\n"\
+				"\r\n")
+
+#endif // _CMD_HEAP_H_
+// eof
+
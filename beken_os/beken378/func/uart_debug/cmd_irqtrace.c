@@ -0,0 +1,92 @@
+#include "include.h"
+#include "uart_debug_pub.h"
+#include "cmd_irqtrace.h"
+#include "mem_pub.h"
+#include "str_pub.h"
+#include "irq_trace_pub.h"
+
+#define CMD_IRQTRACE_DEFAULT_NUM            10
+
+static void cmd_irqtrace_show_hist(const char *name, UINT32 count, UINT32 max_us, UINT32 *hist)
+{
+    os_printf("%s:%d max:%dus [<16us:%d <64us:%d <256us:%d <1ms:%d <4ms:%d <16ms:%d <64ms:%d >=64ms:%d]\r\n",
+              name, count, max_us, hist[0], hist[1], hist[2], hist[3], hist[4], hist[5], hist[6], hist[7]);
+}
+
+static void cmd_irqtrace_show(int num)
+{
+    int i, j, cnt;
+    irq_trace_state_t state;
+    irq_trace_site_t *sites, tmp;
+
+    irq_trace_state(&state);
+    cmd_irqtrace_show_hist("irq masked", state.irq_count, state.irq_max_us, state.irq_hist);
+    cmd_irqtrace_show_hist("sched suspended", state.sched_count, state.sched_max_us, state.sched_hist);
+    if(state.lost)
+    {
+        os_printf("site table full, %d sections not recorded\r\n", state.lost);
+    }
+
+    sites = (irq_trace_site_t *)os_malloc(IRQ_TRACE_SITE_NUM * sizeof(irq_trace_site_t));
+    if(NULL == sites)
+    {
+        os_printf("no memory\r\n");
+        return;
+    }
+
+    for(cnt = 0; (cnt < IRQ_TRACE_SITE_NUM) && (0 == irq_trace_site_state(cnt, &sites[cnt])); cnt ++);
+
+    /* worst first */
+    for(i = 1; i < cnt; i ++)
+    {
+        tmp = sites[i];
+        for(j = i; (j > 0) && (sites[j - 1].max_us < tmp.max_us); j --)
+        {
+            sites[j] = sites[j - 1];
+        }
+        sites[j] = tmp;
+    }
+
+    for(i = 0; (i < cnt) && (i < num); i ++)
+    {
+        if(sites[i].file)
+        {
+            os_printf("%s:%d", sites[i].file, sites[i].line);
+        }
+        else
+        {
+            os_printf("suspend from 0x%08x", sites[i].line);
+        }
+        os_printf(" count:%d max:%dus avg:%dus\r\n", sites[i].count, sites[i].max_us,
+                  (UINT32)(sites[i].total_us / sites[i].count));
+    }
+
+    if(0 == cnt)
+    {
+        os_printf("no call site recorded\r\n");
+    }
+
+    os_free(sites);
+}
+
+int do_irqtrace(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+    int num = CMD_IRQTRACE_DEFAULT_NUM;
+
+    if((argc > 1) && (0 == os_strcmp(argv[1], "-c")))
+    {
+        irq_trace_clear();
+        return 0;
+    }
+
+    if(argc > 1)
+    {
+        num = os_strtoul(argv[1], NULL, 10);
+    }
+
+    cmd_irqtrace_show(num);
+
+    return 0;
+}
+
+// eof
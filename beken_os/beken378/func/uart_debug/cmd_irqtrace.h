@@ -0,0 +1,25 @@
+#ifndef _CMD_IRQTRACE_H_
+#define _CMD_IRQTRACE_H_
+
+#include "command_table.h"
+
+extern int do_irqtrace(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[]);
+
+#define CMD_IRQTRACE_MAXARG                 2
+
+#define ENTRY_CMD_IRQTRACE                  \
+	ENTRY_CMD(irqtrace,                     \
+				CMD_IRQTRACE_MAXARG,        \
+				1,                          \
+				do_irqtrace,                \
+				"irqtrace [-c|n]\r\n",\
+				"\r\n"\
+				"	print masked interrupt and scheduler suspension times and the n worst\r\n"\
+				"	call sites, 10 by default. needs CFG_IRQ_TRACE\r\n"\
+				"Options:\r\n"\
+				"     -c                                 clear the records\r\n"\
+				"\r\n")
+
+#endif // _CMD_IRQTRACE_H_
+// eof
+
@@ -0,0 +1,79 @@
+#include "include.h"
+#include "uart_debug_pub.h"
+#include "cmd_top.h"
+#include "mem_pub.h"
+#include "str_pub.h"
+#include "rtos_pub.h"
+
+#define CMD_TOP_THREAD_MAX              32
+#define CMD_TOP_DEFAULT_MS              1000
+
+static void cmd_top_sort(rtos_thread_stat_t *stats, int num)
+{
+    int i, j;
+    rtos_thread_stat_t tmp;
+
+    for(i = 1; i < num; i ++)
+    {
+        tmp = stats[i];
+        for(j = i; (j > 0) && (stats[j - 1].win_us < tmp.win_us); j --)
+        {
+            stats[j] = stats[j - 1];
+        }
+        stats[j] = tmp;
+    }
+}
+
+int do_top(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+    int i, num;
+    UINT32 ms = CMD_TOP_DEFAULT_MS;
+    uint64_t win_us;
+    rtos_thread_stat_t *stats;
+
+    if(argc > 1)
+    {
+        ms = os_strtoul(argv[1], NULL, 10);
+        if(0 == ms)
+        {
+            ms = CMD_TOP_DEFAULT_MS;
+        }
+    }
+
+    stats = (rtos_thread_stat_t *)os_malloc(CMD_TOP_THREAD_MAX * sizeof(rtos_thread_stat_t));
+    if(NULL == stats)
+    {
+        os_printf("no memory\r\n");
+        return 0;
+    }
+
+    /* restart the window, then measure */
+    rtos_get_thread_stats(NULL, 0, NULL);
+    rtos_delay_milliseconds(ms);
+    num = rtos_get_thread_stats(stats, CMD_TOP_THREAD_MAX, &win_us);
+    if(0 == num)
+    {
+        os_printf("run time stats not available\r\n");
+        os_free(stats);
+        return 0;
+    }
+
+    cmd_top_sort(stats, num);
+
+    os_printf("window %d ms\r\n", (UINT32)(win_us / 1000));
+    os_printf("%-16s Num State Prio    Win%%  Total%%          Run(s)\r\n", "Name");
+    for(i = 0; i < num; i ++)
+    {
+        os_printf("%-16s %3d     %c %4d  %3d.%d%%  %3d.%d%% %10d.%03d\r\n",
+                  stats[i].name, stats[i].number, stats[i].state, stats[i].priority,
+                  stats[i].win_permille / 10, stats[i].win_permille % 10,
+                  stats[i].permille / 10, stats[i].permille % 10,
+                  (UINT32)(stats[i].run_us / 1000000), (UINT32)(stats[i].run_us / 1000 % 1000));
+    }
+
+    os_free(stats);
+
+    return 0;
+}
+
+// eof
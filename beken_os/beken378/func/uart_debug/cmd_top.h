@@ -0,0 +1,23 @@
+#ifndef _CMD_TOP_H_
+#define _CMD_TOP_H_
+
+#include "command_table.h"
+
+extern int do_top(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[]);
+
+#define CMD_TOP_MAXARG                      2
+
+#define ENTRY_CMD_TOP                       \
+	ENTRY_CMD(top,                          \
+				CMD_TOP_MAXARG,             \
+				1,                          \
+				do_top,                     \
+				"top [ms]\r\n",\
+				"\r\n"\
+				"	print the cpu usage of each thread over ms milliseconds, 1000 by default,\r\n"\
+				"	and since the thread was created\r\n"\
+				"\r\n")
+
+#endif // _CMD_TOP_H_
+// eof
+
@@ -6,6 +6,9 @@
 #include "cmd_evm.h"
 #include "cmd_rx_sensitivity.h"
 #include "cmd_reg.h"
+#include "cmd_heap.h"
+#include "cmd_top.h"
+#include "cmd_irqtrace.h"
 
 #if CFG_UART_DEBUG
 cmd_tbl_t command_tbl[] =
@@ -15,6 +18,9 @@ cmd_tbl_t command_tbl[] =
     ENTRY_CMD_RX_SENSITIVITY,
     ENTRY_CMD_HELP,
     ENTRY_CMD_REG,
+    ENTRY_CMD_HEAP,
+    ENTRY_CMD_TOP,
+    ENTRY_CMD_IRQTRACE,
 
     /* last null entry*/
     {NULL,  0, 0, NULLPTR, NULLPTR}
@@ -36,6 +36,8 @@
 #include "ate_app.h"
 #include "BkDriverPwm.h"
 #include "ieee802_11_demo.h"
+#include "rw_msdu.h"
+#include "app.h"
 
 #if CFG_SUPPORT_BOOTLOADER
 #include "wdt_pub.h"
@@ -1043,6 +1045,26 @@ void memory_show_Command(char *pcWriteBuffer, int xWriteBufferLen, int argc, cha
     cmd_printf("free memory %d\r\n", xPortGetFreeHeapSize());
 }
 
+void wlan_stat_Command(char *pcWriteBuffer, int xWriteBufferLen, int argc, char **argv)
+{
+    MSDU_POOL_STATS_T pool;
+    MSDU_TX_STATS_T tx;
+    BUS_MSG_STATS_T bmsg;
+
+    rwm_get_pool_stats(&pool);
+    rwm_get_tx_stats(&tx);
+    bmsg_get_stats(&bmsg);
+
+    cmd_printf("msdu pool: num %d free %d in_use %d max %d hit %d miss %d oversize %d\r\n",
+               CFG_MSDU_POOL_NUM, pool.free_cnt, pool.get_cnt - pool.put_cnt, pool.in_use_max,
+               pool.hit, pool.miss, pool.oversize);
+    cmd_printf("tx: pkts %d ref %d copy %d copy_bytes %d no_node %d\r\n",
+               tx.tx_pkts, tx.tx_ref, tx.tx_copy, tx.tx_copy_bytes, tx.tx_no_node);
+    cmd_printf("core: tx_queued %d wakeups %d fallback %d batches %d batch_max %d rx %d rx_coalesced %d\r\n",
+               bmsg.tx_queued, bmsg.tx_wakeups, bmsg.tx_fallback, bmsg.tx_batches,
+               bmsg.tx_batch_max, bmsg.rx_signals, bmsg.rx_coalesced);
+}
+
 void memory_dump_Command( char *pcWriteBuffer, int xWriteBufferLen, int argc, char **argv )
 {
     int i;
@@ -1552,6 +1574,7 @@ static const struct cli_command built_ins[] =
 
     // others
     {"memshow", "print memory information", memory_show_Command},
+    {"wlanstat", "msdu pool, tx and core thread counters", wlan_stat_Command},
     {"memdump", "<addr> <length>", memory_dump_Command},
     {"os_memset", "<addr> <value 1> [<value 2> ... <value n>]", memory_set_Command},
     //{"memp", "print memp list", memp_dump_Command},
@@ -922,6 +922,15 @@ void bk_wlan_get_scan_ap_result(SCAN_RST_ITEM_PTR scan_rst_table,unsigned char g
 
 
 int bk_wlan_start_assign_scan(UINT8 **ssid_ary, UINT8 ssid_num)
+{
+    return bk_wlan_start_chan_scan(ssid_ary, ssid_num, NULL, 0);
+}
+
+/**
+ * scan for ssid_ary on chans only, ssid_num 0 is a wildcard scan and
+ * chan_num 0 scans all channels.
+ */
+int bk_wlan_start_chan_scan(UINT8 **ssid_ary, UINT8 ssid_num, UINT8 *chans, UINT8 chan_num)
 {
     int ret = 0;
 
@@ -932,12 +941,16 @@ int bk_wlan_start_assign_scan(UINT8 **ssid_ary, UINT8 ssid_num)
 
     os_memset(&scan_param.bssid, 0xff, ETH_ALEN);
 	scan_param.vif_idx = INVALID_VIF_IDX;
-    scan_param.num_ssids = ssid_num;
+    scan_param.num_ssids = ssid_num ? ssid_num : 1;
     for (int i = 0 ; i < ssid_num ; i++ )
     {
         scan_param.ssids[i].length = MIN(SSID_MAX_LEN, os_strlen((char*)ssid_ary[i]));
         os_memcpy(scan_param.ssids[i].array, ssid_ary[i], scan_param.ssids[i].length);
     }
+    for (int i = 0 ; i < MIN(chan_num, sizeof(scan_param.freqs) / sizeof(scan_param.freqs[0])) ; i++ )
+    {
+        scan_param.freqs[i] = rw_ieee80211_get_centre_frequency(chans[i]);
+    }
     rw_msg_send_scanu_req(&scan_param);
 #else
 	wlan_sta_scan_param_t scan_param = {0};
@@ -948,13 +961,18 @@ int bk_wlan_start_assign_scan(UINT8 **ssid_ary, UINT8 ssid_num)
 	/* enable wpa_supplicant */
 	wlan_sta_enable();
 
-	/* set scan ssid list */
-	scan_param.num_ssids = ssid_num;
+	/* set scan ssid list, an empty ssid is the wildcard */
+	scan_param.num_ssids = ssid_num ? ssid_num : 1;
     for (int i = 0 ; i < ssid_num ; i++) {
         scan_param.ssids[i].ssid_len = MIN(WLAN_SSID_MAX_LEN, os_strlen((char*)ssid_ary[i]));
         os_memcpy(scan_param.ssids[i].ssid, ssid_ary[i], scan_param.ssids[i].ssid_len);
     }
 
+	/* set channel list */
+	scan_param.num_chans = MIN(chan_num, sizeof(scan_param.chans));
+	if (scan_param.num_chans)
+		os_memcpy(scan_param.chans, chans, scan_param.num_chans);
+
 	/* start scan */
 	ret = wlan_sta_scan(&scan_param);
 #endif
@@ -14,152 +14,273 @@ static SOCKET_ENTITY socket_entity = {
 
 extern void bmsg_skt_tx_sender(void *arg);
 
-/**
- * append @buf to socket->sk_rx_msg list
+/*
+ * Message descriptors come from a static pool, the heap is only used when the
+ * pool runs dry. The payload is a single os_malloc block that travels with the
+ * descriptor: a receiver may take it over (sk_msg_detach) and hand it on
+ * without another copy. Interrupts are only disabled around list links.
  */
-int ke_sk_send(SOCKET sk, const unsigned char *buf, int len, int flag)
+static SOCKET_MSG sk_msg_pool[SK_MSG_POOL_NUM];
+static struct dl_list sk_msg_free_list = {NULL, NULL};
+
+static int sk_msg_is_pooled(SOCKET_MSG *sk_msg)
 {
-	int ret = 0;
-	unsigned char *data_buf;
-	BK_SOCKET *element;
-	SOCKET_MSG *sk_msg;
+	return (sk_msg >= &sk_msg_pool[0]) && (sk_msg < &sk_msg_pool[SK_MSG_POOL_NUM]);
+}
+
+static SOCKET_MSG *sk_msg_get(void)
+{
+	int i;
+	SOCKET_MSG *sk_msg = NULL;
 	GLOBAL_INT_DECLARATION();
 
-	SK_PRT("ke_tx:%d,buf:0x%x, len:%d\r\n", sk, buf, len);
-	element = sk_get_sk_element(sk);
-	if(0 == element)
+	GLOBAL_INT_DISABLE();
+	if(NULL == sk_msg_free_list.next)
 	{
-		goto tx_exit;
+		dl_list_init(&sk_msg_free_list);
+		for(i = 0; i < SK_MSG_POOL_NUM; i ++)
+		{
+			dl_list_add_tail(&sk_msg_free_list, &sk_msg_pool[i].data);
+		}
 	}
 
-	sk_msg = (SOCKET_MSG *)os_malloc(sizeof(SOCKET_MSG));
+	if(!dl_list_empty(&sk_msg_free_list))
+	{
+		sk_msg = dl_list_first(&sk_msg_free_list, SOCKET_MSG, data);
+		dl_list_del(&sk_msg->data);
+	}
+	GLOBAL_INT_RESTORE();
+
+	if(NULL == sk_msg)
+	{
+		sk_msg = (SOCKET_MSG *)os_malloc(sizeof(SOCKET_MSG));
+	}
+
+	return sk_msg;
+}
+
+static void sk_msg_put(SOCKET_MSG *sk_msg)
+{
+	GLOBAL_INT_DECLARATION();
+
+	if(!sk_msg_is_pooled(sk_msg))
+	{
+		os_free(sk_msg);
+		return;
+	}
+
+	GLOBAL_INT_DISABLE();
+	dl_list_add(&sk_msg_free_list, &sk_msg->data);
+	GLOBAL_INT_RESTORE();
+}
+
+/**
+ * wrap @buf in a descriptor, @buf must be os_malloc'ed and is owned by the
+ * message from now on; it is freed if no descriptor can be had.
+ */
+static SOCKET_MSG *sk_msg_wrap(unsigned char *buf, int len)
+{
+	SOCKET_MSG *sk_msg;
+
+	sk_msg = sk_msg_get();
 	if(0 == sk_msg)
 	{
-		goto tx_exit;
+		os_free(buf);
+		return 0;
 	}
+
+	sk_msg->msg = buf;
+	sk_msg->len = len;
+
+	return sk_msg;
+}
+
+static SOCKET_MSG *sk_msg_dup(const unsigned char *buf, int len)
+{
+	unsigned char *data_buf;
+
 	data_buf = (unsigned char *)os_malloc(len);
 	if(0 == data_buf)
 	{
-		goto malloc_buf_exit;
+		return 0;
 	}
-	ret = len;
-	sk_msg->len = len;
-	sk_msg->msg = data_buf;
+	os_memcpy(data_buf, buf, len);
+
+	return sk_msg_wrap(data_buf, len);
+}
 
-	os_memcpy(sk_msg->msg, buf, len);
+static void sk_msg_enqueue(struct dl_list *queue, SOCKET_MSG *sk_msg)
+{
+	GLOBAL_INT_DECLARATION();
 
 	GLOBAL_INT_DISABLE();
-	dl_list_add_tail(&element->sk_rx_msg, &sk_msg->data);
+	dl_list_add_tail(queue, &sk_msg->data);
 	GLOBAL_INT_RESTORE();
+}
 
-	return ret;
+static SOCKET_MSG *sk_msg_dequeue(struct dl_list *queue)
+{
+	SOCKET_MSG *sk_msg;
+	GLOBAL_INT_DECLARATION();
 
-malloc_buf_exit:
-	os_free(sk_msg);
-	sk_msg = NULL;
+	GLOBAL_INT_DISABLE();
+	sk_msg = dl_list_first(queue, SOCKET_MSG, data);
+	if(sk_msg)
+	{
+		dl_list_del(&sk_msg->data);
+	}
+	GLOBAL_INT_RESTORE();
 
-tx_exit:
-	return ret;
+	return sk_msg;
 }
 
-/**
- * recv buf from socket->sk_tx_msg list.
- */
-int ke_sk_recv(SOCKET sk, const unsigned char *buf, int len, int flag)
+static int sk_msg_peek_len(struct dl_list *queue)
 {
-	int count;
 	int ret = 0;
-	BK_SOCKET *element;
-	SOCKET_MSG *sk_msg, *tmp;
+	SOCKET_MSG *sk_msg;
 	GLOBAL_INT_DECLARATION();
 
-	SK_PRT("ke_rx:%d,buf:0x%x, len:%d\r\n", sk, buf, len);
-	element = sk_get_sk_element(sk);
-	if(0 == element)
+	GLOBAL_INT_DISABLE();
+	sk_msg = dl_list_first(queue, SOCKET_MSG, data);
+	if(sk_msg)
 	{
-		goto rx_exit;
+		ret = sk_msg->len;
 	}
+	GLOBAL_INT_RESTORE();
 
-	GLOBAL_INT_DISABLE();
-	dl_list_for_each_safe(sk_msg, tmp, &element->sk_tx_msg, SOCKET_MSG, data)
+	return ret;
+}
+
+/* copy a dequeued message out to @buf and release it */
+static int sk_msg_copy_out(SOCKET_MSG *sk_msg, const unsigned char *buf, int len)
+{
+	int count;
+
+	if(sk_msg->len > len)
 	{
-		count = MIN(sk_msg->len, len);
+		SK_WPRT("recv_buf_small:%d:%d\r\n", sk_msg->len, len);
+	}
 
-		ASSERT(count);
-		ASSERT(sk_msg);
-		SK_PRT("r1:%d,buf:0x%x, len:%d\r\n", sk, buf, count);
-		os_memcpy((void *)buf, (void *)sk_msg->msg, count);
+	count = MIN(sk_msg->len, len);
+	ASSERT(count);
+	os_memcpy((void *)buf, (void *)sk_msg->msg, count);
+	sk_msg_free(sk_msg);
 
-		ret = count;
+	return count;
+}
 
-		os_free(sk_msg->msg);
-		sk_msg->msg = 0;
-		sk_msg->len = 0;
+/**
+ * take over the payload of @sk_msg, the caller must os_free it.
+ */
+unsigned char *sk_msg_detach(SOCKET_MSG *sk_msg)
+{
+	unsigned char *buf = sk_msg->msg;
 
-		dl_list_del(&sk_msg->data);
-		os_free(sk_msg);
-		sk_msg = 0;
+	sk_msg->msg = 0;
+	return buf;
+}
 
-		break;
+void sk_msg_free(SOCKET_MSG *sk_msg)
+{
+	if(0 == sk_msg)
+	{
+		return;
 	}
 
-	GLOBAL_INT_RESTORE();
-	return ret;
+	if(sk_msg->msg)
+	{
+		os_free(sk_msg->msg);
+		sk_msg->msg = 0;
+	}
+	sk_msg->len = 0;
 
-rx_exit:
-	return 0;
+	sk_msg_put(sk_msg);
 }
 
-int ke_sk_recv_peek_next_payload_size(SOCKET sk)
+/**
+ * append @buf to socket->sk_rx_msg list
+ */
+int ke_sk_send(SOCKET sk, const unsigned char *buf, int len, int flag)
 {
-	int ret = 0;
 	BK_SOCKET *element;
-	SOCKET_MSG *sk_msg, *tmp;
-	GLOBAL_INT_DECLARATION();
+	SOCKET_MSG *sk_msg;
 
+	SK_PRT("ke_tx:%d,buf:0x%x, len:%d\r\n", sk, buf, len);
 	element = sk_get_sk_element(sk);
 	if(0 == element)
 	{
-		goto rx_exit;
+		return 0;
 	}
 
-	GLOBAL_INT_DISABLE();
-	dl_list_for_each_safe(sk_msg, tmp, &element->sk_tx_msg, SOCKET_MSG, data)
+	sk_msg = sk_msg_dup(buf, len);
+	if(0 == sk_msg)
 	{
-		ret = sk_msg->len;
-		break;
+		return 0;
 	}
 
-	GLOBAL_INT_RESTORE();
+	sk_msg_enqueue(&element->sk_rx_msg, sk_msg);
 
-rx_exit:
-	return ret;
+	return len;
 }
 
-int ke_sk_send_peek_next_payload_size(SOCKET sk)
+/**
+ * unlink the next message of socket->sk_tx_msg, the caller owns it and
+ * releases it with sk_msg_free.
+ */
+SOCKET_MSG *ke_sk_recv_msg(SOCKET sk)
 {
-	int ret = 0;
 	BK_SOCKET *element;
-	SOCKET_MSG *sk_msg, *tmp;
-	GLOBAL_INT_DECLARATION();
 
 	element = sk_get_sk_element(sk);
 	if(0 == element)
 	{
-		goto rx_exit;
+		return 0;
 	}
 
-	GLOBAL_INT_DISABLE();
-	dl_list_for_each_safe(sk_msg, tmp, &element->sk_rx_msg, SOCKET_MSG, data)
+	return sk_msg_dequeue(&element->sk_tx_msg);
+}
+
+/**
+ * recv buf from socket->sk_tx_msg list.
+ */
+int ke_sk_recv(SOCKET sk, const unsigned char *buf, int len, int flag)
+{
+	SOCKET_MSG *sk_msg;
+
+	SK_PRT("ke_rx:%d,buf:0x%x, len:%d\r\n", sk, buf, len);
+	sk_msg = ke_sk_recv_msg(sk);
+	if(0 == sk_msg)
 	{
-		ret = sk_msg->len;
-		break;
+		return 0;
 	}
 
-	GLOBAL_INT_RESTORE();
+	return sk_msg_copy_out(sk_msg, buf, len);
+}
 
-rx_exit:
-	return ret;
+int ke_sk_recv_peek_next_payload_size(SOCKET sk)
+{
+	BK_SOCKET *element;
+
+	element = sk_get_sk_element(sk);
+	if(0 == element)
+	{
+		return 0;
+	}
+
+	return sk_msg_peek_len(&element->sk_tx_msg);
+}
+
+int ke_sk_send_peek_next_payload_size(SOCKET sk)
+{
+	BK_SOCKET *element;
+
+	element = sk_get_sk_element(sk);
+	if(0 == element)
+	{
+		return 0;
+	}
+
+	return sk_msg_peek_len(&element->sk_rx_msg);
 }
 
 BK_SOCKET *sk_get_sk_element(SOCKET sk)
@@ -216,109 +337,94 @@ SOCKET fsocket_init(int af, int type, int protocol)
 	return sk;
 }
 
-/*
- *
- */
-int fsocket_send(SOCKET sk, const unsigned char *buf, int len, S_TYPE_PTR type)
+static int fsocket_queue(SOCKET sk, SOCKET_MSG *sk_msg, S_TYPE_PTR type)
 {
-	int ret = 0;
+	int len = sk_msg->len;
 	BK_SOCKET *element;
-	SOCKET_MSG *sk_msg;
-	unsigned char *data_buf;
-	GLOBAL_INT_DECLARATION();
 
-	SK_PRT("hapd_tx:%d,buf:0x%x, len:%d\r\n", sk, buf, len);
 	element = sk_get_sk_element(sk);
 	if(0 == element)
 	{
-		goto tx_exit;
+		sk_msg_free(sk_msg);
+		return 0;
 	}
 
-	sk_msg = (SOCKET_MSG *)os_malloc(sizeof(SOCKET_MSG));
-	if(0 == sk_msg)
-	{
-		goto tx_exit;
-	}
+	sk_msg_enqueue(&element->sk_tx_msg, sk_msg);
+	bmsg_skt_tx_sender(type);
 
-	data_buf = (unsigned char *)os_malloc(len);
-	if(0 == data_buf)
-	{
-		goto malloc_buf_exit;
-	}
-	ret = len;
-	sk_msg->len = len;
-	sk_msg->msg = data_buf;
+	return len;
+}
 
-	os_memcpy(sk_msg->msg, buf, len);
+/*
+ *
+ */
+int fsocket_send(SOCKET sk, const unsigned char *buf, int len, S_TYPE_PTR type)
+{
+	SOCKET_MSG *sk_msg;
 
-	GLOBAL_INT_DISABLE();
-	dl_list_add_tail(&element->sk_tx_msg, &sk_msg->data);
-	GLOBAL_INT_RESTORE();
+	SK_PRT("hapd_tx:%d,buf:0x%x, len:%d\r\n", sk, buf, len);
+	sk_msg = sk_msg_dup(buf, len);
+	if(0 == sk_msg)
+	{
+		return 0;
+	}
 
-	bmsg_skt_tx_sender(type);
+	return fsocket_queue(sk, sk_msg, type);
+}
 
-	return ret;
+/**
+ * same as fsocket_send, but @buf must be os_malloc'ed and is handed over
+ * instead of copied; it is freed by the receiver, or here on failure.
+ */
+int fsocket_send_buf(SOCKET sk, unsigned char *buf, int len, S_TYPE_PTR type)
+{
+	SOCKET_MSG *sk_msg;
 
-malloc_buf_exit:
-	os_free(sk_msg);
+	SK_PRT("hapd_tx:%d,buf:0x%x, len:%d\r\n", sk, buf, len);
+	sk_msg = sk_msg_wrap(buf, len);
+	if(0 == sk_msg)
+	{
+		return 0;
+	}
 
-tx_exit:
-	return ret;
+	return fsocket_queue(sk, sk_msg, type);
 }
 
-int fsocket_recv(SOCKET sk, const unsigned char *buf, int len, int flag)
+/**
+ * unlink the next message of socket->sk_rx_msg, the caller owns it and
+ * releases it with sk_msg_free.
+ */
+SOCKET_MSG *fsocket_recv_msg(SOCKET sk)
 {
-	int count;
-	int ret = 0;
 	BK_SOCKET *element;
-	SOCKET_MSG *sk_msg, *tmp;
-	GLOBAL_INT_DECLARATION();
 
-	SK_PRT("hapd_rx:%d,buf:0x%x, len:%d\r\n", sk, buf, len);
 	element = sk_get_sk_element(sk);
 	if(0 == element)
 	{
-		goto rx_exit;
+		return 0;
 	}
 
-	GLOBAL_INT_DISABLE();
-	dl_list_for_each_safe(sk_msg, tmp, &element->sk_rx_msg, SOCKET_MSG, data)
-	{
-		if(sk_msg->len > len)
-		{
-			SK_WPRT("recv_buf_small:%d:%d\r\n", sk_msg->len, len);
-		}
-
-		count = MIN(sk_msg->len, len);
-
-		ASSERT(count);
-		ASSERT(sk_msg);
-
-		os_memcpy((void *)buf, (void *)sk_msg->msg, count);
-		ret = count;
-
-		os_free(sk_msg->msg);
-		sk_msg->msg = 0;
-		sk_msg->len = 0;
+	return sk_msg_dequeue(&element->sk_rx_msg);
+}
 
-		dl_list_del(&sk_msg->data);
-		os_free(sk_msg);
-		sk_msg = 0;
+int fsocket_recv(SOCKET sk, const unsigned char *buf, int len, int flag)
+{
+	SOCKET_MSG *sk_msg;
 
-		break;
+	SK_PRT("hapd_rx:%d,buf:0x%x, len:%d\r\n", sk, buf, len);
+	sk_msg = fsocket_recv_msg(sk);
+	if(0 == sk_msg)
+	{
+		return 0;
 	}
-	GLOBAL_INT_RESTORE();
-
-	return ret;
 
-rx_exit:
-	return 0;
+	return sk_msg_copy_out(sk_msg, buf, len);
 }
 
 void fsocket_close(SOCKET sk)
 {
 	BK_SOCKET *element;
-	SOCKET_MSG *sk_msg, *tmp;
+	SOCKET_MSG *sk_msg;
 	GLOBAL_INT_DECLARATION();
 
 	SK_PRT("close_sk:%d\r\n", sk);
@@ -329,68 +435,26 @@ void fsocket_close(SOCKET sk)
 	}
 
 	GLOBAL_INT_DISABLE();
-	dl_list_for_each_safe(sk_msg, tmp, &element->sk_tx_msg, SOCKET_MSG, data)
-	{
-		dl_list_del(&sk_msg->data);
-
-		if(sk_msg->msg)
-		{
-			os_free(sk_msg->msg);
-			sk_msg->msg = 0;
-			sk_msg->len = 0;
-		}
+	dl_list_del(&element->sk_element);
+	GLOBAL_INT_RESTORE();
 
-		os_free(sk_msg);
+	while((sk_msg = sk_msg_dequeue(&element->sk_tx_msg)) != 0)
+	{
+		sk_msg_free(sk_msg);
 	}
 
-	dl_list_for_each_safe(sk_msg, tmp, &element->sk_rx_msg, SOCKET_MSG, data)
+	while((sk_msg = sk_msg_dequeue(&element->sk_rx_msg)) != 0)
 	{
-		dl_list_del(&sk_msg->data);
-
-		if(sk_msg->msg)
-		{
-			os_free(sk_msg->msg);
-			sk_msg->msg = 0;
-			sk_msg->len = 0;
-		}
-
-		os_free(sk_msg);
+		sk_msg_free(sk_msg);
 	}
 
-	dl_list_del(&element->sk_element);
-
 	os_free(element);
 	element = 0;
-
-	GLOBAL_INT_RESTORE();
 }
 
 // same as ke_sk_send_peek_next_payload_size
 int fsocket_peek_recv_next_payload_size(SOCKET sk)
 {
-	int ret = 0;
-	BK_SOCKET *element;
-	SOCKET_MSG *sk_msg, *tmp;
-	GLOBAL_INT_DECLARATION();
-
-	element = sk_get_sk_element(sk);
-	if(0 == element)
-	{
-		goto rx_exit;
-	}
-
-	GLOBAL_INT_DISABLE();
-	dl_list_for_each_safe(sk_msg, tmp, &element->sk_rx_msg, SOCKET_MSG, data)
-	{
-		ret = sk_msg->len;
-		break;
-	}
-
-	GLOBAL_INT_RESTORE();
-	return ret;
-
-rx_exit:
-	return 0;
+	return ke_sk_send_peek_next_payload_size(sk);
 }
 // eof
-
@@ -15,6 +15,9 @@
 
 typedef int   SOCKET;
 
+/* preallocated message descriptors, the heap backs them up when exhausted */
+#define SK_MSG_POOL_NUM         16
+
 typedef struct
 {
 	struct dl_list data;
@@ -244,10 +247,15 @@ typedef struct socket_type_st {
 
 extern SOCKET fsocket_init(int af, int type, int protocol);
 extern int fsocket_send(SOCKET sk, const unsigned char *buf, int len, S_TYPE_PTR type);
+extern int fsocket_send_buf(SOCKET sk, unsigned char *buf, int len, S_TYPE_PTR type);
 extern int fsocket_recv(SOCKET sk, const unsigned char *buf, int len, int flag);
+extern SOCKET_MSG *fsocket_recv_msg(SOCKET sk);
 extern void fsocket_close(SOCKET sk);
 extern int ke_sk_send(SOCKET sk, const unsigned char *buf, int len, int flag);
 extern int ke_sk_recv(SOCKET sk, const unsigned char *buf, int len, int flag);
+extern SOCKET_MSG *ke_sk_recv_msg(SOCKET sk);
+extern unsigned char *sk_msg_detach(SOCKET_MSG *sk_msg);
+extern void sk_msg_free(SOCKET_MSG *sk_msg);
 extern BK_SOCKET *sk_get_sk_element(SOCKET sk);
 extern int ke_sk_recv_peek_next_payload_size(SOCKET sk);
 extern int fsocket_peek_recv_next_payload_size(SOCKET sk);
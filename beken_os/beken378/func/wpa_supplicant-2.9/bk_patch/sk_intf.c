@@ -26,34 +26,7 @@ SOCKET data_get_socket_num(u8 vif_idx)
 
 void handle_dummy_read(int sock, void *eloop_ctx, void *sock_ctx)
 {
-    int len;
-    unsigned char *buf;
-
-#ifndef TMP_BUF_LEN
-#define TMP_BUF_LEN    (512)
-#endif
-
-    buf = os_malloc(TMP_BUF_LEN);
-    if(!buf)
-	{
-        os_printf("dummy_read no mem\r\n");
-        goto dummy_exit;
-    }
-
-    len = fsocket_recv(sock, buf, TMP_BUF_LEN, 0);
-    if (len < 0)
-    {
-        wpa_printf(MSG_ERROR, "recv error");
-        goto dummy_exit;
-    }
-
-dummy_exit:
-    if(buf)
-    {
-        os_free(buf);
-    }
-
-    return;
+    sk_msg_free(fsocket_recv_msg(sock));
 }
 
 /*
@@ -85,6 +58,13 @@ int ke_mgmt_packet_rx(unsigned char *buf, int len, int flag)
 	return ke_sk_recv(sk, buf, len, flag);
 }
 
+SOCKET_MSG *ke_mgmt_packet_rx_msg(int flag)
+{
+	SOCKET sk = mgmt_get_socket_num(flag);
+
+	return ke_sk_recv_msg(sk);
+}
+
 int ke_mgmt_peek_txed_next_payload_size(int flag)
 {
 	SOCKET sk = mgmt_get_socket_num(flag);
@@ -125,6 +105,13 @@ int ke_l2_packet_rx(unsigned char *buf, int len, int flag)
 	return ke_sk_recv(sk, buf, len, flag);
 }
 
+SOCKET_MSG *ke_l2_packet_rx_msg(int flag)
+{
+	SOCKET sk = data_get_socket_num(flag);
+
+	return ke_sk_recv_msg(sk);
+}
+
 int ke_data_peek_txed_next_payload_size(int flag)
 {
 	SOCKET sk = data_get_socket_num(flag);
@@ -10,9 +10,11 @@
 
 extern int ke_mgmt_peek_rxed_next_payload_size(int flag);
 extern int ke_mgmt_packet_rx(unsigned char *buf, int len, int flag);
+extern SOCKET_MSG *ke_mgmt_packet_rx_msg(int flag);
 extern int ke_mgmt_packet_tx(unsigned char *buf, int len, int flag);
 extern int ke_l2_packet_tx(unsigned char *buf, int len, int flag);
 extern int ke_l2_packet_rx(unsigned char *buf, int len, int flag);
+extern SOCKET_MSG *ke_l2_packet_rx_msg(int flag);
 extern int ke_data_peek_txed_next_payload_size(int flag);
 extern int ke_data_peek_rxed_next_payload_size(int flag);
 extern int ws_mgmt_peek_rxed_next_payload_size(int flag);
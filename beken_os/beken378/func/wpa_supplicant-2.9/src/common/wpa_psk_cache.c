@@ -5,6 +5,16 @@
 
 #ifdef CONFIG_WPA_PSK_CACHE
 #include "crypto/sha1.h"
+#include "crypto/crypto.h"
+
+#ifdef CONFIG_WPA_PSK_FLASH
+#include "net_param_pub.h"
+#include "drv_model_pub.h"
+#include "sys_ctrl_pub.h"
+#if (FAST_CONNECT_INFO_ENC_METHOD == ENC_METHOD_XOR)
+#include "soft_encrypt.h"
+#endif
+#endif
 
 void start_wpa_psk_cal_thread();
 
@@ -12,6 +22,235 @@ beken_thread_t wpa_pskcalc_thread_handle = NULL;
 
 struct wpa_psk_cache *psk_cache;
 
+#ifdef CONFIG_WPA_PSK_FLASH
+/*
+ * Derived psks are appended to the log slots of the net param sector, so a
+ * reconnect after a reboot skips pbkdf2. A record is only ever programmed
+ * into erased slot bytes; the sector holding the rf calibration is only
+ * erased when the log is full, to compact it. Records are keyed by an hmac
+ * of the ssid and passphrase, the passphrase itself is not stored.
+ */
+#define PSK_FLASH_KEY_LEN	(EFUSE_MAC_START_ADDR + EFUSE_MAC_LEN)
+
+static u8 psk_flash_key[PSK_FLASH_KEY_LEN];
+static int psk_flash_key_read;
+
+/*
+ * the hmac key is the efuse encrypt word, uid and mac of the chip. they are
+ * not in the flash image, so a dump of the log gives no way to test
+ * passphrases against the tags offline.
+ */
+static const u8 *wpa_psk_flash_key(void)
+{
+#if (CFG_SOC_NAME != SOC_BK7231)
+	EFUSE_OPER_ST efuse;
+	int i;
+
+	if (psk_flash_key_read)
+		return psk_flash_key;
+	for (i = 0; i < PSK_FLASH_KEY_LEN; i++) {
+		efuse.addr = EFUSE_ENCRYPT_WORD_ADDR + i;
+		efuse.data = 0xff;
+		/* a read protected byte stays 0xff */
+		sddev_control(SCTRL_DEV_NAME, CMD_EFUSE_READ_BYTE, &efuse);
+		psk_flash_key[i] = efuse.data;
+	}
+	psk_flash_key_read = 1;
+#endif
+	return psk_flash_key;
+}
+
+static void wpa_psk_flash_tag(const u8 *ssid, size_t ssid_len,
+		const char *passphrase, u8 *tag)
+{
+	u8 hash[SHA1_MAC_LEN];
+	u8 len = ssid_len;
+	const u8 *addr[3];
+	size_t alen[3];
+
+	addr[0] = &len;
+	alen[0] = 1;
+	addr[1] = ssid;
+	alen[1] = ssid_len;
+	addr[2] = (const u8 *)passphrase;
+	alen[2] = os_strlen(passphrase);
+	hmac_sha1_vector(wpa_psk_flash_key(), PSK_FLASH_KEY_LEN, 3, addr, alen, hash);
+	os_memcpy(tag, hash, PSK_CACHE_TAG_LEN);
+}
+
+static void wpa_psk_flash_crypt(u8 *psk)
+{
+#if (FAST_CONNECT_INFO_ENC_METHOD == ENC_METHOD_XOR)
+	u8 tmp[PMK_LEN];
+	GLOBAL_INT_DECLARATION();
+
+	/* xor_enc keeps its key position in a global */
+	GLOBAL_INT_DISABLE();
+	xor_enc(psk, tmp, PMK_LEN);
+	GLOBAL_INT_RESTORE();
+	os_memcpy(psk, tmp, PMK_LEN);
+	forced_memzero(tmp, sizeof(tmp));
+#endif
+}
+
+static u32 wpa_psk_flash_check(const PSK_CACHE_REC_ST *rec)
+{
+	const u8 *p = rec->tag;
+	u32 sum = 0;
+	int i;
+
+	for (i = 0; i < PSK_CACHE_TAG_LEN + PMK_LEN; i += 4)
+		sum += WPA_GET_LE32(p + i);
+	return ~sum;
+}
+
+static int wpa_psk_flash_erased(const u8 *p, size_t len)
+{
+	while (len--) {
+		if (*p++ != 0xff)
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * walk the log, returns the newest valid record with tag in rec (any record
+ * if tag is NULL) or -1, and the first erased slot in free_slot (-1 if full)
+ */
+static int wpa_psk_flash_find(const u8 *tag, PSK_CACHE_REC_ST *rec, int *free_slot)
+{
+	PSK_CACHE_REC_ST cur;
+	int slot, found = -1;
+
+	*free_slot = -1;
+	for (slot = 0; slot < NET_PARAM_LOG_SLOTS; slot++) {
+		if (!net_param_log_read(slot, (UINT8 *)&cur))
+			break;
+		if (wpa_psk_flash_erased((u8 *)&cur, sizeof(cur))) {
+			*free_slot = slot;
+			break;
+		}
+		/* a torn write leaves a slot without magic, it stays used */
+		if (cur.magic != PSK_CACHE_REC_MAGIC || cur.check != wpa_psk_flash_check(&cur))
+			continue;
+		if (tag && os_memcmp(cur.tag, tag, PSK_CACHE_TAG_LEN))
+			continue;
+		os_memcpy(rec, &cur, sizeof(cur));
+		found = slot;
+	}
+	forced_memzero(&cur, sizeof(cur));
+	return found;
+}
+
+/* returns 0 and fills psk if it was derived before */
+static int wpa_psk_flash_get(const u8 *ssid, size_t ssid_len,
+		const char *passphrase, u8 *psk)
+{
+	PSK_CACHE_REC_ST rec;
+	u8 tag[PSK_CACHE_TAG_LEN];
+	int free_slot, ret = -1;
+
+	wpa_psk_flash_tag(ssid, ssid_len, passphrase, tag);
+	if (wpa_psk_flash_find(tag, &rec, &free_slot) >= 0) {
+		wpa_psk_flash_crypt(rec.psk);
+		os_memcpy(psk, rec.psk, PMK_LEN);
+		os_printf("PSKC: from flash\n");
+		ret = 0;
+	}
+	forced_memzero(&rec, sizeof(rec));
+	return ret;
+}
+
+/*
+ * rewrites a full log with the newest record of each tag, at most half the
+ * slots so the sector is not erased for every new psk. returns the first
+ * free slot or -1.
+ */
+static int wpa_psk_flash_compact(void)
+{
+	PSK_CACHE_REC_ST *recs, *cur;
+	int slot, i, kept = 0, free_slot = -1;
+
+	recs = os_malloc(NET_PARAM_LOG_SLOTS * sizeof(*recs));
+	if (!recs)
+		return -1;
+
+	/* newest first, the kept records are packed down from the top of recs */
+	for (slot = NET_PARAM_LOG_SLOTS - 1; slot >= 0; slot--) {
+		cur = &recs[slot];
+		if (!net_param_log_read(slot, (UINT8 *)cur))
+			goto out;
+		if (kept == NET_PARAM_LOG_SLOTS / 2)
+			continue;
+		if (cur->magic != PSK_CACHE_REC_MAGIC || cur->check != wpa_psk_flash_check(cur))
+			continue;
+		for (i = NET_PARAM_LOG_SLOTS - kept; i < NET_PARAM_LOG_SLOTS; i++) {
+			if (os_memcmp(recs[i].tag, cur->tag, PSK_CACHE_TAG_LEN) == 0)
+				break;
+		}
+		if (i < NET_PARAM_LOG_SLOTS)
+			continue;
+		kept++;
+		os_memmove(&recs[NET_PARAM_LOG_SLOTS - kept], cur, sizeof(*cur));
+	}
+
+	os_printf("PSKC: flash log compacted to %d\n", kept);
+	if (net_param_log_rewrite((UINT8 *)&recs[NET_PARAM_LOG_SLOTS - kept], kept))
+		free_slot = kept;
+
+out:
+	forced_memzero(recs, NET_PARAM_LOG_SLOTS * sizeof(*recs));
+	os_free(recs);
+	return free_slot;
+}
+
+/* append psk unless the newest record already holds it */
+static void wpa_psk_flash_put(const u8 *ssid, size_t ssid_len,
+		const char *passphrase, const u8 *psk)
+{
+	PSK_CACHE_REC_ST rec, old;
+	int free_slot;
+
+	os_memset(&rec, 0xff, sizeof(rec));
+	wpa_psk_flash_tag(ssid, ssid_len, passphrase, rec.tag);
+	os_memcpy(rec.psk, psk, PMK_LEN);
+	wpa_psk_flash_crypt(rec.psk);
+	rec.check = wpa_psk_flash_check(&rec);
+
+	if (wpa_psk_flash_find(NULL, &old, &free_slot) >= 0 &&
+		os_memcmp(old.tag, rec.tag, PSK_CACHE_TAG_LEN) == 0 &&
+		os_memcmp(old.psk, rec.psk, PMK_LEN) == 0)
+		goto out;
+
+	if (free_slot < 0)
+		free_slot = wpa_psk_flash_compact();
+	if (free_slot < 0) {
+		os_printf("PSKC: flash log full\n");
+		goto out;
+	}
+
+	/* body first, the magic word publishes the record */
+	rec.magic = PSK_CACHE_REC_MAGIC;
+	net_param_log_write(free_slot, 4, (UINT8 *)&rec + 4, sizeof(rec) - 4);
+	net_param_log_write(free_slot, 0, (UINT8 *)&rec.magic, 4);
+
+out:
+	forced_memzero(&rec, sizeof(rec));
+	forced_memzero(&old, sizeof(old));
+}
+#else
+static inline int wpa_psk_flash_get(const u8 *ssid, size_t ssid_len,
+		const char *passphrase, u8 *psk)
+{
+	return -1;
+}
+
+static inline void wpa_psk_flash_put(const u8 *ssid, size_t ssid_len,
+		const char *passphrase, const u8 *psk)
+{
+}
+#endif /* CONFIG_WPA_PSK_FLASH */
+
 void wpa_psk_cache_init()
 {
 	psk_cache = os_zalloc(sizeof(*psk_cache));
@@ -138,6 +377,8 @@ static int ___wpa_psk_cache_add(struct wpa_psk_cache *cache,
 			/* copy calculated psk */
 			os_memcpy(item->psk, psk, psk_len);
 			item->flags = WPA_PSK_CACHE_FLAG_COMPLETE;
+		} else if (!wpa_psk_flash_get(ssid, ssid_len, passphrase, item->psk)) {
+			item->flags = WPA_PSK_CACHE_FLAG_COMPLETE;
 		} else {
 			item->flags = WPA_PSK_CACHE_FLAG_PENDING;
 		}
@@ -223,6 +464,7 @@ void wpa_psk_cal_thread(void *arg)
 			os_printf("PSKC: start\n");
 			pbkdf2_sha1(item->passphrase, (u8 *)item->ssid, item->ssid_len, 4096, item->psk, sizeof(item->psk));
 			os_printf("PSKC: end\n");
+			wpa_psk_flash_put((u8 *)item->ssid, item->ssid_len, item->passphrase, item->psk);
 
 			// requeue to complete list.
 			rtos_get_semaphore(&cache->sema, BEKEN_WAIT_FOREVER);
@@ -319,6 +561,9 @@ int wpa_psk_request(u8 *ssid, size_t ssid_len, char *passphrase, u8 *psk, size_t
 		}
 	}
 
+	if (!complete && !wpa_psk_flash_get(ssid, ssid_len, passphrase, cache->item.psk))
+		complete = 1;
+
 	cache->item.flags = complete ? WPA_PSK_CACHE_FLAG_COMPLETE : WPA_PSK_CACHE_FLAG_PENDING;
 
 	cache->item.ssid = dup_binstr(ssid, ssid_len);
@@ -378,6 +623,9 @@ void wpa_psk_cal_thread(void *arg)
 		}
 		rtos_set_semaphore(&cache->sema);
 
+		if (done)
+			wpa_psk_flash_put((u8 *)ssid, ssid_len, passphrase, psk);
+
 		os_free(ssid);
 		os_free(passphrase);
 
@@ -123,7 +123,11 @@ int sha256_vector(size_t num_elem, const u8 *addr[], const size_t *len, u8 *mac)
 
 void * aes_encrypt_init(const u8 *key, size_t len)
 {
-	mbedtls_aes_context *ctx = os_zalloc(sizeof(*ctx));
+	/* short-lived and hot during key handling, prefer tcm */
+	mbedtls_aes_context *ctx = os_malloc_fast(sizeof(*ctx));
+
+	if (ctx == NULL)
+		return NULL;
 
 	mbedtls_aes_init(ctx);
 
@@ -158,7 +162,10 @@ void aes_encrypt_deinit(void *ctx)
 
 void *aes_decrypt_init(const u8 *key, size_t len)
 {
-	mbedtls_aes_context *ctx = os_zalloc(sizeof(*ctx));
+	mbedtls_aes_context *ctx = os_malloc_fast(sizeof(*ctx));
+
+	if (ctx == NULL)
+		return NULL;
 
 	mbedtls_aes_init(ctx);
 
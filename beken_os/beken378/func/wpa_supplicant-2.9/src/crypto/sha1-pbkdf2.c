@@ -10,23 +10,171 @@
 
 #include "common.h"
 #include "sha1.h"
+#include "crypto.h"
 #include "rtos_pub.h"
 
-static int pbkdf2_sha1_f(const char *passphrase, const u8 *ssid,
-			 size_t ssid_len, int iterations, unsigned int count,
-			 u8 *digest)
+/*
+ * PBKDF2 runs 4096 HMAC-SHA1 per 20 byte block. Going through hmac_sha1()
+ * rehashes the padded key for every HMAC, so each iteration costs four
+ * compressions. Here the states after K ^ ipad and K ^ opad are computed once
+ * and every iteration is two compressions on a message that is always one
+ * 20 byte digest, kept in words so nothing is converted or copied in the loop.
+ */
+
+#define PBKDF2_HMAC_BLOCK	64
+/* bits hashed after the 64 byte key block: one 20 byte digest */
+#define PBKDF2_DIGEST_BITS	((PBKDF2_HMAC_BLOCK + SHA1_MAC_LEN) * 8)
+/* iterations between sleeps that let tasks of the same priority run */
+#define PBKDF2_RELAX_ITER	256
+
+#define rol(value, bits) (((value) << (bits)) | ((value) >> (32 - (bits))))
+
+/* the schedule expands in place over the 16 word block */
+#define blk(i) (w[(i) & 15] = rol(w[((i) + 13) & 15] ^ w[((i) + 8) & 15] ^ \
+	w[((i) + 2) & 15] ^ w[(i) & 15], 1))
+
+#define R0(v,x,y,z,u,i) \
+	u += ((x & (y ^ z)) ^ z) + w[i] + 0x5A827999 + rol(v, 5); x = rol(x, 30);
+#define R1(v,x,y,z,u,i) \
+	u += ((x & (y ^ z)) ^ z) + blk(i) + 0x5A827999 + rol(v, 5); x = rol(x, 30);
+#define R2(v,x,y,z,u,i) \
+	u += (x ^ y ^ z) + blk(i) + 0x6ED9EBA1 + rol(v, 5); x = rol(x, 30);
+#define R3(v,x,y,z,u,i) \
+	u += (((x | y) & z) | (x & y)) + blk(i) + 0x8F1BBCDC + rol(v, 5); \
+	x = rol(x, 30);
+#define R4(v,x,y,z,u,i) \
+	u += (x ^ y ^ z) + blk(i) + 0xCA62C1D6 + rol(v, 5); x = rol(x, 30);
+
+static const u32 pbkdf2_sha1_iv[5] = {
+	0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+};
+
+/* out = compress(in, w), w holds big endian message words and is clobbered */
+static void pbkdf2_sha1_block(u32 out[5], const u32 in[5], u32 w[16])
+{
+	u32 a = in[0], b = in[1], c = in[2], d = in[3], e = in[4];
+
+	R0(a,b,c,d,e, 0); R0(e,a,b,c,d, 1); R0(d,e,a,b,c, 2); R0(c,d,e,a,b, 3);
+	R0(b,c,d,e,a, 4); R0(a,b,c,d,e, 5); R0(e,a,b,c,d, 6); R0(d,e,a,b,c, 7);
+	R0(c,d,e,a,b, 8); R0(b,c,d,e,a, 9); R0(a,b,c,d,e,10); R0(e,a,b,c,d,11);
+	R0(d,e,a,b,c,12); R0(c,d,e,a,b,13); R0(b,c,d,e,a,14); R0(a,b,c,d,e,15);
+	R1(e,a,b,c,d,16); R1(d,e,a,b,c,17); R1(c,d,e,a,b,18); R1(b,c,d,e,a,19);
+	R2(a,b,c,d,e,20); R2(e,a,b,c,d,21); R2(d,e,a,b,c,22); R2(c,d,e,a,b,23);
+	R2(b,c,d,e,a,24); R2(a,b,c,d,e,25); R2(e,a,b,c,d,26); R2(d,e,a,b,c,27);
+	R2(c,d,e,a,b,28); R2(b,c,d,e,a,29); R2(a,b,c,d,e,30); R2(e,a,b,c,d,31);
+	R2(d,e,a,b,c,32); R2(c,d,e,a,b,33); R2(b,c,d,e,a,34); R2(a,b,c,d,e,35);
+	R2(e,a,b,c,d,36); R2(d,e,a,b,c,37); R2(c,d,e,a,b,38); R2(b,c,d,e,a,39);
+	R3(a,b,c,d,e,40); R3(e,a,b,c,d,41); R3(d,e,a,b,c,42); R3(c,d,e,a,b,43);
+	R3(b,c,d,e,a,44); R3(a,b,c,d,e,45); R3(e,a,b,c,d,46); R3(d,e,a,b,c,47);
+	R3(c,d,e,a,b,48); R3(b,c,d,e,a,49); R3(a,b,c,d,e,50); R3(e,a,b,c,d,51);
+	R3(d,e,a,b,c,52); R3(c,d,e,a,b,53); R3(b,c,d,e,a,54); R3(a,b,c,d,e,55);
+	R3(e,a,b,c,d,56); R3(d,e,a,b,c,57); R3(c,d,e,a,b,58); R3(b,c,d,e,a,59);
+	R4(a,b,c,d,e,60); R4(e,a,b,c,d,61); R4(d,e,a,b,c,62); R4(c,d,e,a,b,63);
+	R4(b,c,d,e,a,64); R4(a,b,c,d,e,65); R4(e,a,b,c,d,66); R4(d,e,a,b,c,67);
+	R4(c,d,e,a,b,68); R4(b,c,d,e,a,69); R4(a,b,c,d,e,70); R4(e,a,b,c,d,71);
+	R4(d,e,a,b,c,72); R4(c,d,e,a,b,73); R4(b,c,d,e,a,74); R4(a,b,c,d,e,75);
+	R4(e,a,b,c,d,76); R4(d,e,a,b,c,77); R4(c,d,e,a,b,78); R4(b,c,d,e,a,79);
+
+	out[0] = in[0] + a;
+	out[1] = in[1] + b;
+	out[2] = in[2] + c;
+	out[3] = in[3] + d;
+	out[4] = in[4] + e;
+}
+
+/* the one block message of a 20 byte digest after the key block */
+static void pbkdf2_sha1_digest_msg(u32 w[16], const u32 h[5])
+{
+	w[0] = h[0];
+	w[1] = h[1];
+	w[2] = h[2];
+	w[3] = h[3];
+	w[4] = h[4];
+	w[5] = 0x80000000;
+	w[6] = w[7] = w[8] = w[9] = w[10] = w[11] = w[12] = w[13] = w[14] = 0;
+	w[15] = PBKDF2_DIGEST_BITS;
+}
+
+static void pbkdf2_sha1_load(u32 w[16], const u8 *buf)
+{
+	int i;
+
+	for (i = 0; i < 16; i++)
+		w[i] = WPA_GET_BE32(buf + 4 * i);
+}
+
+/* states after the first block of the inner and outer hash */
+static int pbkdf2_sha1_key(const char *passphrase, u32 istate[5],
+			   u32 ostate[5])
+{
+	u8 pad[PBKDF2_HMAC_BLOCK];
+	u8 tk[SHA1_MAC_LEN];
+	const u8 *key = (const u8 *) passphrase;
+	size_t key_len = os_strlen(passphrase);
+	u32 w[16];
+	size_t i;
+
+	if (key_len > PBKDF2_HMAC_BLOCK) {
+		if (sha1_vector(1, &key, &key_len, tk))
+			return -1;
+		key = tk;
+		key_len = SHA1_MAC_LEN;
+	}
+
+	os_memset(pad, 0, sizeof(pad));
+	os_memcpy(pad, key, key_len);
+	for (i = 0; i < PBKDF2_HMAC_BLOCK; i++)
+		pad[i] ^= 0x36;
+	pbkdf2_sha1_load(w, pad);
+	pbkdf2_sha1_block(istate, pbkdf2_sha1_iv, w);
+
+	for (i = 0; i < PBKDF2_HMAC_BLOCK; i++)
+		pad[i] ^= 0x36 ^ 0x5c;
+	pbkdf2_sha1_load(w, pad);
+	pbkdf2_sha1_block(ostate, pbkdf2_sha1_iv, w);
+
+	forced_memzero(pad, sizeof(pad));
+	forced_memzero(tk, sizeof(tk));
+	forced_memzero(w, sizeof(w));
+	return 0;
+}
+
+/* inner hash of S || INT(count), continued from istate */
+static void pbkdf2_sha1_salt(const u32 istate[5], const u8 *ssid,
+			     size_t ssid_len, unsigned int count, u32 out[5])
 {
-	unsigned char tmp[SHA1_MAC_LEN], tmp2[SHA1_MAC_LEN];
-	int i, j;
-	unsigned char count_buf[4];
-	const u8 *addr[2];
-	size_t len[2];
-	size_t passphrase_len = os_strlen(passphrase);
-
-	addr[0] = ssid;
-	len[0] = ssid_len;
-	addr[1] = count_buf;
-	len[1] = 4;
+	u8 buf[PBKDF2_HMAC_BLOCK];
+	u32 state[5], w[16];
+	size_t msg_len = ssid_len + 4, pos = 0, n;
+	u32 bits = (PBKDF2_HMAC_BLOCK + msg_len) * 8;
+	int last = 0;
+
+	os_memcpy(state, istate, sizeof(state));
+	while (!last) {
+		os_memset(buf, 0, sizeof(buf));
+		for (n = 0; n < PBKDF2_HMAC_BLOCK && pos < msg_len; n++, pos++)
+			buf[n] = pos < ssid_len ? ssid[pos] :
+				(count >> (8 * (3 - (pos - ssid_len)))) & 0xff;
+		if (n < PBKDF2_HMAC_BLOCK && pos == msg_len) {
+			buf[n] = 0x80;
+			pos++;	/* the 0x80 is in */
+		}
+		if (pos > msg_len && n <= PBKDF2_HMAC_BLOCK - 9) {
+			WPA_PUT_BE32(buf + PBKDF2_HMAC_BLOCK - 4, bits);
+			last = 1;
+		}
+		pbkdf2_sha1_load(w, buf);
+		pbkdf2_sha1_block(state, state, w);
+	}
+	os_memcpy(out, state, sizeof(state));
+}
+
+static int pbkdf2_sha1_f(const u32 istate[5], const u32 ostate[5],
+			 const u8 *ssid, size_t ssid_len, int iterations,
+			 unsigned int count, u8 *digest)
+{
+	u32 u[5], inner[5], w[16], t[5];
+	int i;
 
 	/* F(P, S, c, i) = U1 xor U2 xor ... Uc
 	 * U1 = PRF(P, S || i)
@@ -34,32 +182,37 @@ static int pbkdf2_sha1_f(const char *passphrase, const u8 *ssid,
 	 * Uc = PRF(P, Uc-1)
 	 */
 
-	count_buf[0] = (count >> 24) & 0xff;
-	count_buf[1] = (count >> 16) & 0xff;
-	count_buf[2] = (count >> 8) & 0xff;
-	count_buf[3] = count & 0xff;
-	if (hmac_sha1_vector((u8 *) passphrase, passphrase_len, 2, addr, len,
-			     tmp))
-		return -1;
-	os_memcpy(digest, tmp, SHA1_MAC_LEN);
+	pbkdf2_sha1_salt(istate, ssid, ssid_len, count, inner);
+	pbkdf2_sha1_digest_msg(w, inner);
+	pbkdf2_sha1_block(u, ostate, w);
+	os_memcpy(t, u, sizeof(t));
 
 	for (i = 1; i < iterations; i++) {
-		if (hmac_sha1((u8 *) passphrase, passphrase_len, tmp,
-			      SHA1_MAC_LEN, tmp2))
-			return -1;
-		os_memcpy(tmp, tmp2, SHA1_MAC_LEN);
-		for (j = 0; j < SHA1_MAC_LEN; j++)
-			digest[j] ^= tmp2[j];
+		pbkdf2_sha1_digest_msg(w, u);
+		pbkdf2_sha1_block(inner, istate, w);
+		pbkdf2_sha1_digest_msg(w, inner);
+		pbkdf2_sha1_block(u, ostate, w);
+		t[0] ^= u[0];
+		t[1] ^= u[1];
+		t[2] ^= u[2];
+		t[3] ^= u[3];
+		t[4] ^= u[4];
 
 #if defined(CONFIG_WPA_PSK_CACHE) || defined(CONFIG_WPA_PSK_RELAX)
-		/* TODO: change this hard coding 100 */
-		if ((i % 100) == 0) {
+		if ((i % PBKDF2_RELAX_ITER) == 0) {
 			//taskYIELD();
 			rtos_delay_milliseconds(2);
 		}
 #endif
 	}
 
+	for (i = 0; i < 5; i++)
+		WPA_PUT_BE32(digest + 4 * i, t[i]);
+
+	forced_memzero(u, sizeof(u));
+	forced_memzero(inner, sizeof(inner));
+	forced_memzero(w, sizeof(w));
+	forced_memzero(t, sizeof(t));
 	return 0;
 }
 
@@ -85,10 +238,14 @@ int pbkdf2_sha1(const char *passphrase, const u8 *ssid, size_t ssid_len,
 	unsigned char *pos = buf;
 	size_t left = buflen, plen;
 	unsigned char digest[SHA1_MAC_LEN];
+	u32 istate[5], ostate[5];
+
+	if (pbkdf2_sha1_key(passphrase, istate, ostate))
+		return -1;
 
 	while (left > 0) {
 		count++;
-		if (pbkdf2_sha1_f(passphrase, ssid, ssid_len, iterations,
+		if (pbkdf2_sha1_f(istate, ostate, ssid, ssid_len, iterations,
 				  count, digest))
 			return -1;
 		plen = left > SHA1_MAC_LEN ? SHA1_MAC_LEN : left;
@@ -97,5 +254,8 @@ int pbkdf2_sha1(const char *passphrase, const u8 *ssid, size_t ssid_len,
 		left -= plen;
 	}
 
+	forced_memzero(istate, sizeof(istate));
+	forced_memzero(ostate, sizeof(ostate));
+	forced_memzero(digest, sizeof(digest));
 	return 0;
 }
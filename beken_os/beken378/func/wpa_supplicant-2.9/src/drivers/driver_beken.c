@@ -214,33 +214,19 @@ static void handle_frame(struct hostap_driver_data *drv, u8 *buf, size_t len)
 
 static void handle_read(int sock, void *eloop_ctx, void *sock_ctx)
 {
-    int len;
-    unsigned char *buf;
+    SOCKET_MSG *sk_msg;
     struct hostap_driver_data *drv;
 
     drv = eloop_ctx;
-    buf = os_malloc(TMP_BUF_LEN);
-    if(!buf) {
-        os_printf("handle_read no mem\r\n");
-        goto read_exit;
-    }
-
-    len = fsocket_recv(sock, buf, TMP_BUF_LEN, 0);
-    if (len < 0)
+    sk_msg = fsocket_recv_msg(sock);
+    if (!sk_msg)
     {
-        wpa_printf(MSG_ERROR, "recv error");
-        goto read_exit;
+        return;
     }
 
-    handle_frame(drv, buf, len);
-
-read_exit:
-    if(buf)
-    {
-        os_free(buf);
-    }
+    handle_frame(drv, sk_msg->msg, sk_msg->len);
 
-    return;
+    sk_msg_free(sk_msg);
 }
 
 static void handle_eapol(void *ctx, const u8 *src_addr, const u8 *buf, size_t len)
@@ -83,7 +83,9 @@ int __l2_packet_send(struct l2_packet_data *l2, const u8 *dst_addr, u16 proto,
 		type_ptr->args = (void *)&cb;
 	}
 
-	fsocket_send(l2->fd, data_buf, data_len, type_ptr);
+	/* the message takes data_buf over, no copy */
+	fsocket_send_buf(l2->fd, data_buf, data_len, type_ptr);
+	data_buf = NULL;
 	if (sync) {
 		ret = rtos_get_semaphore(&cb.sema, 5*1000 /*BEKEN_NEVER_TIMEOUT*/);
 		if (ret != kNoErr) {
@@ -119,33 +121,28 @@ int l2_packet_send_sync(struct l2_packet_data *l2, const u8 *dst_addr, u16 proto
 
 static void l2_packet_receive(int sock, void *eloop_ctx, void *sock_ctx)
 {
-#define TMP_BUF_LEN     512
-
-	int len;
-	unsigned char *buf;
+	SOCKET_MSG *sk_msg;
 	struct l2_ethhdr *hdr;
 	struct l2_packet_data *l2 = eloop_ctx;
 
-	buf = os_malloc(TMP_BUF_LEN);
-	ASSERT(buf);
+	/* the frame is consumed in place and released afterwards */
+	sk_msg = fsocket_recv_msg(sock);
+	if (sk_msg == NULL)
+		return;
 
-	len = fsocket_recv(sock, buf, TMP_BUF_LEN, 0);
-	if (len < 0) {
+	if (sk_msg->len < (int) sizeof(struct l2_ethhdr)) {
 		wpa_printf(MSG_ERROR, "fsocket_recv_len_err");
 		goto recv_exit;
 	}
 
-	hdr = (struct l2_ethhdr *) buf;
+	hdr = (struct l2_ethhdr *) sk_msg->msg;
 	l2->rx_callback(l2->rx_callback_ctx,
 						hdr->h_source,
-						buf + sizeof(struct l2_ethhdr),
-						len - sizeof(struct l2_ethhdr));
+						sk_msg->msg + sizeof(struct l2_ethhdr),
+						sk_msg->len - sizeof(struct l2_ethhdr));
 
 recv_exit:
-	if(buf)
-		os_free(buf);
-
-	return;
+	sk_msg_free(sk_msg);
 }
 
 extern UINT8 rwm_mgmt_vif_mac2idx(void *mac);
@@ -262,6 +262,9 @@
 /* caculate psk in advance, and store it in memory */
 #define CONFIG_WPA_PSK_CACHE	   1
 
+/* keep derived PSKs in the net param log slots, reconnects after a reboot skip the calculation */
+#define CONFIG_WPA_PSK_FLASH	   1
+
 /* enable multiple PSK cache */
 //#define CONFIG_WPA_PSK_CACHE_MULTI 1
 
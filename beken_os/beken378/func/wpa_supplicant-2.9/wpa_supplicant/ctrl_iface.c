@@ -653,6 +653,25 @@ static int wpas_ctrl_scan(struct wpa_supplicant *wpa_s, wlan_sta_scan_param_t *p
 					  ssid[i].ssid,
 					  ssid[i].ssid_len);
 		}
+
+		/* restrict the scan to the given channels */
+		if (params->num_chans) {
+			int n = params->num_chans;
+
+			if (n > (int) ARRAY_SIZE(params->chans))
+				n = ARRAY_SIZE(params->chans);
+
+			manual_scan_freqs = os_calloc(n + 1, sizeof(int));
+			if (manual_scan_freqs == NULL) {
+				ret = -1;
+				goto done;
+			}
+			for (int i = 0; i < n; i++) {
+				u8 chan = params->chans[i];
+
+				manual_scan_freqs[i] = chan == 14 ? 2484 : 2407 + chan * 5;
+			}
+		}
 	} else {
 		/* do wildcard scan */
 		ssid_count = 1;
@@ -211,6 +211,8 @@ typedef struct wlan_sta_scan_param {
 	uint8_t scan_ssid;    /* Scan SSID of configured network with Probe Requests */
     uint8_t num_ssids;
     wlan_ssid_t ssids[SCAN_SSID_MAX];
+    uint8_t num_chans;    /* 0 for all channels */
+    uint8_t chans[14];    /* 2.4G channels to scan */
 } wlan_sta_scan_param_t;
 
 /**
@@ -171,6 +171,7 @@ void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions ) PRIVILEG
  */
 void *pvPortCalloc( size_t nmemb, size_t size ) PRIVILEGED_FUNCTION;
 void *pvPortRealloc( void *pv, size_t size ) PRIVILEGED_FUNCTION;
+void *pvPortMallocFast( size_t xWantedSize ) PRIVILEGED_FUNCTION;
 #if OSMALLOC_STATISTICAL
 void *pvPortMalloc_cm(const char *call_func_name, int line, size_t xWantedSize, int need_zero) PRIVILEGED_FUNCTION;
 void *vPortFree_cm(const char *call_func_name, int line, void *pv ) PRIVILEGED_FUNCTION;
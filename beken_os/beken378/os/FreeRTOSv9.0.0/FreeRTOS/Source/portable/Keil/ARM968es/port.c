@@ -83,6 +83,9 @@
 #include "rw_pub.h"
 #include "fake_clock_pub.h"
 #include "power_save_pub.h"
+#if CFG_USE_MCU_PS
+#include "mcu_ps_pub.h"
+#endif
 
 #if (NX_POWERSAVE)
 #include "ps.h"
@@ -104,6 +107,9 @@
 	#define abs(x) ((x)>0 ? (x) : -(x))
 #endif
 
+/* Longest sleep the 32k wakeup timer of mcu_power_save() can count. */
+#define portMAX_SUPPRESSED_TICKS		( ( TickType_t ) ( 0x7fffffffUL / ( portTICK_PERIOD_MS * 32 ) ) )
+
 /*-----------------------------------------------------------*/
 
 /* Setup the watchdog to generate the tick interrupts. */
@@ -147,6 +153,51 @@ void vApplicationIdleHook( void )
 	}
 }
 
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TICKLESS_IDLE != 0 )
+/*
+ * Called by the idle task with the scheduler suspended.  mcu_power_save() does
+ * not sleep while a peripheral is busy or an mcu_prevent flag is set, otherwise
+ * it sleeps one tick short of xExpectedIdleTime on the tick timer and returns
+ * the ticks slept.  The tick interrupt left pending by the wakeup accounts for
+ * the last one.
+ */
+void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+{
+#if CFG_USE_MCU_PS
+	TickType_t xMissedTicks;
+	GLOBAL_INT_DECLARATION();
+
+	if( xExpectedIdleTime > portMAX_SUPPRESSED_TICKS )
+	{
+		xExpectedIdleTime = portMAX_SUPPRESSED_TICKS;
+	}
+
+	GLOBAL_INT_DISABLE();
+
+	/* An interrupt readied a task after the idle time was sampled. */
+	if( eTaskConfirmSleepModeStatus() == eAbortSleep )
+	{
+		GLOBAL_INT_RESTORE();
+		return;
+	}
+
+	configPRE_SLEEP_PROCESSING( xExpectedIdleTime );
+	if( xExpectedIdleTime > 0 )
+	{
+		xMissedTicks = mcu_power_save( xExpectedIdleTime );
+		fclk_update_tick( xMissedTicks );
+	}
+	configPOST_SLEEP_PROCESSING( xExpectedIdleTime );
+
+	GLOBAL_INT_RESTORE();
+#else
+	( void ) xExpectedIdleTime;
+#endif
+}
+#endif /* configUSE_TICKLESS_IDLE */
+
 /*-----------------------------------------------------------*/
 /*
  * Initialize the stack of a task to look exactly as if a call to
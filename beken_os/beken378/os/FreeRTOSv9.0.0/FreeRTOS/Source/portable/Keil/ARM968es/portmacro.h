@@ -239,6 +239,16 @@ extern void vTaskSwitchContext( void ); 			\
 	}												\
 }
 
+/* Tickless idle, see vPortSuppressTicksAndSleep() in port.c. */
+extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vPortSuppressTicksAndSleep( xExpectedIdleTime )
+
+/* Run time stats, a free running BKTIMER1 counting 10us units, see rtos_stats.c. */
+extern void rtos_stats_init( void );
+extern unsigned int bk_timer_free_run_get( void );
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() rtos_stats_init()
+#define portGET_RUN_TIME_COUNTER_VALUE() bk_timer_free_run_get()
+
 /* Task function macros as described on the FreeRTOS.org WEB site. */
 #define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void * pvParameters )
 #define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void * pvParameters )
@@ -96,17 +96,23 @@ task.h is included from an application file. */
 
 #include "tuya_mem_heap.h"
 static HEAP_HANDLE s_heap_handle = NULL;
-//static HEAP_HANDLE s_heap_tss_handle = NULL;
+#if (CFG_SOC_NAME == SOC_BK7231N)
+static HEAP_HANDLE s_heap_tcm_handle = NULL;
+#endif
 
 extern void bk_printf(const char *fmt, ...);
 
 /*-----------------------------------------------------------*/
 
 extern unsigned char _empty_ram;
+#if (CFG_SOC_NAME == SOC_BK7231N)
 extern unsigned char _tcmbss_end;
+extern unsigned char _tcm_end;
 
+/* unused tail of the tcm region, after .tcm bss; dtcm and itcm follow it */
 #define TCMBSS_START_ADDRESS (void*)&_tcmbss_end
-#define TCMBSS_END_ADDRESS   (void*)(0x003F0000 + 60*1024 - 512)
+#define TCMBSS_END_ADDRESS   (void*)&_tcm_end
+#endif
 
 #define HEAP_START_ADDRESS    (void*)&_empty_ram
 #if (CFG_SOC_NAME == SOC_BK7231N)
@@ -139,17 +145,41 @@ static void prvHeapInit( void )
         return;
     }
 
-    // ret = tuya_mem_heap_create(TCMBSS_START_ADDRESS, TCMBSS_END_ADDRESS-TCMBSS_START_ADDRESS, &s_heap_tss_handle);
-    // if(0 != ret) {
-    //     bk_printf("--------->heap create tss err:%d", ret);
-    // }
-
     ret = tuya_mem_heap_create(prvHeapGetHeaderPointer(), prvHeapGetTotalSize(), &s_heap_handle);
     if(0 != ret) {
         bk_printf("--------->heap create err:%d", ret);
     }
+
+#if (CFG_SOC_NAME == SOC_BK7231N)
+    if(TCMBSS_END_ADDRESS > TCMBSS_START_ADDRESS) {
+        ret = tuya_mem_heap_create_ex(TCMBSS_START_ADDRESS, TCMBSS_END_ADDRESS - TCMBSS_START_ADDRESS,
+                                      MEM_HEAP_FLAG_FAST, &s_heap_tcm_handle);
+        if(0 != ret) {
+            bk_printf("--------->heap create tcm err:%d", ret);
+        }
+    }
+#endif
 }
 
+#if OSMALLOC_STATISTICAL
+/* every pvPortMalloc/os_malloc caller is a site of the debug allocator, 'heap -s' lists them */
+void *pvPortMalloc_cm(const char *call_func_name, int line, size_t xWantedSize, int need_zero)
+{
+    if(NULL == s_heap_handle) {
+        prvHeapInit();
+    }
+
+    if(xWantedSize == 0) {
+        xWantedSize = 4;
+    }
+
+    if(need_zero) {
+        return tuya_mem_heap_debug_calloc(0, xWantedSize, (char *)call_func_name, line);
+    }
+
+	return tuya_mem_heap_debug_malloc(0, xWantedSize, (char *)call_func_name, line);
+}
+#else
 void *pvPortMalloc( size_t xWantedSize )
 {
     if(NULL == s_heap_handle) {
@@ -162,12 +192,34 @@ void *pvPortMalloc( size_t xWantedSize )
 
 	return tuya_mem_heap_malloc(0, xWantedSize);
 }
+#endif
 
+/* hot, short-lived buffers: served from tcm first, spill into the main heap */
+void *pvPortMallocFast( size_t xWantedSize )
+{
+    if(NULL == s_heap_handle) {
+        prvHeapInit();
+    }
 
+    if(xWantedSize == 0) {
+        xWantedSize = 4;
+    }
+
+	return tuya_mem_heap_malloc_hint(xWantedSize, MEM_HEAP_FLAG_FAST);
+}
+
+#if OSMALLOC_STATISTICAL
+void *vPortFree_cm(const char *call_func_name, int line, void *pv )
+{
+    tuya_mem_heap_free(0, pv);
+    return NULL;
+}
+#else
 void vPortFree( void *pv )
 {
     tuya_mem_heap_free(0, pv);
 }
+#endif
 /*-----------------------------------------------------------*/
 
 size_t xPortGetFreeHeapSize( void )
@@ -178,7 +230,10 @@ size_t xPortGetFreeHeapSize( void )
 
 size_t xPortGetMinimumEverFreeHeapSize( void )
 {
-	return 0;
+    heap_state_t state;
+
+    tuya_mem_heap_state(0, &state);
+	return state.free_watermark;
 }
 /*-----------------------------------------------------------*/
 
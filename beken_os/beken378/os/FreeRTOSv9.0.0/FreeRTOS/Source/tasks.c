@@ -85,6 +85,16 @@ task.h is included from an application file. */
 #include "uart_pub.h"
 #include "tuya_iot_config.h"
 
+#if CFG_IRQ_TRACE
+	/* time each outermost scheduler suspension, keyed by the caller */
+	#include "irq_trace_pub.h"
+	#define traceSCHEDULER_SUSPEND()	irq_trace_suspend_begin( __builtin_return_address( 0 ) )
+	#define traceSCHEDULER_RESUME()		irq_trace_suspend_end()
+#else
+	#define traceSCHEDULER_SUSPEND()
+	#define traceSCHEDULER_RESUME()
+#endif
+
 #define STATIC static
 /* Lint e961 and e750 are suppressed as a MISRA exception justified because the
 MPU ports require MPU_WRAPPERS_INCLUDED_FROM_API_FILE to be defined for the
@@ -1971,6 +1981,11 @@ void vTaskSuspendAll( void )
 	post in the FreeRTOS support forum before reporting this as a bug! -
 	http://goo.gl/wu4acr */
 	++ uxSchedulerSuspended;
+
+	if( uxSchedulerSuspended == ( UBaseType_t ) 1U )
+	{
+		traceSCHEDULER_SUSPEND();
+	}
 }
 /*----------------------------------------------------------*/
 
@@ -2057,6 +2072,8 @@ BaseType_t xAlreadyYielded = pdFALSE;
 
 		if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
 		{
+			traceSCHEDULER_RESUME();
+
 			if( uxCurrentNumberOfTasks > ( UBaseType_t ) 0U )
 			{
 				/* Move any readied tasks from the pending list into the
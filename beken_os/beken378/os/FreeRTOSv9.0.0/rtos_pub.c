@@ -10,6 +10,7 @@
 
 #include "includes.h"
 #include "uart_pub.h"
+#include "bk_timer_pub.h"
 #include "string.h"
 
 /******************************************************
@@ -0,0 +1,238 @@
+#include <string.h>
+
+#include "sys_rtos.h"
+#include "task.h"
+#include "timers.h"
+#include "rtos_pub.h"
+#include "bk_timer_pub.h"
+
+/* task states as shown by vTaskList */
+#define tskBLOCKED_CHAR     ( 'B' )
+#define tskREADY_CHAR       ( 'R' )
+#define tskDELETED_CHAR     ( 'D' )
+#define tskSUSPENDED_CHAR   ( 'S' )
+
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+/*
+ * The kernel keeps a 32 bit run time counter per task in RTOS_STATS_UNIT_US
+ * units, it wraps after about 11.9 hours. Every sample folds the counters into
+ * 64 bit totals kept by task number, the guard timer samples often enough that
+ * no counter can wrap twice between two samples.
+ */
+#define RTOS_STATS_UNIT_US          10
+#define RTOS_STATS_SLOT_NUM         32
+#define RTOS_STATS_TASK_SPARE       4
+#define RTOS_STATS_GUARD_MS         (60 * 60 * 1000)
+
+typedef struct
+{
+    UBaseType_t number;
+    uint32_t last;          /* kernel counter at the previous sample */
+    uint64_t run;
+    uint64_t win_start;     /* run at the previous query */
+    uint8_t used;
+    uint8_t seen;
+} rtos_stats_slot_t;
+
+static rtos_stats_slot_t rtos_stats_slot[RTOS_STATS_SLOT_NUM];
+static uint32_t rtos_stats_last = 0;
+static uint64_t rtos_stats_total = 0;
+static uint64_t rtos_stats_win_start = 0;
+static beken_timer_t rtos_stats_guard;
+
+static uint16_t rtos_stats_permille( uint64_t part, uint64_t total )
+{
+    if ( total == 0 )
+    {
+        return 0;
+    }
+
+    if ( part > total )
+    {
+        part = total;
+    }
+
+    return (uint16_t)( ( part * 1000 + total / 2 ) / total );
+}
+
+static rtos_stats_slot_t *rtos_stats_find( UBaseType_t number )
+{
+    int i;
+
+    for ( i = 0; i < RTOS_STATS_SLOT_NUM; i++ )
+    {
+        if ( rtos_stats_slot[i].used && rtos_stats_slot[i].number == number )
+        {
+            return &rtos_stats_slot[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* must run with the scheduler suspended */
+static void rtos_stats_fold( TaskStatus_t *task, UBaseType_t num, uint32_t total )
+{
+    rtos_stats_slot_t *slot;
+    UBaseType_t x;
+    int i;
+
+    rtos_stats_total += (uint32_t)( total - rtos_stats_last );
+    rtos_stats_last = total;
+
+    for ( i = 0; i < RTOS_STATS_SLOT_NUM; i++ )
+    {
+        rtos_stats_slot[i].seen = 0;
+    }
+
+    for ( x = 0; x < num; x++ )
+    {
+        slot = rtos_stats_find( task[x].xTaskNumber );
+        if ( slot == NULL )
+        {
+            for ( i = 0; i < RTOS_STATS_SLOT_NUM && rtos_stats_slot[i].used; i++ );
+            if ( i == RTOS_STATS_SLOT_NUM )
+            {
+                continue;
+            }
+
+            /* the kernel counter of a new task starts at zero */
+            slot = &rtos_stats_slot[i];
+            memset( slot, 0, sizeof(*slot) );
+            slot->number = task[x].xTaskNumber;
+            slot->used = 1;
+        }
+
+        slot->run += (uint32_t)( task[x].ulRunTimeCounter - slot->last );
+        slot->last = task[x].ulRunTimeCounter;
+        slot->seen = 1;
+    }
+
+    /* deleted tasks */
+    for ( i = 0; i < RTOS_STATS_SLOT_NUM; i++ )
+    {
+        if ( !rtos_stats_slot[i].seen )
+        {
+            rtos_stats_slot[i].used = 0;
+        }
+    }
+}
+
+/* on success the scheduler is left suspended for the caller to read the slots */
+static TaskStatus_t *rtos_stats_sample( UBaseType_t *num )
+{
+    TaskStatus_t *task;
+    UBaseType_t size;
+    uint32_t total;
+
+    size = uxTaskGetNumberOfTasks() + RTOS_STATS_TASK_SPARE;
+    task = pvPortMalloc( size * sizeof(TaskStatus_t) );
+    if ( task == NULL )
+    {
+        return NULL;
+    }
+
+    vTaskSuspendAll();
+    *num = uxTaskGetSystemState( task, size, &total );
+    rtos_stats_fold( task, *num, total );
+
+    return task;
+}
+
+static void rtos_stats_guard_handler( void *arg )
+{
+    TaskStatus_t *task;
+    UBaseType_t num;
+
+    task = rtos_stats_sample( &num );
+    if ( task != NULL )
+    {
+        xTaskResumeAll();
+        vPortFree( task );
+    }
+}
+
+void rtos_stats_init( void )
+{
+    bk_timer_free_run_init( BKTIMER1, RTOS_STATS_UNIT_US );
+
+    /* called by the scheduler start with interrupts off, so do not block */
+    if ( rtos_init_timer( &rtos_stats_guard, RTOS_STATS_GUARD_MS, rtos_stats_guard_handler, NULL ) == kNoErr )
+    {
+        xTimerStart( rtos_stats_guard.handle, 0 );
+    }
+}
+
+int rtos_get_thread_stats( rtos_thread_stat_t *stats, int num, uint64_t *win_us )
+{
+    TaskStatus_t *task;
+    rtos_stats_slot_t *slot;
+    UBaseType_t cnt, x;
+    uint64_t run, win, win_total;
+    int n = 0;
+
+    task = rtos_stats_sample( &cnt );
+    if ( task == NULL )
+    {
+        return 0;
+    }
+
+    win_total = rtos_stats_total - rtos_stats_win_start;
+    rtos_stats_win_start = rtos_stats_total;
+
+    for ( x = 0; x < cnt; x++ )
+    {
+        slot = rtos_stats_find( task[x].xTaskNumber );
+        if ( slot != NULL )
+        {
+            run = slot->run;
+            win = slot->run - slot->win_start;
+            slot->win_start = slot->run;
+        }
+        else
+        {
+            run = task[x].ulRunTimeCounter;
+            win = 0;
+        }
+
+        if ( stats == NULL || n >= num )
+        {
+            continue;
+        }
+
+        strncpy( stats[n].name, task[x].pcTaskName, sizeof(stats[n].name) - 1 );
+        stats[n].name[sizeof(stats[n].name) - 1] = 0;
+        stats[n].number = task[x].xTaskNumber;
+        stats[n].priority = BK_PRIORITY_TO_NATIVE_PRIORITY( (unsigned int)task[x].uxCurrentPriority );
+        switch ( task[x].eCurrentState )
+        {
+            case eRunning:   stats[n].state = 'X'; break;
+            case eReady:     stats[n].state = tskREADY_CHAR; break;
+            case eBlocked:   stats[n].state = tskBLOCKED_CHAR; break;
+            case eSuspended: stats[n].state = tskSUSPENDED_CHAR; break;
+            default:         stats[n].state = tskDELETED_CHAR; break;
+        }
+        stats[n].run_us = run * RTOS_STATS_UNIT_US;
+        stats[n].win_us = win * RTOS_STATS_UNIT_US;
+        stats[n].permille = rtos_stats_permille( run, rtos_stats_total );
+        stats[n].win_permille = rtos_stats_permille( win, win_total );
+        n++;
+    }
+    xTaskResumeAll();
+
+    vPortFree( task );
+
+    if ( win_us != NULL )
+    {
+        *win_us = win_total * RTOS_STATS_UNIT_US;
+    }
+
+    return n;
+}
+#else
+int rtos_get_thread_stats( rtos_thread_stat_t *stats, int num, uint64_t *win_us )
+{
+    return 0;
+}
+#endif
+// eof
@@ -115,9 +115,14 @@
 #define configUSE_STATS_FORMATTING_FUNCTIONS      1
 #define configUSE_ALTERNATIVE_API 		          0
 #define configCHECK_FOR_STACK_OVERFLOW	          2
+/* debug option for the top command, the counter takes BKTIMER1 from tkl_timer */
 #define configGENERATE_RUN_TIME_STATS	          0
 #define configUSE_IDLE_SLEEP_HOOK                 ( 1 )
 
+/* Low power, mcu_power_save() needs more than two ticks to sleep at all */
+#define configUSE_TICKLESS_IDLE                   1
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP     ( 3 )
+
 /* Set the following definitions to 1 to include the API function, or zero
 to exclude the API function. */
 
@@ -53,6 +53,20 @@ typedef void *          beken_thread_t;
 typedef void *          beken_queue_t;
 typedef void *          beken_event_t;        //  OS event: beken_semaphore_t, beken_mutex_t or beken_queue_t
 
+#define RTOS_THREAD_NAME_LEN               16
+
+typedef struct
+{
+    char     name[RTOS_THREAD_NAME_LEN];
+    uint32_t number;                     /**< unique per thread                          */
+    uint32_t priority;
+    char     state;                      /**< X running, R ready, B blocked, S suspended */
+    uint64_t run_us;                     /**< cpu time since the thread was created      */
+    uint64_t win_us;                     /**< cpu time in the window                     */
+    uint16_t permille;                   /**< share of the cpu time since boot           */
+    uint16_t win_permille;               /**< share of the cpu time in the window        */
+} rtos_thread_stat_t;
+
 typedef enum
 {
     WAIT_FOR_ANY_EVENT,
@@ -301,6 +315,19 @@ OSStatus rtos_delay_milliseconds( uint32_t num_ms );
   */
 OSStatus rtos_print_thread_status( char* buffer, int length );
 
+/** @brief    Get the cpu time used by each thread
+  *
+  * @note     Needs configGENERATE_RUN_TIME_STATS, the counter runs on BKTIMER1.
+  *           The window is the time since the previous call.
+  *
+  * @param    stats  : array to fill, may be NULL to only restart the window
+  * @param    num    : capacity of stats
+  * @param    win_us : length of the window in microseconds, may be NULL
+  *
+  * @return   number of entries written, 0 if the statistics are not available
+  */
+int rtos_get_thread_stats( rtos_thread_stat_t *stats, int num, uint64_t *win_us );
+
 /**
   * @}
   */
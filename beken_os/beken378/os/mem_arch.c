@@ -64,6 +64,16 @@ void *os_malloc(size_t size)
     return (void *)pvPortMalloc(size);
 }
 
+void *os_malloc_fast(size_t size)
+{
+    if(platform_is_in_interrupt_context())
+    {
+        os_printf("malloc_fast_risk\r\n");
+    }
+
+    return (void *)pvPortMallocFast(size);
+}
+
 void * os_zalloc(size_t size)
 {
 	void *n = (void *)pvPortMalloc(size);
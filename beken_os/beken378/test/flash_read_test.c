@@ -0,0 +1,189 @@
+/*
+ * host test of flash_read_data() in driver/flash/flash.c on a model of the
+ * sw operate register: a read op keeps BUSY_SW up for one line time, then
+ * the 8 words of the line come out of the data register. every register
+ * access costs one clock of the free running counter, so the irq_trace of
+ * CFG_IRQ_TRACE times the masked sections of the read the way it does on
+ * the target, and the test prints the longest one for a 4 KB read.
+ *
+ * the line time is a model: 8 command, 24 address and 256 data bits on a
+ * single line at 26 MHz, 11 us.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "generic.h"
+#include "sys_rtos.h"
+#include "irq_trace_pub.h"
+#include "bk_timer_pub.h"
+
+#define FAKE_CLK_PER_US     26
+#define FAKE_LINE_CLK       288
+#define FAKE_FLASH_SIZE     0x10000
+
+/* flash.c masks with the CFG_IRQ_TRACE macros of driver/entry/arch.h */
+#define GLOBAL_INT_DECLARATION()   uint32_t irq_tmp
+#define GLOBAL_INT_DISABLE()       do{                                       \
+                                        irq_tmp = int_depth++;               \
+                                        if(!irq_tmp)                         \
+                                        {                                    \
+                                            irq_trace_begin(__FILE__, __LINE__);\
+                                        }                                    \
+                                   }while(0)
+#define GLOBAL_INT_RESTORE()       do{                                       \
+                                        if(!irq_tmp)                         \
+                                        {                                    \
+                                            irq_trace_end();                 \
+                                        }                                    \
+                                        int_depth--;                         \
+                                   }while(0)
+
+/* the registers go to the model below instead of the bus */
+#define _ARM_ARCH_H_
+#define REG_READ(addr)              fake_reg_read(addr)
+#define REG_WRITE(addr, _data)      fake_reg_write((addr), (_data))
+
+static int int_depth;
+static UINT32 fake_reg_read(UINT32 addr);
+static void fake_reg_write(UINT32 addr, UINT32 data);
+
+#include "../driver/flash/flash.c"
+
+static UINT32 fake_now;
+static UINT32 fake_busy_until;
+static UINT32 fake_operate;
+static UINT32 fake_line[8];
+static UINT32 fake_line_pos;
+static UINT32 fake_line_reads;
+static UINT8 fake_flash[FAKE_FLASH_SIZE];
+
+UINT32 bk_timer_free_run_raw(void)
+{
+    return fake_now;
+}
+
+static UINT32 fake_reg_read(UINT32 addr)
+{
+    fake_now ++;
+
+    if(REG_FLASH_OPERATE_SW == addr)
+    {
+        return fake_operate | ((fake_now < fake_busy_until) ? BUSY_SW : 0);
+    }
+
+    if(REG_FLASH_DATA_FLASH_SW == addr)
+    {
+        /* only once the op is done */
+        assert(fake_now >= fake_busy_until);
+        return fake_line[fake_line_pos++ & 7];
+    }
+
+    return 0;
+}
+
+static void fake_reg_write(UINT32 addr, UINT32 data)
+{
+    UINT32 line;
+
+    fake_now ++;
+    if(REG_FLASH_OPERATE_SW != addr)
+    {
+        return;
+    }
+
+    assert(fake_now >= fake_busy_until);
+    fake_operate = data & ~(OP_SW | BUSY_SW);
+    if((data & OP_SW) && (FLASH_OPCODE_READ == ((data >> OP_TYPE_SW_POSI) & OP_TYPE_SW_MASK)))
+    {
+        line = (data >> ADDR_SW_REG_POSI) & ADDR_SW_REG_MASK;
+        assert(0 == (line & 0x1F) && line < FAKE_FLASH_SIZE);
+        memcpy(fake_line, &fake_flash[line], sizeof(fake_line));
+        fake_line_pos = 0;
+        fake_line_reads ++;
+        fake_busy_until = fake_now + FAKE_LINE_CLK;
+    }
+}
+
+/* the rest of flash.c links against these, the read path does not call them */
+void peri_busy_count_add(void) {}
+void peri_busy_count_dec(void) {}
+uint32_t get_ate_mode_state(void) { return 0; }
+UINT32 sddev_control(char *dev_name, UINT32 cmd, void *param) { return 0; }
+UINT32 ddev_register_dev(char *dev_name, DD_OPERATIONS *optr) { return 0; }
+UINT32 ddev_unregister_dev(char *dev_name) { return 0; }
+void bk_printf(const char *fmt, ...) {}
+
+/* random lengths, flash offsets and destination alignments against a plain copy */
+static void test_read(void)
+{
+    UINT8 buf[600 + 8];
+    UINT32 i, r, addr, len, pad;
+
+    for(i = 0; i < FAKE_FLASH_SIZE; i++)
+    {
+        fake_flash[i] = (UINT8)((i * 2654435761u) >> 24);
+    }
+
+    for(r = 0; r < 20000; r++)
+    {
+        len = rand() % 600;
+        addr = rand() % (FAKE_FLASH_SIZE - len);
+        pad = rand() % 4;
+
+        memset(buf, 0xA5, sizeof(buf));
+        flash_read((char *)buf + pad, len, addr);
+        assert(0 == memcmp(buf + pad, &fake_flash[addr], len));
+        for(i = 0; i < pad; i++)
+        {
+            assert(0xA5 == buf[i]);
+        }
+        for(i = pad + len; i < sizeof(buf); i++)
+        {
+            assert(0xA5 == buf[i]);
+        }
+        assert(0 == int_depth);
+    }
+
+    printf("flash_read_test read: ok\n");
+}
+
+/* the masked sections of one 4 KB read as irq_trace sees them */
+static void test_latency(void)
+{
+    static UINT8 buf[4096];
+    irq_trace_state_t state;
+    irq_trace_site_t site;
+    UINT32 start, lines, line_us;
+    int n;
+
+    irq_trace_clear();
+    fake_line_reads = 0;
+    start = fake_now;
+    flash_read((char *)buf, sizeof(buf), 0x1000);
+    assert(0 == memcmp(buf, &fake_flash[0x1000], sizeof(buf)));
+    lines = fake_line_reads;
+    assert(128 == lines);
+
+    irq_trace_state(&state);
+    for(n = 0; irq_trace_site_state(n, &site) == 0; n++)
+    {
+        assert(site.file && strstr(site.file, "flash.c"));
+    }
+
+    /* no masked section spans more than one line */
+    line_us = FAKE_LINE_CLK / FAKE_CLK_PER_US;
+    printf("flash_read_test: 4096 bytes in %u us, %u masked sections, longest %u us, line time %u us\n",
+           (fake_now - start) / FAKE_CLK_PER_US, state.irq_count, state.irq_max_us, line_us);
+    assert(state.irq_max_us <= line_us + 1);
+    assert(state.irq_count >= lines);
+}
+
+int main(void)
+{
+    test_read();
+    test_latency();
+
+    printf("flash_read_test: ok\n");
+    return 0;
+}
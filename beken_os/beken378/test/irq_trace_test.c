@@ -0,0 +1,146 @@
+/*
+ * host test of the histogram buckets and the site table of
+ * func/misc/irq_trace.c, the free running timer is faked below and moves
+ * 26 clocks per us like BKTIMER1.
+ */
+#include <stdio.h>
+#include <assert.h>
+
+#include "irq_trace_pub.h"
+#include "bk_timer_pub.h"
+
+#define FAKE_CLK_PER_US     26
+
+static UINT32 fake_now;
+static const char file_a[] = "a.c";
+static const char file_b[] = "b.c";
+
+UINT32 bk_timer_free_run_raw(void)
+{
+    return fake_now;
+}
+
+static void section(const char *file, int line, UINT32 us)
+{
+    irq_trace_begin(file, line);
+    fake_now += us * FAKE_CLK_PER_US;
+    irq_trace_end();
+}
+
+static void test_bucket(void)
+{
+    static const UINT32 cases[][2] =
+    {
+        {0, 0}, {15, 0}, {16, 1}, {63, 1}, {64, 2}, {255, 2}, {256, 3}, {1023, 3},
+        {1024, 4}, {4095, 4}, {4096, 5}, {16383, 5}, {16384, 6}, {65535, 6},
+        {65536, 7}, {2000000, 7},
+    };
+    irq_trace_state_t state;
+    irq_trace_site_t site;
+    int i;
+
+    for(i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        irq_trace_clear();
+        section(file_a, 1, cases[i][0]);
+
+        irq_trace_state(&state);
+        assert(state.irq_hist[cases[i][1]] == 1);
+        assert(state.irq_max_us == cases[i][0]);
+
+        assert(irq_trace_site_state(0, &site) == 0);
+        assert(site.hist[cases[i][1]] == 1 && site.total_us == cases[i][0]);
+    }
+}
+
+static void test_site(void)
+{
+    irq_trace_state_t state;
+    irq_trace_site_t site;
+    int n;
+
+    irq_trace_clear();
+
+    /* the free running counter wraps inside the section */
+    fake_now = (UINT32)BK_TIMER_FREE_RUN_PERIOD_US * FAKE_CLK_PER_US - 10 * FAKE_CLK_PER_US;
+    irq_trace_begin(file_a, 5);
+    fake_now = 20 * FAKE_CLK_PER_US;
+    irq_trace_end();
+    assert(irq_trace_site_state(0, &site) == 0);
+    assert(site.max_us == 30);
+
+    section(file_a, 5, 100);
+    section(file_b, 5, 7);
+
+    irq_trace_suspend_begin((void *)0x1234);
+    fake_now += 500 * FAKE_CLK_PER_US;
+    irq_trace_suspend_end();
+
+    irq_trace_state(&state);
+    assert(state.irq_count == 3 && state.irq_max_us == 100);
+    assert(state.sched_count == 1 && state.sched_max_us == 500);
+    assert(state.lost == 0);
+
+    for(n = 0; irq_trace_site_state(n, &site) == 0; n++)
+    {
+        if(site.file == file_a)
+        {
+            assert(site.line == 5 && site.count == 2);
+            assert(site.max_us == 100 && site.total_us == 130);
+        }
+        else if(site.file == file_b)
+        {
+            assert(site.count == 1 && site.max_us == 7);
+        }
+        else
+        {
+            /* a scheduler suspension is keyed by the caller */
+            assert(site.file == NULL && site.line == 0x1234);
+            assert(site.count == 1 && site.max_us == 500);
+        }
+    }
+    assert(n == 3);
+}
+
+static void test_site_full(void)
+{
+    irq_trace_state_t state;
+    irq_trace_site_t site;
+    int i, n;
+
+    irq_trace_clear();
+    for(i = 0; i < IRQ_TRACE_SITE_NUM + 5; i++)
+    {
+        section(file_a, 100 + i, 1);
+    }
+
+    irq_trace_state(&state);
+    assert(state.lost == 5 && state.irq_count == IRQ_TRACE_SITE_NUM + 5);
+    for(n = 0; irq_trace_site_state(n, &site) == 0; n++);
+    assert(n == IRQ_TRACE_SITE_NUM);
+
+    /* known sites are still counted */
+    for(i = 0; i < IRQ_TRACE_SITE_NUM; i++)
+    {
+        section(file_a, 100 + i, 2);
+    }
+    for(n = 0; irq_trace_site_state(n, &site) == 0; n++)
+    {
+        assert(site.count == 2 && site.max_us == 2);
+    }
+
+    irq_trace_state(&state);
+    assert(state.lost == 5);
+}
+
+int main(void)
+{
+    test_bucket();
+    test_site();
+    test_site_full();
+
+    printf("irq_trace_test: ok\n");
+
+    return 0;
+}
+// eof
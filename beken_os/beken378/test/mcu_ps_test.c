@@ -0,0 +1,293 @@
+/*
+ * host test of the tick compensation of mcu_power_save() in
+ * func/power_save/mcu_ps.c on the bk7231n timer3 path. the sleep timer and
+ * the wakeup are faked below on a 32k count clock: ps_timer3_enable() hands
+ * back the phase of the tick period it cuts short, the sleep ends early or
+ * when the timer expires, and an expired timer leaves the tick interrupt
+ * pending, which the kernel counts on its own. after every sleep the ticks
+ * the kernel counted must trail the real time by exactly the carry.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+/* the sys_config.h of the bk7231n build */
+#define SOC_BK7231              1
+#define SOC_BK7231U             2
+#define SOC_BK7231N             5
+#define CFG_SOC_NAME            SOC_BK7231N
+#define CFG_USE_MCU_PS          1
+#define CFG_USE_STA_PS          1
+#define NX_POWERSAVE            1
+
+static int int_depth;
+
+#define GLOBAL_INT_DECLARATION()
+#define GLOBAL_INT_DISABLE()    (int_depth++)
+#define GLOBAL_INT_RESTORE()    (int_depth--)
+
+#include "sys_rtos.h"
+#include "../func/power_save/mcu_ps.c"
+
+/* the wakeup takes the 768 us mcu_power_save() puts down as wastage */
+#define FAKE_WAKE_CNT           MCU_PS_US_TO_CNT(768)
+#define FAKE_NO_WAKE            0xffffffffu
+
+static UINT64 fake_now;         /* real time in 32k counts */
+static UINT64 fake_os_tick;     /* ticks the kernel counted */
+static UINT32 fake_phase;       /* counts into the tick period when the idle starts */
+static UINT32 fake_wake_at;     /* counts into the sleep an interrupt wakes the mcu */
+static UINT32 fake_period, fake_slept, fake_sleeps, fake_hooks;
+static UINT8 fake_rf_sleep = 1;
+
+UINT8 ble_switch_mac_sleeped;
+UINT32 use_cal_net;
+
+UINT32 ps_timer3_enable(UINT32 period)
+{
+    assert(int_depth > 0);
+    fake_period = period;
+    fake_sleeps++;
+
+    return fake_phase;
+}
+
+void sctrl_mcu_sleep(UINT32 param)
+{
+    fake_slept = (fake_wake_at < fake_period) ? fake_wake_at : fake_period;
+    fake_now += fake_slept;
+}
+
+UINT32 sctrl_mcu_wakeup(void)
+{
+    fake_now += FAKE_WAKE_CNT;
+    return 1;
+}
+
+void ps_timer3_measure_prepare(void)
+{
+}
+
+/* the tick timer restarts a full period from here */
+UINT32 ps_timer3_disable_cnt(void)
+{
+    fake_phase = 0;
+    return fake_slept;
+}
+
+UINT32 ps_timer3_disable(void)
+{
+    return ps_timer3_disable_cnt() / 32;
+}
+
+UINT8 sctrl_if_mcu_can_sleep(void)
+{
+    return 1;
+}
+
+UINT8 sctrl_if_rf_sleep(void)
+{
+    return fake_rf_sleep;
+}
+
+UINT8 power_save_if_rf_sleep()
+{
+    return 0;
+}
+
+UINT8 power_save_if_ps_rf_dtim_enabled(void)
+{
+    return 0;
+}
+
+bool txl_sleep_check(void)
+{
+    return true;
+}
+
+uint32_t hal_machw_time(void)
+{
+    return 0;
+}
+
+UINT64 fclk_get_tick(void)
+{
+    return fake_os_tick;
+}
+
+UINT32 fclk_update_tick(UINT32 tick)
+{
+    fake_os_tick += tick;
+    return 0;
+}
+
+void sctrl_mcu_init(void)
+{
+}
+
+void sctrl_mcu_exit(void)
+{
+}
+
+void bk_printf(const char *fmt, ...)
+{
+}
+
+static void fake_hook(void)
+{
+    assert(int_depth > 0);
+    fake_hooks++;
+}
+
+/* one idle period as vPortSuppressTicksAndSleep() runs it, returns the ticks mcu_power_save() stepped */
+static UINT32 fake_idle(UINT32 expected, UINT32 wake_at)
+{
+    UINT32 sleeps = fake_sleeps, ticks;
+
+    fake_wake_at = wake_at;
+    ticks = mcu_power_save(expected);
+    assert(int_depth == 0);
+    fclk_update_tick(ticks);
+    if(fake_sleeps != sleeps)
+    {
+        /* the pending tick interrupt of an expired timer */
+        if(fake_slept == fake_period)
+        {
+            fake_os_tick++;
+        }
+        /* the kernel never gets past the tick it expected to wake at */
+        assert(ticks + (fake_slept == fake_period) <= expected);
+    }
+
+    return ticks;
+}
+
+/* run awake for a while, the tick interrupt keeps the kernel in step */
+static void fake_awake(UINT32 ticks, UINT32 phase)
+{
+    fake_now += ticks * MCU_PS_TICK_CNT + phase;
+    fake_os_tick += ticks;
+    fake_phase = phase;
+}
+
+static void fake_reset(void)
+{
+    fake_now = 0;
+    fake_os_tick = 0;
+    fake_phase = 0;
+    mcu_ps_carry_cnt = 0;
+}
+
+static void test_no_sleep(void)
+{
+    UINT32 sleeps = fake_sleeps;
+
+    fake_reset();
+    mcu_ps_enable();
+
+    /* too short to arm the timer */
+    assert(fake_idle(1, FAKE_NO_WAKE) == 0);
+    assert(fake_idle(2, FAKE_NO_WAKE) == 0);
+
+    mcu_prevent_set(MCU_PS_TKL_VOTE);
+    assert(fake_idle(100, FAKE_NO_WAKE) == 0);
+    mcu_prevent_clear(MCU_PS_TKL_VOTE);
+
+    peri_busy_count_add();
+    assert(fake_idle(100, FAKE_NO_WAKE) == 0);
+    peri_busy_count_dec();
+
+    mcu_ps_disable();
+    assert(fake_idle(100, FAKE_NO_WAKE) == 0);
+    mcu_ps_enable();
+
+    assert(fake_sleeps == sleeps && fake_hooks == 0);
+    assert(fake_now == 0 && mcu_ps_carry_cnt == 0);
+}
+
+static void test_carry(void)
+{
+    fake_reset();
+    mcu_ps_enable();
+    mcu_ps_sleep_cb_register(fake_hook, fake_hook);
+
+    /* a timer wakeup one tick early, the pending tick makes up the last one */
+    assert(fake_idle(10, FAKE_NO_WAKE) == 8);
+    assert(fake_period == 9 * MCU_PS_TICK_CNT && fake_os_tick == 9);
+    assert(mcu_ps_carry_cnt == FAKE_WAKE_CNT);
+    assert(fake_now - fake_os_tick * MCU_PS_TICK_CNT == mcu_ps_carry_cnt);
+    assert(fake_hooks == 2);
+
+    /* an early wakeup part way into the third tick, the phase cut short is given back */
+    fake_awake(0, 40);
+    assert(fake_idle(10, 100) == 2);
+    assert(mcu_ps_carry_cnt == 100 + 40 + 2 * FAKE_WAKE_CNT - 2 * MCU_PS_TICK_CNT);
+    assert(fake_now - fake_os_tick * MCU_PS_TICK_CNT == mcu_ps_carry_cnt);
+
+    /* three ticks in the counts, the cap steps two and keeps the rest */
+    fake_awake(1, 63);
+    assert(fake_idle(3, FAKE_NO_WAKE) == 2);
+    assert(mcu_ps_carry_cnt > MCU_PS_TICK_CNT);
+    assert(fake_now - fake_os_tick * MCU_PS_TICK_CNT == mcu_ps_carry_cnt);
+
+    /* and the next sleep hands it over */
+    fake_awake(0, 0);
+    assert(fake_idle(3, 0) == 1);
+    assert(mcu_ps_carry_cnt < MCU_PS_TICK_CNT);
+    assert(fake_now - fake_os_tick * MCU_PS_TICK_CNT == mcu_ps_carry_cnt);
+
+    /* with the rf awake the mac timer corrects the tick instead, nothing is carried */
+    fake_rf_sleep = 0;
+    fake_awake(2, 10);
+    assert(fake_idle(50, FAKE_NO_WAKE) == 0);
+    fake_rf_sleep = 1;
+
+    mcu_ps_sleep_cb_register(NULL, NULL);
+}
+
+/*
+ * random idle lengths as the kernel asks for them, 40% cut short by an
+ * interrupt, a few ticks awake in between. the kernel time trails the real
+ * time by the carry and nothing else, however many sleeps there are, and
+ * by less than a tick after every sleep the cap does not cut short.
+ */
+static void test_random(int rounds)
+{
+    static const UINT32 expected[] = { 3, 4, 5, 10, 50, 250, 1000, 5000 };
+    UINT32 n, period, ticks, max_lag = 0;
+    int r;
+
+    fake_reset();
+    mcu_ps_enable();
+
+    for(r = 0; r < rounds; r++)
+    {
+        n = expected[rand() % (sizeof(expected) / sizeof(expected[0]))];
+        period = (n - 1) * MCU_PS_TICK_CNT;
+        ticks = fake_idle(n, (rand() % 10 < 4) ? (UINT32)rand() % period : FAKE_NO_WAKE);
+
+        assert(fake_now - fake_os_tick * MCU_PS_TICK_CNT == mcu_ps_carry_cnt);
+        assert(ticks == n - 1 || mcu_ps_carry_cnt < MCU_PS_TICK_CNT);
+        if(mcu_ps_carry_cnt > max_lag)
+        {
+            max_lag = mcu_ps_carry_cnt;
+        }
+
+        fake_awake(rand() % 5, rand() % MCU_PS_TICK_CNT);
+    }
+
+    printf("%d idle periods, %u s, kernel behind by %u counts at most\n",
+           rounds, (UINT32)(fake_now / 32768), max_lag);
+}
+
+int main(int argc, char *argv[])
+{
+    srand(argc > 1 ? atoi(argv[1]) : 1);
+
+    test_no_sleep();
+    test_carry();
+    test_random(100000);
+
+    printf("mcu_ps_test: ok\n");
+    return 0;
+}
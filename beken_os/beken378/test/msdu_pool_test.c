@@ -0,0 +1,239 @@
+/*
+ * host test of the tx msdu pool in func/rwnx_intf/rw_msdu_pool.c. the heap is
+ * faked below to see the size of every block and to fail on request: a hit
+ * takes no heap, a miss takes a block of the frame's size and gives it back on
+ * free, and the pool never holds more than CFG_MSDU_POOL_NUM blocks.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <assert.h>
+
+/* the sys_config.h of the build */
+#define CFG_MSDU_RESV_HEAD_LEN  96
+#define CFG_MSDU_RESV_TAIL_LEN  16
+#define CFG_MSDU_POOL_NUM       4
+#define CFG_MSDU_POOL_FRAME_LEN 1536
+
+static int int_depth;
+
+#define GLOBAL_INT_DECLARATION()
+#define GLOBAL_INT_DISABLE()    (int_depth++)
+#define GLOBAL_INT_RESTORE()    (int_depth--)
+#define ASSERT(exp)             assert(exp)
+
+#include "mem_pub.h"
+#undef os_malloc
+#undef os_free
+#define os_malloc               fake_malloc
+#define os_free                 fake_free
+
+static void *fake_malloc(size_t size);
+static void fake_free(void *ptr);
+
+#include "../func/rwnx_intf/rw_msdu_pool.c"
+
+#define FAKE_FRAME_LEN(len)     (sizeof(MSDU_NODE_T) + CFG_MSDU_RESV_HEAD_LEN + (len) + CFG_MSDU_RESV_TAIL_LEN)
+
+static size_t fake_last_size;
+static int fake_blocks, fake_mallocs, fake_frees, fake_fail;
+static int fake_pbuf_frees;
+
+void bk_printf(const char *fmt, ...)
+{
+}
+
+static void *fake_malloc(size_t size)
+{
+    if(fake_fail)
+    {
+        return NULL;
+    }
+
+    fake_last_size = size;
+    fake_mallocs++;
+    fake_blocks++;
+
+    return malloc(size);
+}
+
+static void fake_free(void *ptr)
+{
+    fake_frees++;
+    fake_blocks--;
+    free(ptr);
+}
+
+uint8_t pbuf_free(struct pbuf *p)
+{
+    assert(p->ref > 0);
+    p->ref--;
+    fake_pbuf_frees++;
+
+    return 1;
+}
+
+static void check_stats(UINT32 free_cnt, UINT32 in_use, UINT32 hit, UINT32 miss)
+{
+    MSDU_POOL_STATS_T st;
+
+    rwm_get_pool_stats(&st);
+    assert(st.free_cnt == free_cnt);
+    assert(st.get_cnt - st.put_cnt == in_use);
+    assert(st.hit == hit);
+    assert(st.miss == miss);
+    assert(0 == int_depth);
+}
+
+static void test_init(void)
+{
+    rwm_pool_init();
+    assert(CFG_MSDU_POOL_NUM == fake_mallocs);
+    assert(MSDU_POOL_BUF_LEN == fake_last_size);
+    check_stats(CFG_MSDU_POOL_NUM, 0, 0, 0);
+
+    /* a second init tops up to the same number */
+    rwm_pool_init();
+    assert(CFG_MSDU_POOL_NUM == fake_mallocs);
+}
+
+/* every block the pool has goes out, the frames after that get their own */
+static void test_hit_miss(void)
+{
+    MSDU_NODE_T *node[CFG_MSDU_POOL_NUM];
+    MSDU_NODE_T *miss;
+    struct pbuf p = {0};
+    int i, mallocs = fake_mallocs, frees = fake_frees;
+
+    for(i = 0; i < CFG_MSDU_POOL_NUM; i++)
+    {
+        node[i] = rwm_tx_node_alloc((i & 1) ? CFG_MSDU_POOL_FRAME_LEN : 60);
+        assert(node[i] && node[i]->pooled);
+        assert(node[i]->msdu_ptr == (UINT8 *)node[i] + sizeof(MSDU_NODE_T));
+        assert((NULL == node[i]->pbuf) && (NULL == node[i]->tx_cb));
+    }
+    assert(mallocs == fake_mallocs);
+    check_stats(0, CFG_MSDU_POOL_NUM, CFG_MSDU_POOL_NUM, 0);
+
+    /* the miss takes what the frame needs, not a pool block */
+    miss = rwm_tx_node_alloc(100);
+    assert(miss && !miss->pooled && (100 == miss->len));
+    assert((mallocs + 1 == fake_mallocs) && (FAKE_FRAME_LEN(100) == fake_last_size));
+    check_stats(0, CFG_MSDU_POOL_NUM, CFG_MSDU_POOL_NUM, 1);
+
+    /* and goes back to the heap, not into the pool */
+    miss->pbuf = &p;
+    p.ref = 1;
+    rwm_node_free(miss);
+    assert((frees + 1 == fake_frees) && (1 == fake_pbuf_frees) && (0 == p.ref));
+    check_stats(0, CFG_MSDU_POOL_NUM, CFG_MSDU_POOL_NUM, 1);
+
+    /* no heap left, a miss fails but a returned block is still served */
+    fake_fail = 1;
+    assert(NULL == rwm_tx_node_alloc(100));
+    check_stats(0, CFG_MSDU_POOL_NUM, CFG_MSDU_POOL_NUM, 2);
+    rwm_node_free(node[0]);
+    node[0] = rwm_tx_node_alloc(200);
+    assert(node[0] && node[0]->pooled && (200 == node[0]->len));
+    check_stats(0, CFG_MSDU_POOL_NUM, CFG_MSDU_POOL_NUM + 1, 2);
+    fake_fail = 0;
+
+    for(i = 0; i < CFG_MSDU_POOL_NUM; i++)
+    {
+        rwm_node_free(node[i]);
+    }
+    assert(frees + 1 == fake_frees);
+    check_stats(CFG_MSDU_POOL_NUM, 0, CFG_MSDU_POOL_NUM + 1, 2);
+}
+
+static void test_oversize(void)
+{
+    MSDU_NODE_T *node;
+    MSDU_POOL_STATS_T st;
+
+    node = rwm_tx_node_alloc(CFG_MSDU_POOL_FRAME_LEN + 1);
+    assert(node && !node->pooled);
+    assert(FAKE_FRAME_LEN(CFG_MSDU_POOL_FRAME_LEN + 1) == fake_last_size);
+    rwm_node_free(node);
+
+    /* neither a hit nor a miss, the pool is left alone */
+    rwm_get_pool_stats(&st);
+    assert(1 == st.oversize);
+    check_stats(CFG_MSDU_POOL_NUM, 0, CFG_MSDU_POOL_NUM + 1, 2);
+}
+
+/* a block given back to a full pool goes to the heap, last as the block was never handed out */
+static void test_over_capacity(void)
+{
+    MSDU_NODE_T *extra = (MSDU_NODE_T *)fake_malloc(MSDU_POOL_BUF_LEN);
+    MSDU_POOL_STATS_T before, after;
+    int frees = fake_frees;
+
+    rwm_get_pool_stats(&before);
+    rwm_pool_put(extra);
+    rwm_get_pool_stats(&after);
+    assert(frees + 1 == fake_frees);
+    assert(CFG_MSDU_POOL_NUM == after.free_cnt);
+    assert(before.put_cnt + 1 == after.put_cnt);
+    assert(0 == int_depth);
+}
+
+/* random frame sizes, at most the pool's blocks stay allocated at the end */
+static void test_random(int rounds)
+{
+    MSDU_NODE_T *held[16] = {0};
+    MSDU_POOL_STATS_T st;
+    UINT32 in_use_max = 0, pooled = 0;
+    int r, i;
+
+    for(r = 0; r < rounds; r++)
+    {
+        i = rand() % 16;
+        if(held[i])
+        {
+            pooled -= held[i]->pooled;
+            rwm_node_free(held[i]);
+            held[i] = NULL;
+            continue;
+        }
+
+        held[i] = rwm_tx_node_alloc(1 + rand() % (CFG_MSDU_POOL_FRAME_LEN + 200));
+        assert(held[i]);
+        assert(held[i]->pooled || (FAKE_FRAME_LEN(held[i]->len) == fake_last_size));
+        pooled += held[i]->pooled;
+        in_use_max = (pooled > in_use_max) ? pooled : in_use_max;
+
+        rwm_get_pool_stats(&st);
+        assert(st.free_cnt + pooled == CFG_MSDU_POOL_NUM);
+        assert(st.get_cnt - st.put_cnt == pooled);
+    }
+
+    for(i = 0; i < 16; i++)
+    {
+        if(held[i])
+        {
+            rwm_node_free(held[i]);
+        }
+    }
+
+    rwm_get_pool_stats(&st);
+    assert(CFG_MSDU_POOL_NUM == st.in_use_max);
+    assert(CFG_MSDU_POOL_NUM == in_use_max);
+    assert(CFG_MSDU_POOL_NUM == fake_blocks);
+    check_stats(CFG_MSDU_POOL_NUM, 0, st.hit, st.miss);
+    printf("msdu_pool_test: %u hits, %u misses, %u oversize\n", st.hit, st.miss, st.oversize);
+}
+
+int main(int argc, char *argv[])
+{
+    srand(argc > 1 ? atoi(argv[1]) : 1);
+
+    test_init();
+    test_hit_miss();
+    test_oversize();
+    test_random(20000);
+    test_over_capacity();
+
+    printf("msdu_pool_test: ok\n");
+    return 0;
+}
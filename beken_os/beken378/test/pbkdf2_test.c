@@ -0,0 +1,184 @@
+/*
+ * host test of pbkdf2_sha1 in wpa_supplicant-2.9/src/crypto/sha1-pbkdf2.c:
+ * the RFC 6070 and IEEE 802.11 H.4 vectors, then random passphrases and
+ * ssids against a plain HMAC-SHA1 construction on sha1_vector().
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "includes.h"
+#include "common.h"
+#include "../func/wpa_supplicant-2.9/src/crypto/sha1.h"
+#include "../func/wpa_supplicant-2.9/src/crypto/crypto.h"
+#include "rtos_pub.h"
+
+struct pbkdf2_vector {
+	const char *passphrase;
+	const char *ssid;
+	int iterations;
+	size_t len;
+	const char *hex;
+};
+
+static const struct pbkdf2_vector vectors[] = {
+	/* RFC 6070, the one with embedded NULs does not fit a char * passphrase */
+	{ "password", "salt", 1, 20,
+	  "0c60c80f961f0e71f3a9b524af6012062fe037a6" },
+	{ "password", "salt", 2, 20,
+	  "ea6c014dc72d6f8ccd1ed92ace1d41f0d8de8957" },
+	{ "password", "salt", 4096, 20,
+	  "4b007901b765489abead49d926f721d065a429c1" },
+	{ "passwordPASSWORDpassword", "saltSALTsaltSALTsaltSALTsaltSALTsalt", 4096, 25,
+	  "3d2eec4fe41c849b80c8d83662c0e44a8b291a964cf2f07038" },
+	/* IEEE 802.11 H.4 */
+	{ "password", "IEEE", 4096, 32,
+	  "f42c6fc52df0ebef9ebb4b90b38a5f902e83fe1b135a70e23aed762e9710a12e" },
+	{ "ThisIsAPassword", "ThisIsASSID", 4096, 32,
+	  "0dc0d6eb90555ed6419756b9a15ec3e3209b63df707dd508d14581f8982721af" },
+	{ "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "ZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ", 4096, 32,
+	  "becb93866bb8c3832cb777c2f559807c8c59afcb6eae734885001300a981cc62" },
+};
+
+static int relax_cnt;
+
+OSStatus rtos_delay_milliseconds(uint32_t num_ms)
+{
+	relax_cnt++;
+	return kNoErr;
+}
+
+static void hex2bin(const char *hex, u8 *buf, size_t len)
+{
+	unsigned int v;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		sscanf(hex + 2 * i, "%2x", &v);
+		buf[i] = v;
+	}
+}
+
+/* HMAC-SHA1 of the RFC 2104 text, with nothing precomputed */
+static void ref_hmac_sha1(const u8 *key, size_t key_len, const u8 *msg,
+			  size_t msg_len, u8 *mac)
+{
+	u8 k[64], pad[64], tk[SHA1_MAC_LEN], inner[SHA1_MAC_LEN];
+	const u8 *addr[2];
+	size_t len[2], i;
+
+	if (key_len > 64) {
+		sha1_vector(1, &key, &key_len, tk);
+		key = tk;
+		key_len = SHA1_MAC_LEN;
+	}
+	memset(k, 0, sizeof(k));
+	memcpy(k, key, key_len);
+
+	for (i = 0; i < 64; i++)
+		pad[i] = k[i] ^ 0x36;
+	addr[0] = pad;
+	len[0] = 64;
+	addr[1] = msg;
+	len[1] = msg_len;
+	sha1_vector(2, addr, len, inner);
+
+	for (i = 0; i < 64; i++)
+		pad[i] = k[i] ^ 0x5c;
+	addr[1] = inner;
+	len[1] = SHA1_MAC_LEN;
+	sha1_vector(2, addr, len, mac);
+}
+
+static void ref_pbkdf2_sha1(const char *passphrase, const u8 *ssid,
+			    size_t ssid_len, int iterations, u8 *buf,
+			    size_t buflen)
+{
+	u8 msg[128], u[SHA1_MAC_LEN], t[SHA1_MAC_LEN];
+	unsigned int count;
+	size_t pos = 0, n, i;
+	int it;
+
+	for (count = 1; pos < buflen; count++) {
+		memcpy(msg, ssid, ssid_len);
+		WPA_PUT_BE32(msg + ssid_len, count);
+		ref_hmac_sha1((const u8 *) passphrase, strlen(passphrase), msg,
+			      ssid_len + 4, u);
+		memcpy(t, u, sizeof(t));
+		for (it = 1; it < iterations; it++) {
+			memcpy(msg, u, sizeof(u));
+			ref_hmac_sha1((const u8 *) passphrase, strlen(passphrase),
+				      msg, sizeof(u), u);
+			for (i = 0; i < SHA1_MAC_LEN; i++)
+				t[i] ^= u[i];
+		}
+		n = buflen - pos > SHA1_MAC_LEN ? SHA1_MAC_LEN : buflen - pos;
+		memcpy(buf + pos, t, n);
+		pos += n;
+	}
+}
+
+static void test_vectors(void)
+{
+	u8 out[32], expect[32];
+	size_t i;
+
+	for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+		const struct pbkdf2_vector *v = &vectors[i];
+
+		hex2bin(v->hex, expect, v->len);
+		memset(out, 0xa5, sizeof(out));
+		relax_cnt = 0;
+		assert(pbkdf2_sha1(v->passphrase, (const u8 *) v->ssid,
+				   strlen(v->ssid), v->iterations, out, v->len) == 0);
+		assert(memcmp(out, expect, v->len) == 0);
+		/* nothing written past the requested length */
+		assert(v->len == sizeof(out) || out[v->len] == 0xa5);
+		/* other tasks get to run every 256 iterations of each block */
+		assert(relax_cnt == (int)((v->len + SHA1_MAC_LEN - 1) / SHA1_MAC_LEN) *
+				    ((v->iterations - 1) / 256));
+	}
+}
+
+/*
+ * passphrases up to 100 bytes take the hashed key path past 64, ssids up to
+ * 80 bytes move the salt block across its one and two block layouts
+ */
+static void test_random(int rounds)
+{
+	char passphrase[101];
+	u8 ssid[80], out[64], expect[64];
+	size_t pass_len, ssid_len, len, i;
+	int r, iterations;
+
+	for (r = 0; r < rounds; r++) {
+		pass_len = 1 + rand() % 100;
+		for (i = 0; i < pass_len; i++)
+			passphrase[i] = ' ' + 1 + rand() % 94;
+		passphrase[pass_len] = '\0';
+		ssid_len = rand() % sizeof(ssid);
+		for (i = 0; i < ssid_len; i++)
+			ssid[i] = rand();
+		iterations = 1 + rand() % 40;
+		len = 1 + rand() % sizeof(out);
+
+		assert(pbkdf2_sha1(passphrase, ssid, ssid_len, iterations, out, len) == 0);
+		ref_pbkdf2_sha1(passphrase, ssid, ssid_len, iterations, expect, len);
+		if (memcmp(out, expect, len)) {
+			printf("mismatch: passphrase %zu ssid %zu iterations %d len %zu\n",
+			       pass_len, ssid_len, iterations, len);
+			exit(1);
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	srand(argc > 1 ? atoi(argv[1]) : 1);
+
+	test_vectors();
+	test_random(2000);
+
+	printf("pbkdf2_test: ok\n");
+	return 0;
+}
@@ -0,0 +1,466 @@
+/*
+ * host test of the psk cache in wpa_supplicant-2.9/src/common/wpa_psk_cache.c
+ * with CONFIG_WPA_PSK_FLASH. the net param sector is faked below as NOR
+ * flash, programming only clears bits, and a write can be cut part way: a
+ * cut record is never returned, older records keep resolving, and the info
+ * table below the log is only ever written back as it was when a full log
+ * is compacted.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <assert.h>
+
+#include "includes.h"
+#include "common.h"
+#include "rtos_pub.h"
+
+/* wpa_psk_cache.h and config.h pull in the whole supplicant, the part the cache uses */
+#define __WPA_PSK_CACHE_H_
+#define CONFIG_H
+
+#define CONFIG_WPA_PSK_CACHE            1
+#define CONFIG_WPA_PSK_FLASH            1
+#define ENC_METHOD_XOR                  2
+#define FAST_CONNECT_INFO_ENC_METHOD    ENC_METHOD_XOR
+#define SOC_BK7231                      1
+#define SOC_BK7231N                     7
+#define CFG_SOC_NAME                    SOC_BK7231N
+
+#define PMK_LEN                         32
+#define THD_WPAS_PRIORITY               4
+#define ASSERT(exp)                     assert(exp)
+
+#define WPA_PSK_CACHE_FLAG_PENDING      0x1
+#define WPA_PSK_CACHE_FLAG_COMPLETE     0x2
+
+static int int_depth;
+
+#define GLOBAL_INT_DECLARATION()
+#define GLOBAL_INT_DISABLE()            (int_depth++)
+#define GLOBAL_INT_RESTORE()            (int_depth--)
+
+struct wpa_psk_cache_item {
+	char *ssid;
+	size_t ssid_len;
+	char *passphrase;
+	u8 psk[32];
+	u8 flags;
+};
+
+struct wpa_psk_cache {
+	struct wpa_psk_cache_item item;
+	beken_semaphore_t sema;
+};
+
+struct wpa_ssid {
+	u8 *ssid;
+	size_t ssid_len;
+	char *passphrase;
+	u8 psk[32];
+};
+
+#include "../func/wpa_supplicant-2.9/src/common/wpa_psk_cache.c"
+
+#define TEST_KEY_NUM                    20
+
+static const u8 ieee_psk[PMK_LEN] = {
+	0xf4, 0x2c, 0x6f, 0xc5, 0x2d, 0xf0, 0xeb, 0xef,
+	0x9e, 0xbb, 0x4b, 0x90, 0xb3, 0x8a, 0x5f, 0x90,
+	0x2e, 0x83, 0xfe, 0x1b, 0x13, 0x5a, 0x70, 0xe2,
+	0x3a, 0xed, 0x76, 0x2e, 0x97, 0x10, 0xa1, 0x2e,
+};
+
+struct test_key {
+	u8 ssid[32];
+	size_t ssid_len;
+	char passphrase[64];
+	int stored;
+	int seq;
+	u8 psk[PMK_LEN];
+};
+
+static u8 sector[NET_PARAM_SECTOR_SIZE];
+static u8 table[NET_PARAM_TBL_MAX];
+static u8 efuse[32];
+static int log_writes, log_rewrites, cut_after = -1;
+static jmp_buf cut_jmp;
+
+static int sema_cnt;
+static beken_thread_function_t thread_func;
+
+static struct test_key keys[TEST_KEY_NUM];
+
+void bk_printf(const char *fmt, ...)
+{
+}
+
+OSStatus rtos_init_semaphore(beken_semaphore_t *semaphore, int maxCount)
+{
+	*semaphore = (beken_semaphore_t)&sema_cnt;
+	sema_cnt = 0;
+	return kNoErr;
+}
+
+OSStatus rtos_get_semaphore(beken_semaphore_t *semaphore, uint32_t timeout_ms)
+{
+	assert(sema_cnt == 1);
+	sema_cnt--;
+	return kNoErr;
+}
+
+OSStatus rtos_set_semaphore(beken_semaphore_t *semaphore)
+{
+	assert(sema_cnt == 0);
+	sema_cnt++;
+	return kNoErr;
+}
+
+/* the calculation runs when the test calls run_thread() */
+OSStatus rtos_create_thread(beken_thread_t *thread, uint8_t priority,
+		const char *name, beken_thread_function_t function,
+		uint32_t stack_size, beken_thread_arg_t arg)
+{
+	assert(thread_func == NULL);
+	thread_func = function;
+	*thread = (beken_thread_t)1;
+	return kNoErr;
+}
+
+OSStatus rtos_delete_thread(beken_thread_t *thread)
+{
+	return kNoErr;
+}
+
+OSStatus rtos_delay_milliseconds(uint32_t num_ms)
+{
+	return kNoErr;
+}
+
+char *dup_binstr(const void *src, size_t len)
+{
+	char *res = malloc(len + 1);
+
+	memcpy(res, src, len);
+	res[len] = '\0';
+	return res;
+}
+
+int hexstr2bin(const char *hex, u8 *buf, size_t len)
+{
+	unsigned int v;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (sscanf(hex + 2 * i, "%2x", &v) != 1)
+			return -1;
+		buf[i] = v;
+	}
+	return 0;
+}
+
+UINT32 sddev_control(char *dev_name, UINT32 cmd, VOID *param)
+{
+	EFUSE_OPER_ST *op = param;
+
+	assert(strcmp(dev_name, SCTRL_DEV_NAME) == 0 && cmd == CMD_EFUSE_READ_BYTE);
+	assert(op->addr < sizeof(efuse));
+	op->data = efuse[op->addr];
+	return 0;
+}
+
+const char *wpa_ssid_txt(const u8 *ssid, size_t ssid_len)
+{
+	return "";
+}
+
+UINT32 net_param_log_read(UINT32 slot, UINT8 *buf)
+{
+	if (slot >= NET_PARAM_LOG_SLOTS)
+		return 0;
+	memcpy(buf, &sector[NET_PARAM_TBL_MAX + slot * NET_PARAM_LOG_SLOT_SIZE],
+	       NET_PARAM_LOG_SLOT_SIZE);
+	return 1;
+}
+
+UINT32 net_param_log_write(UINT32 slot, UINT32 offset, UINT8 *buf, UINT32 len)
+{
+	u8 *p = &sector[NET_PARAM_TBL_MAX + slot * NET_PARAM_LOG_SLOT_SIZE + offset];
+	UINT32 i, n;
+
+	assert(slot < NET_PARAM_LOG_SLOTS && offset + len <= NET_PARAM_LOG_SLOT_SIZE);
+	/* the cache only ever programs erased bytes */
+	for (i = 0; i < len; i++)
+		assert(p[i] == 0xff);
+	log_writes++;
+
+	if (cut_after != 0) {
+		if (cut_after > 0)
+			cut_after--;
+		for (i = 0; i < len; i++)
+			p[i] &= buf[i];
+		return 1;
+	}
+
+	/* a cut programs a prefix, the byte after it may get some of its bits */
+	n = rand() % (len + 1);
+	for (i = 0; i < n; i++)
+		p[i] &= buf[i];
+	if (n < len && rand() % 2)
+		p[n] &= buf[n] | (u8)rand();
+	longjmp(cut_jmp, 1);
+	return 0;
+}
+
+/* the sector is erased, the table and the slots given are programmed back */
+UINT32 net_param_log_rewrite(UINT8 *buf, UINT32 count)
+{
+	assert(count <= NET_PARAM_LOG_SLOTS);
+	memset(sector, 0xff, sizeof(sector));
+	memcpy(sector, table, sizeof(table));
+	memcpy(&sector[NET_PARAM_TBL_MAX], buf, count * NET_PARAM_LOG_SLOT_SIZE);
+	log_rewrites++;
+	return 1;
+}
+
+/* the table is rewritten by save_info_item, which empties the log */
+static void flash_reset(void)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(table); i++)
+		table[i] = rand();
+	memcpy(sector, table, sizeof(table));
+	memset(&sector[NET_PARAM_TBL_MAX], 0xff, NET_PARAM_SECTOR_SIZE - NET_PARAM_TBL_MAX);
+}
+
+static int flash_free_slots(void)
+{
+	PSK_CACHE_REC_ST rec;
+	int slot, n = 0;
+
+	for (slot = 0; slot < NET_PARAM_LOG_SLOTS; slot++) {
+		net_param_log_read(slot, (UINT8 *)&rec);
+		n += wpa_psk_flash_erased((u8 *)&rec, sizeof(rec));
+	}
+	return n;
+}
+
+/* a reboot, only the flash is left */
+static void reboot(void)
+{
+	if (psk_cache) {
+		free(psk_cache->item.ssid);
+		free(psk_cache->item.passphrase);
+		free(psk_cache);
+	}
+	thread_func = NULL;
+	wpa_pskcalc_thread_handle = NULL;
+	wpa_psk_cache_init();
+	assert(psk_cache && sema_cnt == 1);
+}
+
+static void run_thread(void)
+{
+	beken_thread_function_t func = thread_func;
+
+	assert(func);
+	thread_func = NULL;
+	func(NULL);
+	assert(wpa_pskcalc_thread_handle == NULL && int_depth == 0);
+}
+
+static void test_request(void)
+{
+	u8 ssid[] = "IEEE";
+	u8 psk[PMK_LEN];
+	PSK_CACHE_REC_ST rec;
+
+	flash_reset();
+	reboot();
+
+	/* nothing in flash, the calculation is started */
+	assert(wpa_psk_request(ssid, 4, "password", NULL, 0) == 0);
+	assert(thread_func);
+	assert(__wpa_get_psk_from_cache(ssid, 4, "password", psk, sizeof(psk)) == 1);
+	assert(wpa_psk_request(ssid, 4, "password", NULL, 0) == 1);
+	run_thread();
+	assert(__wpa_get_psk_from_cache(ssid, 4, "password", psk, sizeof(psk)) == 0);
+	assert(memcmp(psk, ieee_psk, PMK_LEN) == 0);
+
+	/* one record, the psk obfuscated and no trace of the passphrase */
+	assert(flash_free_slots() == NET_PARAM_LOG_SLOTS - 1);
+	net_param_log_read(0, (UINT8 *)&rec);
+	assert(rec.magic == PSK_CACHE_REC_MAGIC);
+	assert(memcmp(rec.psk, ieee_psk, PMK_LEN) != 0);
+	assert(memmem(sector, sizeof(sector), "password", 8) == NULL);
+	assert(memcmp(sector, table, sizeof(table)) == 0);
+
+	/* after a reboot the psk comes from flash, nothing is calculated */
+	reboot();
+	assert(wpa_psk_request(ssid, 4, "password", NULL, 0) == 0);
+	assert(thread_func == NULL);
+	memset(psk, 0, sizeof(psk));
+	assert(__wpa_get_psk_from_cache(ssid, 4, "password", psk, sizeof(psk)) == 0);
+	assert(memcmp(psk, ieee_psk, PMK_LEN) == 0);
+
+	/* another passphrase of the same ssid is not a hit */
+	assert(wpa_psk_request(ssid, 4, "passw0rd", NULL, 0) == 0);
+	assert(thread_func);
+	run_thread();
+	assert(flash_free_slots() == NET_PARAM_LOG_SLOTS - 2);
+	assert(__wpa_get_psk_from_cache(ssid, 4, "passw0rd", psk, sizeof(psk)) == 0);
+	assert(memcmp(psk, ieee_psk, PMK_LEN) != 0);
+
+	/* the tag is keyed by the efuse, the same log on another chip is no hit */
+	efuse[17] ^= 1;
+	psk_flash_key_read = 0;
+	assert(wpa_psk_flash_get(ssid, 4, "password", psk) < 0);
+	efuse[17] ^= 1;
+	psk_flash_key_read = 0;
+	assert(wpa_psk_flash_get(ssid, 4, "password", psk) == 0);
+	assert(memcmp(psk, ieee_psk, PMK_LEN) == 0);
+}
+
+static void check_keys(void)
+{
+	u8 psk[PMK_LEN];
+	int i;
+
+	for (i = 0; i < TEST_KEY_NUM; i++) {
+		if (!keys[i].stored) {
+			assert(wpa_psk_flash_get(keys[i].ssid, keys[i].ssid_len,
+						 keys[i].passphrase, psk) < 0);
+			continue;
+		}
+		assert(wpa_psk_flash_get(keys[i].ssid, keys[i].ssid_len,
+					 keys[i].passphrase, psk) == 0);
+		assert(memcmp(psk, keys[i].psk, PMK_LEN) == 0);
+	}
+	assert(memcmp(sector, table, sizeof(table)) == 0);
+	assert(int_depth == 0);
+}
+
+/*
+ * the last used slot holds a valid record of k, the one just put or one
+ * that was already the newest in the log
+ */
+static int newest(struct test_key *k)
+{
+	PSK_CACHE_REC_ST rec;
+	u8 tag[PSK_CACHE_TAG_LEN];
+	int free_slot;
+
+	wpa_psk_flash_tag(k->ssid, k->ssid_len, k->passphrase, tag);
+	return wpa_psk_flash_find(NULL, &rec, &free_slot) == NET_PARAM_LOG_SLOTS - flash_free_slots() - 1 &&
+	       memcmp(rec.tag, tag, PSK_CACHE_TAG_LEN) == 0;
+}
+
+/*
+ * a full log was compacted: the newest record of each key is kept, at most
+ * half the slots of them, the keys written longest ago go. returns how many
+ * are kept.
+ */
+static int compacted(void)
+{
+	int i, j, newer, kept = 0;
+
+	for (i = 0; i < TEST_KEY_NUM; i++) {
+		if (!keys[i].stored)
+			continue;
+		newer = 0;
+		for (j = 0; j < TEST_KEY_NUM; j++)
+			newer += keys[j].stored && keys[j].seq > keys[i].seq;
+		if (newer < NET_PARAM_LOG_SLOTS / 2)
+			kept++;
+		else
+			keys[i].stored = 0;
+	}
+	return kept;
+}
+
+/* random puts of a few keys with new psks, some of them cut */
+static void test_log(int rounds)
+{
+	struct test_key *k;
+	u8 psk[PMK_LEN], got[PMK_LEN];
+	int r, i, writes, rewrites, free_slots, cuts = 0, full = 0;
+
+	flash_reset();
+	memset(keys, 0, sizeof(keys));
+	for (i = 0; i < TEST_KEY_NUM; i++) {
+		keys[i].ssid_len = 1 + rand() % 32;
+		for (r = 0; r < (int)keys[i].ssid_len; r++)
+			keys[i].ssid[r] = rand();
+		snprintf(keys[i].passphrase, sizeof(keys[i].passphrase), "pass%d-%d", i, rand());
+	}
+
+	for (r = 0; r < rounds; r++) {
+		k = &keys[rand() % TEST_KEY_NUM];
+		for (i = 0; i < PMK_LEN; i++)
+			psk[i] = rand();
+		if (k->stored && rand() % 4 == 0)
+			memcpy(psk, k->psk, PMK_LEN);
+
+		free_slots = flash_free_slots();
+		writes = log_writes;
+		rewrites = log_rewrites;
+		cut_after = rand() % 3 ? -1 : rand() % 2;
+		if (setjmp(cut_jmp)) {
+			cut_after = -1;
+			cuts++;
+			if (log_rewrites != rewrites)
+				compacted();
+			/* the new psk or nothing new, never a torn one */
+			if (newest(k) && wpa_psk_flash_get(k->ssid, k->ssid_len, k->passphrase, got) == 0 &&
+			    memcmp(got, psk, PMK_LEN) == 0) {
+				k->stored = 1;
+				k->seq = r;
+				memcpy(k->psk, psk, PMK_LEN);
+			}
+			check_keys();
+			continue;
+		}
+		wpa_psk_flash_put(k->ssid, k->ssid_len, k->passphrase, psk);
+		cut_after = -1;
+
+		if (log_rewrites != rewrites) {
+			assert(free_slots == 0 && log_rewrites == rewrites + 1);
+			assert(log_writes == writes + 2);
+			assert(flash_free_slots() == NET_PARAM_LOG_SLOTS - compacted() - 1);
+			full++;
+		} else {
+			assert(log_writes == writes + 2 || log_writes == writes);
+			assert(flash_free_slots() == free_slots - (log_writes - writes) / 2);
+		}
+		if (log_writes == writes) {
+			/* the newest record already held it */
+			assert(k->stored && memcmp(k->psk, psk, PMK_LEN) == 0);
+			check_keys();
+			continue;
+		}
+		k->stored = 1;
+		k->seq = r;
+		memcpy(k->psk, psk, PMK_LEN);
+		check_keys();
+
+		/* the newest record already holds it, nothing is written */
+		writes = log_writes;
+		wpa_psk_flash_put(k->ssid, k->ssid_len, k->passphrase, psk);
+		assert(log_writes == writes);
+	}
+	printf("psk_cache_test: %d puts, %d cuts, log full %d times\n", rounds, cuts, full);
+	assert(cuts > 0 && full > 0);
+}
+
+int main(int argc, char *argv[])
+{
+	srand(argc > 1 ? atoi(argv[1]) : 1);
+
+	test_request();
+	test_log(3000);
+
+	printf("psk_cache_test: ok\n");
+	return 0;
+}
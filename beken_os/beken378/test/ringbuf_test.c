@@ -0,0 +1,328 @@
+/*
+ * host test of the lock-free ringbuff in tuyaos utilities/src/tuya_ringbuf.c.
+ * one thread writes and one reads, as the uart ISR and the log task do on the
+ * target. every byte carries a hash of its position in the stream, so a byte
+ * read from the wrong place, read twice or skipped without being counted as
+ * overwritten fails the check.
+ *
+ *   ringbuf_test [seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+/* the copies in and out of the buff give the other thread a chance to run in the middle */
+#define memcpy          rb_memcpy
+static void *rb_memcpy(void *dst, const void *src, size_t len);
+
+#include "../../../tuyaos/tuyaos_adapter/include/utilities/src/tuya_ringbuf.c"
+
+#undef memcpy
+
+#define RB_LEN          64
+#define RB_STREAM_LEN   (4 * 1024 * 1024)
+
+typedef struct {
+    TUYA_RINGBUFF_T rb;
+    RINGBUFF_TYPE_E type;
+    unsigned int seed;
+    volatile int done;
+    /* producer side */
+    unsigned int full;
+    /* consumer side */
+    unsigned int empty, read_total, torn;
+} RB_RACE_T;
+
+VOID_T *tkl_system_malloc(SIZE_T size)
+{
+    return malloc(size);
+}
+
+VOID_T tkl_system_free(VOID_T *ptr)
+{
+    free(ptr);
+}
+
+static void *rb_memcpy(void *dst, const void *src, size_t len)
+{
+    static __thread unsigned int calls;
+    size_t half = len / 2;
+
+    memcpy(dst, src, half);
+    if(0 == ++calls % 16)
+    {
+        sched_yield();
+    }
+    memcpy((UINT8_T *)dst + half, (const UINT8_T *)src + half, len - half);
+
+    return dst;
+}
+
+static UINT8_T pattern(UINT32_T pos)
+{
+    return (UINT8_T)((pos * 2654435761u) >> 24);
+}
+
+static void fill(UINT8_T *buf, UINT32_T pos, UINT32_T len)
+{
+    UINT32_T i;
+
+    for(i = 0; i < len; i++)
+    {
+        buf[i] = pattern(pos + i);
+    }
+}
+
+static void check(const UINT8_T *buf, UINT32_T pos, UINT32_T len)
+{
+    UINT32_T i;
+
+    for(i = 0; i < len; i++)
+    {
+        assert(buf[i] == pattern(pos + i));
+    }
+}
+
+/* single thread: spans stop at the end of the buff, partial commits and consumes */
+static void test_spans(void)
+{
+    TUYA_RINGBUFF_T rb;
+    UINT8_T *span, buf[RB_LEN];
+
+    assert(OPRT_OK == tuya_ring_buff_create(RB_LEN - 3, OVERFLOW_STOP_TYPE, &rb));
+    assert(RB_LEN == tuya_ring_buff_free_size_get(rb));
+    assert(0 == tuya_ring_buff_peek_span(rb, &span));
+
+    /* reserve 40, only 30 are written */
+    assert(40 == tuya_ring_buff_write_reserve(rb, &span, 40));
+    fill(span, 0, 30);
+    assert(OPRT_OK == tuya_ring_buff_write_commit(rb, 30));
+    assert(30 == tuya_ring_buff_used_size_get(rb));
+
+    /* 20 of them are consumed, in two steps */
+    assert(30 == tuya_ring_buff_peek_span(rb, &span));
+    check(span, 0, 30);
+    assert(OPRT_OK == tuya_ring_buff_consume(rb, 5));
+    assert(25 == tuya_ring_buff_peek_span(rb, &span));
+    check(span, 5, 25);
+    assert(OPRT_OK == tuya_ring_buff_consume(rb, 15));
+
+    /* the next reserve stops at the end of the buff, the rest comes from the start */
+    assert(RB_LEN - 30 == tuya_ring_buff_write_reserve(rb, &span, 50));
+    fill(span, 30, RB_LEN - 30);
+    assert(OPRT_OK == tuya_ring_buff_write_commit(rb, RB_LEN - 30));
+    assert(16 == tuya_ring_buff_write_reserve(rb, &span, 16));
+    assert(span == (UINT8_T *)((__RINGBUFF_T *)rb)->buff);
+    fill(span, RB_LEN, 16);
+    assert(OPRT_OK == tuya_ring_buff_write_commit(rb, 16));
+
+    /* 80 written and 20 consumed leave 4 free, a reserve of more gets only those */
+    assert(RB_LEN - 4 == tuya_ring_buff_used_size_get(rb));
+    assert(4 == tuya_ring_buff_write_reserve(rb, &span, 30));
+    fill(span, RB_LEN + 16, 4);
+    assert(OPRT_OK == tuya_ring_buff_write_commit(rb, 4));
+    assert(0 == tuya_ring_buff_free_size_get(rb));
+    assert(0 == tuya_ring_buff_write_reserve(rb, &span, 1));
+    assert(0 == tuya_ring_buff_write(rb, buf, 1));
+
+    /* reading the wrapped data: the span ends at the end of the buff */
+    assert(RB_LEN - 20 == tuya_ring_buff_peek_span(rb, &span));
+    check(span, 20, RB_LEN - 20);
+    assert(OPRT_OK == tuya_ring_buff_consume(rb, RB_LEN - 21));
+    assert(1 == tuya_ring_buff_peek_span(rb, &span));
+    assert(OPRT_OK == tuya_ring_buff_consume(rb, 1));
+    assert(20 == tuya_ring_buff_read(rb, buf, sizeof(buf)));
+    check(buf, RB_LEN, 20);
+    assert(0 == tuya_ring_buff_used_size_get(rb));
+
+    /* a consume past the data stops at the data */
+    assert(OPRT_OK == tuya_ring_buff_consume(rb, 10));
+    assert(RB_LEN == tuya_ring_buff_free_size_get(rb));
+
+    /* in coverage mode the oldest bytes go and are counted */
+    tuya_ring_buff_free(rb);
+    assert(OPRT_OK == tuya_ring_buff_create(RB_LEN, OVERFLOW_COVERAGE_TYPE, &rb));
+    fill(buf, 0, RB_LEN);
+    assert(RB_LEN == tuya_ring_buff_write(rb, buf, RB_LEN));
+    fill(buf, RB_LEN, 10);
+    assert(10 == tuya_ring_buff_write(rb, buf, 10));
+    assert(RB_LEN - 10 == tuya_ring_buff_peek_span(rb, &span));
+    check(span, 10, RB_LEN - 10);
+    assert(10 == tuya_ring_buff_overwrite_size_get(rb));
+    assert(RB_LEN == tuya_ring_buff_read(rb, buf, sizeof(buf)));
+    check(buf, 10, RB_LEN);
+    tuya_ring_buff_free(rb);
+
+    printf("ringbuf_test spans: ok\n");
+}
+
+static void *producer(void *arg)
+{
+    RB_RACE_T *race = arg;
+    UINT8_T *span, buf[RB_LEN * 2];
+    UINT32_T pos = 0, want, len, done;
+    unsigned int seed = race->seed;
+
+    while(pos < RB_STREAM_LEN)
+    {
+        want = 1 + rand_r(&seed) % (RB_LEN * 2);
+        want = (want > RB_STREAM_LEN - pos) ? (RB_STREAM_LEN - pos) : want;
+
+        /* a coverage write of more than the buff keeps only its tail, which this count can not follow */
+        if((OVERFLOW_COVERAGE_TYPE == race->type) && (want > RB_LEN))
+        {
+            want = RB_LEN;
+        }
+
+        if(rand_r(&seed) & 1)
+        {
+            fill(buf, pos, want);
+            len = tuya_ring_buff_write(race->rb, buf, want);
+        }
+        else
+        {
+            /* a partial commit, the rest of the span is left for the next reserve */
+            len = tuya_ring_buff_write_reserve(race->rb, &span, want);
+            if(len)
+            {
+                done = 1 + rand_r(&seed) % len;
+                fill(span, pos, done / 2);
+                if(0 == rand_r(&seed) % 8)
+                {
+                    sched_yield();
+                }
+                fill(span + done / 2, pos + done / 2, done - done / 2);
+                tuya_ring_buff_write_commit(race->rb, done);
+                len = done;
+            }
+        }
+
+        if(0 == len)
+        {
+            race->full++;
+            sched_yield();
+        }
+        pos += len;
+
+        if(0 == rand_r(&seed) % 64)
+        {
+            sched_yield();
+        }
+    }
+
+    race->done = 1;
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    RB_RACE_T *race = arg;
+    UINT8_T *span, buf[RB_LEN * 2];
+    UINT32_T len, want, start, done, used;
+    unsigned int seed = race->seed * 7 + 1;
+    int last = 0;
+
+    for(;;)
+    {
+        /* the producer may finish between the check and the read, one more round drains */
+        last = race->done;
+        RINGBUFF_BARRIER();
+
+        used = tuya_ring_buff_used_size_get(race->rb);
+        assert(used <= RB_LEN);
+
+        if(rand_r(&seed) & 1)
+        {
+            want = 1 + rand_r(&seed) % (RB_LEN * 2);
+            len = tuya_ring_buff_read(race->rb, buf, want);
+            start = race->read_total + tuya_ring_buff_overwrite_size_get(race->rb);
+            check(buf, start, len);
+            race->read_total += len;
+        }
+        else
+        {
+            len = tuya_ring_buff_peek_span(race->rb, &span);
+            assert(len <= RB_LEN);
+            assert(span + len <= ((__RINGBUFF_T *)race->rb)->buff + RB_LEN);
+            start = race->read_total + tuya_ring_buff_overwrite_size_get(race->rb);
+            if(len)
+            {
+                /* the span is only trusted once consume says it was not overwritten */
+                done = 1 + rand_r(&seed) % len;
+                if(0 == rand_r(&seed) % 8)
+                {
+                    sched_yield();
+                }
+                memcpy(buf, span, done);
+                if(OPRT_OK == tuya_ring_buff_consume(race->rb, done))
+                {
+                    check(buf, start, done);
+                    race->read_total += done;
+                }
+                else
+                {
+                    assert(OVERFLOW_COVERAGE_TYPE == race->type);
+                    race->torn++;
+                }
+            }
+        }
+
+        if(0 == len)
+        {
+            if(last)
+            {
+                break;
+            }
+            race->empty++;
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/* the producer blocks on full, the consumer on empty, every byte comes out once */
+static void test_race(RINGBUFF_TYPE_E type, unsigned int seed)
+{
+    RB_RACE_T race = {0};
+    pthread_t prod, cons;
+    UINT32_T overwrite;
+
+    race.type = type;
+    race.seed = seed;
+    assert(OPRT_OK == tuya_ring_buff_create(RB_LEN, type, &race.rb));
+
+    assert(0 == pthread_create(&cons, NULL, consumer, &race));
+    assert(0 == pthread_create(&prod, NULL, producer, &race));
+    pthread_join(prod, NULL);
+    pthread_join(cons, NULL);
+
+    overwrite = tuya_ring_buff_overwrite_size_get(race.rb);
+    assert(0 == tuya_ring_buff_used_size_get(race.rb));
+    assert(RB_STREAM_LEN == race.read_total + overwrite);
+    if(OVERFLOW_STOP_TYPE == type)
+    {
+        assert(0 == overwrite);
+        assert(race.full && race.empty);
+    }
+
+    printf("ringbuf_test %s: %u bytes read, %u overwritten, %u torn spans, %u full, %u empty\n",
+           (OVERFLOW_STOP_TYPE == type) ? "stop" : "coverage",
+           race.read_total, overwrite, race.torn, race.full, race.empty);
+    tuya_ring_buff_free(race.rb);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int seed = (argc > 1) ? atoi(argv[1]) : 1;
+
+    test_spans();
+    test_race(OVERFLOW_STOP_TYPE, seed);
+    test_race(OVERFLOW_COVERAGE_TYPE, seed);
+
+    printf("ringbuf_test: ok\n");
+    return 0;
+}
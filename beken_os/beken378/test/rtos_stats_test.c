@@ -0,0 +1,241 @@
+/*
+ * host test of the run time stats in os/FreeRTOSv9.0.0/rtos_stats.c, the
+ * kernel side is faked below: the test owns the task table and the 32 bit
+ * run time counters and moves them across the wrap.
+ */
+#include <stdio.h>
+#include <assert.h>
+
+#include "../os/FreeRTOSv9.0.0/rtos_stats.c"
+
+#define FAKE_TASK_NUM       8
+
+static TaskStatus_t fake_task[FAKE_TASK_NUM];
+static UBaseType_t fake_task_num;
+static uint32_t fake_total;
+static int fake_suspended;
+
+UBaseType_t uxTaskGetNumberOfTasks( void )
+{
+    return fake_task_num;
+}
+
+UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime )
+{
+    assert( fake_suspended == 1 );
+    assert( uxArraySize >= fake_task_num );
+
+    memcpy( pxTaskStatusArray, fake_task, fake_task_num * sizeof(TaskStatus_t) );
+    *pulTotalRunTime = fake_total;
+
+    return fake_task_num;
+}
+
+void vTaskSuspendAll( void )
+{
+    fake_suspended++;
+}
+
+BaseType_t xTaskResumeAll( void )
+{
+    assert( fake_suspended > 0 );
+    fake_suspended--;
+
+    return 0;
+}
+
+BaseType_t xTimerStart( TimerHandle_t xTimer, TickType_t xTicksToWait )
+{
+    return 1;
+}
+
+OSStatus rtos_init_timer( beken_timer_t* timer, uint32_t time_ms, timer_handler_t function, void* arg )
+{
+    timer->handle = (void *)1;
+    timer->function = function;
+    timer->arg = arg;
+
+    return kNoErr;
+}
+
+UINT32 bk_timer_free_run_init( UINT8 channel, UINT32 unit_us )
+{
+    return 0;
+}
+
+static void fake_reset( void )
+{
+    memset( rtos_stats_slot, 0, sizeof(rtos_stats_slot) );
+    rtos_stats_last = 0;
+    rtos_stats_total = 0;
+    rtos_stats_win_start = 0;
+
+    memset( fake_task, 0, sizeof(fake_task) );
+    fake_task_num = 0;
+    fake_total = 0;
+}
+
+static void fake_add_task( const char *name, UBaseType_t number, eTaskState state, UBaseType_t prio, uint32_t run )
+{
+    TaskStatus_t *task = &fake_task[fake_task_num++];
+
+    task->pcTaskName = name;
+    task->xTaskNumber = number;
+    task->eCurrentState = state;
+    task->uxCurrentPriority = prio;
+    task->ulRunTimeCounter = run;
+}
+
+static void test_permille( void )
+{
+    assert( rtos_stats_permille( 0, 0 ) == 0 );
+    assert( rtos_stats_permille( 5, 0 ) == 0 );
+    assert( rtos_stats_permille( 1, 3 ) == 333 );
+    assert( rtos_stats_permille( 2, 3 ) == 667 );
+    assert( rtos_stats_permille( 5, 4 ) == 1000 );
+    assert( rtos_stats_permille( 1, 2000 ) == 1 );
+    assert( rtos_stats_permille( 1, 2001 ) == 0 );
+
+    /* totals past 32 bit */
+    assert( rtos_stats_permille( 0x100000000ull * 300, 0x100000000ull * 1000 ) == 300 );
+    assert( rtos_stats_permille( 0x123456789ull, 0x123456789ull ) == 1000 );
+}
+
+static void test_fold_wrap( void )
+{
+    TaskStatus_t task[2];
+
+    fake_reset();
+    memset( task, 0, sizeof(task) );
+
+    /* total and task counters wrap between two samples */
+    rtos_stats_last = 0xfffff000u;
+    rtos_stats_total = 0xfffff000u;
+    task[0].xTaskNumber = 1;
+    task[0].ulRunTimeCounter = 0xffffff00u;
+    task[1].xTaskNumber = 2;
+    task[1].ulRunTimeCounter = 0x100;
+    rtos_stats_fold( task, 2, 0xfffff000u );
+
+    task[0].ulRunTimeCounter = 0x100;
+    task[1].ulRunTimeCounter = 0x200;
+    rtos_stats_fold( task, 2, 0x1000 );
+
+    assert( rtos_stats_find( 1 )->run == 0x100000100ull );
+    assert( rtos_stats_find( 2 )->run == 0x200 );
+    assert( rtos_stats_total == 0x100001000ull );
+
+    /* task 2 deleted, its slot is freed */
+    rtos_stats_fold( task, 1, 0x2000 );
+    assert( rtos_stats_find( 2 ) == NULL );
+    assert( rtos_stats_find( 1 )->run == 0x100000100ull );
+}
+
+static void test_fold_full( void )
+{
+    TaskStatus_t task[RTOS_STATS_SLOT_NUM + 2];
+    int i;
+
+    fake_reset();
+    memset( task, 0, sizeof(task) );
+
+    for ( i = 0; i < RTOS_STATS_SLOT_NUM + 2; i++ )
+    {
+        task[i].xTaskNumber = 100 + i;
+        task[i].ulRunTimeCounter = i;
+    }
+    rtos_stats_fold( task, RTOS_STATS_SLOT_NUM + 2, 1000 );
+
+    /* tasks past the table are not tracked */
+    assert( rtos_stats_find( 100 + RTOS_STATS_SLOT_NUM - 1 ) != NULL );
+    assert( rtos_stats_find( 100 + RTOS_STATS_SLOT_NUM ) == NULL );
+
+    /* a slot freed by a deleted task is taken by a new one on the next sample */
+    task[0].xTaskNumber = 200;
+    task[0].ulRunTimeCounter = 7;
+    rtos_stats_fold( task, RTOS_STATS_SLOT_NUM, 2000 );
+    assert( rtos_stats_find( 100 ) == NULL );
+    assert( rtos_stats_find( 200 ) == NULL );
+    rtos_stats_fold( task, RTOS_STATS_SLOT_NUM, 3000 );
+    assert( rtos_stats_find( 200 )->run == 7 );
+}
+
+static void test_thread_stats( void )
+{
+    rtos_thread_stat_t stats[4];
+    uint64_t win_us;
+    int n;
+
+    fake_reset();
+    fake_add_task( "idle", 1, eReady, 0, 600 );
+    fake_add_task( "a_very_long_task_name", 2, eRunning, 3, 300 );
+    fake_add_task( "net", 3, eBlocked, 5, 100 );
+    fake_total = 1000;
+
+    n = rtos_get_thread_stats( stats, 4, &win_us );
+    assert( n == 3 && fake_suspended == 0 );
+    assert( win_us == 1000 * RTOS_STATS_UNIT_US );
+
+    assert( strcmp( stats[0].name, "idle" ) == 0 );
+    assert( stats[0].state == tskREADY_CHAR );
+    assert( stats[0].priority == 9 );
+    assert( stats[0].run_us == 600 * RTOS_STATS_UNIT_US );
+    assert( stats[0].permille == 600 && stats[0].win_permille == 600 );
+
+    assert( strlen( stats[1].name ) == sizeof(stats[1].name) - 1 );
+    assert( strncmp( stats[1].name, "a_very_long_task_name", sizeof(stats[1].name) - 1 ) == 0 );
+    assert( stats[1].state == 'X' && stats[1].priority == 6 );
+    assert( stats[2].state == tskBLOCKED_CHAR && stats[2].permille == 100 );
+
+    /* next window: idle and the total wrap, net is deleted, log is new */
+    fake_task[0].ulRunTimeCounter = 600 + 0xffffff00u - 200;
+    fake_task[1].ulRunTimeCounter = 300 + 100;
+    fake_task[1].eCurrentState = eSuspended;
+    fake_task_num = 2;
+    fake_add_task( "log", 4, eBlocked, 4, 100 );
+    fake_total = 1000 + 0xffffff00u;
+    assert( fake_task[0].ulRunTimeCounter < 600 && fake_total < 1000 );
+
+    n = rtos_get_thread_stats( stats, 4, &win_us );
+    assert( n == 3 && fake_suspended == 0 );
+    assert( win_us == 0xffffff00ull * RTOS_STATS_UNIT_US );
+    assert( rtos_stats_find( 3 ) == NULL );
+
+    assert( stats[0].run_us == ( 600 + 0xffffff00ull - 200 ) * RTOS_STATS_UNIT_US );
+    assert( stats[0].win_us == ( 0xffffff00ull - 200 ) * RTOS_STATS_UNIT_US );
+    assert( stats[0].win_permille == 1000 );
+    assert( stats[0].permille == rtos_stats_permille( 600 + 0xffffff00ull - 200, 1000 + 0xffffff00ull ) );
+    assert( stats[1].state == tskSUSPENDED_CHAR );
+    assert( stats[1].run_us == 400 * RTOS_STATS_UNIT_US && stats[1].win_us == 100 * RTOS_STATS_UNIT_US );
+    assert( strcmp( stats[2].name, "log" ) == 0 );
+    assert( stats[2].win_us == 100 * RTOS_STATS_UNIT_US );
+
+    /* an empty window and a short stats array */
+    n = rtos_get_thread_stats( stats, 1, &win_us );
+    assert( n == 1 && win_us == 0 );
+    assert( stats[0].win_us == 0 && stats[0].win_permille == 0 );
+
+    /* the guard timer only folds */
+    fake_task[0].ulRunTimeCounter += 50;
+    fake_total += 100;
+    rtos_stats_guard_handler( NULL );
+    assert( fake_suspended == 0 );
+    n = rtos_get_thread_stats( NULL, 0, &win_us );
+    assert( n == 0 && win_us == 100 * RTOS_STATS_UNIT_US );
+}
+
+int main( void )
+{
+    rtos_stats_init();
+    assert( rtos_stats_guard.function == rtos_stats_guard_handler );
+
+    test_permille();
+    test_fold_wrap();
+    test_fold_full();
+    test_thread_stats();
+
+    printf( "rtos_stats_test: ok\n" );
+
+    return 0;
+}
+// eof
@@ -0,0 +1,11 @@
+#ifndef _ARCH_H_
+#define _ARCH_H_
+
+#include <stdint.h>
+
+static inline uint32_t portDISABLE_FIQ(void) { return 0; }
+static inline uint32_t portDISABLE_IRQ(void) { return 0; }
+static inline void portENABLE_FIQ(void) { }
+static inline void portENABLE_IRQ(void) { }
+
+#endif // _ARCH_H_
@@ -0,0 +1,10 @@
+#ifndef _ATE_APP_H_
+#define _ATE_APP_H_
+
+/* host build of the test harness, the part of app/ate_app.h flash.c uses */
+#include <stdint.h>
+
+/* provided by the test */
+extern uint32_t get_ate_mode_state(void);
+
+#endif // _ATE_APP_H_
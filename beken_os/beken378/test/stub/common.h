@@ -0,0 +1,51 @@
+#ifndef COMMON_H
+#define COMMON_H
+
+/*
+ * host build of the test harness, the part of wpa_supplicant utils/common.h
+ * and utils/os.h the crypto and psk cache code uses
+ */
+#include <stdint.h>
+#include "mem_pub.h"
+
+typedef uint64_t u64;
+typedef uint32_t u32;
+typedef uint16_t u16;
+typedef uint8_t u8;
+typedef int64_t s64;
+typedef int32_t s32;
+typedef int16_t s16;
+typedef int8_t s8;
+
+#define __must_check
+
+#define WPA_GET_BE32(a) ((((u32) (a)[0]) << 24) | (((u32) (a)[1]) << 16) | \
+			 (((u32) (a)[2]) << 8) | ((u32) (a)[3]))
+#define WPA_PUT_BE32(a, val)					\
+	do {							\
+		(a)[0] = (u8) ((((u32) (val)) >> 24) & 0xff);	\
+		(a)[1] = (u8) ((((u32) (val)) >> 16) & 0xff);	\
+		(a)[2] = (u8) ((((u32) (val)) >> 8) & 0xff);	\
+		(a)[3] = (u8) (((u32) (val)) & 0xff);		\
+	} while (0)
+#define WPA_GET_LE32(a) ((((u32) (a)[3]) << 24) | (((u32) (a)[2]) << 16) | \
+			 (((u32) (a)[1]) << 8) | ((u32) (a)[0]))
+
+#define os_strdup                      strdup
+#define os_strlen                      strlen
+#define os_strcmp                      strcmp
+#define os_memcmp                      memcmp
+
+#define MSG_MSGDUMP                    0
+#define wpa_hexdump_key(l, t, b, n)    do { } while (0)
+
+int hexstr2bin(const char *hex, u8 *buf, size_t len);
+const char * wpa_ssid_txt(const u8 *ssid, size_t ssid_len);
+char * dup_binstr(const void *src, size_t len);
+
+static inline void forced_memzero(void *ptr, size_t len)
+{
+	memset(ptr, 0, len);
+}
+
+#endif /* COMMON_H */
@@ -0,0 +1,11 @@
+#ifndef _DOUBLY_LIST_STUB_H_
+#define _DOUBLY_LIST_STUB_H_
+
+/* host build of the test harness, common/doubly_list.h takes __INLINE from driver/common/compiler.h */
+#include <stddef.h>
+
+#define __INLINE                       static inline
+
+#include "../../common/doubly_list.h"
+
+#endif // _DOUBLY_LIST_STUB_H_
@@ -0,0 +1,20 @@
+#ifndef _GENERIC_H_
+#define _GENERIC_H_
+
+/* host build of the test harness, stands in for common/generic.h */
+#include <stdbool.h>
+#include <assert.h>
+#include "include.h"
+
+typedef void (*FUNCPTR)(void);
+typedef void (*FUNC_1PARAM_PTR)(void *ctxt);
+typedef void (*FUNC_2PARAM_PTR)(void *arg, uint8_t vif_idx);
+
+extern void bk_printf(const char *fmt, ...);
+
+#define ASSERT(exp)                    assert(exp)
+
+#define MIN(x, y)                      (((x) < (y)) ? (x) : (y))
+#define MAX(x, y)                      (((x) > (y)) ? (x) : (y))
+
+#endif // _GENERIC_H_
@@ -0,0 +1,12 @@
+#ifndef _INCLUDE_H_
+#define _INCLUDE_H_
+
+/* host build of the test harness, stands in for common/include.h */
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "typedef.h"
+
+#define CFG_IRQ_TRACE                  1
+
+#endif // _INCLUDE_H_
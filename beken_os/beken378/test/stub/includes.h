@@ -0,0 +1,12 @@
+#ifndef INCLUDES_H
+#define INCLUDES_H
+
+/* host build of the test harness, stands in for wpa_supplicant utils/includes.h */
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+
+#endif /* INCLUDES_H */
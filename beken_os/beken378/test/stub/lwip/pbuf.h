@@ -0,0 +1,20 @@
+#ifndef LWIP_HDR_PBUF_H
+#define LWIP_HDR_PBUF_H
+
+/* host build of the test harness, the part of lwip/pbuf.h the msdu code uses */
+#include <stdint.h>
+
+struct pbuf
+{
+    struct pbuf *next;
+    void *payload;
+    uint16_t tot_len;
+    uint16_t len;
+    uint8_t type_internal;
+    uint16_t ref;
+};
+
+/* provided by the test */
+extern uint8_t pbuf_free(struct pbuf *p);
+
+#endif // LWIP_HDR_PBUF_H
@@ -0,0 +1,14 @@
+#ifndef _MEM_PUB_H_
+#define _MEM_PUB_H_
+
+#include <stdlib.h>
+#include <string.h>
+
+#define os_memcpy                      memcpy
+#define os_memmove                     memmove
+#define os_memset                      memset
+#define os_malloc                      malloc
+#define os_free                        free
+#define os_zalloc(size)                calloc(1, (size))
+
+#endif // _MEM_PUB_H_
@@ -0,0 +1,13 @@
+#ifndef _POWER_SAVE_PUB_H_
+#define _POWER_SAVE_PUB_H_
+
+/* host build of the test harness, the part of func/include/power_save_pub.h mcu_ps.c uses */
+#include "typedef.h"
+#include "rw_pub.h"
+
+/* provided by the test */
+extern UINT8 power_save_if_rf_sleep();
+extern UINT8 power_save_if_ps_rf_dtim_enabled(void);
+extern uint8_t ble_switch_mac_sleeped;
+
+#endif // _POWER_SAVE_PUB_H_
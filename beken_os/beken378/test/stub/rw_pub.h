@@ -0,0 +1,48 @@
+#ifndef _RW_PUB_H_
+#define _RW_PUB_H_
+
+/*
+ * host build of the test harness, the part of func/include/rw_pub.h and the
+ * mac headers behind it that power_save/mcu_ps.c uses
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart_pub.h"
+
+/* ip/mac/mac.h */
+struct mac_addr
+{
+    uint16_t array[3];
+} __attribute__((packed));
+
+/* ip/mac/mac_frame.h */
+struct mac_hdr
+{
+    uint16_t fctl;
+    uint16_t durid;
+    struct mac_addr addr1;
+    struct mac_addr addr2;
+    struct mac_addr addr3;
+    uint16_t seq;
+} __attribute__((packed));
+
+struct bcn_frame
+{
+    struct mac_hdr h;
+    uint64_t tsf;
+    uint16_t bcnint;
+    uint16_t capa;
+    uint8_t variable[];
+} __attribute__((packed));
+
+/* func/include/wlan_ui_pub.h */
+typedef struct
+{
+	int8_t rssi;
+}hal_wifi_link_info_t;
+
+/* provided by the test */
+extern bool txl_sleep_check(void);
+extern uint32_t hal_machw_time(void);
+
+#endif // _RW_PUB_H_
@@ -0,0 +1,7 @@
+#ifndef _RWNXL_H_
+#define _RWNXL_H_
+
+/* host build of the test harness, the part of ip/lmac/src/rwnx/rwnx.h rw_msdu.h uses */
+typedef struct rw_rxifo_st RW_RXIFO_ST, *RW_RXIFO_PTR;
+
+#endif // _RWNXL_H_
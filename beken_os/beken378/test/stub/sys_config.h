@@ -0,0 +1,6 @@
+#ifndef _SYS_CONFIG_H_
+#define _SYS_CONFIG_H_
+
+/* host build of the test harness, each test defines the CFG_ options it needs before the include */
+
+#endif // _SYS_CONFIG_H_
@@ -0,0 +1,7 @@
+#ifndef _SYS_CTRL_H_
+#define _SYS_CTRL_H_
+
+/* host build of the test harness, the system controller registers are not modelled */
+#include "sys_ctrl_pub.h"
+
+#endif // _SYS_CTRL_H_
@@ -0,0 +1,24 @@
+#ifndef _SYS_RTOS_H_
+#define _SYS_RTOS_H_
+
+/* the part of FreeRTOS the run time stats use, see task.h and timers.h */
+#include <stdint.h>
+#include <stdlib.h>
+
+#define configGENERATE_RUN_TIME_STATS  1
+#define configMAX_PRIORITIES           10
+
+typedef long                  BaseType_t;
+typedef unsigned long         UBaseType_t;
+typedef uint32_t              StackType_t;
+typedef void *                TaskHandle_t;
+typedef void *                TimerHandle_t;
+typedef uint32_t              TickType_t;
+
+#define pvPortMalloc                   malloc
+#define vPortFree                      free
+
+/* see os/FreeRTOSv9.0.0/rtos.h */
+#define BK_PRIORITY_TO_NATIVE_PRIORITY(priority)    (uint8_t)(configMAX_PRIORITIES - 1 - priority)
+
+#endif // _SYS_RTOS_H_
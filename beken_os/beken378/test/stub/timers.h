@@ -0,0 +1,9 @@
+#ifndef TIMERS_H
+#define TIMERS_H
+
+#include "sys_rtos.h"
+
+/* provided by the test */
+BaseType_t xTimerStart( TimerHandle_t xTimer, TickType_t xTicksToWait );
+
+#endif // TIMERS_H
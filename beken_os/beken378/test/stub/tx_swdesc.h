@@ -0,0 +1,9 @@
+#ifndef _TX_SWDESC_H_
+#define _TX_SWDESC_H_
+
+/* host build of the test harness, the part of ip/lmac/src/tx/tx_swdesc.h rw_msdu.h uses */
+typedef void (*mgmt_tx_cb_t)(void *param);
+
+struct txdesc;
+
+#endif // _TX_SWDESC_H_
@@ -0,0 +1,32 @@
+#ifndef _TYPEDEF_H_
+#define _TYPEDEF_H_
+
+/* common/typedef.h redefines size_t, which a 64 bit host does not take */
+#include <stdint.h>
+#include <stddef.h>
+
+typedef unsigned char         uint8;
+typedef signed   char         int8;
+typedef unsigned short        uint16;
+typedef signed   short        int16;
+typedef unsigned int          uint32;
+typedef signed   int          int32;
+typedef unsigned long long    uint64;
+typedef signed   long long    int64;
+typedef unsigned char         u8;
+
+typedef unsigned char         UINT8;
+typedef signed   char         INT8;
+typedef unsigned short        UINT16;
+typedef signed   short        INT16;
+typedef unsigned int          UINT32;
+typedef signed   int          INT32;
+typedef unsigned long long    UINT64;
+typedef signed   long long    INT64;
+typedef unsigned char         BOOLEAN;
+typedef unsigned char         BOOL;
+
+#define LPVOID              void *
+#define VOID                void
+
+#endif // _TYPEDEF_H_
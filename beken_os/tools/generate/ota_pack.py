@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Build ota packages for tkl_ota.c.
+
+    raw:   header + image
+    lz:    header + image encoded with literal and window match ops
+    diff:  header + base header + lz ops plus copies from the running firmware
+
+The op stream is described in tkl_ota.c. Every package is decoded again
+after it is built and compared with the input image, --no-verify skips it.
+
+python ota_pack.py -i app_UG.bin -o app_UG_lz.bin -v 1.0.1 --lz
+python ota_pack.py -i app_UG.bin -o app_UG_diff.bin -v 1.0.1 --diff app_old_UA.bin
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+PKG_HEAD = 0x55aa55aa
+PKG_HEAD_LZ = 0x55aa55a1
+PKG_HEAD_DIFF = 0x55aa55a2
+PKG_TAIL = 0xaa55aa55
+
+IMAGE_MAX_SIZE = 664 * 1024 - 2 * 4096
+BASE_MAX_SIZE = 0x12A000 - 0x11000
+
+WINDOW = 4096
+MATCH_MIN = 3
+BASE_MIN = 4
+LIT_MAX = 128
+CHAIN_MAX = 16
+
+
+def varint(v):
+    out = bytearray()
+    while True:
+        b = v & 0x7f
+        v >>= 7
+        if v:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return out
+
+
+def zigzag(d):
+    return (d << 1) if d >= 0 else (((-d) << 1) - 1)
+
+
+def op_len_field(token, length):
+    if length < 0x3f:
+        return bytearray([token | length])
+    return bytearray([token | 0x3f]) + varint(length - 0x3f)
+
+
+def match_len(a, ap, b, bp, limit):
+    n = 0
+    while n + 32 <= limit and a[ap + n:ap + n + 32] == b[bp + n:bp + n + 32]:
+        n += 32
+    while n < limit and a[ap + n] == b[bp + n]:
+        n += 1
+    return n
+
+
+def index_base(base):
+    idx = {}
+    for p in range(len(base) - BASE_MIN + 1):
+        lst = idx.setdefault(base[p:p + BASE_MIN], [])
+        if len(lst) < CHAIN_MAX:
+            lst.append(p)
+    return idx
+
+
+def encode(data, base=None):
+    out = bytearray()
+    lit = bytearray()
+    chains = {}
+    base_idx = index_base(base) if base else None
+    base_pos = 0
+    n = len(data)
+    i = 0
+
+    def flush_lit():
+        for k in range(0, len(lit), LIT_MAX):
+            chunk = lit[k:k + LIT_MAX]
+            out.append(len(chunk) - 1)
+            out.extend(chunk)
+        lit.clear()
+
+    def insert(p):
+        key = data[p:p + MATCH_MIN]
+        lst = chains.setdefault(key, [])
+        lst.append(p)
+        if len(lst) > CHAIN_MAX:
+            del lst[0]
+
+    while i < n:
+        best_gain, best = 0, None
+
+        if base_idx is not None:
+            cands = [base_pos] if base_pos < len(base) else []
+            cands += base_idx.get(data[i:i + BASE_MIN], [])
+            for p in cands:
+                length = match_len(base, p, data, i, min(n - i, len(base) - p))
+                if length < BASE_MIN:
+                    continue
+                op = op_len_field(0xc0, length - BASE_MIN) + varint(zigzag(p - base_pos))
+                gain = length - len(op)
+                if gain > best_gain:
+                    best_gain, best = gain, (length, op, p)
+
+        for p in reversed(chains.get(data[i:i + MATCH_MIN], [])):
+            if i - p > WINDOW:
+                break
+            length = match_len(data, p, data, i, n - i)
+            if length < MATCH_MIN:
+                continue
+            op = op_len_field(0x80, length - MATCH_MIN) + varint(i - p - 1)
+            gain = length - len(op)
+            if gain > best_gain:
+                best_gain, best = gain, (length, op, None)
+
+        if best is None:
+            lit.append(data[i])
+            insert(i)
+            i += 1
+            base_pos += 1
+            continue
+
+        length, op, p = best
+        flush_lit()
+        out.extend(op)
+        for k in range(i, i + length):
+            insert(k)
+        i += length
+        base_pos = (p if p is not None else base_pos) + length
+
+    flush_lit()
+    return bytes(out)
+
+
+def read_varint(buf, pos):
+    v, shift = 0, 0
+    while True:
+        b = buf[pos]
+        pos += 1
+        v |= (b & 0x7f) << shift
+        if not b & 0x80:
+            return v, pos
+        shift += 7
+
+
+def decode(stream, length, base=None):
+    out = bytearray()
+    base_pos = 0
+    pos = 0
+    while len(out) < length:
+        t = stream[pos]
+        pos += 1
+        if t < 0x80:
+            n = t + 1
+            out.extend(stream[pos:pos + n])
+            pos += n
+        else:
+            n = t & 0x3f
+            if n == 0x3f:
+                ext, pos = read_varint(stream, pos)
+                n += ext
+            arg, pos = read_varint(stream, pos)
+            if t < 0xc0:
+                n += MATCH_MIN
+                dist = arg + 1
+                if dist > len(out) or dist > WINDOW:
+                    raise ValueError('match distance out of the window at %d' % len(out))
+                for _ in range(n):
+                    out.append(out[-dist])
+            else:
+                n += BASE_MIN
+                base_pos += (arg >> 1) ^ -(arg & 1)
+                if base is None or base_pos < 0 or base_pos + n > len(base):
+                    raise ValueError('base copy out of range at %d' % len(out))
+                out.extend(base[base_pos:base_pos + n])
+        base_pos += n
+    if len(out) != length:
+        raise ValueError('op overruns the image')
+    return bytes(out)
+
+
+def header(flag, version, image):
+    ver = version.encode('ascii')[:12].ljust(12, b'\0')
+    head = struct.pack('>I12sII', flag, ver, len(image), sum(image) & 0xffffffff)
+    return head + struct.pack('>II', sum(head) & 0xffffffff, PKG_TAIL)
+
+
+def pack(image, version, mode, base=None):
+    if mode == 'raw':
+        return header(PKG_HEAD, version, image) + image
+    if mode == 'lz':
+        return header(PKG_HEAD_LZ, version, image) + encode(image)
+    return header(PKG_HEAD_DIFF, version, image) + \
+        struct.pack('>II', len(base), zlib.crc32(base) & 0xffffffff) + encode(image, base)
+
+
+def unpack(pkg, base=None):
+    flag, _, bin_len, bin_sum, head_sum, tail = struct.unpack('>I12sIIII', pkg[:32])
+    if tail != PKG_TAIL or head_sum != sum(pkg[:24]) & 0xffffffff:
+        raise ValueError('bad package header')
+    if flag == PKG_HEAD:
+        image = pkg[32:32 + bin_len]
+    elif flag == PKG_HEAD_LZ:
+        image = decode(pkg[32:], bin_len)
+    elif flag == PKG_HEAD_DIFF:
+        base_len, base_crc = struct.unpack('>II', pkg[32:40])
+        if base is None or len(base) != base_len or zlib.crc32(base) & 0xffffffff != base_crc:
+            raise ValueError('diff base mismatch')
+        image = decode(pkg[40:], bin_len, base)
+    else:
+        raise ValueError('unknown package type 0x%x' % flag)
+    if sum(image) & 0xffffffff != bin_sum:
+        raise ValueError('image checksum mismatch')
+    return image
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Build raw, lz or diff ota packages')
+    parser.add_argument('--input', '-i', help='new firmware image', required=True)
+    parser.add_argument('--output', '-o', help='package file', required=True)
+    parser.add_argument('--version', '-v', help='software version, up to 12 chars', required=True)
+    mode = parser.add_mutually_exclusive_group()
+    mode.add_argument('--lz', action='store_true', help='compress the image')
+    mode.add_argument('--diff', metavar='BASE', help='diff against BASE, the app partition as it is in flash')
+    parser.add_argument('--no-verify', action='store_true', help='skip decoding the package again')
+    args = parser.parse_args()
+
+    with open(args.input, 'rb') as f:
+        image = f.read()
+    if len(image) >= IMAGE_MAX_SIZE:
+        sys.exit('image too large: %d >= %d' % (len(image), IMAGE_MAX_SIZE))
+
+    base = None
+    if args.diff:
+        with open(args.diff, 'rb') as f:
+            base = f.read()
+        if len(base) > BASE_MAX_SIZE:
+            sys.exit('base too large: %d > %d' % (len(base), BASE_MAX_SIZE))
+
+    pkg = pack(image, args.version, 'diff' if base else ('lz' if args.lz else 'raw'), base)
+    if not args.no_verify and unpack(pkg, base) != image:
+        sys.exit('round trip failed')
+
+    with open(args.output, 'wb') as f:
+        f.write(pkg)
+    print('%s: image %d bytes, package %d bytes (%.2fx)' %
+          (args.output, len(image), len(pkg), float(len(image)) / len(pkg)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,242 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Decode the binary trace frames of tkl_output.c back into log text.
+
+    0xA5 | 0xB0 + argc | format address, u32 le | argc varint args | sum
+
+The format address is resolved against the read-only sections of the axf
+of the running image, or against those sections saved from it at build time. Bytes that do not make a valid
+frame are plain text and are copied through.
+
+python log_decode.py -e app.axf -i uart.log
+python log_decode.py -e app.axf --save app.fmt.json
+python log_decode.py -d app.fmt.json --port /dev/ttyUSB0 --baud 921600
+"""
+
+import argparse
+import base64
+import json
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+TAG = 0xB0
+ARG_MAX = 6
+
+SHF_ALLOC = 0x2
+SHF_WRITE = 0x1
+SHT_NOBITS = 8
+
+CONV = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|z|t|j)?([diouxXcspfeEgGn%])')
+
+
+class StringTable(object):
+    """c strings of the read-only sections, resolved at any address.
+
+    the linker tail merges literals, so a format can start in the middle of
+    another string; the string at an address runs up to the next nul.
+    """
+
+    def __init__(self, sections):
+        self.sections = sorted(sections)
+        self.cache = {}
+
+    def get(self, addr, default=None):
+        if addr in self.cache:
+            return self.cache[addr]
+        s = default
+        for base, data in self.sections:
+            if base <= addr < base + len(data):
+                end = data.find(b'\0', addr - base)
+                raw = data[addr - base:end] if end >= 0 else b''
+                if raw and all(c >= 0x20 and c < 0x7f or c in b'\r\n\t' for c in raw):
+                    s = raw.decode('ascii')
+                    self.cache[addr] = s
+                break
+        return s
+
+    def __len__(self):
+        return sum(len(data) for _, data in self.sections)
+
+
+def elf_strings(path):
+    """the read-only sections of the axf, as a StringTable"""
+    with open(path, 'rb') as f:
+        elf = f.read()
+    if elf[:4] != b'\x7fELF' or elf[4] != 1 or elf[5] != 1:
+        raise ValueError('%s is not a 32 bit little endian elf' % path)
+    shoff, = struct.unpack_from('<I', elf, 0x20)
+    shentsize, shnum = struct.unpack_from('<HH', elf, 0x2e)
+
+    sections = []
+    for i in range(shnum):
+        _, sh_type, flags, addr, offset, size = struct.unpack_from('<IIIIII', elf, shoff + i * shentsize)
+        if not flags & SHF_ALLOC or flags & SHF_WRITE or sh_type == SHT_NOBITS or size == 0:
+            continue
+        sections.append((addr, bytes(elf[offset:offset + size])))
+    return StringTable(sections)
+
+
+def load_table(path):
+    with open(path, 'r') as f:
+        saved = json.load(f)
+    return StringTable((int(k, 16), base64.b64decode(v)) for k, v in saved.items())
+
+
+def save_table(table, path):
+    with open(path, 'w') as f:
+        json.dump({'%08x' % base: base64.b64encode(data).decode('ascii') for base, data in table.sections},
+                  f, indent=0)
+
+
+def cformat(fmt, args, table):
+    """printf with 32 bit args, %s args are addresses of strings in the image"""
+    args = list(args)
+
+    def take():
+        return args.pop(0) if args else 0
+
+    def one(m):
+        flags, width, prec, _, conv = m.groups()
+        if conv == '%':
+            return '%'
+        if width == '*':
+            width = str(struct.unpack('<i', struct.pack('<I', take()))[0])
+        if prec == '*':
+            prec = str(take())
+        spec = '%' + flags + (width or '') + ('.' + prec if prec is not None else '')
+        v = take()
+        if conv in 'di':
+            return (spec + 'd') % struct.unpack('<i', struct.pack('<I', v))[0]
+        if conv == 'u':
+            return (spec + 'd') % v
+        if conv in 'oxX':
+            return (spec + conv) % v
+        if conv == 'c':
+            return (spec + 'c') % chr(v & 0xff)
+        if conv == 's':
+            return (spec + 's') % table.get(v, '<%08x>' % v)
+        if conv == 'p':
+            return (spec + 's') % ('0x%x' % v)
+        return '<%%%s?>' % conv
+
+    return CONV.sub(one, fmt)
+
+
+def read_varint(buf, pos):
+    v, shift = 0, 0
+    while pos < len(buf):
+        b = buf[pos]
+        pos += 1
+        v |= (b & 0x7f) << shift
+        if not b & 0x80:
+            return v & 0xffffffff, pos
+        shift += 7
+        if shift > 28:
+            raise ValueError('varint too long')
+    return None, pos
+
+
+class Decoder(object):
+    """feed uart bytes in any chunking, get text out"""
+
+    def __init__(self, table):
+        self.table = table
+        self.buf = bytearray()
+        self.frames = 0
+        self.bad = 0
+
+    def frame(self, pos):
+        """(text, length) of the frame at pos, (None, 0) if not a frame, None if incomplete"""
+        buf = self.buf
+        if len(buf) - pos < 7:
+            return None
+        argc = buf[pos + 1] - TAG
+        if not 0 <= argc <= ARG_MAX:
+            return (None, 0)
+        fid, = struct.unpack_from('<I', buf, pos + 2)
+        fmt = self.table.get(fid)
+        if fmt is None:
+            return (None, 0)
+        args = []
+        p = pos + 6
+        for _ in range(argc):
+            try:
+                v, p = read_varint(buf, p)
+            except ValueError:
+                return (None, 0)
+            if v is None:
+                return None
+            args.append(v)
+        if p >= len(buf):
+            return None
+        if sum(buf[pos + 1:p]) & 0xff != buf[p]:
+            return (None, 0)
+        return (cformat(fmt, args, self.table), p + 1 - pos)
+
+    def feed(self, data, final=False):
+        self.buf.extend(data)
+        out = []
+        start = pos = 0
+        while True:
+            pos = self.buf.find(SYNC, pos)
+            if pos < 0:
+                pos = len(self.buf)
+                break
+            res = self.frame(pos)
+            if res is None and not final:
+                break
+            if not res or res[0] is None:
+                pos += 1
+                continue
+            out.append(self.buf[start:pos].decode('utf-8', 'replace'))
+            out.append(res[0])
+            self.frames += 1
+            pos += res[1]
+            start = pos
+        out.append(self.buf[start:pos].decode('utf-8', 'replace'))
+        del self.buf[:pos]
+        return ''.join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode tkl_output.c trace frames')
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument('--elf', '-e', help='axf of the running image')
+    src.add_argument('--dict', '-d', help='sections saved with --save')
+    parser.add_argument('--save', help='save the read-only sections of --elf to a json file and exit')
+    parser.add_argument('--input', '-i', help='captured uart stream, stdin if not given')
+    parser.add_argument('--port', help='read from a serial port, needs pyserial')
+    parser.add_argument('--baud', type=int, default=921600)
+    args = parser.parse_args()
+
+    table = elf_strings(args.elf) if args.elf else load_table(args.dict)
+    if args.save:
+        save_table(table, args.save)
+        print('%s: %d bytes' % (args.save, len(table)))
+        return
+
+    dec = Decoder(table)
+    if args.port:
+        import serial
+        port = serial.Serial(args.port, args.baud, timeout=0.1)
+        try:
+            while True:
+                sys.stdout.write(dec.feed(port.read(4096)))
+                sys.stdout.flush()
+        except KeyboardInterrupt:
+            pass
+    else:
+        f = open(args.input, 'rb') if args.input else sys.stdin.buffer
+        while True:
+            data = f.read(65536)
+            if not data:
+                break
+            sys.stdout.write(dec.feed(data))
+    sys.stdout.write(dec.feed(b'', final=True))
+
+
+if __name__ == '__main__':
+    main()
@@ -16,6 +16,28 @@
 extern "C" {
 #endif
 
+#define TKL_HEAP_HIST_NUM       6   // free block buckets: <=32, <=128, <=512, <=2K, <=8K, >8K bytes
+
+typedef struct {
+    UINT_T total_size;              // total heap size of all regions
+    UINT_T free_size;               // current free heap size
+    UINT_T min_ever_free_size;      // minimum free heap size since boot
+    UINT_T max_free_block_size;     // largest block that can be allocated now
+    UINT_T free_block_num;          // number of free blocks
+    UINT_T free_block_hist[TKL_HEAP_HIST_NUM];
+    UINT_T malloc_cnt;              // successful allocations since boot
+    UINT_T free_cnt;                // frees since boot
+    UINT_T fail_cnt;                // failed allocations since boot
+} TKL_HEAP_STAT_T;
+
+typedef struct {
+    CHAR_T *file;                   // call site of the debug allocator, NULL when the caller gives none
+    INT_T line;
+    UINT_T cur_size;                // bytes currently held by the site
+    UINT_T peak_size;               // maximum bytes ever held by the site
+    UINT_T malloc_cnt;
+} TKL_HEAP_SITE_STAT_T;
+
 /**
 * @brief Alloc memory of system
 *
@@ -67,6 +89,32 @@ VOID_T *tkl_system_realloc(VOID_T* ptr, size_t size);
 */
 INT_T tkl_system_get_free_heap_size(VOID_T);
 
+/**
+* @brief Get heap telemetry of system
+*
+* @param[out] stat: heap statistics
+*
+* @note counters are maintained on every malloc/free, the free block
+*       figures are taken with one walk of the free lists
+*
+* @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+*/
+OPERATE_RET tkl_system_get_heap_stat(TKL_HEAP_STAT_T *stat);
+
+/**
+* @brief Get per call-site usage recorded by the debug allocator
+*
+* @param[out] sites: call-site array
+* @param[in] num: capacity of sites
+*
+* @note os_malloc/pvPortMalloc go through the debug allocator when
+*       OSMALLOC_STATISTICAL is set in sys_config.h, the site is the caller function
+*       (a compile time switch, tkl_system_get_heap_stat works without it)
+*
+* @return number of call sites written, 0 when the debug allocator is not used
+*/
+INT_T tkl_system_get_heap_site_stat(TKL_HEAP_SITE_STAT_T *sites, INT_T num);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -16,6 +16,42 @@
 extern "C" {
 #endif
 
+#define TKL_LOG_MODULE_MAX      32  // module ids for tkl_log_level_set, 0 is the default module
+#define TKL_LOG_ARG_MAX         6   // integer args of one tkl_log_output_args record
+
+#define TKL_LOG_MODULE_DEFAULT  0
+#define TKL_LOG_MODULE_WIFI     1   // tkl_wifi
+#define TKL_LOG_MODULE_NET      2   // tkl_lwip, netif glue
+
+typedef enum {
+    TKL_LOG_LEVEL_ERR = 0,
+    TKL_LOG_LEVEL_WARN,
+    TKL_LOG_LEVEL_NOTICE,
+    TKL_LOG_LEVEL_INFO,
+    TKL_LOG_LEVEL_DEBUG,
+    TKL_LOG_LEVEL_TRACE,
+} TKL_LOG_LEVEL_E;
+
+/* tkl_log_output_args with argc counted from the args, more than TKL_LOG_ARG_MAX fails to compile */
+#define TKL_LOG_ARGS(module, level, format, ...) \
+    do { \
+        _Static_assert(__TKL_LOG_NARG(__VA_ARGS__) <= TKL_LOG_ARG_MAX, "TKL_LOG_ARGS: too many args"); \
+        tkl_log_output_args(module, level, format, __TKL_LOG_NARG(__VA_ARGS__), ##__VA_ARGS__); \
+    } while (0)
+#define __TKL_LOG_NARG(...)     __TKL_LOG_NARG_(0, ##__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define __TKL_LOG_NARG_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, n, ...) n
+
+typedef struct {
+    UINT_T records;                 // records queued for the drain task
+    UINT_T drop_records;            // records lost because the ring was full
+    UINT_T drop_bytes;
+    UINT_T filtered;                // calls rejected by the module level before formatting
+    UINT_T ring_size;
+    UINT_T ring_high_water;         // most bytes ever waiting in the ring
+    UINT_T trace_frames;            // records sent as binary trace frames
+    UINT_T trace_bytes;
+} TKL_LOG_STAT_T;
+
 
 /**
 * @brief Output log information
@@ -50,6 +86,65 @@ OPERATE_RET tkl_log_close(VOID_T);
 */
 OPERATE_RET tkl_log_open(VOID_T);
 
+/**
+* @brief Output log information of a module at a level
+*
+* @param[in] module: module id, below TKL_LOG_MODULE_MAX
+* @param[in] level: log level, refer to TKL_LOG_LEVEL_E
+* @param[in] format: printf style format
+*
+* @note The level is checked before anything is formatted. Safe in interrupts.
+*
+* @return 
+*/
+VOID_T tkl_log_output_level(UINT8_T module, UINT8_T level, CONST CHAR_T *format, ...);
+
+/**
+* @brief Output log information formatted later by the drain task
+*
+* @param[in] module: module id, below TKL_LOG_MODULE_MAX
+* @param[in] level: log level, refer to TKL_LOG_LEVEL_E
+* @param[in] format: string literal, only the pointer is queued
+* @param[in] argc: number of args, up to TKL_LOG_ARG_MAX
+* @param[in] ...: 32 bit args, %s only for string literals, no 64 bit or floating point
+*
+* @note The cheapest way to log from interrupts and hot paths, nothing is formatted by the caller.
+*       In trace mode the args are sent as a binary frame and formatted on the host.
+*
+* @return 
+*/
+VOID_T tkl_log_output_args(UINT8_T module, UINT8_T level, CONST CHAR_T *format, UINT8_T argc, ...);
+
+/**
+* @brief Set the most verbose level a module still outputs
+*
+* @param[in] module: module id, below TKL_LOG_MODULE_MAX
+* @param[in] level: log level, refer to TKL_LOG_LEVEL_E
+*
+* @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+*/
+OPERATE_RET tkl_log_level_set(UINT8_T module, UINT8_T level);
+
+/**
+* @brief Get log pipeline counters
+*
+* @param[out] stat: counters
+*
+* @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+*/
+OPERATE_RET tkl_log_stat_get(TKL_LOG_STAT_T *stat);
+
+/**
+* @brief Send tkl_log_output_args records as binary trace frames
+*
+* @param[in] enable: TRUE for frames, FALSE for formatted text
+*
+* @note Frames are decoded on the host with beken_os/tools/log_decode.py and the axf of the running image.
+*
+* @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+*/
+OPERATE_RET tkl_log_trace_set(BOOL_T enable);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -16,10 +16,25 @@
 extern "C" {
 #endif
 
+#define TKL_SLEEP_VOTER_MAX     8   ///< voters, including the one of tkl_cpu_force_wakeup
 
+/**
+ * @brief sleep voter statistics
+ */
+typedef struct {
+    CONST CHAR_T    *name;          ///< voter name
+    UINT_T          votes;          ///< votes held now, sleep is blocked while not 0
+    UINT_T          blocks;         ///< times the voter started to block sleep
+    SYS_TIME_T      blocked_ms;     ///< total time sleep was blocked by the voter
+    SYS_TIME_T      max_ms;         ///< longest single block
+    SYS_TIME_T      since;          ///< start of the current block, valid while votes is not 0
+} TKL_SLEEP_VOTER_STAT_T;
 
 /**
  * @brief sleep callback register
+ *        pre_sleep_cb runs right before the cpu sleeps and post_wakeup_cb right
+ *        after it wakes, both with interrupts disabled. callbacks run in order
+ *        of registration.
  * 
  * @param[in] sleep_cb:  sleep callback
  *
@@ -28,7 +43,7 @@ extern "C" {
 OPERATE_RET tkl_cpu_sleep_callback_register(TUYA_SLEEP_CB_T *sleep_cb);
 
 /**
- * @brief allow to sleep
+ * @brief allow to sleep, drops the vote of tkl_cpu_force_wakeup however often that was called
  * 
  * @param[in] none
  *
@@ -37,7 +52,7 @@ OPERATE_RET tkl_cpu_sleep_callback_register(TUYA_SLEEP_CB_T *sleep_cb);
 VOID_T tkl_cpu_allow_sleep(VOID_T);
 
 /**
- * @brief force wakeup
+ * @brief force wakeup, keeps the cpu awake until tkl_cpu_allow_sleep, calls do not nest
  * 
  * @param[in] none
  *
@@ -45,6 +60,36 @@ VOID_T tkl_cpu_allow_sleep(VOID_T);
  */
 VOID_T tkl_cpu_force_wakeup(VOID_T);
 
+/**
+ * @brief register a sleep voter, a name already registered returns the same voter
+ *
+ * @param[in] name:   voter name, must stay valid
+ * @param[out] voter: voter id
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tkl_cpu_sleep_voter_register(CONST CHAR_T *name, UINT_T *voter);
+
+/**
+ * @brief add or drop a vote to keep the cpu awake, the cpu may sleep when no voter holds a vote
+ *
+ * @param[in] voter: voter id
+ * @param[in] awake: TRUE to add a vote, FALSE to drop one
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tkl_cpu_sleep_vote(UINT_T voter, BOOL_T awake);
+
+/**
+ * @brief get the statistics of a voter, the current block is included
+ *
+ * @param[in] voter: voter id, from 0 up to the first id that fails
+ * @param[out] stat: voter statistics
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tkl_cpu_sleep_voter_stat(UINT_T voter, TKL_SLEEP_VOTER_STAT_T *stat);
+
 /**
 * @brief Set the low power mode of CPU
 *
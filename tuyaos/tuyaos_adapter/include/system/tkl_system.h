@@ -16,6 +16,19 @@
 extern "C" {
 #endif
 
+#define TKL_TASK_NAME_LEN       16
+
+typedef struct {
+    CHAR_T name[TKL_TASK_NAME_LEN];
+    UINT_T number;                  // unique per task
+    UINT_T priority;
+    CHAR_T state;                   // X running, R ready, B blocked, S suspended
+    UINT64_T run_us;                // cpu time since the task was created
+    UINT64_T win_us;                // cpu time in the window
+    UINT16_T permille;              // share of the cpu time since boot
+    UINT16_T win_permille;          // share of the cpu time in the window
+} TKL_TASK_STAT_T;
+
 /**
  * @brief system enter critical
  *
@@ -125,6 +138,19 @@ VOID_T tkl_system_delay(UINT_T num_ms);
 
 OPERATE_RET tkl_system_get_cpu_info(TUYA_CPU_INFO_T **cpu_ary, INT_T *cpu_cnt);
 
+/**
+* @brief get cpu time used by each task
+*
+* @param[out] stats: task array, NULL only restarts the window
+* @param[in] num: capacity of stats
+* @param[out] window_us: time since the previous call, may be NULL
+*
+* @note the window is shared by all callers
+*
+* @return number of tasks written, 0 when run time stats are not enabled
+*/
+INT_T tkl_system_get_task_stat(TKL_TASK_STAT_T *stats, INT_T num, UINT64_T *window_us);
+
 
 #ifdef __cplusplus
 }
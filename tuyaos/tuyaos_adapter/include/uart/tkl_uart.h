@@ -16,6 +16,25 @@
 extern "C" {
 #endif
 
+/* tkl_uart_ioctl commands, arg is a TKL_UART_STAT_T* for GET */
+#define TKL_UART_STAT_GET_CMD       (TUYA_UART_USER_CMD + 1)
+#define TKL_UART_STAT_CLR_CMD       (TUYA_UART_USER_CMD + 2)
+/* arg is a UINT32_T* idle time in characters that ends an rx frame, 0 turns frame mode off */
+#define TKL_UART_RX_FRAME_CMD       (TUYA_UART_USER_CMD + 3)
+
+typedef struct {
+    UINT_T tx_bytes;                // bytes written to the tx fifo
+    UINT_T tx_bytes_per_sec;        // bytes written in the last full second
+    UINT_T tx_dma_bytes;            // part of tx_bytes moved by dma
+    UINT_T tx_drop;                 // bytes refused because the tx ring was full
+    UINT_T tx_isr_cnt;              // tx refill interrupts
+    UINT_T tx_isr_us;               // total time spent in the tx refill interrupt
+    UINT_T tx_isr_max_us;           // longest tx refill interrupt
+    UINT_T rx_bytes;                // bytes moved from the rx fifo to the ring
+    UINT_T rx_frames;               // frame callbacks in frame mode
+    UINT_T rx_drop;                 // bytes lost because the rx ring was full
+    UINT_T rx_overflow;             // hardware rx fifo overruns
+} TKL_UART_STAT_T;
 
 /**
  * @brief uart init
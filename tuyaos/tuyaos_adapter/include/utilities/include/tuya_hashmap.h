@@ -49,6 +49,8 @@ typedef ANY_T *ANY_T_ITER;
  * 
  * @param[in] table_size the hash table size
  * @return a new empty hashmap 
+ *
+ * @note table_size is rounded up to a power of two, the table grows with the element count
  */
 MAP_T tuya_hashmap_new(UINT_T table_size);
 
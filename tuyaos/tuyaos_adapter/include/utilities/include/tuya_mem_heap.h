@@ -19,28 +19,62 @@ extern "C" {
 
 #define MEM_HEAP_LIST_NUM (4)
 
+/* placement flags of a heap region, also used as allocation hint */
+#define MEM_HEAP_FLAG_NORMAL (0x00)
+#define MEM_HEAP_FLAG_FAST   (0x01) // zero-wait-state memory, e.g. TCM
+
+/* free block histogram buckets: <=32, <=128, <=512, <=2K, <=8K, >8K bytes */
+#define MEM_HEAP_HIST_NUM (6)
+
 typedef struct {
     void (*enter_critical)(void);
     void (*exit_critical)(void);
     void (*dbg_output)(char* format, ...);
 }heap_context_t;
 
+typedef struct {
+    unsigned int flags; // MEM_HEAP_FLAG_xxx
+    unsigned long total_size; // total region size
+    unsigned long free_size; // current free region size
+    unsigned long free_watermark; // minimum ever free region size
+    unsigned long max_free_block_size; // size of the largest free block in the region
+}heap_region_state_t;
+
 typedef struct {
     unsigned long total_size; // total heap size
     unsigned long free_size; // current free heap size
     unsigned long free_watermark; // minimum ever free heap size
     unsigned long max_free_block_size; //size of the largest free block
+    unsigned long free_block_num; // blocks on the free lists
+    unsigned long free_block_hist[MEM_HEAP_HIST_NUM]; // free blocks per size bucket
+    unsigned long malloc_cnt; // successful allocations since boot
+    unsigned long free_cnt; // frees since boot
+    unsigned long fail_cnt; // allocations that found no memory in any region
+    unsigned int region_num; // valid entries in region
+    heap_region_state_t region[MEM_HEAP_LIST_NUM];
 }heap_state_t;
 
+// recorded only by tuya_mem_heap_debug_xxx, the counters of heap_state_t are kept by every allocation
+typedef struct {
+    char *filename; // call site of tuya_mem_heap_debug_xxx, may be NULL
+    int line;
+    unsigned long cur_size; // bytes currently held by the site
+    unsigned long peak_size; // maximum bytes ever held by the site
+    unsigned long malloc_cnt;
+}heap_site_state_t;
+
 typedef void* HEAP_HANDLE;
 
 int tuya_mem_heap_init(heap_context_t *ctx);
 int tuya_mem_heap_create(void *start_addr, unsigned int size, HEAP_HANDLE *handle);
+int tuya_mem_heap_create_ex(void *start_addr, unsigned int size, unsigned int flags, HEAP_HANDLE *handle);
 int tuya_mem_heap_delete(HEAP_HANDLE handle);
 void* tuya_mem_heap_malloc(HEAP_HANDLE handle, unsigned int size);
+void* tuya_mem_heap_malloc_hint(unsigned int size, unsigned int hint);
 void* tuya_mem_heap_calloc(HEAP_HANDLE handle, unsigned int size);
 void* tuya_mem_heap_realloc(HEAP_HANDLE handle, void *ptr, unsigned int size);
 void tuya_mem_heap_free(HEAP_HANDLE handle, void *ptr);
+// flushes the size class caches, so that cached blocks show as free blocks
 void tuya_mem_heap_state(HEAP_HANDLE handle, heap_state_t *state);
 int tuya_mem_heap_available(HEAP_HANDLE handle);
 
@@ -48,6 +82,7 @@ void* tuya_mem_heap_debug_malloc(HEAP_HANDLE handle, unsigned int size, char* fi
 void* tuya_mem_heap_debug_calloc(HEAP_HANDLE handle, unsigned int size, char* filename, int line);
 void* tuya_mem_heap_debug_realloc(HEAP_HANDLE handle, void *ptr, unsigned int size, char* filename, int line);
 int tuya_mem_heap_diagnose(HEAP_HANDLE handle);
+int tuya_mem_heap_site_state(int idx, heap_site_state_t *site);
 
 #ifdef __cplusplus
 }
@@ -19,6 +19,12 @@
 typedef VOID_T* TUYA_QUEUE_HANDLE;
 typedef BOOL_T (*TRAVERSE_CB)(VOID_T*item, VOID_T *ctx);
 
+typedef enum {
+    QUEUE_STORE_LIST = 0,   ///< one node malloced per item on enqueue, the queue holds no item memory while empty
+    QUEUE_STORE_ARRAY,      ///< queue_len * item_size malloced at create, enqueue/dequeue never touch the heap
+    QUEUE_STORE_MAX
+}QUEUE_STORE_E;
+
 /**
  * @brief create and initialize a queue (FIFO)
  * 
@@ -32,6 +38,21 @@ typedef BOOL_T (*TRAVERSE_CB)(VOID_T*item, VOID_T *ctx);
  */
 OPERATE_RET tuya_queue_create(CONST UINT32_T queue_len, CONST UINT32_T item_size, TUYA_QUEUE_HANDLE *handle);
 
+/**
+ * @brief create and initialize a queue (FIFO) with the given item store
+ *
+ * @param[in] queue_len the maximum number of items that the queue can contain.
+ * @param[in] item_size the number of bytes each item in the queue will require.
+ * @param[in] store QUEUE_STORE_LIST, as tuya_queue_create, or QUEUE_STORE_ARRAY
+ * @param[out] handle the queue handle
+ *
+ * @note QUEUE_STORE_ARRAY takes the memory of a full queue up front, use it for
+ * short queues on hot paths that must not fail or wait on the heap.
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tuya_queue_create_ex(CONST UINT32_T queue_len, CONST UINT32_T item_size, CONST QUEUE_STORE_E store, TUYA_QUEUE_HANDLE *handle);
+
 /**
  * @brief enqueue, append to the tail
  *
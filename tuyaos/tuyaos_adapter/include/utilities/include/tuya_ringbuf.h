@@ -18,6 +18,11 @@
 #include "tuya_cloud_types.h"
 
 
+/*
+ * one producer and one consumer may use a ringbuff concurrently without any
+ * lock, e.g. an ISR writing and a task reading. more producers or consumers
+ * need external locking.
+ */
 typedef VOID_T* TUYA_RINGBUFF_T;
 
 typedef enum {
@@ -29,12 +34,12 @@ typedef enum {
 /**
  * @brief ringbuff create
  *
- * @param[in]   len:      ringbuff length
+ * @param[in]   len:      ringbuff length, rounded up to a power of two
  * @param[in]   type:     ringbuff type
  * @param[in]   ringbuff: ringbuff handle
  * @return  TRUE/ FALSE
  */
-OPERATE_RET tuya_ring_buff_create(UINT16_T len, RINGBUFF_TYPE_E type, TUYA_RINGBUFF_T *ringbuff);
+OPERATE_RET tuya_ring_buff_create(UINT32_T len, RINGBUFF_TYPE_E type, TUYA_RINGBUFF_T *ringbuff);
 
 /**
  * @brief ringbuff free
@@ -59,7 +64,7 @@ OPERATE_RET tuya_ring_buff_reset(TUYA_RINGBUFF_T ringbuff);
  * @param[in]   ringbuff: ringbuff handle
  * @return  size of ringbuff not used
  */
-UINT16_T tuya_ring_buff_free_size_get(TUYA_RINGBUFF_T ringbuff);
+UINT32_T tuya_ring_buff_free_size_get(TUYA_RINGBUFF_T ringbuff);
 
 /**
  * @brief ringbuff used size get
@@ -67,7 +72,16 @@ UINT16_T tuya_ring_buff_free_size_get(TUYA_RINGBUFF_T ringbuff);
  * @param[in]   ringbuff: ringbuff handle
  * @return  size of ringbuff used
  */
-UINT16_T tuya_ring_buff_used_size_get(TUYA_RINGBUFF_T ringbuff);
+UINT32_T tuya_ring_buff_used_size_get(TUYA_RINGBUFF_T ringbuff);
+
+/**
+ * @brief ringbuff overwritten size get
+ * unread bytes dropped by the producer in OVERFLOW_COVERAGE_TYPE
+ *
+ * @param[in]   ringbuff: ringbuff handle
+ * @return  size of data lost since create or reset
+ */
+UINT32_T tuya_ring_buff_overwrite_size_get(TUYA_RINGBUFF_T ringbuff);
 
 /**
  * @brief ringbuff data read 
@@ -77,7 +91,7 @@ UINT16_T tuya_ring_buff_used_size_get(TUYA_RINGBUFF_T ringbuff);
  * @param[in]   len:      read len
  * @return  length of the data read
  */
-UINT16_T tuya_ring_buff_read(TUYA_RINGBUFF_T ringbuff, VOID_T *data, UINT16_T len);
+UINT32_T tuya_ring_buff_read(TUYA_RINGBUFF_T ringbuff, VOID_T *data, UINT32_T len);
 
 /**
  * @brief ringbuff data peek 
@@ -88,7 +102,7 @@ UINT16_T tuya_ring_buff_read(TUYA_RINGBUFF_T ringbuff, VOID_T *data, UINT16_T le
  * @param[in]   len:      read len
  * @return  length of the data read
  */
-UINT16_T tuya_ring_buff_peek(TUYA_RINGBUFF_T ringbuff, VOID_T *data, UINT16_T len);
+UINT32_T tuya_ring_buff_peek(TUYA_RINGBUFF_T ringbuff, VOID_T *data, UINT32_T len);
 
 /**
  * @brief ringbuff data write 
@@ -98,7 +112,48 @@ UINT16_T tuya_ring_buff_peek(TUYA_RINGBUFF_T ringbuff, VOID_T *data, UINT16_T le
  * @param[in]   len:      write len
  * @return  length of the data write
  */
-UINT16_T tuya_ring_buff_write(TUYA_RINGBUFF_T ringbuff, CONST VOID_T *data, UINT16_T len);
+UINT32_T tuya_ring_buff_write(TUYA_RINGBUFF_T ringbuff, CONST VOID_T *data, UINT32_T len);
+
+/**
+ * @brief ringbuff zero-copy write, step 1
+ * hand out a contiguous area of the buff, fill it and call tuya_ring_buff_write_commit
+ *
+ * @param[in]   ringbuff: ringbuff handle
+ * @param[out]  span:     start of the writable area
+ * @param[in]   len:      wanted len
+ * @return  length of the writable area, may be less than len at the end of buff
+ */
+UINT32_T tuya_ring_buff_write_reserve(TUYA_RINGBUFF_T ringbuff, UINT8_T **span, UINT32_T len);
+
+/**
+ * @brief ringbuff zero-copy write, step 2
+ * make the data written into the reserved area visible to the consumer
+ *
+ * @param[in]   ringbuff: ringbuff handle
+ * @param[in]   len:      written len, not more than the reserved len
+ * @return  OPRT_OK on success. Others on error
+ */
+OPERATE_RET tuya_ring_buff_write_commit(TUYA_RINGBUFF_T ringbuff, UINT32_T len);
+
+/**
+ * @brief ringbuff zero-copy read, step 1
+ * hand out the contiguous part of the unread data, release it with tuya_ring_buff_consume
+ *
+ * @param[in]   ringbuff: ringbuff handle
+ * @param[out]  span:     start of the unread data
+ * @return  length of the contiguous unread data
+ */
+UINT32_T tuya_ring_buff_peek_span(TUYA_RINGBUFF_T ringbuff, UINT8_T **span);
+
+/**
+ * @brief ringbuff zero-copy read, step 2
+ * 
+ * @param[in]   ringbuff: ringbuff handle
+ * @param[in]   len:      consumed len
+ * @return  OPRT_OK on success. OPRT_COM_ERROR if, in OVERFLOW_COVERAGE_TYPE,
+ *          the span was overwritten while in use and its content must be discarded
+ */
+OPERATE_RET tuya_ring_buff_consume(TUYA_RINGBUFF_T ringbuff, UINT32_T len);
 
 
 #ifdef __cplusplus
@@ -18,6 +18,9 @@
 #define MEM_BLOCK_STATIC  (0)
 #define MEM_ANTI_FRAGMENT  (1)
 #define MEM_DEBUG_FREE_FILL (0)
+#ifndef MEM_SIZE_CLASS_ENABLE
+#define MEM_SIZE_CLASS_ENABLE  (1)
+#endif
 
 #define MEM_DEBUG_FILL_VAL  (0xF7)
 #define MEM_BLOCK_MIN_SIZE  (24)
@@ -27,6 +30,13 @@
 #define MEM_ALIGN_NUM  (4)
 #endif
 #define FIT_FIND_DEPTH (3)
+#ifndef MEM_DEBUG_SITE_NUM
+#define MEM_DEBUG_SITE_NUM (32) // call sites tracked by the debug allocator, first come first served
+#endif
+
+#define MEM_SIZE_CLASS_NUM        (6)
+#define MEM_SIZE_CLASS_BATCH      (4)  // blocks carved from the free list per class refill
+#define MEM_SIZE_CLASS_CACHE_MAX  (16) // cached blocks per class before frees go back to the free list
 
 
 #if MEM_BLOCK_MIN_SIZE < MEM_ALIGN_NUM
@@ -46,6 +56,11 @@ typedef struct
 	unsigned long size;
 	unsigned long free;
 	unsigned long free_watermark;
+	unsigned int flags;
+#if defined(MEM_SIZE_CLASS_ENABLE) && (MEM_SIZE_CLASS_ENABLE == 1)
+	MEM_HeapBlock_t * class_list[MEM_SIZE_CLASS_NUM];
+	unsigned short class_cnt[MEM_SIZE_CLASS_NUM];
+#endif
 }MEM_Heap_t;
 
 typedef struct
@@ -56,6 +71,7 @@ typedef struct
 	unsigned long valid;
 	unsigned long used_block;
 	unsigned long free_block;
+	unsigned long cache_block;
 }MEM_HeapStatus_t;
 
 #define MEM_DBG_LEAK_MAGIC 0x13572468
@@ -86,14 +102,34 @@ typedef struct
 
 #define MEM_BLOCK_STAT_USE  0x55
 #define MEM_BLOCK_STAT_FREE 0xaa
+#define MEM_BLOCK_STAT_CACHE 0x5a
 
 #define MEM_DOG_ADDR(block)  (( unsigned char* )block + block->size - 1 )
 #define MEM_LEAK_DBG_ADDR(block) ( MEM_DbgLeak_t* ) ( ( unsigned long )(intptr_t)block + block->size - sizeof(MEM_DbgLeak_t) - MEM_ALIGN_NUM)
+#define MEM_LEAK_DBG_VALID(block) ( (block)->size >= MEM_BLOCK_HEAD_SIZE + sizeof(MEM_DbgLeak_t) + MEM_ALIGN_NUM )
 
 static MEM_Heap_t mem_heap_list[MEM_HEAP_LIST_NUM] = {0};
 static unsigned long s_heap_free_size = 0;
 static unsigned long s_heap_free_size_watermark = 0; // minimum free size ever
 static heap_context_t s_heap_ctx;
+static unsigned long s_heap_malloc_cnt = 0;
+static unsigned long s_heap_free_cnt = 0;
+static unsigned long s_heap_fail_cnt = 0;
+static heap_site_state_t s_heap_site_list[MEM_DEBUG_SITE_NUM];
+static unsigned char s_heap_debug_used = 0; // set by the first debug allocation, frees skip the leak record until then
+
+// upper bound of each free block histogram bucket, the last bucket takes the rest
+static const unsigned long s_heap_hist_tbl[MEM_HEAP_HIST_NUM - 1] = {32, 128, 512, 2048, 8192};
+
+#if defined(MEM_SIZE_CLASS_ENABLE) && (MEM_SIZE_CLASS_ENABLE == 1)
+#define MEM_CLASS_BLOCK_SIZE(payload) (ALIGN_UP((payload) + 1) + MEM_BLOCK_HEAD_SIZE)
+
+// block size of each class, payload 16/32/64/128/256/512 bytes
+static const unsigned long s_size_class_tbl[MEM_SIZE_CLASS_NUM] = {
+	MEM_CLASS_BLOCK_SIZE(16),  MEM_CLASS_BLOCK_SIZE(32),  MEM_CLASS_BLOCK_SIZE(64),
+	MEM_CLASS_BLOCK_SIZE(128), MEM_CLASS_BLOCK_SIZE(256), MEM_CLASS_BLOCK_SIZE(512),
+};
+#endif
 
 static int mem_heap_init ( MEM_Heap_t * heap, void * ptr, unsigned long size )
 {
@@ -119,6 +155,10 @@ static int mem_heap_init ( MEM_Heap_t * heap, void * ptr, unsigned long size )
 
     heap->free = size;
     heap->free_watermark = size;
+#if defined(MEM_SIZE_CLASS_ENABLE) && (MEM_SIZE_CLASS_ENABLE == 1)
+	memset(heap->class_list, 0, sizeof(heap->class_list));
+	memset(heap->class_cnt, 0, sizeof(heap->class_cnt));
+#endif
 	s_heap_free_size += size;
 	s_heap_free_size_watermark = s_heap_free_size;
 
@@ -210,7 +250,174 @@ static MEM_HeapBlock_t * mem_chunk_get ( MEM_Heap_t * heap, unsigned long size )
 	return ( NULL );
 }
 
-static MEM_Heap_t *MEM_HeapCreate ( void*ptr, unsigned long size )
+/* insert a block (already tagged free) into the address-ordered free list, merging neighbours */
+static void mem_chunk_put ( MEM_Heap_t * heap, MEM_HeapBlock_t * free_block )
+{
+	MEM_HeapBlock_t * next_block;
+	MEM_HeapBlock_t * pre_block;
+
+	next_block = heap->free_list;
+	pre_block = NULL;
+	while ( next_block && ( next_block < free_block ) )
+	{
+		MEM_ASSERT ( ( unsigned long ) next_block >= ALIGN_UP ( heap->base ) );
+		MEM_ASSERT ( ( unsigned long ) next_block + next_block->size <= ALIGN_DOWN ( heap->base + heap->size ) );
+
+		pre_block = next_block;
+		next_block = next_block->next;
+
+		MEM_ASSERT ( ( !next_block ) || ( next_block > pre_block ) );
+	}
+
+	MEM_ASSERT ( ( !next_block ) || ( next_block > free_block ) );
+	MEM_ASSERT ( ( !pre_block ) || ( pre_block < free_block ) );
+
+	free_block->next = next_block;
+	if ( !pre_block )
+	{
+		heap->free_list = free_block;
+		pre_block    = free_block;
+	}
+	else
+	{
+		if ( ( ( char * ) pre_block + pre_block->size ) == ( char * ) free_block )
+		{
+#if defined(MEM_DEBUG_FREE_FILL) && (MEM_DEBUG_FREE_FILL == 1)
+            *MEM_DOG_ADDR ( pre_block ) = MEM_DEBUG_FILL_VAL;
+#endif
+
+			pre_block->size += free_block->size;
+
+#if defined(MEM_DEBUG_FREE_FILL) && (MEM_DEBUG_FREE_FILL == 1)
+            memset ( free_block, MEM_DEBUG_FILL_VAL, MEM_BLOCK_HEAD_SIZE);
+#endif
+		}
+		else
+		{
+			pre_block->next = free_block;
+			pre_block        = free_block;
+		}
+	}
+
+	if ( next_block )
+	{
+		if ( ( ( char * ) pre_block + pre_block->size ) == ( char * ) next_block )
+		{
+#if defined(MEM_DEBUG_FREE_FILL) && (MEM_DEBUG_FREE_FILL == 1)
+            *MEM_DOG_ADDR ( pre_block ) = MEM_DEBUG_FILL_VAL;
+#endif
+			pre_block->size  += next_block->size;
+			pre_block->next  = next_block->next;
+
+#if defined(MEM_DEBUG_FREE_FILL) && (MEM_DEBUG_FREE_FILL == 1)
+            memset ( next_block, MEM_DEBUG_FILL_VAL, sizeof ( MEM_HeapBlock_t ));
+#endif
+		}
+	}
+}
+
+#if defined(MEM_SIZE_CLASS_ENABLE) && (MEM_SIZE_CLASS_ENABLE == 1)
+static long mem_class_index ( unsigned long size )
+{
+	long i;
+
+	for ( i = 0; i < MEM_SIZE_CLASS_NUM; i++ )
+	{
+		if ( size <= s_size_class_tbl[i] )
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/* O(1) when the class list is not empty, otherwise carve a run of blocks from the free list */
+static MEM_HeapBlock_t * mem_class_get ( MEM_Heap_t * heap, long cls )
+{
+	MEM_HeapBlock_t * block;
+	MEM_HeapBlock_t * this_block;
+	unsigned long blk_size = s_size_class_tbl[cls];
+	unsigned long total;
+	long num;
+	long i;
+
+	block = heap->class_list[cls];
+	if ( block )
+	{
+		heap->class_list[cls] = block->next;
+		heap->class_cnt[cls]--;
+		*MEM_DOG_ADDR ( block ) = MEM_BLOCK_STAT_USE;
+		return block;
+	}
+
+	num = MEM_SIZE_CLASS_BATCH;
+	block = mem_chunk_get ( heap, blk_size * num );
+	if ( block == NULL )
+	{
+		return mem_chunk_get ( heap, blk_size );
+	}
+
+	/* every carved block keeps a normal header, so it can go back to the free list on its own */
+	total = block->size;
+	for ( i = num - 1; i > 0; i-- )
+	{
+		this_block = ( MEM_HeapBlock_t * ) (intptr_t)( ( unsigned long ) (intptr_t)block + i * blk_size );
+		this_block->size = ( i == num - 1 ) ? ( total - i * blk_size ) : blk_size;
+		*MEM_DOG_ADDR ( this_block ) = MEM_BLOCK_STAT_CACHE;
+		this_block->next = heap->class_list[cls];
+		heap->class_list[cls] = this_block;
+		heap->class_cnt[cls]++;
+	}
+
+	block->size = blk_size;
+	*MEM_DOG_ADDR ( block ) = MEM_BLOCK_STAT_USE;
+	return block;
+}
+
+/* returns 0 when the block was kept in its class list */
+static int mem_class_put ( MEM_Heap_t * heap, MEM_HeapBlock_t * block )
+{
+	long cls = mem_class_index ( block->size );
+
+	if ( ( cls < 0 ) || ( block->size != s_size_class_tbl[cls] ) ||
+	     ( heap->class_cnt[cls] >= MEM_SIZE_CLASS_CACHE_MAX ) )
+	{
+		return -1;
+	}
+
+	*MEM_DOG_ADDR ( block ) = MEM_BLOCK_STAT_CACHE;
+	block->next = heap->class_list[cls];
+	heap->class_list[cls] = block;
+	heap->class_cnt[cls]++;
+
+	return 0;
+}
+
+/* give every cached block back to the free list so that large requests can coalesce them */
+static int mem_class_flush ( MEM_Heap_t * heap )
+{
+	MEM_HeapBlock_t * block;
+	int flushed = 0;
+	long i;
+
+	for ( i = 0; i < MEM_SIZE_CLASS_NUM; i++ )
+	{
+		while ( ( block = heap->class_list[i] ) != NULL )
+		{
+			heap->class_list[i] = block->next;
+			*MEM_DOG_ADDR ( block ) = MEM_BLOCK_STAT_FREE;
+			mem_chunk_put ( heap, block );
+			flushed = 1;
+		}
+		heap->class_cnt[i] = 0;
+	}
+
+	return flushed;
+}
+#endif
+
+static MEM_Heap_t *MEM_HeapCreate ( void*ptr, unsigned long size, unsigned int flags )
 {
 	MEM_Heap_t * heap = NULL;
 	long i;
@@ -238,6 +445,10 @@ static MEM_Heap_t *MEM_HeapCreate ( void*ptr, unsigned long size )
 			heap->size = 0;
 			heap = NULL;
 		}
+		else
+		{
+			heap->flags = flags;
+		}
 	}
 	s_heap_ctx.exit_critical();
 	
@@ -274,13 +485,17 @@ static void * MEM_Allocate ( MEM_Heap_t * heap, unsigned long size)
 {
 	unsigned long new_size;
 	MEM_HeapBlock_t * block;
+#if defined(MEM_SIZE_CLASS_ENABLE) && (MEM_SIZE_CLASS_ENABLE == 1)
+	long cls;
+#endif
 
 	if ( heap == NULL || size == 0 )
 	{
 		return ( NULL );
 	}
 
-	size = size < 4 ? 4 : size;
+	// a freed block takes its next pointer from the payload, the dog byte must stay clear of it
+	size = size < sizeof(void *) ? sizeof(void *) : size;
 
 	new_size = ALIGN_UP ( size + 1 ) + MEM_BLOCK_HEAD_SIZE;
 	if ( new_size < size )
@@ -289,7 +504,24 @@ static void * MEM_Allocate ( MEM_Heap_t * heap, unsigned long size)
 	}
 
 	s_heap_ctx.enter_critical();
+#if defined(MEM_SIZE_CLASS_ENABLE) && (MEM_SIZE_CLASS_ENABLE == 1)
+	cls = mem_class_index ( new_size );
+	if ( cls >= 0 )
+	{
+		block = mem_class_get ( heap, cls );
+	}
+	else
+	{
+		block = mem_chunk_get ( heap, new_size );
+	}
+
+	if ( ( block == NULL ) && mem_class_flush ( heap ) )
+	{
+		block = mem_chunk_get ( heap, new_size );
+	}
+#else
 	block = mem_chunk_get ( heap, new_size );
+#endif
 	if(block) {
         heap->free -= block->size;
         if(heap->free_watermark > heap->free) {
@@ -300,6 +532,7 @@ static void * MEM_Allocate ( MEM_Heap_t * heap, unsigned long size)
         if(s_heap_free_size_watermark > s_heap_free_size) {
             s_heap_free_size_watermark = s_heap_free_size;
         }
+        s_heap_malloc_cnt++;
 	}
 	s_heap_ctx.exit_critical();
 		
@@ -311,6 +544,57 @@ static void * MEM_Allocate ( MEM_Heap_t * heap, unsigned long size)
 	return NULL;
 }
 
+/*
+ * must be called inside the critical section. a slot is taken once its site
+ * allocated, filename may be NULL (wolfssl XMALLOC passes no caller name).
+ */
+static void mem_heap_site_account ( char* filename, long line, unsigned long size, int is_alloc )
+{
+	heap_site_state_t * site = NULL;
+	long i;
+
+	for ( i = 0; i < MEM_DEBUG_SITE_NUM; i++ )
+	{
+		if ( s_heap_site_list[i].malloc_cnt == 0 )
+		{
+			if ( !is_alloc )
+			{
+				return;
+			}
+
+			site = &s_heap_site_list[i];
+			site->filename = filename;
+			site->line = line;
+			break;
+		}
+
+		if ( ( s_heap_site_list[i].filename == filename ) && ( s_heap_site_list[i].line == line ) )
+		{
+			site = &s_heap_site_list[i];
+			break;
+		}
+	}
+
+	if ( site == NULL )
+	{
+		return;
+	}
+
+	if ( is_alloc )
+	{
+		site->cur_size += size;
+		site->malloc_cnt++;
+		if ( site->cur_size > site->peak_size )
+		{
+			site->peak_size = site->cur_size;
+		}
+	}
+	else
+	{
+		site->cur_size = ( site->cur_size > size ) ? ( site->cur_size - size ) : 0;
+	}
+}
+
 static void * MEM_AllocateDebug ( MEM_Heap_t * heap, unsigned long size , char* filename, long line )
 {
 	void *p;
@@ -329,6 +613,11 @@ static void * MEM_AllocateDebug ( MEM_Heap_t * heap, unsigned long size , char*
 		leak->line = line;
 		leak->size = size;
 		leak->magic = MEM_DBG_LEAK_MAGIC;
+
+		s_heap_ctx.enter_critical();
+		s_heap_debug_used = 1;
+		mem_heap_site_account ( filename, line, size, 1 );
+		s_heap_ctx.exit_critical();
 	}
 
 	return p;
@@ -337,8 +626,6 @@ static void * MEM_AllocateDebug ( MEM_Heap_t * heap, unsigned long size , char*
 static void MEM_Deallocate ( MEM_Heap_t * heap, void*ptr)
 {
 	MEM_HeapBlock_t * free_block;
-	MEM_HeapBlock_t * next_block;
-	MEM_HeapBlock_t * pre_block;
 	unsigned char* pdog;
 
 	if ( heap == NULL || ptr == NULL )
@@ -354,7 +641,7 @@ static void MEM_Deallocate ( MEM_Heap_t * heap, void*ptr)
 	{
 		s_heap_ctx.dbg_output ( "[MEM DBG] MEM_Deallocate MEM_DEBUG_DOG_TAG err %p,size=%d\r\n", ptr, free_block->size );
 
-		if ( *pdog == MEM_BLOCK_STAT_FREE )
+		if ( ( *pdog == MEM_BLOCK_STAT_FREE ) || ( *pdog == MEM_BLOCK_STAT_CACHE ) )
 		{
 			s_heap_ctx.dbg_output ( "[MEM DBG] mem %p might be freed yet\r\n", ptr);
 		}
@@ -368,72 +655,33 @@ static void MEM_Deallocate ( MEM_Heap_t * heap, void*ptr)
 
 	s_heap_ctx.enter_critical();
 
-	*pdog = MEM_BLOCK_STAT_FREE;
-
 	MEM_ASSERT ( ( unsigned long ) free_block >= ( unsigned long ) heap->base );
 	MEM_ASSERT ( ( unsigned long ) free_block + free_block->size <= ( unsigned long ) heap->base + heap->size );
 
-	heap->free += free_block->size;
-	s_heap_free_size += free_block->size;
-
-	next_block = heap->free_list;
-	pre_block = NULL;
-	while ( next_block && ( next_block < free_block ) )
-	{
-		MEM_ASSERT ( ( unsigned long ) next_block >= ALIGN_UP ( heap->base ) );
-		MEM_ASSERT ( ( unsigned long ) next_block + next_block->size <= ALIGN_DOWN ( heap->base + heap->size ) );
-
-		pre_block = next_block;
-		next_block = next_block->next;
-
-		MEM_ASSERT ( ( !next_block ) || ( next_block > pre_block ) );
-	}
-
-	MEM_ASSERT ( ( !next_block ) || ( next_block > free_block ) );
-	MEM_ASSERT ( ( !pre_block ) || ( pre_block < free_block ) );
-
-	free_block->next = next_block;
-	if ( !pre_block )
+	if ( s_heap_debug_used && MEM_LEAK_DBG_VALID ( free_block ) )
 	{
-		heap->free_list = free_block;
-		pre_block    = free_block;
-	}
-	else
-	{
-		if ( ( ( char * ) pre_block + pre_block->size ) == ( char * ) free_block )
+		MEM_DbgLeak_t* leak = MEM_LEAK_DBG_ADDR ( free_block );
+		if ( leak->magic == MEM_DBG_LEAK_MAGIC )
 		{
-#if defined(MEM_DEBUG_FREE_FILL) && (MEM_DEBUG_FREE_FILL == 1)
-            *MEM_DOG_ADDR ( pre_block ) = MEM_DEBUG_FILL_VAL;
-#endif
-
-			pre_block->size += free_block->size;
-
-#if defined(MEM_DEBUG_FREE_FILL) && (MEM_DEBUG_FREE_FILL == 1)
-            memset ( free_block, MEM_DEBUG_FILL_VAL, MEM_BLOCK_HEAD_SIZE);
-#endif
-		}
-		else
-		{
-			pre_block->next = free_block;
-			pre_block        = free_block;
+			mem_heap_site_account ( leak->filename, leak->line, leak->size, 0 );
+			leak->magic = 0;
 		}
 	}
 
-	if ( next_block )
+	heap->free += free_block->size;
+	s_heap_free_size += free_block->size;
+	s_heap_free_cnt++;
+
+#if defined(MEM_SIZE_CLASS_ENABLE) && (MEM_SIZE_CLASS_ENABLE == 1)
+	if ( mem_class_put ( heap, free_block ) == 0 )
 	{
-		if ( ( ( char * ) pre_block + pre_block->size ) == ( char * ) next_block )
-		{
-#if defined(MEM_DEBUG_FREE_FILL) && (MEM_DEBUG_FREE_FILL == 1)
-            *MEM_DOG_ADDR ( pre_block ) = MEM_DEBUG_FILL_VAL;
+		s_heap_ctx.exit_critical();
+		return;
+	}
 #endif
-			pre_block->size  += next_block->size;
-			pre_block->next  = next_block->next;
 
-#if defined(MEM_DEBUG_FREE_FILL) && (MEM_DEBUG_FREE_FILL == 1)
-            memset ( next_block, MEM_DEBUG_FILL_VAL, sizeof ( MEM_HeapBlock_t ));
-#endif
-		}
-	}
+	*pdog = MEM_BLOCK_STAT_FREE;
+	mem_chunk_put ( heap, free_block );
 	s_heap_ctx.exit_critical();
 }
 
@@ -511,6 +759,11 @@ static void  MEM_HeapStatus ( MEM_Heap_t * heap, MEM_HeapStatus_t * status )
 			freeBlockp = freeBlockp->next;
 			status->free_block++;
 		}
+		else if(  *MEM_DOG_ADDR ( thisBlockp ) == MEM_BLOCK_STAT_CACHE )
+		{
+			status->free += thisBlockp->size - MEM_BLOCK_HEAD_SIZE - 1;
+			status->cache_block++;
+		}
 		else
 		{
             result = 3;
@@ -542,6 +795,113 @@ EXIT:
     }
 }
 
+/*
+ * walk the free list only, cheap enough to be called from production telemetry.
+ * cached blocks are counted in heap->free but not listed, they go back to the
+ * free list first so that the blocks and the largest one are what an allocation
+ * that misses would find after its flush
+ */
+static void mem_heap_free_scan ( MEM_Heap_t * heap, heap_state_t *state, heap_region_state_t *region )
+{
+	MEM_HeapBlock_t * block;
+	unsigned long size;
+	long i;
+
+	s_heap_ctx.enter_critical();
+#if defined(MEM_SIZE_CLASS_ENABLE) && (MEM_SIZE_CLASS_ENABLE == 1)
+	mem_class_flush ( heap );
+#endif
+	for ( block = heap->free_list; block; block = block->next )
+	{
+		size = block->size - MEM_BLOCK_HEAD_SIZE - 1;
+
+		for ( i = 0; i < MEM_HEAP_HIST_NUM - 1; i++ )
+		{
+			if ( size <= s_heap_hist_tbl[i] )
+			{
+				break;
+			}
+		}
+		state->free_block_hist[i]++;
+		state->free_block_num++;
+
+		if ( size > region->max_free_block_size )
+		{
+			region->max_free_block_size = size;
+		}
+	}
+	s_heap_ctx.exit_critical();
+
+	if ( region->max_free_block_size > state->max_free_block_size )
+	{
+		state->max_free_block_size = region->max_free_block_size;
+	}
+}
+
+static MEM_Heap_t * mem_heap_find ( void *ptr )
+{
+    long idx = 0 ;
+    MEM_Heap_t  * pHeap = NULL;
+
+    for ( idx = 0 ; idx < MEM_HEAP_LIST_NUM ; idx ++ )
+    {
+        pHeap = &mem_heap_list[idx] ;
+        if(pHeap->size > 0) {
+            if(((unsigned char *)ptr > pHeap->base) && ((unsigned char *)ptr < (pHeap->base + pHeap->size))) {
+                return pHeap;
+            }
+        } else {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * regions whose flags match the hint are tried first. a hinted allocation
+ * spills into the normal regions, a normal one never lands in a fast region:
+ * dma buffers come from plain malloc and tcm is not reachable for every master
+ */
+static void * mem_heap_alloc_hint ( unsigned long size, unsigned int hint, char* filename, long line )
+{
+    long pass = 0;
+    long idx = 0 ;
+    void *ptr = NULL;
+    MEM_Heap_t  * pHeap = NULL;
+
+    for(pass = 0; pass < 2; pass ++) {
+        for(idx = 0; idx < MEM_HEAP_LIST_NUM; idx ++) {
+            pHeap = &mem_heap_list[idx];
+            if(0 == pHeap->size) {
+                break;
+            }
+
+            if((0 == pass) ? (pHeap->flags != hint) :
+               ((MEM_HEAP_FLAG_NORMAL == hint) || (MEM_HEAP_FLAG_NORMAL != pHeap->flags))) {
+                continue;
+            }
+
+            if(pHeap->free > (size + MEM_BLOCK_MIN_SIZE)) {
+                if(filename) {
+                    ptr = MEM_AllocateDebug(pHeap, size, filename, line);
+                } else {
+                    ptr = MEM_Allocate(pHeap, size);
+                }
+                if(NULL != ptr) {
+                    return ptr;
+                }
+            }
+        }
+    }
+
+    s_heap_ctx.enter_critical();
+    s_heap_fail_cnt++;
+    s_heap_ctx.exit_critical();
+
+    return NULL;
+}
+
 int tuya_mem_heap_init(heap_context_t *ctx)
 {
     if((NULL == ctx) || (NULL == ctx->enter_critical) ||
@@ -557,12 +917,17 @@ int tuya_mem_heap_init(heap_context_t *ctx)
 }
 
 int tuya_mem_heap_create(void *start_addr, unsigned int size, HEAP_HANDLE *handle)
+{
+    return tuya_mem_heap_create_ex(start_addr, size, MEM_HEAP_FLAG_NORMAL, handle);
+}
+
+int tuya_mem_heap_create_ex(void *start_addr, unsigned int size, unsigned int flags, HEAP_HANDLE *handle)
 {
     MEM_Heap_t * pMemHeap = NULL;
 
-    s_heap_ctx.dbg_output("[MEM DBG] heap init-------size:%d addr:%p---------\r\n", size, start_addr);
+    s_heap_ctx.dbg_output("[MEM DBG] heap init-------size:%d addr:%p flags:%d---------\r\n", size, start_addr, flags);
 
-	pMemHeap = MEM_HeapCreate (start_addr, size);
+	pMemHeap = MEM_HeapCreate (start_addr, size, flags);
 	if(NULL == pMemHeap) {
 		return -1;
 	}
@@ -583,30 +948,23 @@ int tuya_mem_heap_delete(HEAP_HANDLE handle)
 void* tuya_mem_heap_malloc(HEAP_HANDLE handle, unsigned int size)
 {
     if(0 != handle) {
-        return MEM_Allocate((MEM_Heap_t *)handle, size);
-    } else {
-        long idx = 0 ;
-        void *ptr = NULL;
-        MEM_Heap_t  * pHeap = NULL;
-
-        for(idx = 0; idx < MEM_HEAP_LIST_NUM; idx ++) {
-            pHeap = &mem_heap_list[idx];
-            if(pHeap->size > 0) {
-                if(pHeap->free > (size + MEM_BLOCK_MIN_SIZE)) {
-                    ptr = MEM_Allocate(pHeap, size);
-                    if(NULL != ptr) {
-                        return ptr;
-                    }
-                }
-            } else {
-                break;
-            }
+        void *ptr = MEM_Allocate((MEM_Heap_t *)handle, size);
+        if(NULL == ptr) {
+            s_heap_ctx.enter_critical();
+            s_heap_fail_cnt++;
+            s_heap_ctx.exit_critical();
         }
-
-        return NULL;
+        return ptr;
+    } else {
+        return mem_heap_alloc_hint(size, MEM_HEAP_FLAG_NORMAL, NULL, 0);
     }
 }
 
+void* tuya_mem_heap_malloc_hint(unsigned int size, unsigned int hint)
+{
+    return mem_heap_alloc_hint(size, hint, NULL, 0);
+}
+
 void* tuya_mem_heap_calloc(HEAP_HANDLE handle, unsigned int size)
 {
     void *ptr = tuya_mem_heap_malloc(handle, size);
@@ -632,15 +990,21 @@ void* tuya_mem_heap_realloc(HEAP_HANDLE handle, void *ptr, unsigned int size)
 	}
 
 	unsigned long new_size;
-	size = size < 4 ? 4 : size;
+	size = size < sizeof(void *) ? sizeof(void *) : size;
 
 	new_size = ALIGN_UP ( size + 1 ) + MEM_BLOCK_HEAD_SIZE;
 	if ( new_size <= old_block->size ) { // old buffer is big enough
 		return ptr;
 	}
 
-	// alloc new buffer
-	void* tmp = tuya_mem_heap_malloc(handle, size);
+	// alloc new buffer, keep it in the same kind of region as the old one
+	void* tmp = NULL;
+	if(0 != handle) {
+		tmp = tuya_mem_heap_malloc(handle, size);
+	} else {
+		MEM_Heap_t *pHeap = mem_heap_find(ptr);
+		tmp = mem_heap_alloc_hint(size, pHeap ? pHeap->flags : MEM_HEAP_FLAG_NORMAL, NULL, 0);
+	}
 	if(NULL == tmp) {
 		return NULL;
 	}
@@ -655,21 +1019,7 @@ void tuya_mem_heap_free(HEAP_HANDLE handle, void *ptr)
     if(0 != handle) {
         MEM_Deallocate((MEM_Heap_t *)handle, ptr);
     } else {
-        long idx = 0 ;
-        MEM_Heap_t  * pHeap = NULL;
-
-        for ( idx = 0 ; idx < MEM_HEAP_LIST_NUM ; idx ++ )
-        {
-            pHeap = &mem_heap_list[idx] ;
-            if(pHeap->size > 0) {
-                if(((unsigned char *)ptr > pHeap->base) && ((unsigned char *)ptr < (pHeap->base + pHeap->size))) {
-                    MEM_Deallocate(pHeap, ptr);
-                    break;
-                }
-            } else {
-                break;
-            }
-        }
+        MEM_Deallocate(mem_heap_find(ptr), ptr);
     }
 }
 
@@ -689,6 +1039,12 @@ void tuya_mem_heap_state(HEAP_HANDLE handle, heap_state_t *state)
     }
 
     MEM_Heap_t  * pHeap = (MEM_Heap_t *)handle;
+    heap_region_state_t *region = NULL;
+
+    memset(state, 0, sizeof(heap_state_t));
+    state->malloc_cnt = s_heap_malloc_cnt;
+    state->free_cnt = s_heap_free_cnt;
+    state->fail_cnt = s_heap_fail_cnt;
 
     if(0 == handle) {
         long idx = 0 ;
@@ -700,6 +1056,13 @@ void tuya_mem_heap_state(HEAP_HANDLE handle, heap_state_t *state)
             pHeap = &mem_heap_list[idx];
             if(pHeap->size > 0) {
                 state->total_size += pHeap->size;
+
+                region = &state->region[state->region_num++];
+                region->flags = pHeap->flags;
+                region->total_size = pHeap->size;
+                region->free_size = pHeap->free;
+                region->free_watermark = pHeap->free_watermark;
+                mem_heap_free_scan(pHeap, state, region);
             } else {
                 break;
             }
@@ -708,33 +1071,28 @@ void tuya_mem_heap_state(HEAP_HANDLE handle, heap_state_t *state)
         state->total_size = pHeap->size;
         state->free_size = pHeap->free;
         state->free_watermark = pHeap->free_watermark;
+
+        region = &state->region[state->region_num++];
+        region->flags = pHeap->flags;
+        region->total_size = pHeap->size;
+        region->free_size = pHeap->free;
+        region->free_watermark = pHeap->free_watermark;
+        mem_heap_free_scan(pHeap, state, region);
     }
 }
 
 void* tuya_mem_heap_debug_malloc(HEAP_HANDLE handle, unsigned int size, char* filename, int line)
 {
     if(0 != handle) {
-        return MEM_AllocateDebug((MEM_Heap_t *)handle, size, filename, line);
-    } else {
-        long idx = 0 ;
-        void *ptr = NULL;
-        MEM_Heap_t  * pHeap = NULL;
-
-        for(idx = 0; idx < MEM_HEAP_LIST_NUM; idx ++) {
-            pHeap = &mem_heap_list[idx];
-            if(pHeap->size > 0) {
-                if(pHeap->free > (size + MEM_BLOCK_MIN_SIZE)) {
-                    ptr = MEM_AllocateDebug((MEM_Heap_t *)pHeap, size, filename, line);
-                    if(NULL != ptr) {
-                        return ptr;
-                    }
-                }
-            } else {
-                break;
-            }
+        void *ptr = MEM_AllocateDebug((MEM_Heap_t *)handle, size, filename, line);
+        if(NULL == ptr) {
+            s_heap_ctx.enter_critical();
+            s_heap_fail_cnt++;
+            s_heap_ctx.exit_critical();
         }
-
-        return NULL;
+        return ptr;
+    } else {
+        return mem_heap_alloc_hint(size, MEM_HEAP_FLAG_NORMAL, filename, line);
     }
 }
 
@@ -772,8 +1130,8 @@ int tuya_mem_heap_diagnose(HEAP_HANDLE handle)
             s_heap_ctx.dbg_output("[MEM DBG] SYS_MemStat !!!!! MEM MNG DAMAGED!!!!! \r\n");
         }
 
-        s_heap_ctx.dbg_output("[MEM DBG] Heap size=%d, free=%d, free_largest=%d, malloc_block=%d, free_block=%d\r\n",
-            memst.size, memst.free, memst.free_largest, memst.used_block, memst.free_block);
+        s_heap_ctx.dbg_output("[MEM DBG] Heap size=%d, free=%d, free_largest=%d, malloc_block=%d, free_block=%d, cache_block=%d\r\n",
+            memst.size, memst.free, memst.free_largest, memst.used_block, memst.free_block, memst.cache_block);
     } else {
         long idx = 0 ;
 
@@ -786,8 +1144,8 @@ int tuya_mem_heap_diagnose(HEAP_HANDLE handle)
                     s_heap_ctx.dbg_output("[MEM DBG] SYS_MemStat !!!!! MEM MNG DAMAGED!!!!! \r\n");
                 }
 
-                s_heap_ctx.dbg_output("[MEM DBG] Heap size=%d, free=%d, free_largest=%d, malloc_block=%d, free_block=%d\r\n",
-                    memst.size, memst.free, memst.free_largest, memst.used_block, memst.free_block);
+                s_heap_ctx.dbg_output("[MEM DBG] Heap size=%d, free=%d, free_largest=%d, malloc_block=%d, free_block=%d, cache_block=%d\r\n",
+                    memst.size, memst.free, memst.free_largest, memst.used_block, memst.free_block, memst.cache_block);
             } else {
                 break;
             }
@@ -797,3 +1155,20 @@ int tuya_mem_heap_diagnose(HEAP_HANDLE handle)
     return 0;
 }
 
+int tuya_mem_heap_site_state(int idx, heap_site_state_t *site)
+{
+    int ret = -1;
+
+    if((NULL == site) || (idx < 0) || (idx >= MEM_DEBUG_SITE_NUM)) {
+        return -1;
+    }
+
+    s_heap_ctx.enter_critical();
+    if(0 != s_heap_site_list[idx].malloc_cnt) {
+        *site = s_heap_site_list[idx];
+        ret = 0;
+    }
+    s_heap_ctx.exit_critical();
+
+    return ret;
+}
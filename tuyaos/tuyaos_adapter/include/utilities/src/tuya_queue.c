@@ -47,10 +47,33 @@ typedef struct {
     UINT32_T item_size;
     UINT32_T queue_len;
     UINT32_T queue_free;
-    
-    LIST_HEAD head;
+    QUEUE_STORE_E store;
+
+    LIST_HEAD list; // QUEUE_STORE_LIST
+    UINT32_T head;  // QUEUE_STORE_ARRAY, slot of the first item
+    UCHAR_T *buff;  // QUEUE_STORE_ARRAY, queue_len * item_size
 }TUYA_QUEUE_T;
 
+/* address of the idx-th item counted from the head, idx < queue_len */
+STATIC UCHAR_T *__queue_slot(TUYA_QUEUE_T *queue, UINT32_T idx)
+{
+    idx += queue->head;
+    if(idx >= queue->queue_len) {
+        idx -= queue->queue_len;
+    }
+
+    return queue->buff + idx * queue->item_size;
+}
+
+STATIC VOID_T __queue_head_forward(TUYA_QUEUE_T *queue, UINT32_T num)
+{
+    queue->head += num;
+    if(queue->head >= queue->queue_len) {
+        queue->head -= queue->queue_len;
+    }
+    queue->queue_free += num;
+}
+
 STATIC OPERATE_RET __enqueue(TUYA_QUEUE_HANDLE handle, CONST VOID_T *item, ENQUEUE_POLICY_E policy)
 {
     OPERATE_RET op_ret = OPRT_OK;
@@ -60,7 +83,25 @@ STATIC OPERATE_RET __enqueue(TUYA_QUEUE_HANDLE handle, CONST VOID_T *item, ENQUE
     }
 
     TUYA_QUEUE_T *queue = (TUYA_QUEUE_T *)handle;
-    
+
+    if(QUEUE_STORE_ARRAY == queue->store) {
+        QUEUE_LOCK(queue);
+        if(queue->queue_free > 0) {
+            if(POLICY_SEND_TO_BACK == policy) {
+                memcpy(__queue_slot(queue, queue->queue_len - queue->queue_free), item, queue->item_size);
+            } else if(POLICY_SEND_TO_FRONT == policy){
+                queue->head = (0 == queue->head) ? (queue->queue_len - 1) : (queue->head - 1);
+                memcpy(__queue_slot(queue, 0), item, queue->item_size);
+            }
+            queue->queue_free--;
+        } else {
+            op_ret = OPRT_EXCEED_UPPER_LIMIT;
+        }
+        QUEUE_UNLOCK(queue);
+
+        return op_ret;
+    }
+
     QUEUE_ITEM_T *queue_item = (QUEUE_ITEM_T *)tkl_system_malloc(SIZEOF(QUEUE_ITEM_T) + queue->item_size);
     if(NULL == queue_item) {
         return OPRT_MALLOC_FAILED;
@@ -72,9 +113,9 @@ STATIC OPERATE_RET __enqueue(TUYA_QUEUE_HANDLE handle, CONST VOID_T *item, ENQUE
     QUEUE_LOCK(queue);
     if(queue->queue_free > 0) {
         if(POLICY_SEND_TO_BACK == policy) {
-            tuya_list_add_tail(&(queue_item->node), &(queue->head));
+            tuya_list_add_tail(&(queue_item->node), &(queue->list));
         } else if(POLICY_SEND_TO_FRONT == policy){
-            tuya_list_add(&(queue_item->node), &(queue->head));
+            tuya_list_add(&(queue_item->node), &(queue->list));
         }
         queue->queue_free--;
     } else {
@@ -99,15 +140,38 @@ STATIC OPERATE_RET __enqueue(TUYA_QUEUE_HANDLE handle, CONST VOID_T *item, ENQUE
  * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
  */
 OPERATE_RET tuya_queue_create(CONST UINT32_T queue_len, CONST UINT32_T item_size, TUYA_QUEUE_HANDLE *handle)
+{
+    return tuya_queue_create_ex(queue_len, item_size, QUEUE_STORE_LIST, handle);
+}
+
+/**
+ * @brief create and initialize a queue (FIFO) with the given item store
+ *
+ * @param[in] queue_len the maximum number of items that the queue can contain.
+ * @param[in] item_size the number of bytes each item in the queue will require.
+ * @param[in] store QUEUE_STORE_LIST or QUEUE_STORE_ARRAY
+ * @param[out] handle the queue handle
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tuya_queue_create_ex(CONST UINT32_T queue_len, CONST UINT32_T item_size, CONST QUEUE_STORE_E store, TUYA_QUEUE_HANDLE *handle)
 {
     OPERATE_RET op_ret = OPRT_OK;
     TUYA_QUEUE_T *queue = NULL;
+    UINT32_T buff_size = 0;
 
-    if((NULL == handle) || (0 == queue_len) || (0 == item_size)) {
+    if((NULL == handle) || (0 == queue_len) || (0 == item_size) || (store >= QUEUE_STORE_MAX)) {
         return OPRT_INVALID_PARM;
     }
 
-    queue = (TUYA_QUEUE_T *)tkl_system_malloc(SIZEOF(TUYA_QUEUE_T));
+    if(QUEUE_STORE_ARRAY == store) {
+        if(queue_len > (0xFFFFFFFF - SIZEOF(TUYA_QUEUE_T)) / item_size) {
+            return OPRT_INVALID_PARM;
+        }
+        buff_size = queue_len * item_size;
+    }
+
+    queue = (TUYA_QUEUE_T *)tkl_system_malloc(SIZEOF(TUYA_QUEUE_T) + buff_size);
     if(!queue) {
         return OPRT_MALLOC_FAILED;
     }
@@ -121,7 +185,10 @@ OPERATE_RET tuya_queue_create(CONST UINT32_T queue_len, CONST UINT32_T item_size
     queue->item_size = item_size;
     queue->queue_len = queue_len;
     queue->queue_free = queue_len;
-    INIT_LIST_HEAD(&(queue->head));
+    queue->store = store;
+    INIT_LIST_HEAD(&(queue->list));
+    queue->head = 0;
+    queue->buff = buff_size ? (UCHAR_T *)(queue + 1) : NULL;
 
     *handle = (TUYA_QUEUE_HANDLE)queue;
 
@@ -173,22 +240,28 @@ OPERATE_RET tuya_queue_output(TUYA_QUEUE_HANDLE handle, CONST VOID_T *item)
     TUYA_QUEUE_T *queue = (TUYA_QUEUE_T *)handle;
 
     QUEUE_LOCK(queue);
-    if(queue->queue_free < queue->queue_len) {
-        QUEUE_ITEM_T *queue_item = tuya_list_entry(queue->head.next, QUEUE_ITEM_T, node);
+    if(queue->queue_free >= queue->queue_len) {
+        op_ret = OPRT_NOT_FOUND;
+    } else if(QUEUE_STORE_ARRAY == queue->store) {
+        if(item) {
+            memcpy((VOID_T *)item, __queue_slot(queue, 0), queue->item_size);
+        }
+        __queue_head_forward(queue, 1);
+    } else {
+        QUEUE_ITEM_T *queue_item = tuya_list_entry(queue->list.next, QUEUE_ITEM_T, node);
         if(item) {
             memcpy((VOID_T *)item, queue_item->data, queue->item_size);
         }
         tuya_list_del(&(queue_item->node));
         tkl_system_free(queue_item);
         queue->queue_free++;
-    } else {
-        op_ret = OPRT_NOT_FOUND;
     }
     QUEUE_UNLOCK(queue);
 
     return op_ret;
 }
 
+
 /**
  * @brief get the peek item,  not dequeue
  *
@@ -208,11 +281,13 @@ OPERATE_RET tuya_queue_peek(TUYA_QUEUE_HANDLE handle, CONST VOID_T *item)
     TUYA_QUEUE_T *queue = (TUYA_QUEUE_T *)handle;
 
     QUEUE_LOCK(queue);
-    if(queue->queue_free < queue->queue_len) {
-        QUEUE_ITEM_T *queue_item = tuya_list_entry(queue->head.next, QUEUE_ITEM_T, node);
-        memcpy((VOID_T *)item, queue_item->data, queue->item_size);
-    } else {
+    if(queue->queue_free >= queue->queue_len) {
         op_ret = OPRT_NOT_FOUND;
+    } else if(QUEUE_STORE_ARRAY == queue->store) {
+        memcpy((VOID_T *)item, __queue_slot(queue, 0), queue->item_size);
+    } else {
+        QUEUE_ITEM_T *queue_item = tuya_list_entry(queue->list.next, QUEUE_ITEM_T, node);
+        memcpy((VOID_T *)item, queue_item->data, queue->item_size);
     }
     QUEUE_UNLOCK(queue);
 
@@ -235,12 +310,21 @@ OPERATE_RET tuya_queue_traverse(TUYA_QUEUE_HANDLE handle, TRAVERSE_CB cb, VOID_T
     TUYA_QUEUE_T *queue = (TUYA_QUEUE_T *)handle;
     struct tuya_list_head *p = NULL;
     QUEUE_ITEM_T *queue_item = NULL;
+    UINT32_T index = 0;
 
     QUEUE_LOCK(queue);
-    tuya_list_for_each(p, &(queue->head)) {
-        queue_item = tuya_list_entry(p, QUEUE_ITEM_T, node);
-        if(!cb(queue_item->data, ctx)) {
-            break;
+    if(QUEUE_STORE_ARRAY == queue->store) {
+        for(index = 0; index < queue->queue_len - queue->queue_free; index++) {
+            if(!cb(__queue_slot(queue, index), ctx)) {
+                break;
+            }
+        }
+    } else {
+        tuya_list_for_each(p, &(queue->list)) {
+            queue_item = tuya_list_entry(p, QUEUE_ITEM_T, node);
+            if(!cb(queue_item->data, ctx)) {
+                break;
+            }
         }
     }
     QUEUE_UNLOCK(queue);
@@ -267,11 +351,12 @@ OPERATE_RET tuya_queue_clear(TUYA_QUEUE_HANDLE handle)
     QUEUE_ITEM_T *queue_item = NULL;
 
     QUEUE_LOCK(queue);
-    tuya_list_for_each_safe(p, n, &(queue->head)) {
+    tuya_list_for_each_safe(p, n, &(queue->list)) {
         queue_item = tuya_list_entry(p, QUEUE_ITEM_T, node);
         tuya_list_del(&queue_item->node);
         tkl_system_free(queue_item);
     }
+    queue->head = 0;
     queue->queue_free = queue->queue_len;
     QUEUE_UNLOCK(queue);
 
@@ -299,9 +384,25 @@ OPERATE_RET tuya_queue_get_batch(TUYA_QUEUE_HANDLE handle, CONST UINT32_T start,
     QUEUE_ITEM_T *queue_item = NULL;
     UINT32_T index = 0;
     UINT32_T count = 0;
+    UINT32_T used = 0;
+
+    if(QUEUE_STORE_ARRAY == queue->store) {
+        QUEUE_LOCK(queue);
+        used = queue->queue_len - queue->queue_free;
+        for(count = 0; (count < num) && (start + count < used); count++) {
+            memcpy((UCHAR_T*)items + count * queue->item_size, __queue_slot(queue, start + count), queue->item_size);
+        }
+        QUEUE_UNLOCK(queue);
+
+        if(start >= used || count != num) {
+            return OPRT_NOT_FOUND;
+        }
+
+        return OPRT_OK;
+    }
 
     QUEUE_LOCK(queue);
-    tuya_list_for_each(p, &(queue->head)) {
+    tuya_list_for_each(p, &(queue->list)) {
         if(index < start) {
             index++;
             continue;
@@ -341,6 +442,22 @@ OPERATE_RET tuya_queue_delete_batch(TUYA_QUEUE_HANDLE handle, CONST UINT32_T num
         return OPRT_INVALID_PARM;
     }
 
+    TUYA_QUEUE_T *queue = (TUYA_QUEUE_T *)handle;
+
+    if(QUEUE_STORE_ARRAY == queue->store) {
+        QUEUE_LOCK(queue);
+        count = queue->queue_len - queue->queue_free;
+        if(count < num) {
+            op_ret = OPRT_NOT_FOUND;
+        } else {
+            count = num;
+        }
+        __queue_head_forward(queue, count);
+        QUEUE_UNLOCK(queue);
+
+        return op_ret;
+    }
+
     while((count-- > 0) && (OPRT_OK == op_ret)) {
         op_ret = tuya_queue_output(handle, NULL);
     }
@@ -1,3 +1,4 @@
+
 #include "tkl_memory.h"
 #include "tuya_ringbuf.h"
 
@@ -9,50 +10,141 @@
 #define GET_MIN(x, y)   ((x) < (y) ? (x) : (y))
 #define GET_MAX(x, y)   ((x) > (y) ? (x) : (y))
 
+/*
+ * order buffer accesses against index updates. the target cores are single-core,
+ * where a compiler barrier is enough between an ISR and a task; SMP hosts need a
+ * real fence.
+ */
+#ifndef RINGBUFF_BARRIER
+#if defined(SYSTEM_LINUX) && (OPERATING_SYSTEM == SYSTEM_LINUX)
+#define RINGBUFF_BARRIER()  __sync_synchronize()
+#else
+#define RINGBUFF_BARRIER()  __asm__ __volatile__("" ::: "memory")
+#endif
+#endif
+
 
 /*
  * ringbuff structure
+ *
+ * in/out are free-running counters, the buffer position is counter & mask.
+ * in is only written by the producer and out only by the consumer, so one
+ * producer and one consumer need no lock. resv is the producer's write
+ * frontier in coverage mode, the consumer checks it to detect data that was
+ * overwritten while being read.
 */
 typedef struct {
     RINGBUFF_TYPE_E type;   ///< ringbuff type
-    UINT8_T  reserved;      ///< Reserved
-    UINT16_T in;            ///< position of input
-    UINT16_T out;           ///< position of output
-    UINT16_T len;           ///< length of buff data
+    UINT32_T size;          ///< buff size, power of two
+    UINT32_T mask;          ///< size - 1
+    volatile UINT32_T in;   ///< input counter
+    volatile UINT32_T out;  ///< output counter
+    volatile UINT32_T resv; ///< producer frontier, coverage mode only
+    UINT32_T overwrite;     ///< bytes lost to overwriting, updated by the consumer
     UINT8_T buff[];         ///< ring buff
 } __RINGBUFF_T;
 
 #define RINGBUFF_SIZE   sizeof(__RINGBUFF_T)
 
 
-STATIC VOID_T __ringbuff_init(__RINGBUFF_T *ringbuff, UINT16_T len)
+STATIC VOID_T __ringbuff_init(__RINGBUFF_T *ringbuff)
 {
     ringbuff->in = 0;
     ringbuff->out = 0;
-    ringbuff->len = len;
+    ringbuff->resv = 0;
+    ringbuff->overwrite = 0;
 }
 
+STATIC UINT32_T __ringbuff_roundup_pow2(UINT32_T len)
+{
+    UINT32_T size = 1;
 
-OPERATE_RET tuya_ring_buff_create(UINT16_T len, RINGBUFF_TYPE_E type, TUYA_RINGBUFF_T *ringbuff)
+    while (size < len) {
+        size <<= 1;
+    }
+
+    return size;
+}
+
+/* consumer side: oldest valid counter, skipping what the producer already overwrote */
+STATIC UINT32_T __ringbuff_out_get(__RINGBUFF_T *rbuff, UINT32_T in)
 {
-    __RINGBUFF_T *rbuff = NULL;
-    __RINGBUFF_T **out_ring_buff = (__RINGBUFF_T **)ringbuff;
-    
+    UINT32_T out = rbuff->out;
 
-    if(type == OVERFLOW_COVERAGE_TYPE) {
-        return OPRT_NOT_SUPPORTED;
+    if (in - out > rbuff->size) {
+        out = in - rbuff->size;
     }
 
-    if(ringbuff == NULL || len == 0) {
+    return out;
+}
+
+/* consumer side: publish a new output counter, accounting the skipped bytes */
+STATIC VOID_T __ringbuff_out_set(__RINGBUFF_T *rbuff, UINT32_T out, UINT32_T skip_to)
+{
+    rbuff->overwrite += skip_to - rbuff->out;
+    rbuff->out = out;
+}
+
+STATIC VOID_T __ringbuff_copy_out(__RINGBUFF_T *rbuff, UINT32_T out, UINT8_T *pdata, UINT32_T len)
+{
+    UINT32_T pos = out & rbuff->mask;
+    UINT32_T tmp_len = GET_MIN(rbuff->size - pos, len);
+
+    memcpy(pdata, &rbuff->buff[pos], tmp_len);
+    if (len > tmp_len) {
+        memcpy(&pdata[tmp_len], rbuff->buff, len - tmp_len);
+    }
+}
+
+/* copy up to len bytes from the consumer position, retrying if the producer laps the copy */
+STATIC UINT32_T __ringbuff_fetch(__RINGBUFF_T *rbuff, UINT8_T *pdata, UINT32_T len, UINT32_T *next_out)
+{
+    UINT32_T in, out;
+
+    for (;;) {
+        in = rbuff->in;
+        RINGBUFF_BARRIER();
+        out = __ringbuff_out_get(rbuff, in);
+        len = GET_MIN(len, in - out);
+        if (len == 0) {
+            break;
+        }
+
+        __ringbuff_copy_out(rbuff, out, pdata, len);
+
+        if (rbuff->type != OVERFLOW_COVERAGE_TYPE) {
+            break;
+        }
+
+        RINGBUFF_BARRIER();
+        if (rbuff->resv - out <= rbuff->size) {
+            break;
+        }
+    }
+
+    *next_out = out + len;
+    return len;
+}
+
+OPERATE_RET tuya_ring_buff_create(UINT32_T len, RINGBUFF_TYPE_E type, TUYA_RINGBUFF_T *ringbuff)
+{
+    UINT32_T size;
+    __RINGBUFF_T *rbuff = NULL;
+    __RINGBUFF_T **out_ring_buff = (__RINGBUFF_T **)ringbuff;
+
+    if(ringbuff == NULL || len == 0 || len > 0x80000000UL) {
         return OPRT_INVALID_PARM;
     }
-    
-    rbuff = (__RINGBUFF_T *)RINGBUFF_MALLOC(RINGBUFF_SIZE+len);
+
+    size = __ringbuff_roundup_pow2(len);
+    rbuff = (__RINGBUFF_T *)RINGBUFF_MALLOC(RINGBUFF_SIZE+size);
     if(rbuff == NULL) {
         return OPRT_MALLOC_FAILED;
     }
     rbuff->type = type;
-    __ringbuff_init(rbuff, len);
+    rbuff->size = size;
+    rbuff->mask = size - 1;
+    __ringbuff_init(rbuff);
     *out_ring_buff = rbuff;
 
     return OPRT_OK;
@@ -78,158 +170,203 @@ OPERATE_RET tuya_ring_buff_reset(TUYA_RINGBUFF_T ringbuff)
     if (rbuff == NULL) {
         return OPRT_INVALID_PARM;
     }
-    __ringbuff_init(rbuff, rbuff->len);
+    __ringbuff_init(rbuff);
 
     return OPRT_OK;
 }
 
-UINT16_T tuya_ring_buff_free_size_get(TUYA_RINGBUFF_T ringbuff)
+UINT32_T tuya_ring_buff_free_size_get(TUYA_RINGBUFF_T ringbuff)
 {
-    UINT16_T size, in, out;
     __RINGBUFF_T *rbuff = (__RINGBUFF_T *)ringbuff;
 
     if(rbuff == NULL) {
         return 0;
     }
 
-    in = rbuff->in;
-    out = rbuff->out;
-    if(in == out) {
-        size = rbuff->len;
-    }
-    else if (out > in) {
-        size = out - in;
-    }
-    else {
-        size = rbuff->len - (in - out);
-    }
-
-    return size - 1;
+    return rbuff->size - tuya_ring_buff_used_size_get(rbuff);
 }
 
-UINT16_T tuya_ring_buff_used_size_get(TUYA_RINGBUFF_T ringbuff)
+UINT32_T tuya_ring_buff_used_size_get(TUYA_RINGBUFF_T ringbuff)
 {
-    UINT16_T size, in, out;
+    UINT32_T size;
     __RINGBUFF_T *rbuff = (__RINGBUFF_T *)ringbuff;
 
     if(rbuff == NULL) {
         return 0;
     }
 
-    in = rbuff->in;
-    out = rbuff->out;
-    if (in == out) {
-        size = 0;
-    } else if (in > out) {
-        size = in - out;
-    } else {
-        size = rbuff->len - (out - in);
+    size = rbuff->in - rbuff->out;
+
+    return GET_MIN(size, rbuff->size);
+}
+
+UINT32_T tuya_ring_buff_overwrite_size_get(TUYA_RINGBUFF_T ringbuff)
+{
+    __RINGBUFF_T *rbuff = (__RINGBUFF_T *)ringbuff;
+
+    if(rbuff == NULL) {
+        return 0;
     }
 
-    return size;
+    return rbuff->overwrite;
 }
 
-UINT16_T tuya_ring_buff_write(TUYA_RINGBUFF_T ringbuff, const VOID_T *data, UINT16_T len)
+UINT32_T tuya_ring_buff_write(TUYA_RINGBUFF_T ringbuff, const VOID_T *data, UINT32_T len)
 {
-    UINT16_T tmp_len;
-    UINT16_T free_len;
+    UINT8_T *span;
+    UINT32_T tmp_len;
+    UINT32_T total = 0;
     CONST UINT8_T* pdata = data;
     __RINGBUFF_T *rbuff = (__RINGBUFF_T *)ringbuff;
 
     if(rbuff == NULL || data == NULL || len == 0) {
         return 0;
     }
-    // overwriting unread parts is not supported when the write is full
-    free_len = tuya_ring_buff_free_size_get(rbuff);
-    len = GET_MIN(free_len, len);
-    if(len == 0) {
-        return 0;
-    }
-
-    // write data to remaining buff
-    tmp_len = GET_MIN(rbuff->len - rbuff->in, len);
-    memcpy(&rbuff->buff[rbuff->in], pdata, tmp_len);
-    rbuff->in += tmp_len;
-    len -= tmp_len;
 
-    // write remaining data to beginning of buffer
-    if (len > 0) {
-        memcpy(rbuff->buff, &pdata[tmp_len], len);
-        rbuff->in = len;
+    // only the newest size bytes can survive in coverage mode
+    if (rbuff->type == OVERFLOW_COVERAGE_TYPE && len > rbuff->size) {
+        pdata += len - rbuff->size;
+        len = rbuff->size;
     }
 
-    // buff loopback check
-    if (rbuff->in >= rbuff->len) {
-        rbuff->in = 0;
+    // at most two spans: up to the end of buff, then from the beginning
+    while (len > 0) {
+        tmp_len = tuya_ring_buff_write_reserve(rbuff, &span, len);
+        if (tmp_len == 0) {
+            break;
+        }
+        memcpy(span, &pdata[total], tmp_len);
+        tuya_ring_buff_write_commit(rbuff, tmp_len);
+        total += tmp_len;
+        len -= tmp_len;
     }
 
-    return tmp_len + len;
+    return total;
 }
 
-UINT16_T tuya_ring_buff_read(TUYA_RINGBUFF_T ringbuff, VOID_T *data, UINT16_T len)
+UINT32_T tuya_ring_buff_write_reserve(TUYA_RINGBUFF_T ringbuff, UINT8_T **span, UINT32_T len)
 {
-    UINT16_T tmp_len;
-    UINT16_T used_len;
-    UINT8_T *pdata = data;
+    UINT32_T in, pos, avail;
     __RINGBUFF_T *rbuff = (__RINGBUFF_T *)ringbuff;
 
-    if(rbuff == NULL || data == NULL || len == 0) {
+    if(rbuff == NULL || span == NULL) {
         return 0;
     }
 
-    used_len = tuya_ring_buff_used_size_get(rbuff);
-    len = GET_MIN(used_len, len);
+    in = rbuff->in;
+    pos = in & rbuff->mask;
+    if (rbuff->type == OVERFLOW_COVERAGE_TYPE) {
+        avail = rbuff->size;
+    } else {
+        avail = rbuff->size - (in - rbuff->out);
+    }
+
+    len = GET_MIN(len, GET_MIN(avail, rbuff->size - pos));
     if (len == 0) {
         return 0;
     }
 
-    // read data from linear part of buffer
-    tmp_len = GET_MIN(rbuff->len - rbuff->out, len);
-    memcpy(pdata, &rbuff->buff[rbuff->out], tmp_len);
-    rbuff->out += tmp_len;
-    len -= tmp_len;
+    if (rbuff->type == OVERFLOW_COVERAGE_TYPE) {
+        // announce the overwrite before touching the data
+        rbuff->resv = in + len;
+        RINGBUFF_BARRIER();
+    }
+
+    *span = &rbuff->buff[pos];
+    return len;
+}
+
+OPERATE_RET tuya_ring_buff_write_commit(TUYA_RINGBUFF_T ringbuff, UINT32_T len)
+{
+    __RINGBUFF_T *rbuff = (__RINGBUFF_T *)ringbuff;
 
-    // read data from beginning of buffer (overflow part)
-    if (len > 0) {
-        memcpy(&pdata[tmp_len], rbuff->buff, len);
-        rbuff->out = len;
+    if(rbuff == NULL) {
+        return OPRT_INVALID_PARM;
     }
 
-    // check end of buffer
-    if (rbuff->out >= rbuff->len) {
-        rbuff->out = 0;
+    // data must be visible before the consumer sees the new counter
+    RINGBUFF_BARRIER();
+    rbuff->in += len;
+    if (rbuff->type == OVERFLOW_COVERAGE_TYPE) {
+        rbuff->resv = rbuff->in;
     }
 
-    return tmp_len + len;
+    return OPRT_OK;
 }
 
-UINT16_T tuya_ring_buff_peek(TUYA_RINGBUFF_T ringbuff, VOID_T *data, UINT16_T len)
+UINT32_T tuya_ring_buff_read(TUYA_RINGBUFF_T ringbuff, VOID_T *data, UINT32_T len)
 {
-    UINT16_T out;
-    UINT16_T tmp_len;
-    UINT16_T used_len;
-    UINT8_T *pdata = data;
+    UINT32_T next_out;
     __RINGBUFF_T *rbuff = (__RINGBUFF_T *)ringbuff;
 
     if(rbuff == NULL || data == NULL || len == 0) {
         return 0;
     }
 
-    out = rbuff->out;
-    used_len = tuya_ring_buff_used_size_get(rbuff);
-
-    len = GET_MIN(len, used_len);
+    len = __ringbuff_fetch(rbuff, data, len, &next_out);
     if (len == 0) {
         return 0;
     }
 
-    tmp_len = GET_MIN(rbuff->len - out, len);
-    memcpy(pdata, &rbuff->buff[out], tmp_len);
-    len -= tmp_len;
+    // the copy must complete before the producer may reuse the area
+    RINGBUFF_BARRIER();
+    __ringbuff_out_set(rbuff, next_out, next_out - len);
+
+    return len;
+}
+
+UINT32_T tuya_ring_buff_peek(TUYA_RINGBUFF_T ringbuff, VOID_T *data, UINT32_T len)
+{
+    UINT32_T next_out;
+    __RINGBUFF_T *rbuff = (__RINGBUFF_T *)ringbuff;
+
+    if(rbuff == NULL || data == NULL || len == 0) {
+        return 0;
+    }
+
+    return __ringbuff_fetch(rbuff, data, len, &next_out);
+}
+
+UINT32_T tuya_ring_buff_peek_span(TUYA_RINGBUFF_T ringbuff, UINT8_T **span)
+{
+    UINT32_T in, out, pos;
+    __RINGBUFF_T *rbuff = (__RINGBUFF_T *)ringbuff;
 
-    if (len > 0) {
-        memcpy(&pdata[tmp_len], rbuff->buff, len);
+    if(rbuff == NULL || span == NULL) {
+        return 0;
     }
-    
-    return tmp_len + len;
+
+    in = rbuff->in;
+    RINGBUFF_BARRIER();
+    out = __ringbuff_out_get(rbuff, in);
+    __ringbuff_out_set(rbuff, out, out);
+
+    pos = out & rbuff->mask;
+    *span = &rbuff->buff[pos];
+
+    return GET_MIN(in - out, rbuff->size - pos);
+}
+
+OPERATE_RET tuya_ring_buff_consume(TUYA_RINGBUFF_T ringbuff, UINT32_T len)
+{
+    UINT32_T out;
+    __RINGBUFF_T *rbuff = (__RINGBUFF_T *)ringbuff;
+
+    if(rbuff == NULL) {
+        return OPRT_INVALID_PARM;
+    }
+
+    out = rbuff->out;
+    len = GET_MIN(len, rbuff->in - out);
+
+    RINGBUFF_BARRIER();
+    if (rbuff->type == OVERFLOW_COVERAGE_TYPE && rbuff->resv - out > rbuff->size) {
+        // the producer lapped the span while it was in use
+        out = __ringbuff_out_get(rbuff, rbuff->in);
+        __ringbuff_out_set(rbuff, out, out);
+        return OPRT_COM_ERROR;
+    }
+    rbuff->out = out + len;
+
+    return OPRT_OK;
 }
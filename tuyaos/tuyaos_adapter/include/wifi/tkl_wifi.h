@@ -181,6 +181,28 @@ typedef VOID_T (*SNIFFER_CALLBACK)(CONST UINT8_T *buf, CONST UINT16_T len, CONST
  */
 typedef VOID_T (*WIFI_REV_MGNT_CB)(UCHAR_T *buf, UINT_T len);
 
+/**
+ * @brief callback function: WIFI_SCAN_AP_CB
+ *        called for every ap as its beacon or probe response arrives
+ *        during <tkl_wifi_scan_ap_async>, then once with ap == NULL
+ *        when the scan ends. runs in the wifi core task, must not block.
+ * @param[in]       ap          the ap found, NULL at the end of the scan
+ * @param[in]       arg         the arg of WF_SCAN_PARAM_S
+ * @return TRUE to stop the scan
+ */
+typedef BOOL_T (*WIFI_SCAN_AP_CB)(CONST AP_IF_S *ap, VOID_T *arg);
+
+/* tuya sdk definition of async scan param */
+typedef struct {
+    CONST SCHAR_T   *ssid;               ///< probe for this ssid and report only it, NULL for all
+    BOOL_T          stop_on_match;       ///< opt in: stop at the first bss of ssid, not the strongest
+    UCHAR_T         chan_num;            ///< number of chans, 0 for all channels
+    UCHAR_T         chans[14];           ///< channels to scan
+    USHORT_T        dwell_ms;            ///< per channel dwell time hint, 0 for default
+    WIFI_SCAN_AP_CB cb;                  ///< result callback
+    VOID_T          *arg;                ///< callback arg
+} WF_SCAN_PARAM_S;
+
 /**
  * @brief callback function: WIFI_STATUS_CHANGE_CB
  *        when wifi connect status changed, notify tuyaos
@@ -223,6 +245,17 @@ OPERATE_RET tkl_wifi_scan_ap(CONST SCHAR_T *ssid, AP_IF_S **ap_ary, UINT_T *num)
  */
 OPERATE_RET tkl_wifi_release_ap(AP_IF_S *ap);
 
+/**
+ * @brief start a scan and stream the aps found to param->cb, the
+ *        function returns as soon as the scan is started
+ *
+ * @param[in]       param       the scan param
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ *
+ * @note dwell_ms is a hint, platforms with fixed dwell times ignore it
+ */
+OPERATE_RET tkl_wifi_scan_ap_async(CONST WF_SCAN_PARAM_S *param);
+
 /**
  * @brief start a soft ap
  * 
@@ -41,14 +41,23 @@ extern int hal_flash_unlock(void);
 
 #define SIMPLE_FLASH_KEY_ADDR  (0x200000 - 0x3000 - 0xE000 - 0x1000)            //4k
 
-#define UF_PARTITION_START     (0x200000 - 0x3000 - 0xE000 - 0x1000) - 0x3000 - 0x1000 - 0x18000
+/*
+ * the UF partition is the store of tkl_fs, which formats and garbage collects
+ * every sector of it, so nothing else may write there. tkl_flash_write and
+ * tkl_flash_erase refuse the range, tkl_fs goes through tkl_flash_uf_write and
+ * tkl_flash_uf_erase. the TuyaOS file system is tkl_fs on this platform.
+ */
+#define UF_PARTITION_START     ((0x200000 - 0x3000 - 0xE000 - 0x1000) - 0x3000 - 0x1000 - 0x18000)
 #define UF_PARTITION_SIZE      0x18000          //96k
+#define UF_PARTITION_IN(addr, size) (((addr) < UF_PARTITION_START + UF_PARTITION_SIZE) && ((addr) + (size) > UF_PARTITION_START))
 
 #if defined(KV_PROTECTED_ENABLE) && (KV_PROTECTED_ENABLE==1)
     #define PROTECTED_DATA_ADDR (0x200000 - 0x3000 - 0xE000 - 0x1000 - 0x1000)// protected data (1 block)
     #define PROTECTED_FLASH_HUGE_SZ 0x1000 // 4k  ĿС
 #endif
 
+/* opened on the first tkl_flash_read and kept, the flash ddev has no open/close hooks */
+static DD_HANDLE flash_read_handle = DD_HANDLE_UNVALID;
 
 /**
  * @brief flash ñ,enable tureΪȫfalseΪ뱣
@@ -73,6 +82,7 @@ int tkl_flash_set_protect(const bool enable)
     ddev_close(flash_handle);
     return OPRT_OK;
 }
+
 static unsigned int __uni_flash_is_protect_all(void)
 {
     DD_HANDLE flash_handle;
@@ -86,57 +96,8 @@ static unsigned int __uni_flash_is_protect_all(void)
     return (FLASH_PROTECT_ALL == param);
 }
 
-// --- END: user defines and implements ---
-
-/**
-* @brief read flash
-*
-* @param[in] addr: flash address
-* @param[out] dst: pointer of buffer
-* @param[in] size: size of buffer
-*
-* @note This API is used for reading flash.
-*
-* @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
-*/
-OPERATE_RET tkl_flash_read(UINT32_T addr, UCHAR_T *dst, UINT32_T size)
-{
-    // --- BEGIN: user implements ---
-    unsigned int status;
-
-    if (NULL == dst) {
-        return OPRT_INVALID_PARM;
-    }
-
-    /* TODO: need to consider whether to use locks at the TKL layer*/
-    hal_flash_lock();
-
-    DD_HANDLE flash_handle;
-    flash_handle = ddev_open(FLASH_DEV_NAME, &status, 0);
-    ddev_read(flash_handle, (char *)dst, size, addr);
-    ddev_close(flash_handle);
-
-    /* TODO: need to consider whether to use locks at the TKL layer*/
-    hal_flash_unlock();
-
-    return OPRT_OK;
-    // --- END: user implements ---
-}
-
-/**
-* @brief write flash
-*
-* @param[in] addr: flash address
-* @param[in] src: pointer of buffer
-* @param[in] size: size of buffer
-*
-* @note This API is used for writing flash.
-*
-* @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
-*/
-OPERATE_RET tkl_flash_write(UINT32_T addr, CONST UCHAR_T *src, UINT32_T size)
+static OPERATE_RET __flash_write(UINT32_T addr, CONST UCHAR_T *src, UINT32_T size)
 {
-    // --- BEGIN: user implements ---
     DD_HANDLE flash_handle;
     unsigned int protect_flag;
     unsigned int status;
@@ -167,22 +128,10 @@ OPERATE_RET tkl_flash_write(UINT32_T addr, CONST UCHAR_T *src, UINT32_T size)
     /* TODO: need to consider whether to use locks at the TKL layer*/
     hal_flash_unlock();
     return OPRT_OK;
-    // --- END: user implements ---
 }
 
-/**
-* @brief erase flash
-*
-* @param[in] addr: flash address
-* @param[in] size: size of flash block
-*
-* @note This API is used for erasing flash.
-*
-* @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
-*/
-OPERATE_RET tkl_flash_erase(UINT32_T addr, UINT32_T size)
+static OPERATE_RET __flash_erase(UINT32_T addr, UINT32_T size)
 {
-    // --- BEGIN: user implements ---
     unsigned short start_sec = (addr / PARTITION_SIZE);
     unsigned short end_sec = ((addr + size - 1) / PARTITION_SIZE);
     unsigned int status;
@@ -222,6 +171,105 @@ OPERATE_RET tkl_flash_erase(UINT32_T addr, UINT32_T size)
     hal_flash_unlock();
 
     return OPRT_OK;
+}
+
+/* the access of tkl_fs to its partition, see UF_PARTITION_START */
+OPERATE_RET tkl_flash_uf_write(UINT32_T addr, CONST UCHAR_T *src, UINT32_T size)
+{
+    if ((addr < UF_PARTITION_START) || (addr + size > UF_PARTITION_START + UF_PARTITION_SIZE)) {
+        return OPRT_INVALID_PARM;
+    }
+
+    return __flash_write(addr, src, size);
+}
+
+OPERATE_RET tkl_flash_uf_erase(UINT32_T addr, UINT32_T size)
+{
+    if ((addr < UF_PARTITION_START) || (addr + size > UF_PARTITION_START + UF_PARTITION_SIZE)) {
+        return OPRT_INVALID_PARM;
+    }
+
+    return __flash_erase(addr, size);
+}
+
+// --- END: user defines and implements ---
+
+/**
+* @brief read flash
+*
+* @param[in] addr: flash address
+* @param[out] dst: pointer of buffer
+* @param[in] size: size of buffer
+*
+* @note This API is used for reading flash.
+*
+* @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+*/
+OPERATE_RET tkl_flash_read(UINT32_T addr, UCHAR_T *dst, UINT32_T size)
+{
+    // --- BEGIN: user implements ---
+    unsigned int status;
+
+    if (NULL == dst) {
+        return OPRT_INVALID_PARM;
+    }
+
+    /* TODO: need to consider whether to use locks at the TKL layer*/
+    hal_flash_lock();
+
+    // the flash device has no open/close hooks, one handle serves all reads
+    if (DD_HANDLE_UNVALID == flash_read_handle) {
+        flash_read_handle = ddev_open(FLASH_DEV_NAME, &status, 0);
+    }
+    ddev_read(flash_read_handle, (char *)dst, size, addr);
+
+    /* TODO: need to consider whether to use locks at the TKL layer*/
+    hal_flash_unlock();
+
+    return OPRT_OK;
+    // --- END: user implements ---
+}
+
+/**
+* @brief write flash
+*
+* @param[in] addr: flash address
+* @param[in] src: pointer of buffer
+* @param[in] size: size of buffer
+*
+* @note This API is used for writing flash.
+*
+* @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+*/
+OPERATE_RET tkl_flash_write(UINT32_T addr, CONST UCHAR_T *src, UINT32_T size)
+{
+    // --- BEGIN: user implements ---
+    if (UF_PARTITION_IN(addr, size)) {
+        return OPRT_INVALID_PARM;
+    }
+
+    return __flash_write(addr, src, size);
+    // --- END: user implements ---
+}
+
+/**
+* @brief erase flash
+*
+* @param[in] addr: flash address
+* @param[in] size: size of flash block
+*
+* @note This API is used for erasing flash.
+*
+* @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+*/
+OPERATE_RET tkl_flash_erase(UINT32_T addr, UINT32_T size)
+{
+    // --- BEGIN: user implements ---
+    if (UF_PARTITION_IN(addr, size)) {
+        return OPRT_INVALID_PARM;
+    }
+
+    return __flash_erase(addr, size);
     // --- END: user implements ---
 }
 
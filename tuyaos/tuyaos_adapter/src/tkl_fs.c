@@ -0,0 +1,2178 @@
+/**
+ * @file tkl_fs.c
+ * @brief this file was auto-generated by tuyaos v&v tools, developer can add implements between BEGIN and END
+ *
+ * @warning: changes between user 'BEGIN' and 'END' will be keeped when run tuyaos v&v tools
+ *           changes in other place will be overwrited and lost
+ *
+ * @copyright Copyright 2020-2021 Tuya Inc. All Rights Reserved.
+ *
+ */
+
+// --- BEGIN: user defines and implements ---
+#include <string.h>
+#include "tkl_fs.h"
+#include "tuya_error_code.h"
+#include "tkl_flash.h"
+#include "tkl_memory.h"
+#include "tkl_mutex.h"
+#include "tkl_semaphore.h"
+#include "tkl_thread.h"
+#include "tkl_system.h"
+
+/* the only way to write the UF partition, see tkl_flash.c */
+extern OPERATE_RET tkl_flash_uf_write(UINT32_T addr, CONST UCHAR_T *src, UINT32_T size);
+extern OPERATE_RET tkl_flash_uf_erase(UINT32_T addr, UINT32_T size);
+
+/*
+ * log structured file store on the TUYA_FLASH_TYPE_UF partition. the partition
+ * belongs to it alone, tkl_flash.c refuses writes and erases there from anyone
+ * else, the store reaches it through tkl_flash_uf_write/tkl_flash_uf_erase.
+ *
+ * every sector starts with a FS_SECTOR_HEAD_T holding its erase count, records
+ * are appended behind it and never rewritten. an inode record names a file, a
+ * data record carries one FS_BLOCK_SIZE block of it. each record has a
+ * sequence number and a crc, the newest valid record of a file or of a block
+ * wins wherever it lives, so a mount replays the sectors in any order and a
+ * record torn by a power cut is simply not there. a partition without any
+ * sector of the store is only formatted when it is blank, a mount fails on
+ * foreign data instead of erasing it.
+ *
+ * the size of a file is the one in its newest inode, and only data records
+ * older than that inode belong to the file. a handle appends its blocks and
+ * publishes all of them with one inode when it is closed or flushed, the
+ * records they replace stay live until then, so a cut before the inode leaves
+ * the old content. "w" and a truncation write an inode whose base_seq kills
+ * all older data records, the blocks that survive a truncation are copied
+ * first. a mount that finds records of a rewrite cut before its inode copies
+ * the file once the same way, else a later inode would publish them. a
+ * removed file leaves a tombstone inode, it is kept until the older inode
+ * records of the file are erased or a mount would bring the file back.
+ *
+ * a sector is reclaimed by copying its live records into the active sector and
+ * erasing it. FS_GC_RESERVE erased sectors are kept for that, a task collects
+ * in the background before the reserve is reached and moves data out of
+ * sectors whose erase count lags FS_WEAR_DELTA behind the most worn one.
+ */
+#define FS_SECTOR_SIZE          4096
+#define FS_SECTOR_MAX           32
+#define FS_BLOCK_SIZE           256     // file data carried by one record
+#define FS_NAME_MAX             48      // path bytes, without the terminator
+#define FS_FILE_MAX             64      // files, directories and pending tombstones
+#define FS_OPEN_MAX             8
+#define FS_FD_BASE              3
+#define FS_GC_RESERVE           1
+#define FS_GC_SOFT              3
+#define FS_GC_TOMB_SOFT         8       // tombstones kept before their sectors are collected
+#define FS_WEAR_DELTA           64
+
+#define FS_GC_TASK_STACK        2048
+#define FS_GC_TASK_PRIO         1
+
+#define FS_SECTOR_MAGIC         0x4c465331
+#define FS_REC_MAGIC            0xa5
+#define FS_REC_INODE            0x01
+#define FS_REC_DATA             0x02
+
+#define FS_INODE_DIR            0x01
+#define FS_INODE_DELETED        0x02
+
+#define FS_MODE_DIR             0040000
+#define FS_MODE_REG             0100000
+
+#define FS_GC_DEAD              1       // the sector with the most dead bytes
+#define FS_GC_WEAR              2       // the least worn sector
+#define FS_GC_TOMB              3       // a sector that keeps a tombstone alive
+
+#define FS_OPEN_RD              0x01
+#define FS_OPEN_WR              0x02
+#define FS_OPEN_APPEND          0x04
+
+typedef struct {
+    UINT32_T magic;
+    UINT32_T erase_cnt;
+    UINT32_T crc;               // of the two fields above
+    UINT32_T resv;
+} FS_SECTOR_HEAD_T;
+
+typedef struct {
+    UINT8_T  magic;
+    UINT8_T  type;
+    UINT16_T len;               // payload bytes
+    UINT32_T id;
+    UINT32_T seq;
+    UINT32_T crc;               // of the fields above and the payload
+} FS_REC_HEAD_T;
+
+typedef struct {
+    UINT32_T base_seq;          // data records older than this are dead
+    UINT32_T size;
+    UINT8_T  flags;
+    UINT8_T  name_len;
+    UINT16_T resv;
+} FS_INODE_T;                   // the name follows
+
+typedef struct {
+    UINT32_T blk;
+} FS_DATA_T;                    // the block data follows
+
+#define FS_HEAD_SIZE            ((UINT32_T)sizeof(FS_SECTOR_HEAD_T))
+#define FS_REC_SIZE(len)        (((UINT32_T)sizeof(FS_REC_HEAD_T) + (len) + 3) & ~3u)
+#define FS_REC_MAX              FS_REC_SIZE(sizeof(FS_DATA_T) + FS_BLOCK_SIZE)
+#define FS_DATA_SIZE(len)       FS_REC_SIZE(sizeof(FS_DATA_T) + (len))
+#define FS_FILE_SIZE_MAX        (sg_fs.sector_num * FS_SECTOR_SIZE)
+
+typedef struct {
+    UINT32_T erase_cnt;
+    UINT16_T used;              // append offset, FS_SECTOR_SIZE once sealed
+    UINT16_T end;               // end of the valid records
+    UINT16_T live;              // bytes of live records
+} FS_SECTOR_T;
+
+typedef struct {
+    UINT32_T addr;              // data record, 0 for a hole
+    UINT32_T seq;
+    UINT32_T prev;              // the published record addr replaces, live until the next inode
+    UINT16_T len;               // data bytes in the record
+    UINT16_T prev_len;
+} FS_BLK_T;
+
+typedef struct {
+    UINT32_T id;                // 0 for a free slot
+    UINT32_T ino_addr;
+    UINT32_T ino_seq;
+    UINT32_T base_seq;
+    UINT32_T size;
+    UINT32_T ino_mask;          // sectors holding inode records of the id, the newest included
+    UINT16_T ino_len;
+    UINT8_T  flags;
+    UINT8_T  open_cnt;
+    UINT8_T  dirty;             // data or a base_seq not published by an inode yet
+    UINT8_T  torn;              // the mount found data of a rewrite cut before its inode
+    UINT16_T blk_num;
+    FS_BLK_T *blk;
+    CHAR_T   name[FS_NAME_MAX + 1];
+} FS_NODE_T;
+
+typedef struct {
+    FS_NODE_T *node;
+    UINT32_T pos;
+    UINT32_T size;              // file size including the buffered block
+    UINT32_T buf_blk;
+    BOOL_T   dirty;
+    UINT8_T  flags;
+    UINT8_T  buf[FS_BLOCK_SIZE];
+} FS_FILE_T;
+
+typedef struct {
+    CHAR_T name[FS_NAME_MAX + 1];
+    UINT8_T flags;
+} FS_INFO_T;
+
+typedef struct {
+    CHAR_T prefix[FS_NAME_MAX + 2];
+    UINT32_T prefix_len;
+    UINT32_T idx;
+    FS_INFO_T info;
+} FS_DIR_T;
+
+typedef struct {
+    BOOL_T mounted;
+    UINT32_T base;
+    UINT32_T sector_num;
+    UINT32_T active;
+    UINT32_T next_seq;
+    UINT32_T next_id;
+    FS_SECTOR_T sector[FS_SECTOR_MAX];
+    FS_NODE_T node[FS_FILE_MAX];
+    FS_FILE_T *fd[FS_OPEN_MAX];
+    TKL_MUTEX_HANDLE mutex;
+    TKL_SEM_HANDLE gc_sem;
+    TKL_THREAD_HANDLE gc_thread;
+    UINT8_T buf[FS_REC_MAX];
+} FS_T;
+
+static FS_T sg_fs;
+
+static UINT32_T __fs_crc32(UINT32_T crc, CONST UINT8_T *data, UINT32_T len)
+{
+    static CONST UINT32_T crc_tbl[16] = {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+    };
+
+    crc = ~crc;
+    while (len--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ crc_tbl[crc & 0x0f];
+        crc = (crc >> 4) ^ crc_tbl[crc & 0x0f];
+    }
+
+    return ~crc;
+}
+
+/* addresses are offsets in the partition */
+static INT_T __fs_read(UINT32_T addr, VOID_T *buf, UINT32_T len)
+{
+    return (OPRT_OK == tkl_flash_read(sg_fs.base + addr, buf, len)) ? 0 : -1;
+}
+
+static INT_T __fs_prog(UINT32_T addr, CONST VOID_T *buf, UINT32_T len)
+{
+    return (OPRT_OK == tkl_flash_uf_write(sg_fs.base + addr, buf, len)) ? 0 : -1;
+}
+
+static UINT32_T __fs_sec_addr(UINT32_T sec)
+{
+    return sec * FS_SECTOR_SIZE;
+}
+
+static FS_SECTOR_T *__fs_sec_of(UINT32_T addr)
+{
+    return &sg_fs.sector[addr / FS_SECTOR_SIZE];
+}
+
+static VOID_T __fs_dead(UINT32_T addr, UINT32_T size)
+{
+    if (addr) {
+        __fs_sec_of(addr)->live -= size;
+    }
+}
+
+static BOOL_T __fs_blank(UINT32_T addr, UINT32_T len)
+{
+    UINT32_T i, n;
+
+    while (len) {
+        n = (len < sizeof(sg_fs.buf)) ? len : sizeof(sg_fs.buf);
+        if (0 != __fs_read(addr, sg_fs.buf, n)) {
+            return FALSE;
+        }
+        for (i = 0; i < n; i++) {
+            if (0xff != sg_fs.buf[i]) {
+                return FALSE;
+            }
+        }
+        addr += n;
+        len -= n;
+    }
+
+    return TRUE;
+}
+
+/* erase a sector and give it a header, a blank sector only gets the header */
+static INT_T __fs_format(UINT32_T sec, BOOL_T erase)
+{
+    FS_SECTOR_T *s = &sg_fs.sector[sec];
+    FS_SECTOR_HEAD_T head;
+
+    if (erase) {
+        if (OPRT_OK != tkl_flash_uf_erase(sg_fs.base + __fs_sec_addr(sec), FS_SECTOR_SIZE)) {
+            return -1;
+        }
+        s->erase_cnt++;
+    }
+
+    head.magic = FS_SECTOR_MAGIC;
+    head.erase_cnt = s->erase_cnt;
+    head.crc = __fs_crc32(0, (UINT8_T *)&head, 8);
+    head.resv = 0xffffffff;
+    s->used = FS_SECTOR_SIZE;
+    s->end = FS_HEAD_SIZE;
+    s->live = 0;
+    if (0 != __fs_prog(__fs_sec_addr(sec), &head, sizeof(head))) {
+        return -1;
+    }
+    s->used = FS_HEAD_SIZE;
+
+    return 0;
+}
+
+static BOOL_T __fs_sec_free(UINT32_T sec)
+{
+    return (sec != sg_fs.active) && (FS_HEAD_SIZE == sg_fs.sector[sec].used);
+}
+
+static UINT32_T __fs_free_count(VOID_T)
+{
+    UINT32_T i, cnt = 0;
+
+    for (i = 0; i < sg_fs.sector_num; i++) {
+        if (__fs_sec_free(i)) {
+            cnt++;
+        }
+    }
+
+    return cnt;
+}
+
+/* the least worn erased sector */
+static INT_T __fs_pick_free(VOID_T)
+{
+    UINT32_T i;
+    INT_T sec = -1;
+
+    for (i = 0; i < sg_fs.sector_num; i++) {
+        if (__fs_sec_free(i) && ((sec < 0) || (sg_fs.sector[i].erase_cnt < sg_fs.sector[sec].erase_cnt))) {
+            sec = i;
+        }
+    }
+
+    return sec;
+}
+
+static FS_NODE_T *__fs_node_by_id(UINT32_T id)
+{
+    UINT32_T i;
+
+    for (i = 0; i < FS_FILE_MAX; i++) {
+        if (sg_fs.node[i].id == id) {
+            return &sg_fs.node[i];
+        }
+    }
+
+    return NULL;
+}
+
+static FS_NODE_T *__fs_node_by_name(CONST CHAR_T *name)
+{
+    UINT32_T i;
+
+    for (i = 0; i < FS_FILE_MAX; i++) {
+        if (sg_fs.node[i].id && !(sg_fs.node[i].flags & FS_INODE_DELETED) && (0 == strcmp(sg_fs.node[i].name, name))) {
+            return &sg_fs.node[i];
+        }
+    }
+
+    return NULL;
+}
+
+static VOID_T __fs_node_free(FS_NODE_T *node)
+{
+    if (node->blk) {
+        tkl_system_free(node->blk);
+    }
+    memset(node, 0, sizeof(*node));
+}
+
+static INT_T __fs_blk_reserve(FS_NODE_T *node, UINT32_T blk)
+{
+    FS_BLK_T *tbl;
+
+    if (blk < node->blk_num) {
+        return 0;
+    }
+
+    tbl = tkl_system_realloc(node->blk, (blk + 1) * sizeof(FS_BLK_T));
+    if (NULL == tbl) {
+        return -1;
+    }
+    memset(&tbl[node->blk_num], 0, (blk + 1 - node->blk_num) * sizeof(FS_BLK_T));
+    node->blk = tbl;
+    node->blk_num = blk + 1;
+
+    return 0;
+}
+
+/* drop the blocks at and beyond size */
+static VOID_T __fs_blk_trim(FS_NODE_T *node, UINT32_T size)
+{
+    UINT32_T i, keep = (size + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE;
+
+    for (i = keep; i < node->blk_num; i++) {
+        __fs_dead(node->blk[i].addr, FS_DATA_SIZE(node->blk[i].len));
+        __fs_dead(node->blk[i].prev, FS_DATA_SIZE(node->blk[i].prev_len));
+    }
+    if (keep < node->blk_num) {
+        node->blk_num = keep;
+    }
+    if (0 == keep && node->blk) {
+        tkl_system_free(node->blk);
+        node->blk = NULL;
+    }
+}
+
+static INT_T __fs_gc_step(UINT8_T mode);
+
+/* make room for size bytes in the active sector, gc may dip into the reserve */
+static INT_T __fs_room(UINT32_T size, BOOL_T gc)
+{
+    UINT32_T i, free_cnt;
+    INT_T sec;
+
+    for (i = 0; i <= sg_fs.sector_num; i++) {
+        if (sg_fs.sector[sg_fs.active].used + size <= FS_SECTOR_SIZE) {
+            return 0;
+        }
+
+        free_cnt = __fs_free_count();
+        if ((free_cnt > FS_GC_RESERVE) || (gc && free_cnt)) {
+            sg_fs.sector[sg_fs.active].used = FS_SECTOR_SIZE;
+            sec = __fs_pick_free();
+            sg_fs.active = sec;
+            continue;
+        }
+
+        if (gc || (0 != __fs_gc_step(FS_GC_DEAD))) {
+            break;
+        }
+    }
+
+    return -1;
+}
+
+/* append a record in sg_fs.buf, a header and size bytes */
+static INT_T __fs_append(UINT32_T size, BOOL_T gc, UINT32_T *addr)
+{
+    FS_SECTOR_T *s;
+    UINT32_T len = sizeof(FS_REC_HEAD_T) + ((FS_REC_HEAD_T *)sg_fs.buf)->len;
+
+    if (0 != __fs_room(size, gc)) {
+        return -1;
+    }
+
+    s = &sg_fs.sector[sg_fs.active];
+    *addr = __fs_sec_addr(sg_fs.active) + s->used;
+    if (0 != __fs_prog(*addr, sg_fs.buf, len)) {
+        // whatever got programmed can not be appended to any more
+        s->used = FS_SECTOR_SIZE;
+        return -1;
+    }
+    s->used += size;
+    s->end = s->used;
+    s->live += size;
+
+    return 0;
+}
+
+/* build a record in sg_fs.buf and append it, the sequence number is taken on success */
+static INT_T __fs_rec_write(UINT8_T type, UINT32_T id, CONST VOID_T *p1, UINT32_T l1, CONST VOID_T *p2, UINT32_T l2, UINT32_T *addr)
+{
+    FS_REC_HEAD_T *head = (FS_REC_HEAD_T *)sg_fs.buf;
+    UINT8_T *payload = sg_fs.buf + sizeof(FS_REC_HEAD_T);
+
+    // a collection on the way copies through sg_fs.buf, make the room first
+    if (0 != __fs_room(FS_REC_SIZE(l1 + l2), FALSE)) {
+        return -1;
+    }
+
+    head->magic = FS_REC_MAGIC;
+    head->type = type;
+    head->len = l1 + l2;
+    head->id = id;
+    head->seq = sg_fs.next_seq;
+    memcpy(payload, p1, l1);
+    if (l2) {
+        memcpy(payload + l1, p2, l2);
+    }
+    head->crc = __fs_crc32(0, sg_fs.buf, 12);
+    head->crc = __fs_crc32(head->crc, payload, head->len);
+
+    if (0 != __fs_append(FS_REC_SIZE(head->len), FALSE, addr)) {
+        return -1;
+    }
+    sg_fs.next_seq++;
+
+    return 0;
+}
+
+/* the inode publishes the size, base_seq and every data record written before it */
+static INT_T __fs_inode_write(FS_NODE_T *node, UINT8_T flags, CONST CHAR_T *name)
+{
+    FS_INODE_T ino;
+    UINT32_T i, addr, seq = sg_fs.next_seq;
+
+    ino.base_seq = node->base_seq;
+    ino.size = node->size;
+    ino.flags = flags;
+    ino.name_len = strlen(name);
+    ino.resv = 0xffff;
+    if (0 != __fs_rec_write(FS_REC_INODE, node->id, &ino, sizeof(ino), name, ino.name_len, &addr)) {
+        return -1;
+    }
+
+    __fs_dead(node->ino_addr, node->ino_len);
+    node->ino_addr = addr;
+    node->ino_seq = seq;
+    node->ino_len = FS_REC_SIZE(sizeof(ino) + ino.name_len);
+    node->ino_mask |= 1u << (addr / FS_SECTOR_SIZE);
+    node->flags = flags;
+    if (name != node->name) {
+        strcpy(node->name, name);
+    }
+
+    for (i = 0; i < node->blk_num; i++) {
+        __fs_dead(node->blk[i].prev, FS_DATA_SIZE(node->blk[i].prev_len));
+        node->blk[i].prev = 0;
+    }
+    node->dirty = FALSE;
+
+    return 0;
+}
+
+/* the record is not part of the file until the next inode, the published one it replaces is kept */
+static INT_T __fs_data_write(FS_NODE_T *node, UINT32_T blk, CONST UINT8_T *data, UINT32_T len, UINT32_T size)
+{
+    FS_DATA_T hdr;
+    FS_BLK_T *b;
+    UINT32_T addr, seq = sg_fs.next_seq;
+
+    if (0 != __fs_blk_reserve(node, blk)) {
+        return -1;
+    }
+
+    hdr.blk = blk;
+    if (0 != __fs_rec_write(FS_REC_DATA, node->id, &hdr, sizeof(hdr), data, len, &addr)) {
+        return -1;
+    }
+
+    b = &node->blk[blk];
+    if (b->addr && (b->seq < node->ino_seq)) {
+        b->prev = b->addr;
+        b->prev_len = b->len;
+    } else {
+        __fs_dead(b->addr, FS_DATA_SIZE(b->len));
+    }
+    b->addr = addr;
+    b->seq = seq;
+    b->len = len;
+    node->size = size;
+    node->dirty = TRUE;
+
+    return 0;
+}
+
+/* block contents as of size, bytes past the data of the record read as zero */
+static INT_T __fs_blk_load(FS_NODE_T *node, UINT32_T blk, UINT8_T *buf, UINT32_T size)
+{
+    UINT32_T len = 0;
+
+    if ((blk < node->blk_num) && node->blk[blk].addr) {
+        len = node->blk[blk].len;
+        if (blk * FS_BLOCK_SIZE + len > size) {
+            len = (size > blk * FS_BLOCK_SIZE) ? (size - blk * FS_BLOCK_SIZE) : 0;
+        }
+        if (len && (0 != __fs_read(node->blk[blk].addr + sizeof(FS_REC_HEAD_T) + sizeof(FS_DATA_T), buf, len))) {
+            return -1;
+        }
+    }
+    memset(buf + len, 0, FS_BLOCK_SIZE - len);
+
+    return 0;
+}
+
+/*
+ * a shrink leaves the old bytes behind the new end in the last block, they
+ * are rewritten as zero before the file grows over them again
+ */
+static INT_T __fs_clip_tail(FS_NODE_T *node)
+{
+    UINT32_T blk = node->size / FS_BLOCK_SIZE, len = node->size % FS_BLOCK_SIZE;
+    UINT8_T data[FS_BLOCK_SIZE];
+
+    if (!len || (blk >= node->blk_num) || (0 == node->blk[blk].addr) || (node->blk[blk].len <= len)) {
+        return 0;
+    }
+    if (0 != __fs_blk_load(node, blk, data, node->size)) {
+        return -1;
+    }
+
+    return __fs_data_write(node, blk, data, len, node->size);
+}
+
+/*
+ * cut a file to size, the blocks that survive are copied before the inode kills
+ * the old ones. a torn file takes the copy on a grow too, it is what moves
+ * base_seq past the records of the cut rewrite.
+ */
+static INT_T __fs_truncate(FS_NODE_T *node, UINT32_T size)
+{
+    UINT32_T i, len, base;
+    UINT8_T data[FS_BLOCK_SIZE];
+
+    if ((size > node->size) && !node->torn) {
+        if (0 != __fs_clip_tail(node)) {
+            return -1;
+        }
+        node->size = size;
+        return __fs_inode_write(node, node->flags, node->name);
+    }
+
+    base = sg_fs.next_seq;
+    for (i = 0; (i < node->blk_num) && (i * FS_BLOCK_SIZE < size); i++) {
+        if (0 == node->blk[i].addr) {
+            continue;
+        }
+        len = node->blk[i].len;
+        if (0 != __fs_blk_load(node, i, data, node->size)) {
+            return -1;
+        }
+        if (0 != __fs_data_write(node, i, data, len, node->size)) {
+            return -1;
+        }
+    }
+
+    node->base_seq = base;
+    node->size = size;
+    if (0 != __fs_inode_write(node, node->flags, node->name)) {
+        return -1;
+    }
+    __fs_blk_trim(node, size);
+    node->torn = FALSE;
+
+    return 0;
+}
+
+/* "w" empties the file in RAM, the old blocks stay live until the inode of the new content */
+static INT_T __fs_rewrite(FS_NODE_T *node)
+{
+    FS_BLK_T *b;
+    UINT32_T i;
+
+    if (node->dirty && (0 != __fs_inode_write(node, node->flags, node->name))) {
+        return -1;
+    }
+
+    for (i = 0; i < node->blk_num; i++) {
+        b = &node->blk[i];
+        b->prev = b->addr;
+        b->prev_len = b->len;
+        b->addr = 0;
+        b->len = 0;
+    }
+    node->base_seq = sg_fs.next_seq;
+    node->size = 0;
+    node->dirty = TRUE;
+    // the new base_seq kills the records of a cut rewrite as well
+    node->torn = FALSE;
+
+    return 0;
+}
+
+static INT_T __fs_delete(FS_NODE_T *node)
+{
+    UINT32_T i;
+
+    if (0 != __fs_inode_write(node, node->flags | FS_INODE_DELETED, node->name)) {
+        return -1;
+    }
+
+    for (i = 0; i < node->blk_num; i++) {
+        __fs_dead(node->blk[i].addr, FS_DATA_SIZE(node->blk[i].len));
+    }
+    if (node->blk) {
+        tkl_system_free(node->blk);
+        node->blk = NULL;
+    }
+    node->blk_num = 0;
+    node->size = 0;
+
+    return 0;
+}
+
+/* next record of a sector from *addr on, 0 and the header when there is one */
+static INT_T __fs_rec_next(UINT32_T sec, UINT32_T *addr, FS_REC_HEAD_T *head, BOOL_T verify)
+{
+    UINT32_T crc, end = __fs_sec_addr(sec) + FS_SECTOR_SIZE;
+
+    if (*addr + sizeof(FS_REC_HEAD_T) > end) {
+        return -1;
+    }
+    if (0 != __fs_read(*addr, head, sizeof(FS_REC_HEAD_T))) {
+        return -1;
+    }
+    if ((FS_REC_MAGIC != head->magic) || ((FS_REC_INODE != head->type) && (FS_REC_DATA != head->type)) ||
+        (head->len > FS_REC_MAX - sizeof(FS_REC_HEAD_T)) || (*addr + FS_REC_SIZE(head->len) > end)) {
+        return -1;
+    }
+
+    if (verify) {
+        if (0 != __fs_read(*addr, sg_fs.buf, sizeof(FS_REC_HEAD_T) + head->len)) {
+            return -1;
+        }
+        crc = __fs_crc32(0, sg_fs.buf, 12);
+        crc = __fs_crc32(crc, sg_fs.buf + sizeof(FS_REC_HEAD_T), head->len);
+        if (crc != head->crc) {
+            return -1;
+        }
+        if ((FS_REC_INODE == head->type) &&
+            ((head->len < sizeof(FS_INODE_T)) || (head->len - sizeof(FS_INODE_T) > FS_NAME_MAX) ||
+             (((FS_INODE_T *)(sg_fs.buf + sizeof(FS_REC_HEAD_T)))->name_len != head->len - sizeof(FS_INODE_T)))) {
+            return -1;
+        }
+        if ((FS_REC_DATA == head->type) && (head->len < sizeof(FS_DATA_T))) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* a sector with an inode record a tombstone waits for, -1 if there is none */
+static INT_T __fs_tomb_sector(VOID_T)
+{
+    UINT32_T i, mask;
+    INT_T sec;
+
+    for (i = 0; i < FS_FILE_MAX; i++) {
+        if (!sg_fs.node[i].id || !(sg_fs.node[i].flags & FS_INODE_DELETED)) {
+            continue;
+        }
+        mask = sg_fs.node[i].ino_mask & ~(1u << sg_fs.active);
+        for (sec = 0; mask; sec++, mask >>= 1) {
+            if (mask & 1) {
+                return sec;
+            }
+        }
+    }
+
+    return -1;
+}
+
+static UINT32_T __fs_tomb_count(VOID_T)
+{
+    UINT32_T i, cnt = 0;
+
+    for (i = 0; i < FS_FILE_MAX; i++) {
+        if (sg_fs.node[i].id && (sg_fs.node[i].flags & FS_INODE_DELETED)) {
+            cnt++;
+        }
+    }
+
+    return cnt;
+}
+
+/* copy the live records of a sector to the active one and erase it */
+static INT_T __fs_gc_step(UINT8_T mode)
+{
+    UINT32_T i, addr, end, size, new_addr, bit;
+    INT_T victim = -1;
+    FS_REC_HEAD_T head;
+    FS_DATA_T hdr;
+    FS_NODE_T *node;
+    FS_SECTOR_T *s;
+    BOOL_T live;
+
+    if (FS_GC_TOMB == mode) {
+        victim = __fs_tomb_sector();
+    }
+    for (i = 0; (FS_GC_TOMB != mode) && (i < sg_fs.sector_num); i++) {
+        s = &sg_fs.sector[i];
+        if ((i == sg_fs.active) || __fs_sec_free(i)) {
+            continue;
+        }
+        if (FS_GC_WEAR == mode) {
+            if ((victim < 0) || (s->erase_cnt < sg_fs.sector[victim].erase_cnt)) {
+                victim = i;
+            }
+        } else if (s->used - FS_HEAD_SIZE > s->live) {
+            if ((victim < 0) || (s->used - s->live > sg_fs.sector[victim].used - sg_fs.sector[victim].live)) {
+                victim = i;
+            }
+        }
+    }
+    if (victim < 0) {
+        return -1;
+    }
+
+    bit = 1u << victim;
+    end = __fs_sec_addr(victim) + sg_fs.sector[victim].end;
+    for (addr = __fs_sec_addr(victim) + FS_HEAD_SIZE; (addr < end) && (0 == __fs_rec_next(victim, &addr, &head, FALSE)); addr += size) {
+        size = FS_REC_SIZE(head.len);
+        node = __fs_node_by_id(head.id);
+        live = FALSE;
+        if (NULL == node) {
+            continue;
+        }
+
+        if (FS_REC_INODE == head.type) {
+            if (node->ino_addr != addr) {
+                continue;
+            }
+            // a tombstone goes with the last older inode record of its file
+            if ((node->flags & FS_INODE_DELETED) && !(node->ino_mask & ~bit)) {
+                __fs_node_free(node);
+                continue;
+            }
+            live = TRUE;
+        } else {
+            if (0 != __fs_read(addr + sizeof(FS_REC_HEAD_T), &hdr, sizeof(hdr))) {
+                return -1;
+            }
+            live = (hdr.blk < node->blk_num) && ((node->blk[hdr.blk].addr == addr) || (node->blk[hdr.blk].prev == addr));
+        }
+        if (!live) {
+            continue;
+        }
+
+        if (0 != __fs_read(addr, sg_fs.buf, sizeof(FS_REC_HEAD_T) + head.len)) {
+            return -1;
+        }
+        if (0 != __fs_append(size, TRUE, &new_addr)) {
+            return -1;
+        }
+        if (FS_REC_INODE == head.type) {
+            node->ino_addr = new_addr;
+            node->ino_mask |= 1u << (new_addr / FS_SECTOR_SIZE);
+        } else if (node->blk[hdr.blk].addr == addr) {
+            node->blk[hdr.blk].addr = new_addr;
+        } else {
+            node->blk[hdr.blk].prev = new_addr;
+        }
+    }
+
+    if (0 != __fs_format(victim, TRUE)) {
+        return -1;
+    }
+    for (i = 0; i < FS_FILE_MAX; i++) {
+        sg_fs.node[i].ino_mask &= ~bit;
+    }
+
+    return 0;
+}
+
+static INT_T __fs_gc_needed(VOID_T)
+{
+    UINT32_T i, min = 0, max = 0;
+
+    if (__fs_free_count() < FS_GC_SOFT) {
+        return FS_GC_DEAD;
+    }
+    if ((__fs_tomb_count() > FS_GC_TOMB_SOFT) && (__fs_tomb_sector() >= 0)) {
+        return FS_GC_TOMB;
+    }
+
+    for (i = 0; i < sg_fs.sector_num; i++) {
+        if (sg_fs.sector[i].erase_cnt < sg_fs.sector[min].erase_cnt) {
+            min = i;
+        }
+        if (sg_fs.sector[i].erase_cnt > max) {
+            max = sg_fs.sector[i].erase_cnt;
+        }
+    }
+
+    // an erased sector that lags behind is taken by the next __fs_pick_free() anyway
+    if ((min == sg_fs.active) || __fs_sec_free(min)) {
+        return 0;
+    }
+
+    return (max - sg_fs.sector[min].erase_cnt > FS_WEAR_DELTA) ? FS_GC_WEAR : 0;
+}
+
+static VOID_T __fs_gc_task(VOID_T *arg)
+{
+    UINT32_T i;
+    INT_T need;
+
+    for (;;) {
+        tkl_semaphore_wait(sg_fs.gc_sem, TKL_SEM_WAIT_FOREVER);
+
+        // one sector at a time, file access waits for at most one erase
+        for (i = 0; i < sg_fs.sector_num; i++) {
+            tkl_mutex_lock(sg_fs.mutex);
+            need = __fs_gc_needed();
+            if (need) {
+                need = (0 == __fs_gc_step(need));
+            }
+            tkl_mutex_unlock(sg_fs.mutex);
+            if (!need) {
+                break;
+            }
+        }
+    }
+}
+
+/* inode records, with their live bytes */
+static VOID_T __fs_replay_inode(UINT32_T addr, FS_REC_HEAD_T *head)
+{
+    FS_INODE_T *ino = (FS_INODE_T *)(sg_fs.buf + sizeof(FS_REC_HEAD_T));
+    FS_NODE_T *node = __fs_node_by_id(head->id);
+
+    if (NULL == node) {
+        node = __fs_node_by_id(0);
+        if (NULL == node) {
+            return;
+        }
+        node->id = head->id;
+    }
+    node->ino_mask |= 1u << (addr / FS_SECTOR_SIZE);
+    if (head->seq <= node->ino_seq) {
+        __fs_dead(addr, FS_REC_SIZE(head->len));
+        return;
+    }
+
+    __fs_dead(node->ino_addr, node->ino_len);
+    node->ino_addr = addr;
+    node->ino_seq = head->seq;
+    node->ino_len = FS_REC_SIZE(head->len);
+    node->base_seq = ino->base_seq;
+    node->size = ino->size;
+    node->flags = ino->flags;
+    memcpy(node->name, ino + 1, ino->name_len);
+    node->name[ino->name_len] = 0;
+}
+
+static VOID_T __fs_replay_data(UINT32_T addr, FS_REC_HEAD_T *head)
+{
+    FS_DATA_T *hdr = (FS_DATA_T *)(sg_fs.buf + sizeof(FS_REC_HEAD_T));
+    FS_NODE_T *node = __fs_node_by_id(head->id);
+    UINT32_T size = FS_REC_SIZE(head->len);
+
+    if ((NULL == node) || (node->flags & FS_INODE_DELETED) || (head->seq < node->base_seq)) {
+        __fs_dead(addr, size);
+        return;
+    }
+    // written after the newest inode, the rewrite was cut before it got published
+    if (head->seq > node->ino_seq) {
+        node->torn = TRUE;
+        __fs_dead(addr, size);
+        return;
+    }
+    if ((hdr->blk >= FS_FILE_SIZE_MAX / FS_BLOCK_SIZE) || (0 != __fs_blk_reserve(node, hdr->blk))) {
+        __fs_dead(addr, size);
+        return;
+    }
+
+    if (node->blk[hdr->blk].addr && (head->seq <= node->blk[hdr->blk].seq)) {
+        __fs_dead(addr, size);
+        return;
+    }
+
+    __fs_dead(node->blk[hdr->blk].addr, FS_DATA_SIZE(node->blk[hdr->blk].len));
+    node->blk[hdr->blk].addr = addr;
+    node->blk[hdr->blk].seq = head->seq;
+    node->blk[hdr->blk].len = head->len - sizeof(FS_DATA_T);
+}
+
+static INT_T __fs_mount(VOID_T)
+{
+    TUYA_FLASH_BASE_INFO_T info;
+    FS_SECTOR_HEAD_T shead;
+    FS_REC_HEAD_T head;
+    UINT32_T i, pass, addr, end, valid_cnt = 0, max_erase = 0;
+    BOOL_T valid[FS_SECTOR_MAX];
+    INT_T sec;
+
+    memset(&info, 0, sizeof(info));
+    if ((OPRT_OK != tkl_flash_get_one_type_info(TUYA_FLASH_TYPE_UF, &info)) || (0 == info.partition_num)) {
+        return -1;
+    }
+    sg_fs.base = info.partition[0].start_addr;
+    sg_fs.sector_num = info.partition[0].size / FS_SECTOR_SIZE;
+    if (sg_fs.sector_num > FS_SECTOR_MAX) {
+        sg_fs.sector_num = FS_SECTOR_MAX;
+    }
+    if (sg_fs.sector_num < FS_GC_RESERVE + 2) {
+        return -1;
+    }
+    sg_fs.next_seq = 1;
+    sg_fs.next_id = 1;
+
+    for (i = 0; i < sg_fs.sector_num; i++) {
+        valid[i] = (0 == __fs_read(__fs_sec_addr(i), &shead, sizeof(shead))) && (FS_SECTOR_MAGIC == shead.magic) &&
+                   (shead.crc == __fs_crc32(0, (UINT8_T *)&shead, 8));
+        sg_fs.sector[i].erase_cnt = valid[i] ? shead.erase_cnt : 0;
+        sg_fs.sector[i].used = FS_HEAD_SIZE;
+        sg_fs.sector[i].end = FS_HEAD_SIZE;
+        sg_fs.sector[i].live = 0;
+        if (valid[i]) {
+            valid_cnt++;
+        }
+        if (valid[i] && (shead.erase_cnt > max_erase)) {
+            max_erase = shead.erase_cnt;
+        }
+    }
+
+    /*
+     * without a single sector of ours the partition is only taken when it is
+     * blank, foreign data is never erased. a cut in the first format may have
+     * left part of a header, the rest of that sector is still blank then.
+     */
+    for (i = 0; (0 == valid_cnt) && (i < sg_fs.sector_num); i++) {
+        if ((0 != __fs_read(__fs_sec_addr(i), &shead, sizeof(shead))) || (FS_SECTOR_MAGIC != (shead.magic & FS_SECTOR_MAGIC)) ||
+            !__fs_blank(__fs_sec_addr(i) + FS_HEAD_SIZE, FS_SECTOR_SIZE - FS_HEAD_SIZE)) {
+            return -1;
+        }
+    }
+
+    // inodes first, a data record needs the base_seq of its file whatever sector holds them
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < sg_fs.sector_num; i++) {
+            if (!valid[i]) {
+                continue;
+            }
+            end = __fs_sec_addr(i) + FS_HEAD_SIZE;
+            for (addr = end; 0 == __fs_rec_next(i, &addr, &head, TRUE); addr += FS_REC_SIZE(head.len)) {
+                end = addr + FS_REC_SIZE(head.len);
+                if (0 == pass) {
+                    sg_fs.sector[i].live += FS_REC_SIZE(head.len);
+                    if (head.seq >= sg_fs.next_seq) {
+                        sg_fs.next_seq = head.seq + 1;
+                    }
+                    if (head.id >= sg_fs.next_id) {
+                        sg_fs.next_id = head.id + 1;
+                    }
+                    if (FS_REC_INODE == head.type) {
+                        __fs_replay_inode(addr, &head);
+                    }
+                } else if (FS_REC_DATA == head.type) {
+                    __fs_replay_data(addr, &head);
+                }
+            }
+            if (0 == pass) {
+                sg_fs.sector[i].end = end - __fs_sec_addr(i);
+                sg_fs.sector[i].used = sg_fs.sector[i].end;
+                // a torn record or anything else behind the log, append elsewhere
+                if (!__fs_blank(end, __fs_sec_addr(i) + FS_SECTOR_SIZE - end)) {
+                    sg_fs.sector[i].used = FS_SECTOR_SIZE;
+                }
+            }
+        }
+    }
+
+    for (i = 0; i < FS_FILE_MAX; i++) {
+        if (sg_fs.node[i].id) {
+            __fs_blk_trim(&sg_fs.node[i], sg_fs.node[i].size);
+        }
+    }
+
+    sg_fs.active = sg_fs.sector_num;
+    for (i = 0; i < sg_fs.sector_num; i++) {
+        if (!valid[i]) {
+            // an erase cut short, or a sector never used
+            sg_fs.sector[i].erase_cnt = max_erase;
+            if (0 != __fs_format(i, !__fs_blank(__fs_sec_addr(i), FS_SECTOR_SIZE))) {
+                sg_fs.sector[i].used = FS_SECTOR_SIZE;
+            }
+        } else if ((sg_fs.sector[i].used > FS_HEAD_SIZE) && (sg_fs.sector[i].used < FS_SECTOR_SIZE) &&
+                   ((sg_fs.active == sg_fs.sector_num) || (sg_fs.sector[i].used > sg_fs.sector[sg_fs.active].used))) {
+            sg_fs.active = i;
+        }
+    }
+    if (sg_fs.active == sg_fs.sector_num) {
+        sec = __fs_pick_free();
+        sg_fs.active = (sec < 0) ? 0 : sec;
+    }
+
+    // the tails of the other partly used sectors count as dead, collection takes them back
+    for (i = 0; i < sg_fs.sector_num; i++) {
+        if ((i != sg_fs.active) && (sg_fs.sector[i].used > FS_HEAD_SIZE)) {
+            sg_fs.sector[i].used = FS_SECTOR_SIZE;
+        }
+    }
+
+    // a file that fails to copy here stays torn, its next commit copies it
+    for (i = 0; i < FS_FILE_MAX; i++) {
+        if (sg_fs.node[i].id && sg_fs.node[i].torn) {
+            __fs_truncate(&sg_fs.node[i], sg_fs.node[i].size);
+        }
+    }
+
+    return 0;
+}
+
+static INT_T __fs_lock(VOID_T)
+{
+    TKL_MUTEX_HANDLE mutex = NULL;
+
+    if (NULL == sg_fs.mutex) {
+        if (OPRT_OK != tkl_mutex_create_init(&mutex)) {
+            return -1;
+        }
+        TKL_ENTER_CRITICAL();
+        if (NULL == sg_fs.mutex) {
+            sg_fs.mutex = mutex;
+            mutex = NULL;
+        }
+        TKL_EXIT_CRITICAL();
+        if (mutex) {
+            tkl_mutex_release(mutex);
+        }
+    }
+
+    tkl_mutex_lock(sg_fs.mutex);
+    if (!sg_fs.mounted) {
+        if (0 != __fs_mount()) {
+            tkl_mutex_unlock(sg_fs.mutex);
+            return -1;
+        }
+        sg_fs.mounted = TRUE;
+        if ((OPRT_OK == tkl_semaphore_create_init(&sg_fs.gc_sem, 0, 1)) &&
+            (OPRT_OK != tkl_thread_create(&sg_fs.gc_thread, "fs_gc", FS_GC_TASK_STACK, FS_GC_TASK_PRIO, __fs_gc_task, NULL))) {
+            tkl_semaphore_release(sg_fs.gc_sem);
+            sg_fs.gc_sem = NULL;
+        }
+    }
+
+    return 0;
+}
+
+static VOID_T __fs_unlock(VOID_T)
+{
+    if (sg_fs.gc_sem && __fs_gc_needed()) {
+        tkl_semaphore_post(sg_fs.gc_sem);
+    }
+    tkl_mutex_unlock(sg_fs.mutex);
+}
+
+/* path without the leading and trailing slashes, "" is the root */
+static INT_T __fs_path(CONST CHAR_T *path, CHAR_T *name)
+{
+    UINT32_T len;
+
+    if (NULL == path) {
+        return -1;
+    }
+    while ('/' == *path) {
+        path++;
+    }
+    len = strlen(path);
+    while (len && ('/' == path[len - 1])) {
+        len--;
+    }
+    if (len > FS_NAME_MAX) {
+        return -1;
+    }
+    memcpy(name, path, len);
+    name[len] = 0;
+
+    return 0;
+}
+
+static BOOL_T __fs_parent_exists(CONST CHAR_T *name)
+{
+    CHAR_T parent[FS_NAME_MAX + 1];
+    CHAR_T *slash;
+    FS_NODE_T *node;
+
+    strcpy(parent, name);
+    slash = strrchr(parent, '/');
+    if (NULL == slash) {
+        return TRUE;
+    }
+    *slash = 0;
+    node = __fs_node_by_name(parent);
+
+    return node && (node->flags & FS_INODE_DIR);
+}
+
+static BOOL_T __fs_has_child(CONST CHAR_T *name)
+{
+    UINT32_T i, len = strlen(name);
+
+    for (i = 0; i < FS_FILE_MAX; i++) {
+        if (sg_fs.node[i].id && !(sg_fs.node[i].flags & FS_INODE_DELETED) &&
+            (0 == strncmp(sg_fs.node[i].name, name, len)) && ('/' == sg_fs.node[i].name[len])) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static FS_NODE_T *__fs_create(CONST CHAR_T *name, UINT8_T flags)
+{
+    FS_NODE_T *node;
+    UINT32_T i;
+
+    if (!__fs_parent_exists(name)) {
+        return NULL;
+    }
+    // a full table is mostly tombstones, collecting their sectors frees them
+    for (i = 0; (NULL == (node = __fs_node_by_id(0))) && (i < sg_fs.sector_num); i++) {
+        if (0 != __fs_gc_step(FS_GC_TOMB)) {
+            break;
+        }
+    }
+    if (NULL == node) {
+        return NULL;
+    }
+
+    node->id = sg_fs.next_id;
+    node->base_seq = sg_fs.next_seq;
+    if (0 != __fs_inode_write(node, flags, name)) {
+        memset(node, 0, sizeof(*node));
+        return NULL;
+    }
+    sg_fs.next_id++;
+
+    return node;
+}
+
+static INT_T __fs_flush(FS_FILE_T *file)
+{
+    FS_NODE_T *node = file->node;
+    UINT32_T len, size, start = file->buf_blk * FS_BLOCK_SIZE;
+
+    if (!file->dirty) {
+        return 0;
+    }
+
+    if ((file->size > node->size) && (file->buf_blk != node->size / FS_BLOCK_SIZE) && (0 != __fs_clip_tail(node))) {
+        return -1;
+    }
+
+    size = (file->size > node->size) ? file->size : node->size;
+    len = (size - start < FS_BLOCK_SIZE) ? (size - start) : FS_BLOCK_SIZE;
+    if (0 != __fs_data_write(node, file->buf_blk, file->buf, len, size)) {
+        return -1;
+    }
+    file->dirty = FALSE;
+
+    return 0;
+}
+
+/* flush the handle and publish everything written to the file with one inode */
+static INT_T __fs_commit(FS_FILE_T *file)
+{
+    FS_NODE_T *node = file->node;
+
+    if (0 != __fs_flush(file)) {
+        return -1;
+    }
+    if (node->torn) {
+        return __fs_truncate(node, node->size);
+    }
+    if (!node->dirty) {
+        return 0;
+    }
+    if (0 != __fs_inode_write(node, node->flags, node->name)) {
+        return -1;
+    }
+    __fs_blk_trim(node, node->size);
+
+    return 0;
+}
+
+static FS_FILE_T *__fs_file(TUYA_FILE file)
+{
+    UINT32_T i;
+
+    for (i = 0; i < FS_OPEN_MAX; i++) {
+        if (file && (sg_fs.fd[i] == file)) {
+            return (FS_FILE_T *)file;
+        }
+    }
+
+    return NULL;
+}
+
+static INT_T __fs_read_at(FS_FILE_T *file, UINT8_T *buf, UINT32_T len)
+{
+    FS_NODE_T *node = file->node;
+    UINT8_T data[FS_BLOCK_SIZE];
+    UINT32_T blk, off, n, total = 0;
+
+    if (file->pos >= node->size) {
+        return 0;
+    }
+    if (len > node->size - file->pos) {
+        len = node->size - file->pos;
+    }
+
+    while (total < len) {
+        blk = file->pos / FS_BLOCK_SIZE;
+        off = file->pos % FS_BLOCK_SIZE;
+        n = FS_BLOCK_SIZE - off;
+        if (n > len - total) {
+            n = len - total;
+        }
+        if (0 != __fs_blk_load(node, blk, data, node->size)) {
+            break;
+        }
+        memcpy(buf + total, data + off, n);
+        file->pos += n;
+        total += n;
+    }
+
+    return total;
+}
+
+// --- END: user defines and implements ---
+
+/**
+* @brief Make directory
+*
+* @param[in] path: path of directory
+*
+* @note This API is used for making a directory
+*
+* @return 0 on success. Others on failed
+*/
+INT_T tkl_fs_mkdir(CONST CHAR_T* path)
+{
+    // --- BEGIN: user implements ---
+    CHAR_T name[FS_NAME_MAX + 1];
+    INT_T ret = -1;
+
+    if ((0 != __fs_path(path, name)) || (0 == name[0]) || (0 != __fs_lock())) {
+        return -1;
+    }
+
+    if ((NULL == __fs_node_by_name(name)) && __fs_create(name, FS_INODE_DIR)) {
+        ret = 0;
+    }
+
+    __fs_unlock();
+    return ret;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Remove directory
+*
+* @param[in] path: path of directory
+*
+* @note This API is used for removing a directory
+*
+* @return 0 on success. Others on failed
+*/
+INT_T tkl_fs_remove(CONST CHAR_T* path)
+{
+    // --- BEGIN: user implements ---
+    CHAR_T name[FS_NAME_MAX + 1];
+    FS_NODE_T *node;
+    INT_T ret = -1;
+
+    if ((0 != __fs_path(path, name)) || (0 == name[0]) || (0 != __fs_lock())) {
+        return -1;
+    }
+
+    node = __fs_node_by_name(name);
+    if (node && (0 == node->open_cnt) && !((node->flags & FS_INODE_DIR) && __fs_has_child(name))) {
+        ret = __fs_delete(node);
+    }
+
+    __fs_unlock();
+    return ret;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Get file mode
+*
+* @param[in] path: path of directory
+* @param[out] mode: bit attibute of directory
+*
+* @note This API is used for getting file mode.
+*
+* @return 0 on success. Others on failed
+*/
+INT_T tkl_fs_mode(CONST CHAR_T* path, UINT_T* mode)
+{
+    // --- BEGIN: user implements ---
+    CHAR_T name[FS_NAME_MAX + 1];
+    FS_NODE_T *node;
+    INT_T ret = 0;
+
+    if ((NULL == mode) || (0 != __fs_path(path, name)) || (0 != __fs_lock())) {
+        return -1;
+    }
+
+    node = __fs_node_by_name(name);
+    if (0 == name[0]) {
+        *mode = FS_MODE_DIR | TUYA_IRUSR | TUYA_IWUSR;
+    } else if (node) {
+        *mode = ((node->flags & FS_INODE_DIR) ? FS_MODE_DIR : FS_MODE_REG) | TUYA_IRUSR | TUYA_IWUSR;
+    } else {
+        ret = -1;
+    }
+
+    __fs_unlock();
+    return ret;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Check whether the file or directory exists
+*
+* @param[in] path: path of directory
+* @param[out] is_exist: the file or directory exists or not
+*
+* @note This API is used to check whether the file or directory exists.
+*
+* @return 0 on success. Others on failed
+*/
+INT_T tkl_fs_is_exist(CONST CHAR_T* path, BOOL_T* is_exist)
+{
+    // --- BEGIN: user implements ---
+    CHAR_T name[FS_NAME_MAX + 1];
+
+    if ((NULL == is_exist) || (0 != __fs_path(path, name)) || (0 != __fs_lock())) {
+        return -1;
+    }
+
+    *is_exist = (0 == name[0]) || (NULL != __fs_node_by_name(name));
+
+    __fs_unlock();
+    return 0;
+    // --- END: user implements ---
+}
+
+/**
+* @brief File rename
+*
+* @param[in] path_old: old path of directory
+* @param[in] path_new: new path of directory
+*
+* @note This API is used to rename the file.
+*
+* @return 0 on success. Others on failed
+*/
+INT_T tkl_fs_rename(CONST CHAR_T* path_old, CONST CHAR_T* path_new)
+{
+    // --- BEGIN: user implements ---
+    CHAR_T name_old[FS_NAME_MAX + 1];
+    CHAR_T name_new[FS_NAME_MAX + 1];
+    FS_NODE_T *node, *target;
+    INT_T ret = -1;
+
+    if ((0 != __fs_path(path_old, name_old)) || (0 != __fs_path(path_new, name_new)) ||
+        (0 == name_old[0]) || (0 == name_new[0]) || (0 != __fs_lock())) {
+        return -1;
+    }
+
+    node = __fs_node_by_name(name_old);
+    target = __fs_node_by_name(name_new);
+    if ((NULL == node) || (node == target) || !__fs_parent_exists(name_new) ||
+        ((node->flags & FS_INODE_DIR) && __fs_has_child(name_old))) {
+        goto EXIT;
+    }
+
+    // an existing file is replaced, the old name still holds the data if the cut comes in between
+    if (target) {
+        if ((target->flags & FS_INODE_DIR) || target->open_cnt || (0 != __fs_delete(target))) {
+            goto EXIT;
+        }
+    }
+    ret = __fs_inode_write(node, node->flags, name_new);
+
+EXIT:
+    __fs_unlock();
+    return ret;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Open directory
+*
+* @param[in] path: path of directory
+* @param[out] dir: handle of directory
+*
+* @note This API is used to open a directory
+*
+* @return 0 on success. Others on failed
+*/
+INT_T tkl_dir_open(CONST CHAR_T* path, TUYA_DIR* dir)
+{
+    // --- BEGIN: user implements ---
+    CHAR_T name[FS_NAME_MAX + 1];
+    FS_NODE_T *node;
+    FS_DIR_T *d;
+
+    if ((NULL == dir) || (0 != __fs_path(path, name)) || (0 != __fs_lock())) {
+        return -1;
+    }
+
+    node = __fs_node_by_name(name);
+    if (name[0] && !(node && (node->flags & FS_INODE_DIR))) {
+        __fs_unlock();
+        return -1;
+    }
+    __fs_unlock();
+
+    d = tkl_system_malloc(sizeof(FS_DIR_T));
+    if (NULL == d) {
+        return -1;
+    }
+    memset(d, 0, sizeof(FS_DIR_T));
+    strcpy(d->prefix, name);
+    if (name[0]) {
+        strcat(d->prefix, "/");
+    }
+    d->prefix_len = strlen(d->prefix);
+    *dir = d;
+
+    return 0;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Close directory
+*
+* @param[in] dir: handle of directory
+*
+* @note This API is used to close a directory
+*
+* @return 0 on success. Others on failed
+*/
+INT_T tkl_dir_close(TUYA_DIR dir)
+{
+    // --- BEGIN: user implements ---
+    if (NULL == dir) {
+        return -1;
+    }
+    tkl_system_free(dir);
+
+    return 0;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Read directory
+*
+* @param[in] dir: handle of directory
+* @param[out] info: file information
+*
+* @note This API is used to read a directory.
+* Read the file information of the current node, and the internal pointer points to the next node.
+*
+* @return 0 on success. Others on failed
+*/
+INT_T tkl_dir_read(TUYA_DIR dir, TUYA_FILEINFO* info)
+{
+    // --- BEGIN: user implements ---
+    FS_DIR_T *d = (FS_DIR_T *)dir;
+    FS_NODE_T *node;
+    INT_T ret = -1;
+
+    if ((NULL == d) || (NULL == info) || (0 != __fs_lock())) {
+        return -1;
+    }
+
+    // the entry is only valid up to the next read of the same handle
+    for (; d->idx < FS_FILE_MAX; d->idx++) {
+        node = &sg_fs.node[d->idx];
+        if ((0 == node->id) || (node->flags & FS_INODE_DELETED) ||
+            (0 != strncmp(node->name, d->prefix, d->prefix_len)) || strchr(node->name + d->prefix_len, '/')) {
+            continue;
+        }
+        strcpy(d->info.name, node->name + d->prefix_len);
+        d->info.flags = node->flags;
+        *info = &d->info;
+        d->idx++;
+        ret = 0;
+        break;
+    }
+
+    __fs_unlock();
+    return ret;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Get the name of the file node
+*
+* @param[in] info: file information
+* @param[out] name: file name
+*
+* @note This API is used to get the name of the file node.
+*
+* @return 0 on success. Others on failed
+*/
+INT_T tkl_dir_name(TUYA_FILEINFO info, CONST CHAR_T** name)
+{
+    // --- BEGIN: user implements ---
+    if ((NULL == info) || (NULL == name)) {
+        return -1;
+    }
+    *name = ((FS_INFO_T *)info)->name;
+
+    return 0;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Check whether the node is a directory
+*
+* @param[in] info: file information
+* @param[out] is_dir: is directory or not
+*
+* @note This API is used to check whether the node is a directory.
+*
+* @return 0 on success. Others on failed
+*/
+INT_T tkl_dir_is_directory(TUYA_FILEINFO info, BOOL_T* is_dir)
+{
+    // --- BEGIN: user implements ---
+    if ((NULL == info) || (NULL == is_dir)) {
+        return -1;
+    }
+    *is_dir = (((FS_INFO_T *)info)->flags & FS_INODE_DIR) ? TRUE : FALSE;
+
+    return 0;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Check whether the node is a normal file
+*
+* @param[in] info: file information
+* @param[out] is_regular: is normal file or not
+*
+* @note This API is used to check whether the node is a normal file.
+*
+* @return 0 on success. Others on failed
+*/
+INT_T tkl_dir_is_regular(TUYA_FILEINFO info, BOOL_T* is_regular)
+{
+    // --- BEGIN: user implements ---
+    if ((NULL == info) || (NULL == is_regular)) {
+        return -1;
+    }
+    *is_regular = (((FS_INFO_T *)info)->flags & FS_INODE_DIR) ? FALSE : TRUE;
+
+    return 0;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Open file
+*
+* @param[in] path: path of file
+* @param[in] mode: file open mode: "r","w"...
+*
+* @note This API is used to open a file
+*
+* @return the file handle, NULL means failed
+*/
+TUYA_FILE tkl_fopen(CONST CHAR_T* path, CONST CHAR_T* mode)
+{
+    // --- BEGIN: user implements ---
+    CHAR_T name[FS_NAME_MAX + 1];
+    FS_FILE_T *file = NULL;
+    FS_NODE_T *node;
+    UINT8_T flags;
+    UINT32_T i;
+
+    if ((NULL == mode) || (0 != __fs_path(path, name)) || (0 == name[0])) {
+        return NULL;
+    }
+
+    switch (mode[0]) {
+        case 'r': flags = FS_OPEN_RD; break;
+        case 'w': flags = FS_OPEN_WR; break;
+        case 'a': flags = FS_OPEN_WR | FS_OPEN_APPEND; break;
+        default: return NULL;
+    }
+    if (strchr(mode, '+')) {
+        flags |= FS_OPEN_RD | FS_OPEN_WR;
+    }
+
+    if (0 != __fs_lock()) {
+        return NULL;
+    }
+
+    for (i = 0; (i < FS_OPEN_MAX) && sg_fs.fd[i]; i++);
+    node = __fs_node_by_name(name);
+    if ((i == FS_OPEN_MAX) || (node && (node->flags & FS_INODE_DIR))) {
+        goto EXIT;
+    }
+    if (NULL == node) {
+        if ('r' == mode[0]) {
+            goto EXIT;
+        }
+        node = __fs_create(name, 0);
+        if (NULL == node) {
+            goto EXIT;
+        }
+    } else if (('w' == mode[0]) && node->size && (0 != __fs_rewrite(node))) {
+        goto EXIT;
+    }
+
+    file = tkl_system_malloc(sizeof(FS_FILE_T));
+    if (NULL == file) {
+        goto EXIT;
+    }
+    memset(file, 0, sizeof(FS_FILE_T));
+    file->node = node;
+    file->flags = flags;
+    file->size = node->size;
+    file->pos = (flags & FS_OPEN_APPEND) ? node->size : 0;
+    node->open_cnt++;
+    sg_fs.fd[i] = file;
+
+EXIT:
+    __fs_unlock();
+    return file;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Close file
+*
+* @param[in] file: file handle
+*
+* @note This API is used to close a file
+*
+* @return 0 on success. EOF on failed
+*/
+INT_T tkl_fclose(TUYA_FILE file)
+{
+    // --- BEGIN: user implements ---
+    FS_FILE_T *f;
+    UINT32_T i;
+    INT_T ret;
+
+    if (0 != __fs_lock()) {
+        return -1;
+    }
+
+    f = __fs_file(file);
+    if (NULL == f) {
+        __fs_unlock();
+        return -1;
+    }
+    ret = __fs_commit(f);
+    for (i = 0; i < FS_OPEN_MAX; i++) {
+        if (sg_fs.fd[i] == f) {
+            sg_fs.fd[i] = NULL;
+        }
+    }
+    f->node->open_cnt--;
+    tkl_system_free(f);
+
+    __fs_unlock();
+    return ret;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Read file
+*
+* @param[in] buf: buffer for reading file
+* @param[in] bytes: buffer size
+* @param[in] file: file handle
+*
+* @note This API is used to read a file
+*
+* @return the bytes read from file
+*/
+INT_T tkl_fread(VOID_T* buf, INT_T bytes, TUYA_FILE file)
+{
+    // --- BEGIN: user implements ---
+    FS_FILE_T *f;
+    INT_T ret = 0;
+
+    if ((NULL == buf) || (bytes <= 0) || (0 != __fs_lock())) {
+        return 0;
+    }
+
+    f = __fs_file(file);
+    if (f && (f->flags & FS_OPEN_RD) && (0 == __fs_flush(f))) {
+        ret = __fs_read_at(f, buf, bytes);
+    }
+
+    __fs_unlock();
+    return ret;
+    // --- END: user implements ---
+}
+
+/**
+* @brief write file
+*
+* @param[in] buf: buffer for writing file
+* @param[in] bytes: buffer size
+* @param[in] file: file handle
+*
+* @note This API is used to write a file
+*
+* @return the bytes write to file
+*/
+INT_T tkl_fwrite(VOID_T* buf, INT_T bytes, TUYA_FILE file)
+{
+    // --- BEGIN: user implements ---
+    FS_FILE_T *f;
+    FS_NODE_T *node;
+    UINT32_T blk, off, n;
+    INT_T total = 0;
+
+    if ((NULL == buf) || (bytes <= 0) || (0 != __fs_lock())) {
+        return 0;
+    }
+
+    f = __fs_file(file);
+    if ((NULL == f) || !(f->flags & FS_OPEN_WR)) {
+        goto EXIT;
+    }
+    node = f->node;
+    if (f->flags & FS_OPEN_APPEND) {
+        f->pos = (f->size > node->size) ? f->size : node->size;
+    }
+    if (f->pos >= FS_FILE_SIZE_MAX) {
+        goto EXIT;
+    }
+    if ((UINT32_T)bytes > FS_FILE_SIZE_MAX - f->pos) {
+        bytes = FS_FILE_SIZE_MAX - f->pos;
+    }
+
+    // a block is buffered until the next block is touched, small writes do not each take a record
+    while (total < bytes) {
+        blk = f->pos / FS_BLOCK_SIZE;
+        off = f->pos % FS_BLOCK_SIZE;
+        n = FS_BLOCK_SIZE - off;
+        if (n > (UINT32_T)(bytes - total)) {
+            n = bytes - total;
+        }
+
+        if (!f->dirty || (f->buf_blk != blk)) {
+            if (0 != __fs_flush(f)) {
+                break;
+            }
+            if ((n < FS_BLOCK_SIZE) && (0 != __fs_blk_load(node, blk, f->buf, node->size))) {
+                break;
+            }
+            f->buf_blk = blk;
+        }
+
+        memcpy(f->buf + off, (UINT8_T *)buf + total, n);
+        f->dirty = TRUE;
+        f->pos += n;
+        if (f->pos > f->size) {
+            f->size = f->pos;
+        }
+        total += n;
+    }
+
+EXIT:
+    __fs_unlock();
+    return total;
+    // --- END: user implements ---
+}
+
+/**
+* @brief write buffer to flash
+*
+* @param[in] fd: file fd
+*
+* @note This API is used to write buffer to flash
+*
+* @return 0 on success. others on failed
+*/
+INT_T tkl_fsync(INT_T fd)
+{
+    // --- BEGIN: user implements ---
+    INT_T ret = -1;
+
+    if ((fd < FS_FD_BASE) || (fd >= FS_FD_BASE + FS_OPEN_MAX) || (0 != __fs_lock())) {
+        return -1;
+    }
+
+    if (sg_fs.fd[fd - FS_FD_BASE]) {
+        ret = __fs_commit(sg_fs.fd[fd - FS_FD_BASE]);
+    }
+
+    __fs_unlock();
+    return ret;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Read string from file
+*
+* @param[in] buf: buffer for reading file
+* @param[in] len: buffer size
+* @param[in] file: file handle
+*
+* @note This API is used to read string from file
+*
+* @return the content get from file, NULL means failed
+*/
+CHAR_T* tkl_fgets(CHAR_T* buf, INT_T len, TUYA_FILE file)
+{
+    // --- BEGIN: user implements ---
+    FS_FILE_T *f;
+    CHAR_T *line;
+    INT_T n = 0;
+
+    if ((NULL == buf) || (len < 2) || (0 != __fs_lock())) {
+        return NULL;
+    }
+
+    f = __fs_file(file);
+    if (f && (f->flags & FS_OPEN_RD) && (0 == __fs_flush(f))) {
+        n = __fs_read_at(f, (UINT8_T *)buf, len - 1);
+    }
+    if (n > 0) {
+        buf[n] = 0;
+        line = strchr(buf, '\n');
+        if (line) {
+            f->pos -= n - (line + 1 - buf);
+            line[1] = 0;
+        }
+    }
+
+    __fs_unlock();
+    return (n > 0) ? buf : NULL;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Check wheather to reach the end fo the file
+*
+* @param[in] file: file handle
+*
+* @note This API is used to check wheather to reach the end fo the file
+*
+* @return 0 on not eof, others on eof
+*/
+INT_T tkl_feof(TUYA_FILE file)
+{
+    // --- BEGIN: user implements ---
+    FS_FILE_T *f;
+    INT_T ret = 1;
+
+    if (0 != __fs_lock()) {
+        return 1;
+    }
+
+    f = __fs_file(file);
+    if (f) {
+        ret = (f->pos >= ((f->size > f->node->size) ? f->size : f->node->size));
+    }
+
+    __fs_unlock();
+    return ret;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Seek to the offset position of the file
+*
+* @param[in] file: file handle
+* @param[in] offs: offset
+* @param[in] whence: seek start point mode
+*
+* @note This API is used to seek to the offset position of the file.
+*
+* @return 0 on success, others on failed
+*/
+INT_T tkl_fseek(TUYA_FILE file, INT64_T offs, INT_T whence)
+{
+    // --- BEGIN: user implements ---
+    FS_FILE_T *f;
+    INT64_T pos = -1;
+
+    if (0 != __fs_lock()) {
+        return -1;
+    }
+
+    f = __fs_file(file);
+    if (f) {
+        switch (whence) {
+            case TUYA_SEEK_SET: pos = offs; break;
+            case TUYA_SEEK_CUR: pos = (INT64_T)f->pos + offs; break;
+            case TUYA_SEEK_END: pos = (INT64_T)((f->size > f->node->size) ? f->size : f->node->size) + offs; break;
+            default: break;
+        }
+    }
+    if ((pos >= 0) && (pos <= 0x7fffffff)) {
+        f->pos = (UINT32_T)pos;
+    }
+
+    __fs_unlock();
+    return ((pos >= 0) && (pos <= 0x7fffffff)) ? 0 : -1;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Get current position of file
+*
+* @param[in] file: file handle
+*
+* @note This API is used to get current position of file.
+*
+* @return the current offset of the file
+*/
+INT64_T tkl_ftell(TUYA_FILE file)
+{
+    // --- BEGIN: user implements ---
+    FS_FILE_T *f;
+    INT64_T pos = -1;
+
+    if (0 != __fs_lock()) {
+        return -1;
+    }
+
+    f = __fs_file(file);
+    if (f) {
+        pos = f->pos;
+    }
+
+    __fs_unlock();
+    return pos;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Get file size
+*
+* @param[in] filepath file path + file name
+*
+* @note This API is used to get the size of file.
+*
+* @return the sizeof of file
+*/
+INT_T tkl_fgetsize(CONST CHAR_T *filepath)
+{
+    // --- BEGIN: user implements ---
+    CHAR_T name[FS_NAME_MAX + 1];
+    FS_NODE_T *node;
+    INT_T size = -1;
+
+    if ((0 != __fs_path(filepath, name)) || (0 != __fs_lock())) {
+        return -1;
+    }
+
+    node = __fs_node_by_name(name);
+    if (node && !(node->flags & FS_INODE_DIR)) {
+        size = node->size;
+    }
+
+    __fs_unlock();
+    return size;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Judge if the file can be access
+*
+* @param[in] filepath file path + file name
+*
+* @param[in] mode access mode
+*
+* @note This API is used to access one file.
+*
+* @return 0 success,-1 failed
+*/
+INT_T tkl_faccess(CONST CHAR_T *filepath, INT_T mode)
+{
+    // --- BEGIN: user implements ---
+    BOOL_T is_exist = FALSE;
+
+    if ((0 != tkl_fs_is_exist(filepath, &is_exist)) || !is_exist) {
+        return -1;
+    }
+
+    return (mode & TUYA_X_OK) ? -1 : 0;
+    // --- END: user implements ---
+}
+
+/**
+* @brief read the next character from stream
+*
+* @param[in] file char stream
+*
+* @note This API is used to get one char from stream.
+*
+* @return as an unsigned char cast to a int ,or EOF on end of file or error
+*/
+INT_T tkl_fgetc(TUYA_FILE file)
+{
+    // --- BEGIN: user implements ---
+    UINT8_T c;
+
+    if (1 != tkl_fread(&c, 1, file)) {
+        return -1;
+    }
+
+    return c;
+    // --- END: user implements ---
+}
+
+/**
+* @brief flush the IO read/write stream
+*
+* @param[in] file char stream
+*
+* @note This API is used to flush the IO read/write stream.
+*
+* @return 0 success,-1 failed
+*/
+INT_T tkl_fflush(TUYA_FILE file)
+{
+    // --- BEGIN: user implements ---
+    FS_FILE_T *f;
+    INT_T ret = -1;
+
+    if (0 != __fs_lock()) {
+        return -1;
+    }
+
+    f = __fs_file(file);
+    if (f) {
+        ret = __fs_commit(f);
+    }
+
+    __fs_unlock();
+    return ret;
+    // --- END: user implements ---
+}
+
+/**
+* @brief get the file fd
+*
+* @param[in] file char stream
+*
+* @note This API is used to get the file fd.
+*
+* @return the file fd
+*/
+INT_T tkl_fileno(TUYA_FILE file)
+{
+    // --- BEGIN: user implements ---
+    UINT32_T i;
+
+    for (i = 0; i < FS_OPEN_MAX; i++) {
+        if (file && (sg_fs.fd[i] == file)) {
+            return FS_FD_BASE + i;
+        }
+    }
+
+    return -1;
+    // --- END: user implements ---
+}
+
+
+/**
+* @brief truncate one file according to the length
+*
+* @param[in] fd file description
+*
+* @param[in] length the length want to truncate
+*
+* @note This API is used to truncate one file.
+*
+* @return 0 success,-1 failed
+*/
+INT_T tkl_ftruncate(INT_T fd, UINT64_T length)
+{
+    // --- BEGIN: user implements ---
+    FS_FILE_T *f;
+    UINT32_T i;
+    INT_T ret = -1;
+
+    if ((fd < FS_FD_BASE) || (fd >= FS_FD_BASE + FS_OPEN_MAX) || (length > 0x7fffffff) || (0 != __fs_lock())) {
+        return -1;
+    }
+
+    f = sg_fs.fd[fd - FS_FD_BASE];
+    for (i = 0; f && (i < FS_OPEN_MAX); i++) {
+        if (sg_fs.fd[i] && (sg_fs.fd[i]->node == f->node) && (0 != __fs_flush(sg_fs.fd[i]))) {
+            f = NULL;
+        }
+    }
+    if (f && (f->flags & FS_OPEN_WR) && (length <= FS_FILE_SIZE_MAX)) {
+        ret = __fs_truncate(f->node, (UINT32_T)length);
+        // other handles drop what they know of the old size
+        for (i = 0; (0 == ret) && (i < FS_OPEN_MAX); i++) {
+            if (sg_fs.fd[i] && (sg_fs.fd[i]->node == f->node)) {
+                sg_fs.fd[i]->size = f->node->size;
+            }
+        }
+    }
+
+    __fs_unlock();
+    return ret;
+    // --- END: user implements ---
+}
@@ -25,6 +25,7 @@
 #include "rw_pub.h"
 #include "sk_intf.h"
 #include "tuya_error_code.h"
+#include "tkl_output.h"
 // --- END: user defines and implements ---
 
 /**
@@ -64,7 +65,7 @@ OPERATE_RET tkl_ethernetif_output(TKL_NETIF_HANDLE netif, TKL_PBUF_HANDLE p)
 
 	if (vif_idx >= NX_VIRT_DEV_MAX)
 	{
-		os_printf("%s: invalid vif: %d!\r\n", __func__, vif_idx);
+		TKL_LOG_ARGS(TKL_LOG_MODULE_NET, TKL_LOG_LEVEL_ERR, "%s: invalid vif: %d!\r\n", __func__, vif_idx);
 		return ERR_ARG;
 	}
     
@@ -120,7 +121,7 @@ OPERATE_RET tkl_ethernetif_recv(TKL_NETIF_HANDLE netif, TKL_PBUF_HANDLE p)
         /* full packet send to tcpip_thread to process */
         if (p_netif->input(p_buf, p_netif) != ERR_OK)    // ethernet_input
         {
-            os_printf("ethernetif_input: IP input error\r\n");
+            TKL_LOG_ARGS(TKL_LOG_MODULE_NET, TKL_LOG_LEVEL_WARN, "ethernetif_input: IP input error\r\n");
             pbuf_free(p_buf);
             p_buf = NULL;
             return OPRT_COM_ERROR;
@@ -13,6 +13,7 @@
 #include "tkl_memory.h"
 #include "mem_pub.h"
 #include "tuya_error_code.h"
+#include "tuya_mem_heap.h"
 // --- END: user defines and implements ---
 
 /**
@@ -103,3 +104,74 @@ INT_T tkl_system_get_free_heap_size(VOID_T)
     
 }
 
+/**
+* @brief Get heap telemetry of system
+*
+* @param[out] stat: heap statistics
+*
+* @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+*/
+OPERATE_RET tkl_system_get_heap_stat(TKL_HEAP_STAT_T *stat)
+{
+    // --- BEGIN: user implements ---
+    INT_T i = 0;
+    heap_state_t state;
+
+    if (NULL == stat) {
+        return OPRT_INVALID_PARM;
+    }
+
+    tuya_mem_heap_state(0, &state);
+
+    stat->total_size = state.total_size;
+    stat->free_size = state.free_size;
+    stat->min_ever_free_size = state.free_watermark;
+    stat->max_free_block_size = state.max_free_block_size;
+    stat->free_block_num = state.free_block_num;
+    for (i = 0; i < TKL_HEAP_HIST_NUM && i < MEM_HEAP_HIST_NUM; i++) {
+        stat->free_block_hist[i] = state.free_block_hist[i];
+    }
+    stat->malloc_cnt = state.malloc_cnt;
+    stat->free_cnt = state.free_cnt;
+    stat->fail_cnt = state.fail_cnt;
+
+    return OPRT_OK;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Get per call-site usage recorded by the debug allocator
+*
+* @param[out] sites: call-site array
+* @param[in] num: capacity of sites
+*
+* @return number of call sites written
+*/
+INT_T tkl_system_get_heap_site_stat(TKL_HEAP_SITE_STAT_T *sites, INT_T num)
+{
+    // --- BEGIN: user implements ---
+    INT_T i = 0;
+    INT_T cnt = 0;
+    heap_site_state_t site;
+
+    if (NULL == sites) {
+        return 0;
+    }
+
+    for (i = 0; cnt < num; i++) {
+        if (0 != tuya_mem_heap_site_state(i, &site)) {
+            break;
+        }
+
+        sites[cnt].file = site.filename;
+        sites[cnt].line = site.line;
+        sites[cnt].cur_size = site.cur_size;
+        sites[cnt].peak_size = site.peak_size;
+        sites[cnt].malloc_cnt = site.malloc_cnt;
+        cnt++;
+    }
+
+    return cnt;
+    // --- END: user implements ---
+}
+
@@ -13,6 +13,7 @@
 #include "tkl_ota.h"
 #include "tuya_error_code.h"
 #include <string.h>
+#include <stddef.h>
 
 #include "tkl_output.h"
 #include "tkl_memory.h"
@@ -20,12 +21,57 @@
 #include "tkl_system.h"
 
 #define UG_PKG_HEAD     0x55aa55aa
+#define UG_PKG_HEAD_LZ  0x55aa55a1  // image encoded with literal and window match ops
+#define UG_PKG_HEAD_DIFF 0x55aa55a2 // lz ops plus copies from the running firmware, UPDATE_DIFF_HDR_S follows the header
 #define UG_PKG_TAIL     0xaa55aa55
 #define UG_START_ADDR   0x12A000   //664k  
-#define RT_IMG_WR_UNIT  512
-#define BUF_SIZE        4096
+#define RT_IMG_WR_UNIT  512     // image head, held back until the image is verified
+#define OTA_PAGE_SIZE   256     // flash program unit, data is written in whole pages
+#define OTA_SECTOR_SIZE 4096    // flash erase unit
 #define OTA_MAX_BIN_SIZE (664 * 1024)
 
+/*
+ * progress journal, the last two sectors of the ota area. records are appended
+ * in slots and the newest one that passes its crc wins. a sector is only erased
+ * when the newest record lives in the other one, so a power cut at any point
+ * leaves at least one valid record behind.
+ */
+#ifndef OTA_JOURNAL_INTERVAL
+#define OTA_JOURNAL_INTERVAL    4       // sectors of image between two journal records
+#endif
+#define OTA_JOURNAL_MAGIC       0x4f544a4e
+#define OTA_JOURNAL_SECTORS     2
+#define OTA_JOURNAL_ADDR        (UG_START_ADDR + OTA_MAX_BIN_SIZE - OTA_JOURNAL_SECTORS * OTA_SECTOR_SIZE)
+#define OTA_JOURNAL_SLOT_SIZE   1024
+#define OTA_JOURNAL_SECTOR_SLOTS (OTA_SECTOR_SIZE / OTA_JOURNAL_SLOT_SIZE)
+#define OTA_JOURNAL_SLOTS       (OTA_JOURNAL_SECTORS * OTA_JOURNAL_SECTOR_SLOTS)
+#define OTA_IMAGE_MAX_SIZE      (OTA_MAX_BIN_SIZE - OTA_JOURNAL_SECTORS * OTA_SECTOR_SIZE)
+
+/*
+ * encoded images, built by beken_os/tools/generate/ota_pack.py. the stream is a list of ops,
+ * one token byte followed by LEB128 arguments:
+ *   0x00-0x7f  literal, token + 1 bytes follow
+ *   0x80-0xbf  match, (token & 0x3f) + 3 bytes from distance + 1 back in the output
+ *   0xc0-0xff  base copy, (token & 0x3f) + 4 bytes from the running firmware
+ * a length field of 0x3f is followed by a number added to it. a base copy carries
+ * the zigzag offset change of the base position, which advances with the output.
+ */
+#define OTA_LZ_WINDOW           4096    // decoded history for matches, multiple of OTA_PAGE_SIZE
+#define OTA_LZ_OP_MAX           11      // longest op header, token and two LEB128 numbers
+#define OTA_LZ_MATCH_MIN        3
+#define OTA_LZ_BASE_MIN         4
+#ifndef OTA_DIFF_ENABLE
+#define OTA_DIFF_ENABLE         1               // accept diff packages, reported as TUYA_OTA_DIFF
+#endif
+#define OTA_DIFF_BASE_ADDR      0x11000         // app partition, the firmware diffs are made against
+#define OTA_DIFF_BASE_SIZE      (UG_START_ADDR - OTA_DIFF_BASE_ADDR)
+
+typedef enum {
+    OTA_OP_LIT = 0,
+    OTA_OP_MATCH,
+    OTA_OP_BASE
+}OTA_OP_E;
+
 typedef enum {
     UGS_RECV_HEADER = 0,
     UGS_RECV_IMG_DATA,
@@ -42,22 +88,424 @@ typedef struct
     unsigned int tail_flag;          //0x55aa55aa
 }UPDATE_FILE_HDR_S;
 
+typedef struct
+{
+    unsigned int base_len;           // bytes of the running firmware the diff was made against
+    unsigned int base_crc;           // crc32 of those bytes
+}UPDATE_DIFF_HDR_S;
+
+typedef struct {
+    unsigned int magic;
+    unsigned int seq;
+    unsigned int offset;            // image bytes safe in flash, sector aligned, 0: no session to resume
+    unsigned int image_size;        // package size the session was started with
+    unsigned int data_sum;          // byte sum of the image up to offset
+    unsigned int pkg_crc;           // crc32 of the package, header included, up to offset
+    UPDATE_FILE_HDR_S file_header;
+    unsigned char first_block[RT_IMG_WR_UNIT];
+    unsigned int crc;               // crc32 of all the fields above
+}OTA_JOURNAL_S;
+
 typedef struct {
     UPDATE_FILE_HDR_S file_header;
     unsigned int flash_addr;
     unsigned int start_addr;
     unsigned int recv_data_cnt;
+    unsigned int erase_addr;        // first sector not erased yet
+    unsigned int data_sum;          // byte sum of the image received so far
+    unsigned int pkg_crc;           // crc32 of the package received so far
+    unsigned int image_size;        // package size from tkl_ota_start_notify
+    unsigned int jnl_seq;           // sequence number of the next journal record
+    BOOL_T unprotected;
     UG_STAT_E stat;
+    unsigned int pkg_type;          // header_flag of the package
+    unsigned char *window;          // decoded history, encoded images only
+    unsigned int dec_cnt;           // image bytes decoded, the window is flushed page by page
+    unsigned int op;
+    unsigned int op_len;            // bytes left in the current op
+    unsigned int op_dist;
+    unsigned int base_len;
+    unsigned int base_pos;          // base offset lined up with the output
+    unsigned char first_block[RT_IMG_WR_UNIT];
+    OTA_JOURNAL_S jnl;              // last record read or written
 }UG_PROC_S;
 
 /***********************************************************
 *************************variable define********************
 ***********************************************************/
 static UG_PROC_S *ug_proc = NULL;
-static unsigned char *frist_block_databuf = NULL;
-static unsigned char first_block = 1;
+static TUYA_OTA_FIRMWARE_INFO_T ota_resume_info;
 
 extern int tkl_flash_set_protect(const BOOL_T enable);
+
+static unsigned int __ota_crc32(unsigned int crc, const unsigned char *data, unsigned int len)
+{
+    static const unsigned int crc_tbl[16] = {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+    };
+
+    crc = ~crc;
+    while(len--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ crc_tbl[crc & 0x0f];
+        crc = (crc >> 4) ^ crc_tbl[crc & 0x0f];
+    }
+
+    return ~crc;
+}
+
+static void __ota_sum(const unsigned char *data, unsigned int len)
+{
+    unsigned int i, sum = ug_proc->data_sum;
+
+    for(i = 0; i < len; i++) {
+        sum += data[i];
+    }
+    ug_proc->data_sum = sum;
+    ug_proc->pkg_crc = __ota_crc32(ug_proc->pkg_crc, data, len);
+}
+
+// erase each sector right before the first write into it
+static OPERATE_RET __ota_flash_program(unsigned int addr, const unsigned char *data, unsigned int len)
+{
+    while(ug_proc->erase_addr < addr + len) {
+        if(tkl_flash_erase(ug_proc->erase_addr, OTA_SECTOR_SIZE)) {
+            return OPRT_COM_ERROR;
+        }
+        ug_proc->erase_addr += OTA_SECTOR_SIZE;
+    }
+
+    return tkl_flash_write(addr, data, len);
+}
+
+// newest valid record into jnl, returns the sequence number to continue with
+static unsigned int __ota_journal_load(OTA_JOURNAL_S *jnl)
+{
+    unsigned int i, seq = 0, slot = OTA_JOURNAL_SLOTS;
+
+    for(i = 0; i < OTA_JOURNAL_SLOTS; i++) {
+        if(tkl_flash_read(OTA_JOURNAL_ADDR + i * OTA_JOURNAL_SLOT_SIZE, (unsigned char *)jnl, sizeof(OTA_JOURNAL_S))) {
+            continue;
+        }
+        if((jnl->magic != OTA_JOURNAL_MAGIC) ||
+           (jnl->crc != __ota_crc32(0, (unsigned char *)jnl, offsetof(OTA_JOURNAL_S, crc)))) {
+            continue;
+        }
+        if((slot == OTA_JOURNAL_SLOTS) || ((int)(jnl->seq - seq) > 0)) {
+            seq = jnl->seq;
+            slot = i;
+        }
+    }
+
+    if((slot == OTA_JOURNAL_SLOTS) ||
+       tkl_flash_read(OTA_JOURNAL_ADDR + slot * OTA_JOURNAL_SLOT_SIZE, (unsigned char *)jnl, sizeof(OTA_JOURNAL_S))) {
+        memset(jnl, 0, sizeof(OTA_JOURNAL_S));
+    }
+
+    // slots after the newest record may hold a torn write, continue on a freshly erased sector
+    return (seq / OTA_JOURNAL_SECTOR_SLOTS + 1) * OTA_JOURNAL_SECTOR_SLOTS;
+}
+
+// record the session state at offset, data up to offset must already be in flash
+static OPERATE_RET __ota_journal_commit(unsigned int offset)
+{
+    OTA_JOURNAL_S *jnl = &ug_proc->jnl;
+    unsigned int slot = ug_proc->jnl_seq % OTA_JOURNAL_SLOTS;
+    unsigned int addr = OTA_JOURNAL_ADDR + slot * OTA_JOURNAL_SLOT_SIZE;
+
+    if(0 == (slot % OTA_JOURNAL_SECTOR_SLOTS)) {
+        if(tkl_flash_erase(addr, OTA_SECTOR_SIZE)) {
+            return OPRT_COM_ERROR;
+        }
+    }
+
+    memset(jnl, 0, sizeof(OTA_JOURNAL_S));
+    jnl->magic = OTA_JOURNAL_MAGIC;
+    jnl->seq = ug_proc->jnl_seq++;
+    jnl->offset = offset;
+    if(offset) {
+        jnl->image_size = ug_proc->image_size;
+        jnl->data_sum = ug_proc->data_sum;
+        jnl->pkg_crc = ug_proc->pkg_crc;
+        memcpy(&jnl->file_header, &ug_proc->file_header, sizeof(UPDATE_FILE_HDR_S));
+        memcpy(jnl->first_block, ug_proc->first_block, RT_IMG_WR_UNIT);
+    }
+    jnl->crc = __ota_crc32(0, (unsigned char *)jnl, offsetof(OTA_JOURNAL_S, crc));
+
+    return tkl_flash_write(addr, (unsigned char *)jnl, sizeof(OTA_JOURNAL_S));
+}
+
+/*
+ * the download restarted at the journal point is the recorded one: the same
+ * package size, and the point and crc32 tkl_ota_get_old_firmware_info reported
+ * for this journal, which the peer checks against its own package first
+ */
+static BOOL_T __ota_journal_match(const TUYA_OTA_DATA_T *pack)
+{
+    OTA_JOURNAL_S *jnl = &ug_proc->jnl;
+
+    if((0 == jnl->offset) || (pack->offset != sizeof(UPDATE_FILE_HDR_S) + jnl->offset)) {
+        return FALSE;
+    }
+    if((ug_proc->image_size != jnl->image_size) || (pack->total_len && (pack->total_len != jnl->image_size))) {
+        return FALSE;
+    }
+
+    return (ota_resume_info.len == pack->offset) && (ota_resume_info.crc32 == jnl->pkg_crc);
+}
+
+// continue the session recorded in the journal, the stream restarts at the recorded offset
+static void __ota_journal_resume(void)
+{
+    OTA_JOURNAL_S *jnl = &ug_proc->jnl;
+
+    memcpy(&ug_proc->file_header, &jnl->file_header, sizeof(UPDATE_FILE_HDR_S));
+    memcpy(ug_proc->first_block, jnl->first_block, RT_IMG_WR_UNIT);
+    ug_proc->start_addr = UG_START_ADDR;
+    ug_proc->recv_data_cnt = jnl->offset;
+    ug_proc->flash_addr = ug_proc->start_addr + jnl->offset;
+    ug_proc->erase_addr = ug_proc->flash_addr;     // the sector after offset may be half written
+    ug_proc->data_sum = jnl->data_sum;
+    ug_proc->pkg_crc = jnl->pkg_crc;
+    ug_proc->pkg_type = jnl->file_header.header_flag;
+    ug_proc->stat = UGS_RECV_IMG_DATA;
+}
+
+static OPERATE_RET __ota_image_write(const unsigned char *data, unsigned int data_len, unsigned int *used)
+{
+    unsigned int write_len = 0, offset = 0, commit_len = 0;
+
+    if(data_len > ug_proc->file_header.bin_len - ug_proc->recv_data_cnt) {
+        data_len = ug_proc->file_header.bin_len - ug_proc->recv_data_cnt;
+    }
+
+    // the image head is kept in ram and only programmed once the image is verified
+    if(ug_proc->recv_data_cnt < RT_IMG_WR_UNIT) {
+        write_len = RT_IMG_WR_UNIT - ug_proc->recv_data_cnt;
+        if(write_len > data_len) {
+            write_len = data_len;
+        }
+        memcpy(&ug_proc->first_block[ug_proc->recv_data_cnt], data, write_len);
+        __ota_sum(data, write_len);
+        ug_proc->flash_addr += write_len;
+        ug_proc->recv_data_cnt += write_len;
+        offset = write_len;
+    }
+
+    while(offset < data_len) {
+        // whole pages only, except for the tail of the image
+        write_len = data_len - offset;
+        if(ug_proc->recv_data_cnt + write_len < ug_proc->file_header.bin_len) {
+            write_len &= ~(OTA_PAGE_SIZE - 1);
+        }
+
+        // stop at the next journal point so the recorded sum matches the flash
+        commit_len = OTA_JOURNAL_INTERVAL * OTA_SECTOR_SIZE - ug_proc->recv_data_cnt % (OTA_JOURNAL_INTERVAL * OTA_SECTOR_SIZE);
+        if(write_len > commit_len) {
+            write_len = commit_len;
+        }
+        if(0 == write_len) {
+            break;
+        }
+
+        if(__ota_flash_program(ug_proc->flash_addr, &data[offset], write_len)) {
+            tkl_log_output("Write sector failed\r\n");
+            return OPRT_OS_ADAPTER_OTA_PROCESS_FAILED;
+        }
+        __ota_sum(&data[offset], write_len);
+        ug_proc->flash_addr += write_len;
+        ug_proc->recv_data_cnt += write_len;
+        offset += write_len;
+
+        // encoded streams can not restart mid way, the decoder state is not journaled
+        if((write_len == commit_len) && (ug_proc->recv_data_cnt < ug_proc->file_header.bin_len) &&
+           (UG_PKG_HEAD == ug_proc->pkg_type)) {
+            // losing a record only costs a longer resume, keep downloading
+            if(__ota_journal_commit(ug_proc->recv_data_cnt)) {
+                tkl_log_output("ota journal write failed at %d\r\n", ug_proc->recv_data_cnt);
+            }
+        }
+    }
+
+    *used = offset;
+    return OPRT_OK;
+}
+
+// LEB128, FALSE when the data ends inside the number
+static BOOL_T __ota_varint(const unsigned char *data, unsigned int len, unsigned int *pos, unsigned int *val)
+{
+    unsigned int shift = 0, v = 0;
+
+    while((*pos < len) && (shift < 32)) {
+        v |= (data[*pos] & 0x7f) << shift;
+        if(0 == (data[(*pos)++] & 0x80)) {
+            *val = v;
+            return TRUE;
+        }
+        shift += 7;
+    }
+
+    return FALSE;
+}
+
+// start the next op, returns the header size, 0 when the data ends inside it
+static unsigned int __ota_op_parse(const unsigned char *data, unsigned int len)
+{
+    unsigned int pos = 1, op, op_len, arg = 0, ext = 0;
+
+    if(0 == len) {
+        return 0;
+    }
+
+    if(data[0] < 0x80) {
+        op = OTA_OP_LIT;
+        op_len = data[0] + 1;
+    } else {
+        op = (data[0] < 0xc0) ? OTA_OP_MATCH : OTA_OP_BASE;
+        op_len = data[0] & 0x3f;
+        if((0x3f == op_len) && !__ota_varint(data, len, &pos, &ext)) {
+            return 0;
+        }
+        op_len += ext + ((OTA_OP_MATCH == op) ? OTA_LZ_MATCH_MIN : OTA_LZ_BASE_MIN);
+        if(!__ota_varint(data, len, &pos, &arg)) {
+            return 0;
+        }
+    }
+
+    ug_proc->op = op;
+    ug_proc->op_len = op_len;
+    if(OTA_OP_MATCH == op) {
+        ug_proc->op_dist = arg + 1;
+    } else if(OTA_OP_BASE == op) {
+        ug_proc->base_pos += (arg >> 1) ^ (0 - (arg & 1));
+    }
+
+    return pos;
+}
+
+// decode an encoded image into the window and write it out a page at a time
+static OPERATE_RET __ota_image_decode(const unsigned char *data, unsigned int len, unsigned int *used)
+{
+    OPERATE_RET op_ret = OPRT_OK;
+    unsigned int in = 0, hdr = 0, n = 0, i = 0, wr = 0;
+    unsigned int bin_len = ug_proc->file_header.bin_len;
+    unsigned char *win = ug_proc->window;
+    unsigned int pos;
+
+    while(ug_proc->dec_cnt < bin_len) {
+        if(0 == ug_proc->op_len) {
+            hdr = __ota_op_parse(&data[in], len - in);
+            if(0 == hdr) {
+                if(len - in >= OTA_LZ_OP_MAX) {
+                    return OPRT_OS_ADAPTER_OTA_PROCESS_FAILED;
+                }
+                break;
+            }
+            in += hdr;
+            if(ug_proc->op_len > bin_len - ug_proc->dec_cnt) {
+                tkl_log_output("ota op overruns the image at %d\r\n", ug_proc->dec_cnt);
+                return OPRT_OS_ADAPTER_OTA_PROCESS_FAILED;
+            }
+        }
+
+        // never cross a page, the window is flushed at every page end
+        pos = ug_proc->dec_cnt & (OTA_LZ_WINDOW - 1);
+        n = OTA_PAGE_SIZE - (pos & (OTA_PAGE_SIZE - 1));
+        if(n > ug_proc->op_len) {
+            n = ug_proc->op_len;
+        }
+
+        switch(ug_proc->op) {
+            case OTA_OP_LIT:
+                if(n > len - in) {
+                    n = len - in;
+                }
+                memcpy(&win[pos], &data[in], n);
+                in += n;
+                break;
+
+            case OTA_OP_MATCH:
+                if((ug_proc->op_dist > ug_proc->dec_cnt) || (ug_proc->op_dist > OTA_LZ_WINDOW)) {
+                    return OPRT_OS_ADAPTER_OTA_PROCESS_FAILED;
+                }
+                for(i = 0; i < n; i++) {
+                    win[pos + i] = win[(pos + i - ug_proc->op_dist) & (OTA_LZ_WINDOW - 1)];
+                }
+                break;
+
+            case OTA_OP_BASE:
+                if((UG_PKG_HEAD_DIFF != ug_proc->pkg_type) ||
+                   (ug_proc->base_pos > ug_proc->base_len) || (n > ug_proc->base_len - ug_proc->base_pos)) {
+                    return OPRT_OS_ADAPTER_OTA_PROCESS_FAILED;
+                }
+                if(tkl_flash_read(OTA_DIFF_BASE_ADDR + ug_proc->base_pos, &win[pos], n)) {
+                    return OPRT_OS_ADAPTER_OTA_PROCESS_FAILED;
+                }
+                break;
+        }
+
+        if(0 == n) {
+            break;
+        }
+        ug_proc->op_len -= n;
+        ug_proc->dec_cnt += n;
+        ug_proc->base_pos += n;
+
+        if((0 == (ug_proc->dec_cnt & (OTA_PAGE_SIZE - 1))) || (ug_proc->dec_cnt == bin_len)) {
+            n = ug_proc->dec_cnt - ug_proc->recv_data_cnt;
+            op_ret = __ota_image_write(&win[ug_proc->recv_data_cnt & (OTA_LZ_WINDOW - 1)], n, &wr);
+            if(OPRT_OK != op_ret) {
+                return op_ret;
+            }
+            if(wr != n) {
+                return OPRT_OS_ADAPTER_OTA_PROCESS_FAILED;
+            }
+        }
+    }
+
+    *used = in;
+    return OPRT_OK;
+}
+
+// the diff only applies to the firmware it was made against
+static OPERATE_RET __ota_diff_base_check(unsigned int base_len, unsigned int base_crc)
+{
+    unsigned int addr = 0, n = 0, crc = 0;
+
+    if((0 == base_len) || (base_len > OTA_DIFF_BASE_SIZE)) {
+        return OPRT_OS_ADAPTER_OTA_START_INFORM_FAILED;
+    }
+
+    for(addr = 0; addr < base_len; addr += n) {
+        n = base_len - addr;
+        if(n > OTA_LZ_WINDOW) {
+            n = OTA_LZ_WINDOW;
+        }
+        if(tkl_flash_read(OTA_DIFF_BASE_ADDR + addr, ug_proc->window, n)) {
+            return OPRT_OS_ADAPTER_OTA_START_INFORM_FAILED;
+        }
+        crc = __ota_crc32(crc, ug_proc->window, n);
+    }
+
+    return (crc == base_crc) ? OPRT_OK : OPRT_OS_ADAPTER_OTA_START_INFORM_FAILED;
+}
+
+static void __ota_session_close(void)
+{
+    if(NULL == ug_proc) {
+        return;
+    }
+
+    if(ug_proc->unprotected) {
+        tkl_flash_set_protect(TRUE);
+    }
+    if(ug_proc->window) {
+        tkl_system_free(ug_proc->window);
+    }
+    tkl_system_free(ug_proc);
+    ug_proc = NULL;
+}
 // --- END: user defines and implements ---
 
 /**
@@ -72,8 +520,9 @@ extern int tkl_flash_set_protect(const BOOL_T enable);
 OPERATE_RET tkl_ota_get_ability(UINT_T *image_size, TUYA_OTA_TYPE_E *type)
 {
     // --- BEGIN: user implements ---
-    *image_size = OTA_MAX_BIN_SIZE;
-    *type = TUYA_OTA_FULL;
+    *image_size = OTA_IMAGE_MAX_SIZE;
+    // full and lz packages are taken either way
+    *type = OTA_DIFF_ENABLE ? TUYA_OTA_DIFF : TUYA_OTA_FULL;
 
     return OPRT_OK;
     // --- END: user implements ---
@@ -102,12 +551,23 @@ OPERATE_RET tkl_ota_start_notify(UINT_T image_size, TUYA_OTA_TYPE_E type, TUYA_O
         if(NULL == ug_proc) {
             return OPRT_MALLOC_FAILED;
         }
+        memset(ug_proc, 0, sizeof(UG_PROC_S));
     }
 
+    if(ug_proc->unprotected) {
+        tkl_flash_set_protect(TRUE);
+    }
+    if(ug_proc->window) {
+        tkl_system_free(ug_proc->window);
+    }
     memset(ug_proc,0,sizeof(UG_PROC_S));
-    first_block = 1;
+    ug_proc->image_size = image_size;
+    ug_proc->jnl_seq = __ota_journal_load(&ug_proc->jnl);
+    if(ug_proc->jnl.offset) {
+        tkl_log_output("ota journal: resume point %d/%d\r\n", ug_proc->jnl.offset, ug_proc->jnl.file_header.bin_len);
+    }
     
-    return OPRT_OK;;
+    return OPRT_OK;
     // --- END: user implements ---
 }
 
@@ -124,11 +584,9 @@ OPERATE_RET tkl_ota_start_notify(UINT_T image_size, TUYA_OTA_TYPE_E type, TUYA_O
 OPERATE_RET tkl_ota_data_process(TUYA_OTA_DATA_T *pack, UINT_T* remain_len)
 {
     // --- BEGIN: user implements ---
-    unsigned int sum_tmp = 0, i = 0;
-    unsigned int write_len = 0;
-    unsigned char *buf = NULL;
+    OPERATE_RET op_ret = OPRT_OK;
+    unsigned int sum_tmp = 0, i = 0, used = 0, hdr_len = 0;
 
-    
     if(ug_proc == NULL) {
         tkl_log_output("ota don't start or start err,process error!\r\n");
         return OPRT_COM_ERROR;
@@ -136,6 +594,21 @@ OPERATE_RET tkl_ota_data_process(TUYA_OTA_DATA_T *pack, UINT_T* remain_len)
 
     switch(ug_proc->stat) {
         case UGS_RECV_HEADER: {
+            // the download restarted at the journal point, nothing before it is sent again
+            if(__ota_journal_match(pack)) {
+                tkl_log_output("ota resume from %d\r\n", ug_proc->jnl.offset);
+                __ota_journal_resume();
+                tkl_flash_set_protect(FALSE);
+                ug_proc->unprotected = TRUE;
+                goto OTA_IMG_DATA;
+            }
+
+            // anything else has to start over with the header
+            if(pack->offset != 0) {
+                tkl_log_output("ota can not resume at %d, restart from 0\r\n", pack->offset);
+                return OPRT_OS_ADAPTER_OTA_START_INFORM_FAILED;
+            }
+
             if(pack->len < sizeof(UPDATE_FILE_HDR_S)) {
                 *remain_len = pack->len;
                 break;
@@ -157,119 +630,87 @@ OPERATE_RET tkl_ota_data_process(TUYA_OTA_DATA_T *pack, UINT_T* remain_len)
             
             tkl_log_output("header_flag(0x%x) tail_flag(0x%x) head_sum(0x%x-0x%x) bin_sum(0x%x)\r\n",ug_proc->file_header.header_flag,ug_proc->file_header.tail_flag,ug_proc->file_header.head_sum,sum_tmp,ug_proc->file_header.bin_sum);
 
-            if((ug_proc->file_header.header_flag !=  UG_PKG_HEAD) || (ug_proc->file_header.tail_flag !=  UG_PKG_TAIL) || (ug_proc->file_header.head_sum != sum_tmp )) {
+            if(((ug_proc->file_header.header_flag != UG_PKG_HEAD) && (ug_proc->file_header.header_flag != UG_PKG_HEAD_LZ) &&
+                ((ug_proc->file_header.header_flag != UG_PKG_HEAD_DIFF) || !OTA_DIFF_ENABLE)) || (ug_proc->file_header.tail_flag !=  UG_PKG_TAIL) || (ug_proc->file_header.head_sum != sum_tmp )) {
                 memset(&ug_proc->file_header, 0, sizeof(UPDATE_FILE_HDR_S));
                 tkl_log_output("bin_file data header err: header_flag(0x%x) tail_flag(0x%x) bin_sum(0x%x) get_sum(0x%x)\r\n",ug_proc->file_header.header_flag,ug_proc->file_header.tail_flag,ug_proc->file_header.head_sum,sum_tmp);
                 return OPRT_OS_ADAPTER_OTA_START_INFORM_FAILED;
             }
             
-            if(ug_proc->file_header.bin_len >= OTA_MAX_BIN_SIZE) { //ugļΪ664K
+            if(ug_proc->file_header.bin_len >= OTA_IMAGE_MAX_SIZE) { //ugļΪ664K
                 memset(&ug_proc->file_header, 0, sizeof(UPDATE_FILE_HDR_S));
                 tkl_log_output("bin_file too large.... %d\r\n", ug_proc->file_header.bin_len);
                 return OPRT_OS_ADAPTER_OTA_PKT_SIZE_FAILED;
             }
             
+            hdr_len = sizeof(UPDATE_FILE_HDR_S);
+            if(UG_PKG_HEAD_DIFF == ug_proc->file_header.header_flag) {
+                hdr_len += sizeof(UPDATE_DIFF_HDR_S);
+                if(pack->len < hdr_len) {
+                    *remain_len = pack->len;
+                    break;
+                }
+                ug_proc->base_len = (pack->data[32]<<24)|(pack->data[33]<<16)|(pack->data[34]<<8)|pack->data[35];
+            }
+
+            if((UG_PKG_HEAD != ug_proc->file_header.header_flag) && (NULL == ug_proc->window)) {
+                ug_proc->window = tkl_system_malloc(OTA_LZ_WINDOW);
+                if(NULL == ug_proc->window) {
+                    return OPRT_MALLOC_FAILED;
+                }
+            }
+
+            if(UG_PKG_HEAD_DIFF == ug_proc->file_header.header_flag) {
+                op_ret = __ota_diff_base_check(ug_proc->base_len, (pack->data[36]<<24)|(pack->data[37]<<16)|(pack->data[38]<<8)|pack->data[39]);
+                if(OPRT_OK != op_ret) {
+                    tkl_log_output("diff base mismatch, base_len %d\r\n", ug_proc->base_len);
+                    return op_ret;
+                }
+            }
+
             tkl_log_output("sw_ver:%s\r\n", ug_proc->file_header.sw_version);
             tkl_log_output("get right bin_file_header!!!\r\n");
             ug_proc->start_addr = UG_START_ADDR;
             ug_proc->flash_addr = ug_proc->start_addr;
             ug_proc->stat = UGS_RECV_IMG_DATA;
             ug_proc->recv_data_cnt = 0;
-            *remain_len = pack->len - sizeof(UPDATE_FILE_HDR_S);
-            
+            ug_proc->erase_addr = ug_proc->start_addr;
+            ug_proc->data_sum = 0;
+            ug_proc->pkg_crc = __ota_crc32(0, pack->data, sizeof(UPDATE_FILE_HDR_S));
+            ug_proc->pkg_type = ug_proc->file_header.header_flag;
+            ug_proc->dec_cnt = 0;
+            ug_proc->op_len = 0;
+            ug_proc->base_pos = 0;
+            *remain_len = pack->len - hdr_len;
+
+            // sectors are erased as the image arrives, keep the flash writable for the session
             tkl_flash_set_protect(FALSE);
-            tkl_flash_erase(ug_proc->start_addr,ug_proc->file_header.bin_len);
-            tkl_flash_set_protect(TRUE);
-            
+            ug_proc->unprotected = TRUE;
+
+            // a fresh download overwrites the recorded one, drop it before touching the image
+            if(ug_proc->jnl.offset && __ota_journal_commit(0)) {
+                tkl_log_output("ota journal reset failed\r\n");
+                return OPRT_OS_ADAPTER_OTA_START_INFORM_FAILED;
+            }
+
         } 
         break;
         
         case UGS_RECV_IMG_DATA: {    //dont have set lock for flash! 
-            *remain_len = pack->len;
-            if((pack->len < RT_IMG_WR_UNIT) && (ug_proc->recv_data_cnt <= (ug_proc->file_header.bin_len - RT_IMG_WR_UNIT))) {
-                break;
+OTA_IMG_DATA:
+            if(UG_PKG_HEAD == ug_proc->pkg_type) {
+                op_ret = __ota_image_write(pack->data, pack->len, &used);
+            } else {
+                op_ret = __ota_image_decode(pack->data, pack->len, &used);
             }
-            
-            write_len = pack->len;
-            
-            while(write_len >= RT_IMG_WR_UNIT) {
-                if(first_block) {
-                    if(NULL == frist_block_databuf){
-                        frist_block_databuf = tkl_system_malloc(RT_IMG_WR_UNIT);
-                        if(NULL == frist_block_databuf) {
-                            return OPRT_OS_ADAPTER_OTA_PROCESS_FAILED;
-                        }
-                    }
-                    
-                    memcpy(frist_block_databuf, &pack->data[pack->len - write_len], RT_IMG_WR_UNIT);
-                    
-                    
-                    buf = tkl_system_malloc(RT_IMG_WR_UNIT);
-                    if(NULL == buf ) {
-                        return OPRT_OS_ADAPTER_OTA_PROCESS_FAILED;
-                    }
-
-                    memset(buf, 0xFF , RT_IMG_WR_UNIT);  // make dummy data 
-                    tkl_flash_set_protect(FALSE);
-                    if(tkl_flash_write(ug_proc->flash_addr, buf, RT_IMG_WR_UNIT)) {
-                        tkl_flash_set_protect(TRUE);
-                        tkl_log_output("Write sector failed\r\n");
-                        if(buf){
-                            tkl_system_free(buf);
-                            buf = NULL;
-                        }
-                        return OPRT_OS_ADAPTER_OTA_PROCESS_FAILED;
-                    }
-                    tkl_flash_set_protect(TRUE);
-                    first_block = 0;    
-                } else {
-                    tkl_flash_set_protect(FALSE);
-                    if(tkl_flash_write(ug_proc->flash_addr, &pack->data[pack->len - write_len], RT_IMG_WR_UNIT)) {
-                        tkl_flash_set_protect(TRUE);
-                        tkl_log_output("Write sector failed\r\n");
-                        if(buf){
-                            tkl_system_free(buf);
-                            buf = NULL;
-                        }
-                        return OPRT_OS_ADAPTER_OTA_PROCESS_FAILED;
-                    }
-                    tkl_flash_set_protect(TRUE);
-                }
-                ug_proc->flash_addr += RT_IMG_WR_UNIT;
-                ug_proc->recv_data_cnt += RT_IMG_WR_UNIT;
-                write_len -= RT_IMG_WR_UNIT; 
-                *remain_len = write_len;
+            if(OPRT_OK != op_ret) {
+                return op_ret;
             }
-            
-            if((ug_proc->recv_data_cnt > (ug_proc->file_header.bin_len - RT_IMG_WR_UNIT)) \
-                && (write_len >= (ug_proc->file_header.bin_len - ug_proc->recv_data_cnt))) {    //last 512 (write directly when get data )
-                
-                tkl_flash_set_protect(FALSE);
-                
-                if(tkl_flash_write(ug_proc->flash_addr, &pack->data[pack->len - write_len], write_len)) {
-                    tkl_flash_set_protect(TRUE);
-                    tkl_log_output("Write sector failed\r\n");
-                    if(buf){
-                        tkl_system_free(buf);
-                        buf = NULL;
-                    }
-                    return OPRT_OS_ADAPTER_OTA_PROCESS_FAILED;
-                }
-                
-                tkl_flash_set_protect(TRUE);
-                
-                ug_proc->flash_addr += write_len;
-                ug_proc->recv_data_cnt += write_len;
-                write_len = 0;
-                *remain_len = 0;
-            }            
+
+            *remain_len = pack->len - used;
             if(ug_proc->recv_data_cnt >= ug_proc->file_header.bin_len) {
                 ug_proc->stat = UGS_FINISH;
-                if(buf){
-                    tkl_system_free(buf);
-                    buf = NULL;
-                }
-                break;
+                *remain_len = 0;
             }
         }
         break;
@@ -296,64 +737,37 @@ OPERATE_RET tkl_ota_data_process(TUYA_OTA_DATA_T *pack, UINT_T* remain_len)
 OPERATE_RET tkl_ota_end_notify(BOOL_T reset)
 {
     // --- BEGIN: user implements ---
-    unsigned int i = 0,k = 0,rlen = 0,addr = 0;
-    unsigned int flash_checksum = 0;
-    unsigned char *pTempbuf = NULL;
+    unsigned int head_len = 0;
 
     if(ug_proc == NULL) {
         tkl_log_output("ota don't start or start err, can't end inform!\r\n");
         return OPRT_OS_ADAPTER_INVALID_PARM;
     }
-    
-    pTempbuf = tkl_system_malloc(BUF_SIZE);
-    if(NULL == pTempbuf ) {
-        tkl_log_output("Malloc failed!!\r\n");
-        return OPRT_MALLOC_FAILED;
-    }
 
-    
-    for(i = 0; i < ug_proc->file_header.bin_len; i += BUF_SIZE) {
-        rlen  = ((ug_proc->file_header.bin_len - i) >= BUF_SIZE) ? BUF_SIZE : (ug_proc->file_header.bin_len - i);
-        addr = ug_proc->start_addr + i;
-        tkl_flash_read(addr, pTempbuf, rlen);
-        if(0 == i) {
-            memcpy(pTempbuf, frist_block_databuf ,RT_IMG_WR_UNIT); //first 4k block 
-        } 
-        
-        for(k = 0; k < rlen; k++){
-            flash_checksum += pTempbuf[k];
-        }
-     
-    }
-    
-    if(flash_checksum != ug_proc->file_header.bin_sum) {
-        tkl_log_output("verify_ota_checksum err  checksum(0x%x)  file_header.bin_sum(0x%x)\r\n",flash_checksum,ug_proc->file_header.bin_sum);
-        
+    // the sum is accumulated while the image is written, no read back needed
+    if((ug_proc->stat != UGS_FINISH) || (ug_proc->data_sum != ug_proc->file_header.bin_sum)) {
+        tkl_log_output("verify_ota_checksum err  checksum(0x%x)  file_header.bin_sum(0x%x) recv(%d/%d)\r\n",
+                       ug_proc->data_sum, ug_proc->file_header.bin_sum,
+                       ug_proc->recv_data_cnt, ug_proc->file_header.bin_len);
         goto OTA_VERIFY_PROC;
-    } 
-        
-    tkl_flash_read(ug_proc->start_addr, pTempbuf, BUF_SIZE);
-
-    tkl_flash_set_protect(FALSE);
-    tkl_flash_erase(ug_proc->start_addr, BUF_SIZE);
-    tkl_flash_set_protect(TRUE);
+    }
 
-    memcpy(pTempbuf, frist_block_databuf, RT_IMG_WR_UNIT); // ԭͷϢ512byte
-    tkl_flash_set_protect(FALSE);
-    tkl_flash_write(ug_proc->start_addr, pTempbuf, BUF_SIZE);
-    tkl_flash_set_protect(TRUE);
+    // drop the journal first, a cut before the head is written then simply restarts the download
+    if(ug_proc->jnl.offset && __ota_journal_commit(0)) {
+        tkl_log_output("ota journal reset failed\r\n");
+        goto OTA_VERIFY_PROC;
+    }
 
+    // the head lands in erased flash, this commits the image for the bootloader
+    head_len = (ug_proc->file_header.bin_len < RT_IMG_WR_UNIT) ? ug_proc->file_header.bin_len : RT_IMG_WR_UNIT;
+    if(__ota_flash_program(ug_proc->start_addr, ug_proc->first_block, head_len)) {
+        tkl_log_output("Write image head failed\r\n");
+        goto OTA_VERIFY_PROC;
+    }
 
     tkl_log_output("the gateway upgrade success\r\n");
-    
-    tkl_system_free(pTempbuf);
-    pTempbuf = NULL;
-    
-    tkl_system_free(ug_proc);
-    ug_proc = NULL;
 
-    tkl_system_free(frist_block_databuf);
-    frist_block_databuf = NULL;
+    __ota_session_close();
 
     if(TRUE == reset) { //verify 
         tkl_system_reset();
@@ -361,21 +775,12 @@ OPERATE_RET tkl_ota_end_notify(BOOL_T reset)
     return OPRT_OK;
     
  OTA_VERIFY_PROC:
-    if(pTempbuf != NULL) {
-        tkl_system_free(pTempbuf);
-        pTempbuf = NULL;
+    // a complete image that fails the check can not be resumed either
+    if((ug_proc->stat == UGS_FINISH) && ug_proc->jnl.offset) {
+        __ota_journal_commit(0);
     }
+    __ota_session_close();
 
-    if(ug_proc != NULL) {
-        tkl_system_free(ug_proc);
-        ug_proc = NULL;
-    }
-
-    if(frist_block_databuf != NULL) {
-        tkl_system_free(frist_block_databuf);
-        frist_block_databuf = NULL;
-    }
-    
     return OPRT_OS_ADAPTER_OTA_END_INFORM_FAILED;
     // --- END: user implements ---
 }
@@ -394,7 +799,28 @@ OPERATE_RET tkl_ota_end_notify(BOOL_T reset)
 OPERATE_RET tkl_ota_get_old_firmware_info(TUYA_OTA_FIRMWARE_INFO_T **info)
 {
     // --- BEGIN: user implements ---
-    return OPRT_NOT_SUPPORTED;
+    OTA_JOURNAL_S *jnl = NULL;
+
+    if(NULL == info) {
+        return OPRT_OS_ADAPTER_INVALID_PARM;
+    }
+
+    jnl = tkl_system_malloc(sizeof(OTA_JOURNAL_S));
+    if(NULL == jnl) {
+        return OPRT_MALLOC_FAILED;
+    }
+
+    // len is where the package download may restart, 0 when there is nothing to resume
+    memset(&ota_resume_info, 0, sizeof(ota_resume_info));
+    __ota_journal_load(jnl);
+    if(jnl->offset) {
+        ota_resume_info.len = sizeof(UPDATE_FILE_HDR_S) + jnl->offset;
+        ota_resume_info.crc32 = jnl->pkg_crc;
+    }
+    tkl_system_free(jnl);
+
+    *info = &ota_resume_info;
+    return OPRT_OK;
     // --- END: user implements ---
 }
 
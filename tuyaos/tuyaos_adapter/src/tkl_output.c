@@ -11,18 +11,271 @@
 
 // --- BEGIN: user defines and implements ---
 #include "tkl_output.h"
+#include "include.h"
+#include "tkl_semaphore.h"
+#include "tkl_thread.h"
 #include "tuya_error_code.h"
+#include "tuya_ringbuf.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
 extern void bk_printf(const char *fmt, ...);
+extern void bk_print_raw(const char *str);
+extern void bk_print_bin(const UINT8 *buf, UINT32 len);
+extern int bk_wlan_get_INT_status(void);
 #define OutputPrint bk_printf
-// --- END: user defines and implements ---
 
-#if defined(ENABLE_LOG_OUTPUT_FORMAT) && (ENABLE_LOG_OUTPUT_FORMAT == 1)
-#ifndef MAX_SIZE_OF_DEBUG_BUF
-#define MAX_SIZE_OF_DEBUG_BUF (1024)
+/*
+ * deferred output: callers only copy a record into the ring, a low priority
+ * task formats and prints it. producers may be any task or interrupt, so a
+ * record is written under a short interrupt lock; the task is the only
+ * reader. until the task is running, and after tkl_log_close, output is
+ * synchronous as before.
+ */
+#ifndef TKL_LOG_DEFERRED
+#define TKL_LOG_DEFERRED        1
+#endif
+#ifndef TKL_LOG_RING_SIZE
+#define TKL_LOG_RING_SIZE       4096
 #endif
+#ifndef TKL_LOG_LINE_MAX
+#define TKL_LOG_LINE_MAX        256
+#endif
+#ifndef TKL_LOG_TASK_PRIO
+#define TKL_LOG_TASK_PRIO       1
+#endif
+#define TKL_LOG_TASK_STACK      2048
+#ifndef TKL_LOG_TRACE
+#define TKL_LOG_TRACE           0   // default of tkl_log_trace_set
+#endif
+
+#define LOG_REC_TEXT            0   // payload is the text
+#define LOG_REC_ARGS            1   // payload is the format pointer and argc words
+
+typedef struct {
+    UINT16_T len;                   // payload bytes
+    UINT8_T type;
+    UINT8_T argc;
+} LOG_REC_HDR_T;
+
+typedef struct {
+    CONST CHAR_T *format;
+    UINT32_T args[TKL_LOG_ARG_MAX];
+} LOG_REC_ARGS_T;
+
+STATIC TUYA_RINGBUFF_T s_log_ring = NULL;
+STATIC TKL_SEM_HANDLE s_log_sem = NULL;
+STATIC TKL_THREAD_HANDLE s_log_thread = NULL;
+STATIC volatile BOOL_T s_log_deferred = FALSE;
+STATIC volatile BOOL_T s_log_starting = FALSE;
+STATIC CHAR_T s_log_line[TKL_LOG_LINE_MAX];     // drain task only
+STATIC UINT8_T s_log_level[TKL_LOG_MODULE_MAX] = { [0 ... TKL_LOG_MODULE_MAX - 1] = TKL_LOG_LEVEL_TRACE };
+STATIC TKL_LOG_STAT_T s_log_stat;
+STATIC volatile BOOL_T s_log_trace = TKL_LOG_TRACE;
+
+STATIC BOOL_T __log_in_isr(VOID_T)
+{
+    return (1 == bk_wlan_get_INT_status()) ? TRUE : FALSE;
+}
+
+/* queue one record, header and payload go in together or not at all */
+STATIC VOID_T __log_push(UINT8_T type, UINT8_T argc, CONST VOID_T *data, UINT32_T len)
+{
+    LOG_REC_HDR_T hdr;
+    UINT32_T used;
+    BOOL_T wake = FALSE;
+    GLOBAL_INT_DECLARATION();
+
+    hdr.len = len;
+    hdr.type = type;
+    hdr.argc = argc;
+
+    GLOBAL_INT_DISABLE();
+    used = tuya_ring_buff_used_size_get(s_log_ring);
+    if (s_log_stat.ring_size - used >= sizeof(hdr) + len) {
+        tuya_ring_buff_write(s_log_ring, &hdr, sizeof(hdr));
+        tuya_ring_buff_write(s_log_ring, data, len);
+        s_log_stat.records++;
+        used += sizeof(hdr) + len;
+        if (used > s_log_stat.ring_high_water) {
+            s_log_stat.ring_high_water = used;
+        }
+        // the task drains until empty, it only sleeps on an empty ring
+        wake = (used == sizeof(hdr) + len);
+    } else {
+        s_log_stat.drop_records++;
+        s_log_stat.drop_bytes += len;
+    }
+    GLOBAL_INT_RESTORE();
+
+    if (wake) {
+        tkl_semaphore_post(s_log_sem);
+    }
+}
+
+/*
+ * trace frame, sent instead of the formatted text of a tkl_log_output_args record:
+ *
+ *   0xA5 | 0xB0 + argc | format address, 4 bytes little endian | args | sum
+ *
+ * args are unsigned LEB128 varints, sum is the low byte of the sum of every byte
+ * after 0xA5. the address is where the format string sits in the image, so
+ * beken_os/tools/log_decode.py looks it up in the axf and formats the line on
+ * the host. the frames share the port with plain text, the decoder passes
+ * through bytes that do not make a valid frame.
+ */
+#define LOG_TRACE_SYNC          0xA5
+#define LOG_TRACE_TAG           0xB0
+#define LOG_TRACE_FRAME_MAX     (2 + 4 + TKL_LOG_ARG_MAX * 5 + 1)
+
+STATIC VOID_T __log_trace_emit(CONST CHAR_T *format, UINT8_T argc, CONST UINT32_T *args)
+{
+    UINT8_T frame[LOG_TRACE_FRAME_MAX];
+    UINT32_T id = (UINT32_T)format;
+    UINT32_T len = 0, v, i;
+    UINT8_T sum = 0;
+
+    frame[len++] = LOG_TRACE_SYNC;
+    frame[len++] = LOG_TRACE_TAG + argc;
+    frame[len++] = id;
+    frame[len++] = id >> 8;
+    frame[len++] = id >> 16;
+    frame[len++] = id >> 24;
+    for (i = 0; i < argc; i++) {
+        v = args[i];
+        while (v >= 0x80) {
+            frame[len++] = (v & 0x7f) | 0x80;
+            v >>= 7;
+        }
+        frame[len++] = v;
+    }
+    for (i = 1; i < len; i++) {
+        sum += frame[i];
+    }
+    frame[len++] = sum;
+
+    bk_print_bin(frame, len);
+    s_log_stat.trace_frames++;
+    s_log_stat.trace_bytes += len;
+}
+
+STATIC BOOL_T __log_pop(VOID_T)
+{
+    LOG_REC_HDR_T hdr;
+    LOG_REC_ARGS_T rec;
+    UINT32_T *a = rec.args;
+
+    // a record becomes readable only once it is complete
+    if (tuya_ring_buff_peek(s_log_ring, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+        tuya_ring_buff_used_size_get(s_log_ring) < sizeof(hdr) + hdr.len) {
+        return FALSE;
+    }
+    tuya_ring_buff_read(s_log_ring, &hdr, sizeof(hdr));
+
+    if (LOG_REC_TEXT == hdr.type) {
+        tuya_ring_buff_read(s_log_ring, s_log_line, hdr.len);
+        s_log_line[hdr.len] = 0;
+    } else {
+        memset(&rec, 0, sizeof(rec));
+        tuya_ring_buff_read(s_log_ring, &rec, hdr.len);
+        if (s_log_trace) {
+            __log_trace_emit(rec.format, hdr.argc, rec.args);
+            return TRUE;
+        }
+        snprintf(s_log_line, sizeof(s_log_line), rec.format, a[0], a[1], a[2], a[3], a[4], a[5]);
+    }
+    bk_print_raw(s_log_line);
 
-STATIC CHAR_T s_output_buf[MAX_SIZE_OF_DEBUG_BUF] = {0};
+    return TRUE;
+}
+
+STATIC VOID_T __log_task(VOID_T *arg)
+{
+    for (;;) {
+        tkl_semaphore_wait(s_log_sem, TKL_SEM_WAIT_FOREVER);
+        while (__log_pop() || tuya_ring_buff_used_size_get(s_log_ring) > 0) {
+            ;
+        }
+    }
+}
+
+STATIC VOID_T __log_start(VOID_T)
+{
+    BOOL_T busy;
+    GLOBAL_INT_DECLARATION();
+
+    GLOBAL_INT_DISABLE();
+    busy = s_log_starting;
+    s_log_starting = TRUE;
+    GLOBAL_INT_RESTORE();
+    if (busy) {
+        return;
+    }
+
+    if (NULL == s_log_ring) {
+        if (OPRT_OK != tuya_ring_buff_create(TKL_LOG_RING_SIZE, OVERFLOW_STOP_TYPE, &s_log_ring)) {
+            goto EXIT;
+        }
+        s_log_stat.ring_size = tuya_ring_buff_free_size_get(s_log_ring);
+    }
+    if (NULL == s_log_sem && OPRT_OK != tkl_semaphore_create_init(&s_log_sem, 0, 1)) {
+        goto EXIT;
+    }
+    if (NULL == s_log_thread &&
+        OPRT_OK != tkl_thread_create(&s_log_thread, "tkl_log", TKL_LOG_TASK_STACK, TKL_LOG_TASK_PRIO, __log_task, NULL)) {
+        s_log_thread = NULL;
+        goto EXIT;
+    }
+    s_log_deferred = TRUE;
+
+EXIT:
+    s_log_starting = FALSE;
+}
+
+/* FALSE means print synchronously */
+STATIC BOOL_T __log_deferred(VOID_T)
+{
+#if TKL_LOG_DEFERRED
+    if (!s_log_deferred && NULL == s_log_thread && !__log_in_isr() &&
+        taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        __log_start();
+    }
 #endif
+    return s_log_deferred;
+}
+
+STATIC VOID_T __log_vprint(CONST CHAR_T *format, va_list ap)
+{
+    CHAR_T line[TKL_LOG_LINE_MAX];
+    INT_T len;
+
+    len = vsnprintf(line, sizeof(line), format, ap);
+    if (len < 0) {
+        return;
+    }
+    if (len >= (INT_T)sizeof(line)) {
+        len = sizeof(line) - 1;
+    }
+
+    if (__log_deferred()) {
+        __log_push(LOG_REC_TEXT, 0, line, len);
+    } else {
+        bk_print_raw(line);
+    }
+}
+
+STATIC BOOL_T __log_level_pass(UINT8_T module, UINT8_T level)
+{
+    if (module >= TKL_LOG_MODULE_MAX || level > s_log_level[module]) {
+        s_log_stat.filtered++;
+        return FALSE;
+    }
+    return TRUE;
+}
+// --- END: user defines and implements ---
 
 /**
 * @brief Output log information
@@ -44,11 +297,14 @@ VOID_T tkl_log_output(CONST CHAR_T *format, ...)
     va_list ap;
 
     va_start(ap, format);
-    vsnprintf(s_output_buf, MAX_SIZE_OF_DEBUG_BUF,format,ap);
+    __log_vprint(format, ap);
     va_end(ap);
-    bk_printf("%s", s_output_buf);
 #else
-    OutputPrint((char *)format);
+    if (__log_deferred()) {
+        __log_push(LOG_REC_TEXT, 0, format, strnlen(format, TKL_LOG_LINE_MAX - 1));
+    } else {
+        OutputPrint((char *)format);
+    }
 #endif
     // --- END: user implements ---
 }
@@ -65,6 +321,14 @@ VOID_T tkl_log_output(CONST CHAR_T *format, ...)
 OPERATE_RET tkl_log_close(VOID_T)
 {
     // --- BEGIN: user implements ---
+    // new output goes out directly, wait for the task to empty the ring
+    s_log_deferred = FALSE;
+    if (s_log_ring && !__log_in_isr()) {
+        while (tuya_ring_buff_used_size_get(s_log_ring) > 0) {
+            tkl_semaphore_post(s_log_sem);
+            vTaskDelay(1);
+        }
+    }
     return OPRT_OK;
     // --- END: user implements ---
 }
@@ -81,7 +345,145 @@ OPERATE_RET tkl_log_close(VOID_T)
 OPERATE_RET tkl_log_open(VOID_T)
 {
     // --- BEGIN: user implements ---
+#if TKL_LOG_DEFERRED
+    __log_start();
+    if (!s_log_deferred) {
+        return OPRT_COM_ERROR;
+    }
+#endif
+    return OPRT_OK;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Output log information of a module at a level
+*
+* @param[in] module: module id, below TKL_LOG_MODULE_MAX
+* @param[in] level: log level, refer to TKL_LOG_LEVEL_E
+* @param[in] format: printf style format
+*
+* @note The level is checked before anything is formatted. Safe in interrupts.
+*
+* @return 
+*/
+VOID_T tkl_log_output_level(UINT8_T module, UINT8_T level, CONST CHAR_T *format, ...)
+{
+    // --- BEGIN: user implements ---
+    va_list ap;
+
+    if (format == NULL || !__log_level_pass(module, level)) {
+        return;
+    }
+
+    va_start(ap, format);
+    __log_vprint(format, ap);
+    va_end(ap);
+    // --- END: user implements ---
+}
+
+/**
+* @brief Output log information formatted later by the drain task
+*
+* @param[in] module: module id, below TKL_LOG_MODULE_MAX
+* @param[in] level: log level, refer to TKL_LOG_LEVEL_E
+* @param[in] format: string literal, only the pointer is queued
+* @param[in] argc: number of args, up to TKL_LOG_ARG_MAX
+* @param[in] ...: 32 bit args, %s only for string literals, no 64 bit or floating point
+*
+* @note The cheapest way to log from interrupts and hot paths, nothing is formatted by the caller.
+*       In trace mode the args are sent as a binary frame and formatted on the host.
+*
+* @return 
+*/
+VOID_T tkl_log_output_args(UINT8_T module, UINT8_T level, CONST CHAR_T *format, UINT8_T argc, ...)
+{
+    // --- BEGIN: user implements ---
+    LOG_REC_ARGS_T rec;
+    va_list ap;
+    UINT8_T i;
+
+    if (format == NULL || argc > TKL_LOG_ARG_MAX || !__log_level_pass(module, level)) {
+        return;
+    }
+
+    rec.format = format;
+    va_start(ap, argc);
+    for (i = 0; i < argc; i++) {
+        rec.args[i] = va_arg(ap, UINT32_T);
+    }
+    va_end(ap);
+
+    if (__log_deferred()) {
+        __log_push(LOG_REC_ARGS, argc, &rec, sizeof(CONST CHAR_T *) + argc * sizeof(UINT32_T));
+        return;
+    }
+    if (s_log_trace) {
+        __log_trace_emit(format, argc, rec.args);
+        return;
+    }
+
+    for (; i < TKL_LOG_ARG_MAX; i++) {
+        rec.args[i] = 0;
+    }
+    OutputPrint(format, rec.args[0], rec.args[1], rec.args[2], rec.args[3], rec.args[4], rec.args[5]);
+    // --- END: user implements ---
+}
+
+/**
+* @brief Set the most verbose level a module still outputs
+*
+* @param[in] module: module id, below TKL_LOG_MODULE_MAX
+* @param[in] level: log level, refer to TKL_LOG_LEVEL_E
+*
+* @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+*/
+OPERATE_RET tkl_log_level_set(UINT8_T module, UINT8_T level)
+{
+    // --- BEGIN: user implements ---
+    if (module >= TKL_LOG_MODULE_MAX) {
+        return OPRT_INVALID_PARM;
+    }
+    s_log_level[module] = level;
     return OPRT_OK;
     // --- END: user implements ---
 }
 
+/**
+* @brief Get log pipeline counters
+*
+* @param[out] stat: counters
+*
+* @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+*/
+OPERATE_RET tkl_log_stat_get(TKL_LOG_STAT_T *stat)
+{
+    // --- BEGIN: user implements ---
+    GLOBAL_INT_DECLARATION();
+
+    if (NULL == stat) {
+        return OPRT_INVALID_PARM;
+    }
+
+    GLOBAL_INT_DISABLE();
+    memcpy(stat, &s_log_stat, sizeof(TKL_LOG_STAT_T));
+    GLOBAL_INT_RESTORE();
+    return OPRT_OK;
+    // --- END: user implements ---
+}
+
+/**
+* @brief Send tkl_log_output_args records as binary trace frames
+*
+* @param[in] enable: TRUE for frames, FALSE for formatted text
+*
+* @note Frames are decoded on the host with beken_os/tools/log_decode.py and the axf of the running image.
+*
+* @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+*/
+OPERATE_RET tkl_log_trace_set(BOOL_T enable)
+{
+    // --- BEGIN: user implements ---
+    s_log_trace = enable;
+    return OPRT_OK;
+    // --- END: user implements ---
+}
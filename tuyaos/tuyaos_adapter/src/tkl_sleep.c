@@ -10,12 +10,112 @@
  */
 
 // --- BEGIN: user defines and implements ---
+#include <string.h>
 #include "tkl_sleep.h"
+#include "tkl_system.h"
 #include "tuya_error_code.h"
 #include "wlan_ui_pub.h"
+#include "mcu_ps_pub.h"
 
+#define TKL_SLEEP_CB_MAX        8
+
+/* voter 0 belongs to tkl_cpu_force_wakeup/tkl_cpu_allow_sleep, which set and clear it without counting */
+#define TKL_SLEEP_VOTER_CPU     0
+
+/*
+ * the mcu sleeps only while no voter holds a vote. the first vote of any voter
+ * sets MCU_PS_TKL_VOTE in mcu_prevent, the last vote dropped clears it.
+ */
+static TKL_SLEEP_VOTER_STAT_T sg_voter[TKL_SLEEP_VOTER_MAX] = {{"cpu"}};
+static UINT_T sg_voter_num = 1;
+static UINT_T sg_voter_held = 0;
+
+static TUYA_SLEEP_CB_T sg_sleep_cb[TKL_SLEEP_CB_MAX];
+static volatile UINT_T sg_sleep_cb_num = 0;
 
 unsigned char cpu_lp_flag = 0;
+
+/* close the current block of a voter */
+static VOID_T sleep_voter_account(TKL_SLEEP_VOTER_STAT_T *v, SYS_TIME_T now)
+{
+    SYS_TIME_T held = now - v->since;
+
+    v->blocked_ms += held;
+    if (held > v->max_ms) {
+        v->max_ms = held;
+    }
+}
+
+/* called with the critical section held, returns the change of voters holding a vote */
+static INT_T sleep_voter_vote(TKL_SLEEP_VOTER_STAT_T *v, BOOL_T awake, SYS_TIME_T now)
+{
+    if (awake) {
+        if (v->votes++ == 0) {
+            v->since = now;
+            v->blocks++;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (v->votes == 0) {
+        return 0;
+    }
+    if (--v->votes == 0) {
+        sleep_voter_account(v, now);
+        return -1;
+    }
+    return 0;
+}
+
+/* called with the critical section held, follows a change of voters holding a vote */
+static VOID_T sleep_voter_held(INT_T held)
+{
+    if ((held > 0) && (0 == sg_voter_held++)) {
+        mcu_prevent_set(MCU_PS_TKL_VOTE);
+    } else if ((held < 0) && (0 == --sg_voter_held)) {
+        mcu_prevent_clear(MCU_PS_TKL_VOTE);
+    }
+}
+
+/* set or clear the cpu voter, a repeated call changes nothing */
+static VOID_T sleep_voter_cpu(BOOL_T awake)
+{
+    TKL_SLEEP_VOTER_STAT_T *v = &sg_voter[TKL_SLEEP_VOTER_CPU];
+    SYS_TIME_T now = tkl_system_get_millisecond();
+
+    TKL_ENTER_CRITICAL();
+    if (awake && (0 == v->votes)) {
+        sleep_voter_held(sleep_voter_vote(v, TRUE, now));
+    } else if (!awake && v->votes) {
+        // drops every vote at once
+        v->votes = 1;
+        sleep_voter_held(sleep_voter_vote(v, FALSE, now));
+    }
+    TKL_EXIT_CRITICAL();
+}
+
+static VOID_T sleep_pre_sleep(VOID_T)
+{
+    UINT_T i;
+
+    for (i = 0; i < sg_sleep_cb_num; i++) {
+        if (sg_sleep_cb[i].pre_sleep_cb) {
+            sg_sleep_cb[i].pre_sleep_cb();
+        }
+    }
+}
+
+static VOID_T sleep_post_wakeup(VOID_T)
+{
+    UINT_T i;
+
+    for (i = 0; i < sg_sleep_cb_num; i++) {
+        if (sg_sleep_cb[i].post_wakeup_cb) {
+            sg_sleep_cb[i].post_wakeup_cb();
+        }
+    }
+}
 // --- END: user defines and implements ---
 
 /**
@@ -28,7 +128,28 @@ unsigned char cpu_lp_flag = 0;
 OPERATE_RET tkl_cpu_sleep_callback_register(TUYA_SLEEP_CB_T *sleep_cb)
 {
     // --- BEGIN: user implements ---
-    return OPRT_NOT_SUPPORTED;
+    UINT_T num;
+
+    if ((NULL == sleep_cb) || ((NULL == sleep_cb->pre_sleep_cb) && (NULL == sleep_cb->post_wakeup_cb))) {
+        return OPRT_INVALID_PARM;
+    }
+
+    TKL_ENTER_CRITICAL();
+    num = sg_sleep_cb_num;
+    if (num >= TKL_SLEEP_CB_MAX) {
+        TKL_EXIT_CRITICAL();
+        return OPRT_COM_ERROR;
+    }
+    // the slot is complete before the sleep path can see it
+    sg_sleep_cb[num] = *sleep_cb;
+    sg_sleep_cb_num = num + 1;
+    TKL_EXIT_CRITICAL();
+
+    if (0 == num) {
+        mcu_ps_sleep_cb_register(sleep_pre_sleep, sleep_post_wakeup);
+    }
+
+    return OPRT_OK;
     // --- END: user implements ---
 }
 
@@ -42,7 +163,7 @@ OPERATE_RET tkl_cpu_sleep_callback_register(TUYA_SLEEP_CB_T *sleep_cb)
 VOID_T tkl_cpu_allow_sleep(VOID_T)
 {
     // --- BEGIN: user implements ---
-    return ;
+    sleep_voter_cpu(FALSE);
     // --- END: user implements ---
 }
 
@@ -56,7 +177,108 @@ VOID_T tkl_cpu_allow_sleep(VOID_T)
 VOID_T tkl_cpu_force_wakeup(VOID_T)
 {
     // --- BEGIN: user implements ---
-    return ;
+    sleep_voter_cpu(TRUE);
+    // --- END: user implements ---
+}
+
+/**
+ * @brief register a sleep voter, a name already registered returns the same voter
+ *
+ * @param[in] name:   voter name, must stay valid
+ * @param[out] voter: voter id
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tkl_cpu_sleep_voter_register(CONST CHAR_T *name, UINT_T *voter)
+{
+    // --- BEGIN: user implements ---
+    UINT_T i;
+    OPERATE_RET ret = OPRT_OK;
+
+    if ((NULL == name) || (NULL == voter)) {
+        return OPRT_INVALID_PARM;
+    }
+
+    TKL_ENTER_CRITICAL();
+    for (i = 0; i < sg_voter_num; i++) {
+        if (0 == strcmp(sg_voter[i].name, name)) {
+            break;
+        }
+    }
+    if (i == sg_voter_num) {
+        if (i < TKL_SLEEP_VOTER_MAX) {
+            memset(&sg_voter[i], 0, sizeof(sg_voter[i]));
+            sg_voter[i].name = name;
+            sg_voter_num++;
+        } else {
+            ret = OPRT_COM_ERROR;
+        }
+    }
+    TKL_EXIT_CRITICAL();
+
+    *voter = i;
+    return ret;
+    // --- END: user implements ---
+}
+
+/**
+ * @brief add or drop a vote to keep the cpu awake, the cpu may sleep when no voter holds a vote
+ *
+ * @param[in] voter: voter id
+ * @param[in] awake: TRUE to add a vote, FALSE to drop one
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tkl_cpu_sleep_vote(UINT_T voter, BOOL_T awake)
+{
+    // --- BEGIN: user implements ---
+    INT_T held;
+    SYS_TIME_T now = tkl_system_get_millisecond();
+
+    if (voter >= sg_voter_num) {
+        return OPRT_INVALID_PARM;
+    }
+
+    TKL_ENTER_CRITICAL();
+    if (!awake && (0 == sg_voter[voter].votes)) {
+        TKL_EXIT_CRITICAL();
+        return OPRT_COM_ERROR;
+    }
+
+    held = sleep_voter_vote(&sg_voter[voter], awake, now);
+    sleep_voter_held(held);
+    TKL_EXIT_CRITICAL();
+
+    return OPRT_OK;
+    // --- END: user implements ---
+}
+
+/**
+ * @brief get the statistics of a voter, the current block is included
+ *
+ * @param[in] voter: voter id, from 0 up to the first id that fails
+ * @param[out] stat: voter statistics
+ *
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ */
+OPERATE_RET tkl_cpu_sleep_voter_stat(UINT_T voter, TKL_SLEEP_VOTER_STAT_T *stat)
+{
+    // --- BEGIN: user implements ---
+    SYS_TIME_T now = tkl_system_get_millisecond();
+
+    if ((voter >= sg_voter_num) || (NULL == stat)) {
+        return OPRT_INVALID_PARM;
+    }
+
+    TKL_ENTER_CRITICAL();
+    *stat = sg_voter[voter];
+    TKL_EXIT_CRITICAL();
+
+    if (stat->votes) {
+        sleep_voter_account(stat, now);
+    }
+
+    return OPRT_OK;
     // --- END: user implements ---
 }
 
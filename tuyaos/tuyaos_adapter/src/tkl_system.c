@@ -10,7 +10,9 @@
  */
 
 // --- BEGIN: user defines and implements ---
+#include <string.h>
 #include "tkl_system.h"
+#include "tkl_memory.h"
 #include "tuya_error_code.h"
 #include "start_type_pub.h"
 #include "FreeRTOS.h"
@@ -192,3 +194,51 @@ OPERATE_RET tkl_system_get_cpu_info(TUYA_CPU_INFO_T **cpu_ary, INT_T *cpu_cnt)
     // --- END: user implements ---
 }
 
+/**
+* @brief get cpu time used by each task
+*
+* @param[out] stats: task array, NULL only restarts the window
+* @param[in] num: capacity of stats
+* @param[out] window_us: time since the previous call
+*
+* @return number of tasks written
+*/
+INT_T tkl_system_get_task_stat(TKL_TASK_STAT_T *stats, INT_T num, UINT64_T *window_us)
+{
+    // --- BEGIN: user implements ---
+    INT_T i = 0;
+    INT_T cnt = 0;
+    uint64_t win_us = 0;
+    rtos_thread_stat_t *task = NULL;
+
+    if ((NULL != stats) && (num > 0)) {
+        task = (rtos_thread_stat_t *)tkl_system_malloc(num * sizeof(rtos_thread_stat_t));
+        if (NULL == task) {
+            return 0;
+        }
+    }
+
+    cnt = rtos_get_thread_stats(task, (NULL == task) ? 0 : num, &win_us);
+
+    for (i = 0; i < cnt; i++) {
+        memcpy(stats[i].name, task[i].name, TKL_TASK_NAME_LEN);
+        stats[i].number = task[i].number;
+        stats[i].priority = task[i].priority;
+        stats[i].state = task[i].state;
+        stats[i].run_us = task[i].run_us;
+        stats[i].win_us = task[i].win_us;
+        stats[i].permille = task[i].permille;
+        stats[i].win_permille = task[i].win_permille;
+    }
+
+    if (NULL != task) {
+        tkl_system_free(task);
+    }
+
+    if (NULL != window_us) {
+        *window_us = win_us;
+    }
+
+    return cnt;
+    // --- END: user implements ---
+}
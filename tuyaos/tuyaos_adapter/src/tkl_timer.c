@@ -14,10 +14,18 @@
 #include "tuya_error_code.h"
 #include "tkl_output.h"
 #include "BkDriverTimer.h"
+#include "FreeRTOS.h"
 
 /* private macros */
 #define TIMER_DEV_NUM       4
 
+/* bk timer1 is the run time stats counter of the kernel when enabled, see rtos_stats.c */
+#if (configGENERATE_RUN_TIME_STATS == 1)
+#define TIMER_ID_INVALID(id)    (((id) >= TIMER_DEV_NUM) || (1 == (id)))
+#else
+#define TIMER_ID_INVALID(id)    ((id) >= TIMER_DEV_NUM)
+#endif
+
 /* private variables */
 static TUYA_TIMER_BASE_CFG_T timer_map[] = {
     {TUYA_TIMER_MODE_ONCE, NULL, NULL},
@@ -87,7 +95,7 @@ void tkl_hw_test(void)
 OPERATE_RET tkl_timer_init(TUYA_TIMER_NUM_E timer_id, TUYA_TIMER_BASE_CFG_T *cfg)
 {
     // --- BEGIN: user implements ---
-    if (timer_id >= TIMER_DEV_NUM) {
+    if (TIMER_ID_INVALID(timer_id)) {
         return OPRT_NOT_SUPPORTED;
     }
     if(cfg == NULL){
@@ -114,7 +122,7 @@ OPERATE_RET tkl_timer_init(TUYA_TIMER_NUM_E timer_id, TUYA_TIMER_BASE_CFG_T *cfg
 OPERATE_RET tkl_timer_start(TUYA_TIMER_NUM_E timer_id, UINT_T us)
 {
     // --- BEGIN: user implements ---
-    if (timer_id >= TIMER_DEV_NUM) {
+    if (TIMER_ID_INVALID(timer_id)) {
         return OPRT_NOT_SUPPORTED;
     }
 
@@ -143,7 +151,7 @@ OPERATE_RET tkl_timer_start(TUYA_TIMER_NUM_E timer_id, UINT_T us)
 OPERATE_RET tkl_timer_stop(TUYA_TIMER_NUM_E timer_id)
 {
     // --- BEGIN: user implements ---
-    if (timer_id >= TIMER_DEV_NUM) {
+    if (TIMER_ID_INVALID(timer_id)) {
         return OPRT_NOT_SUPPORTED;
     }
 
@@ -200,6 +208,10 @@ OPERATE_RET tkl_timer_get(TUYA_TIMER_NUM_E timer_id, UINT_T *us)
     // --- BEGIN: user implements ---
     uint32_t count;
 
+    if (TIMER_ID_INVALID(timer_id)) {
+        return OPRT_NOT_SUPPORTED;
+    }
+
     if ((0 == timer_id) || (1 == timer_id)) {
         bk_timer_read_cnt(timer_id, &count);
 
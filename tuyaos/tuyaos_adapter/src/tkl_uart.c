@@ -12,9 +12,76 @@
 // --- BEGIN: user defines and implements ---
 #include "tkl_uart.h"
 #include "tuya_error_code.h"
+#include "tuya_ringbuf.h"
+#include "tkl_mutex.h"
 #include "drv_model_pub.h"
 #include "uart_pub.h"
+#include "bk_timer_pub.h"
+#include "fake_clock_pub.h"
 #include "BkDriverUart.h"
+#include <string.h>
+
+/*
+ * once a tx callback is registered the port sends asynchronously: write
+ * only queues into a per-port ring and the TX_FIFO_NEED_WRITE interrupt
+ * refills the hardware fifo from it. the callback runs in the interrupt
+ * when the ring has drained. the ring takes one producer, so writer tasks
+ * queue under the port's tx mutex; write must not be called from an isr.
+ */
+#ifndef TKL_UART_TX_RING_SIZE
+#define TKL_UART_TX_RING_SIZE   1024
+#endif
+
+/*
+ * with an rx callback the interrupt drains the hardware fifo into a ring
+ * and tkl_uart_read takes from there. in frame mode the callback only runs
+ * when the line has been idle for TKL_UART_RX_FRAME_CMD character times,
+ * or early once the ring is three quarters full.
+ */
+#ifndef TKL_UART_RX_RING_SIZE
+#define TKL_UART_RX_RING_SIZE   1024
+#endif
+
+/* hand spans of at least TKL_UART_TX_DMA_MIN bytes to the general dma */
+#ifndef TKL_UART_TX_DMA
+#define TKL_UART_TX_DMA         0
+#endif
+#ifndef TKL_UART_TX_DMA_MIN
+#define TKL_UART_TX_DMA_MIN     64
+#endif
+#ifndef TKL_UART_TX_DMA_CHANNEL
+#define TKL_UART_TX_DMA_CHANNEL GDMA_CHANNEL_2
+#endif
+#if TKL_UART_TX_DMA
+#include "general_dma_pub.h"
+#endif
+
+/* isr time comes from the 26MHz calibration timer, which wraps every 15s */
+#ifndef TKL_UART_ISR_STAT
+#define TKL_UART_ISR_STAT       1
+#endif
+#define UART_CAL_TIMER_WRAP     (15000 * 26000)
+#define UART_CAL_TIMER_MHZ      26
+
+#define UART_PORT_NUM           2
+
+typedef struct {
+    TUYA_UART_NUM_E port_id;        // handed back to the callbacks
+    TUYA_RINGBUFF_T rx_ring;
+    TUYA_UART_IRQ_CB rx_cb;
+    UINT32_T rx_frame_idle;         // idle characters that end a frame, 0 calls rx_cb per interrupt
+    UINT32_T rx_overflow_base;      // driver overrun count at the last stat clear
+    TUYA_RINGBUFF_T tx_ring;
+    TKL_MUTEX_HANDLE tx_mutex;      // serializes the writers of tx_ring, created once and kept
+    TUYA_UART_IRQ_CB tx_cb;
+    BOOL_T tx_int_off;              // tkl_uart_set_tx_int(FALSE) pauses the ring
+    volatile UINT32_T tx_dma_len;   // bytes of the ring head owned by the dma
+    UINT32_T sec;
+    UINT32_T sec_bytes;
+    TKL_UART_STAT_T stat;
+} UART_PORT_T;
+
+static UART_PORT_T s_uart[UART_PORT_NUM];
 
 extern void bk_send_byte(UINT8 uport, UINT8 data);
 void uart_dev_irq_handler(int uport, void *param)
@@ -24,6 +91,289 @@ void uart_dev_irq_handler(int uport, void *param)
     uart_irq_cb((UINT_T)uport);
 }
 
+static void __uart_rx_handler(int uport, void *param)
+{
+    UART_PORT_T *uart = &s_uart[uport];
+    UINT8_T *span;
+    UINT8_T tmp[16];
+    UINT32_T len, n;
+
+    do {
+        len = tuya_ring_buff_write_reserve(uart->rx_ring, &span, TKL_UART_RX_RING_SIZE);
+        if (0 == len) {
+            // ring full, empty the fifo anyway so it does not overrun
+            while ((n = uart_read_fifo_buf(uport, tmp, sizeof(tmp))) > 0) {
+                uart->stat.rx_drop += n;
+            }
+            break;
+        }
+        n = uart_read_fifo_buf(uport, span, len);
+        tuya_ring_buff_write_commit(uart->rx_ring, n);
+        uart->stat.rx_bytes += n;
+    } while (n == len);
+
+    if (NULL == uart->rx_cb) {
+        return;
+    }
+
+    if (0 == uart->rx_frame_idle) {
+        uart->rx_cb(uart->port_id);
+        return;
+    }
+
+    if (uart_rx_is_stop_end(uport) ||
+        tuya_ring_buff_free_size_get(uart->rx_ring) < TKL_UART_RX_RING_SIZE / 4) {
+        if (tuya_ring_buff_used_size_get(uart->rx_ring) > 0) {
+            uart->stat.rx_frames++;
+            uart->rx_cb(uart->port_id);
+        }
+    }
+}
+
+/* stop the rx interrupt from using the ring and release it */
+static VOID_T __uart_rx_ring_close(UINT8 port)
+{
+    UART_PORT_T *uart = &s_uart[port];
+    TUYA_RINGBUFF_T ring = uart->rx_ring;
+    GLOBAL_INT_DECLARATION();
+
+    if (NULL == ring) {
+        return;
+    }
+
+    bk_uart_set_rx_callback(port, NULL, NULL);
+    GLOBAL_INT_DISABLE();
+    uart->rx_cb = NULL;
+    uart->rx_ring = NULL;
+    GLOBAL_INT_RESTORE();
+    tuya_ring_buff_free(ring);
+}
+
+static VOID_T __uart_tx_account(UART_PORT_T *uart, UINT32_T len)
+{
+    UINT32_T sec = fclk_get_second();
+
+    if (sec != uart->sec) {
+        uart->stat.tx_bytes_per_sec = (sec == uart->sec + 1) ? uart->sec_bytes : 0;
+        uart->sec = sec;
+        uart->sec_bytes = 0;
+    }
+    uart->sec_bytes += len;
+    uart->stat.tx_bytes += len;
+}
+
+#if TKL_UART_ISR_STAT
+static UINT32_T __uart_cal_cnt(VOID_T)
+{
+    timer_param_t param;
+
+    param.channel = CAL_TIMER_ID;
+    param.period = 0;
+    sddev_control(TIMER_DEV_NAME, CMD_TIMER_READ_CNT, &param);
+
+    return param.period;
+}
+
+static VOID_T __uart_isr_account(UART_PORT_T *uart, UINT32_T start)
+{
+    UINT32_T end = __uart_cal_cnt();
+    UINT32_T us;
+
+    if (end < start) {
+        end += UART_CAL_TIMER_WRAP;
+    }
+    us = (end - start) / UART_CAL_TIMER_MHZ;
+
+    uart->stat.tx_isr_cnt++;
+    uart->stat.tx_isr_us += us;
+    if (us > uart->stat.tx_isr_max_us) {
+        uart->stat.tx_isr_max_us = us;
+    }
+}
+#endif
+
+#if TKL_UART_TX_DMA
+static volatile INT_T s_uart_dma_port = -1;
+
+static VOID_T __uart_tx_dma_done(UINT32 param)
+{
+    UART_PORT_T *uart;
+    INT_T port = s_uart_dma_port;
+
+    if (port < 0) {
+        return;
+    }
+    uart = &s_uart[port];
+
+    tuya_ring_buff_consume(uart->tx_ring, uart->tx_dma_len);
+    __uart_tx_account(uart, uart->tx_dma_len);
+    uart->stat.tx_dma_bytes += uart->tx_dma_len;
+    uart->tx_dma_len = 0;
+    s_uart_dma_port = -1;
+
+    // the fifo interrupt refills what is left and reports completion
+    uart_set_tx_fifo_needwr_int(port, !uart->tx_int_off);
+}
+
+static BOOL_T __uart_tx_dma_start(UINT8 port, UINT8_T *span, UINT32_T len)
+{
+    GDMACFG_TPYES_ST init_cfg;
+    GDMA_CFG_ST en_cfg;
+
+    if (s_uart_dma_port >= 0) {
+        return FALSE;
+    }
+
+    memset(&init_cfg, 0, sizeof(GDMACFG_TPYES_ST));
+    init_cfg.dstdat_width = 8;
+    init_cfg.srcdat_width = 8;
+    init_cfg.dstptr_incr = 0;
+    init_cfg.srcptr_incr = 1;
+    init_cfg.src_start_addr = span;
+    init_cfg.dst_start_addr = (VOID_T *)uart_tx_fifo_port(port);
+    init_cfg.channel = TKL_UART_TX_DMA_CHANNEL;
+    init_cfg.prio = 0;
+    init_cfg.u.type4.src_loop_start_addr = span;
+    init_cfg.u.type4.src_loop_end_addr = span + len;
+    init_cfg.fin_handler = __uart_tx_dma_done;
+    init_cfg.src_module = GDMA_X_SRC_DTCM_RD_REQ;
+    init_cfg.dst_module = (BK_UART_1 == port) ? GDMA_X_DST_UART1_TX_REQ : GDMA_X_DST_UART2_TX_REQ;
+    sddev_control(GDMA_DEV_NAME, CMD_GDMA_CFG_TYPE4, &init_cfg);
+
+    en_cfg.channel = TKL_UART_TX_DMA_CHANNEL;
+    en_cfg.param = len;
+    sddev_control(GDMA_DEV_NAME, CMD_GDMA_SET_TRANS_LENGTH, &en_cfg);
+    en_cfg.param = 0;
+    sddev_control(GDMA_DEV_NAME, CMD_GDMA_CFG_WORK_MODE, &en_cfg);
+    sddev_control(GDMA_DEV_NAME, CMD_GDMA_CFG_SRCADDR_LOOP, &en_cfg);
+
+    s_uart_dma_port = port;
+    s_uart[port].tx_dma_len = len;
+
+    en_cfg.param = 1;
+    sddev_control(GDMA_DEV_NAME, CMD_GDMA_SET_DMA_ENABLE, &en_cfg);
+
+    return TRUE;
+}
+#endif
+
+/* move ring data into the fifo, interrupts must be off. returns FALSE once the ring is empty */
+static BOOL_T __uart_tx_refill(UINT8 port)
+{
+    UART_PORT_T *uart = &s_uart[port];
+    UINT8_T *span;
+    UINT32_T len, n;
+
+    if (uart->tx_dma_len) {
+        return TRUE;
+    }
+
+    for (;;) {
+        len = tuya_ring_buff_peek_span(uart->tx_ring, &span);
+        if (0 == len) {
+            return FALSE;
+        }
+
+#if TKL_UART_TX_DMA
+        if (len >= TKL_UART_TX_DMA_MIN && __uart_tx_dma_start(port, span, len)) {
+            uart_set_tx_fifo_needwr_int(port, 0);
+            return TRUE;
+        }
+#endif
+
+        n = uart_write_fifo_buf(port, span, len);
+        tuya_ring_buff_consume(uart->tx_ring, n);
+        __uart_tx_account(uart, n);
+        if (n < len) {
+            return TRUE;
+        }
+    }
+}
+
+static void __uart_tx_needwr_handler(int uport, void *param)
+{
+    UART_PORT_T *uart = &s_uart[uport];
+#if TKL_UART_ISR_STAT
+    UINT32_T start = __uart_cal_cnt();
+#endif
+
+    if (!__uart_tx_refill(uport)) {
+        uart_set_tx_fifo_needwr_int(uport, 0);
+        if (uart->tx_cb) {
+            uart->tx_cb(uart->port_id);
+        }
+    }
+
+#if TKL_UART_ISR_STAT
+    __uart_isr_account(uart, start);
+#endif
+}
+
+/*
+ * prime the fifo from task context and leave the interrupt on, even when
+ * everything fit, so completion is always reported from the interrupt.
+ */
+static VOID_T __uart_tx_kick(UINT8 port)
+{
+    UART_PORT_T *uart = &s_uart[port];
+    GLOBAL_INT_DECLARATION();
+
+    GLOBAL_INT_DISABLE();
+    if (!uart->tx_int_off && !uart->tx_dma_len) {
+        __uart_tx_refill(port);
+        if (!uart->tx_dma_len) {
+            uart_set_tx_fifo_needwr_int(port, 1);
+        }
+    }
+    GLOBAL_INT_RESTORE();
+}
+
+/* leave async mode: stop the interrupt and flush what is still queued */
+static VOID_T __uart_tx_async_close(UINT8 port)
+{
+    UART_PORT_T *uart = &s_uart[port];
+    TUYA_RINGBUFF_T ring;
+    UINT8_T *span;
+    UINT32_T len, n;
+    GLOBAL_INT_DECLARATION();
+
+    if (NULL == uart->tx_mutex) {
+        return;
+    }
+
+    // no writer is in the ring once the mutex is held
+    tkl_mutex_lock(uart->tx_mutex);
+    ring = uart->tx_ring;
+    if (NULL == ring) {
+        tkl_mutex_unlock(uart->tx_mutex);
+        return;
+    }
+
+#if TKL_UART_TX_DMA
+    while (uart->tx_dma_len) {
+        ;
+    }
+#endif
+
+    GLOBAL_INT_DISABLE();
+    uart_set_tx_fifo_needwr_int(port, 0);
+    uart_tx_fifo_needwr_callback_set(port, NULL, NULL);
+    uart->tx_cb = NULL;
+    uart->tx_ring = NULL;
+    GLOBAL_INT_RESTORE();
+
+    while ((len = tuya_ring_buff_peek_span(ring, &span)) > 0) {
+        n = uart_write_fifo_buf(port, span, len);
+        tuya_ring_buff_consume(ring, n);
+        GLOBAL_INT_DISABLE();
+        __uart_tx_account(uart, n);
+        GLOBAL_INT_RESTORE();
+    }
+    tuya_ring_buff_free(ring);
+
+    tkl_mutex_unlock(uart->tx_mutex);
+}
+
 // --- END: user defines and implements ---
 
 /**
@@ -122,6 +472,8 @@ OPERATE_RET tkl_uart_deinit(TUYA_UART_NUM_E port_id)
         return OPRT_INVALID_PARM;
     }
 
+    __uart_tx_async_close(port);
+    __uart_rx_ring_close(port);
     bk_uart_diable_rx(port);
     bk_uart_finalize(port);
     return OPRT_OK;
@@ -145,9 +497,10 @@ OPERATE_RET tkl_uart_deinit(TUYA_UART_NUM_E port_id)
 INT_T tkl_uart_write(TUYA_UART_NUM_E port_id, VOID_T *buff, UINT16_T len)
 {
     // --- BEGIN: user implements ---
-    extern void bk_send_byte(UINT8 uport, UINT8 data);
+    UART_PORT_T *uart;
     bk_uart_t port;
     int i;
+    GLOBAL_INT_DECLARATION();
 
     if ( 0 == TUYA_UART_GET_PORT_NUMBER(port_id)) {
         port = BK_UART_1;
@@ -156,10 +509,32 @@ INT_T tkl_uart_write(TUYA_UART_NUM_E port_id, VOID_T *buff, UINT16_T len)
     } else {
         return OPRT_INVALID_PARM;
     }
+    uart = &s_uart[port];
 
-    for ( i = 0; i < len; i++) {
-        bk_send_byte( port, *(UINT8*)(buff+i));
+    if (uart->tx_ring) {
+        // the ring may have been closed while this task waited for the mutex
+        tkl_mutex_lock(uart->tx_mutex);
+        if (uart->tx_ring) {
+            i = tuya_ring_buff_write(uart->tx_ring, buff, len);
+            GLOBAL_INT_DISABLE();
+            uart->stat.tx_drop += len - i;
+            GLOBAL_INT_RESTORE();
+            if (i > 0) {
+                __uart_tx_kick(port);
+            }
+            tkl_mutex_unlock(uart->tx_mutex);
+            return i;
+        }
+        tkl_mutex_unlock(uart->tx_mutex);
     }
+
+    for ( i = 0; i < len; ) {
+        i += uart_write_fifo_buf(port, (UINT8_T *)buff + i, len - i);
+    }
+    // the stat ioctls and the tx interrupt touch the same counters
+    GLOBAL_INT_DISABLE();
+    __uart_tx_account(uart, len);
+    GLOBAL_INT_RESTORE();
     
     return i;
     // --- END: user implements ---
@@ -181,6 +556,8 @@ INT_T tkl_uart_write(TUYA_UART_NUM_E port_id, VOID_T *buff, UINT16_T len)
 VOID_T tkl_uart_rx_irq_cb_reg(TUYA_UART_NUM_E port_id, TUYA_UART_IRQ_CB rx_cb)
 {
     // --- BEGIN: user implements ---
+    UART_PORT_T *uart;
+    TUYA_RINGBUFF_T ring;
     bk_uart_t port;
 
     if ( 0 == TUYA_UART_GET_PORT_NUMBER(port_id)) {
@@ -190,8 +567,24 @@ VOID_T tkl_uart_rx_irq_cb_reg(TUYA_UART_NUM_E port_id, TUYA_UART_IRQ_CB rx_cb)
     } else {
         return ;
     }
+    uart = &s_uart[port];
 
-    bk_uart_set_rx_callback(port, uart_dev_irq_handler, rx_cb);
+    if (NULL == rx_cb) {
+        __uart_rx_ring_close(port);
+        return ;
+    }
+
+    if (NULL == uart->rx_ring) {
+        if (OPRT_OK != tuya_ring_buff_create(TKL_UART_RX_RING_SIZE, OVERFLOW_STOP_TYPE, &ring)) {
+            // no memory for the ring, let the callback read the fifo directly
+            bk_uart_set_rx_callback(port, uart_dev_irq_handler, rx_cb);
+            return ;
+        }
+        uart->rx_ring = ring;
+    }
+    uart->port_id = port_id;
+    uart->rx_cb = rx_cb;
+    bk_uart_set_rx_callback(port, __uart_rx_handler, NULL);
     // --- END: user implements ---
 }
 
@@ -213,7 +606,39 @@ VOID_T tkl_uart_rx_irq_cb_reg(TUYA_UART_NUM_E port_id, TUYA_UART_IRQ_CB rx_cb)
 VOID_T tkl_uart_tx_irq_cb_reg(TUYA_UART_NUM_E port_id, TUYA_UART_IRQ_CB tx_cb)
 {
     // --- BEGIN: user implements ---
-    return ;
+    UART_PORT_T *uart;
+    TUYA_RINGBUFF_T ring;
+    bk_uart_t port;
+    GLOBAL_INT_DECLARATION();
+
+    if ( 0 == TUYA_UART_GET_PORT_NUMBER(port_id)) {
+        port = BK_UART_1;
+    } else if ( 1 == TUYA_UART_GET_PORT_NUMBER(port_id)) {
+        port = BK_UART_2;
+    } else {
+        return ;
+    }
+    uart = &s_uart[port];
+
+    if (NULL == tx_cb) {
+        __uart_tx_async_close(port);
+        return ;
+    }
+
+    if (NULL == uart->tx_ring) {
+        if ((NULL == uart->tx_mutex) && (OPRT_OK != tkl_mutex_create_init(&uart->tx_mutex))) {
+            return ;
+        }
+        if (OPRT_OK != tuya_ring_buff_create(TKL_UART_TX_RING_SIZE, OVERFLOW_STOP_TYPE, &ring)) {
+            return ;
+        }
+        GLOBAL_INT_DISABLE();
+        uart->tx_ring = ring;
+        uart->port_id = port_id;
+        uart_tx_fifo_needwr_callback_set(port, __uart_tx_needwr_handler, NULL);
+        GLOBAL_INT_RESTORE();
+    }
+    uart->tx_cb = tx_cb;
     // --- END: user implements ---
 }
 
@@ -235,8 +660,6 @@ INT_T tkl_uart_read(TUYA_UART_NUM_E port_id, VOID_T *buff, UINT16_T len)
 {
     // --- BEGIN: user implements ---
     bk_uart_t port;
-    int result;
-    int i;
 
     if ( 0 == TUYA_UART_GET_PORT_NUMBER(port_id)) {
         port = BK_UART_1;
@@ -246,16 +669,11 @@ INT_T tkl_uart_read(TUYA_UART_NUM_E port_id, VOID_T *buff, UINT16_T len)
         return OPRT_INVALID_PARM;
     }
 
-    for ( i = 0; i < len; i++) {
-        result = uart_read_byte(port);
-        if (-1 != result) {
-            *(uint8_t*)(buff+i)  = (uint8_t) result;
-        }
-        else {
-            break;
-        }
+    if (s_uart[port].rx_ring) {
+        return tuya_ring_buff_read(s_uart[port].rx_ring, buff, len);
     }
-    return i;
+
+    return uart_read_fifo_buf(port, buff, len);
     // --- END: user implements ---
 }
 
@@ -275,6 +693,33 @@ INT_T tkl_uart_read(TUYA_UART_NUM_E port_id, VOID_T *buff, UINT16_T len)
 OPERATE_RET tkl_uart_set_tx_int(TUYA_UART_NUM_E port_id, BOOL_T enable)
 {
     // --- BEGIN: user implements ---
+    UART_PORT_T *uart;
+    bk_uart_t port;
+    GLOBAL_INT_DECLARATION();
+
+    if ( 0 == TUYA_UART_GET_PORT_NUMBER(port_id)) {
+        port = BK_UART_1;
+    } else if ( 1 == TUYA_UART_GET_PORT_NUMBER(port_id)) {
+        port = BK_UART_2;
+    } else {
+        return OPRT_INVALID_PARM;
+    }
+    uart = &s_uart[port];
+
+    if (NULL == uart->tx_ring) {
+        return OPRT_OK;
+    }
+
+    if (enable) {
+        uart->tx_int_off = FALSE;
+        __uart_tx_kick(port);
+    } else {
+        GLOBAL_INT_DISABLE();
+        uart->tx_int_off = TRUE;
+        uart_set_tx_fifo_needwr_int(port, 0);
+        GLOBAL_INT_RESTORE();
+    }
+
     return OPRT_OK;
     // --- END: user implements ---
 }
@@ -333,6 +778,58 @@ OPERATE_RET tkl_uart_wait_for_data(TUYA_UART_NUM_E port_id, INT_T timeout_ms)
 OPERATE_RET tkl_uart_ioctl(TUYA_UART_NUM_E port_id, UINT32_T cmd, VOID *arg)
 {
     // --- BEGIN: user implements ---
+    UART_PORT_T *uart;
+    UINT32_T idle;
+    UINT8_T sel;
+    bk_uart_t port;
+    GLOBAL_INT_DECLARATION();
+
+    if ( 0 == TUYA_UART_GET_PORT_NUMBER(port_id)) {
+        port = BK_UART_1;
+    } else if ( 1 == TUYA_UART_GET_PORT_NUMBER(port_id)) {
+        port = BK_UART_2;
+    } else {
+        return OPRT_INVALID_PARM;
+    }
+    uart = &s_uart[port];
+
+    switch (cmd) {
+    case TKL_UART_STAT_GET_CMD:
+        if (NULL == arg) {
+            return OPRT_INVALID_PARM;
+        }
+        GLOBAL_INT_DISABLE();
+        __uart_tx_account(uart, 0);
+        uart->stat.rx_overflow = uart_rx_overflow_get(port) - uart->rx_overflow_base;
+        memcpy(arg, &uart->stat, sizeof(TKL_UART_STAT_T));
+        GLOBAL_INT_RESTORE();
+        return OPRT_OK;
+
+    case TKL_UART_STAT_CLR_CMD:
+        GLOBAL_INT_DISABLE();
+        memset(&uart->stat, 0, sizeof(TKL_UART_STAT_T));
+        uart->sec_bytes = 0;
+        uart->rx_overflow_base = uart_rx_overflow_get(port);
+        GLOBAL_INT_RESTORE();
+        return OPRT_OK;
+
+    case TKL_UART_RX_FRAME_CMD:
+        if (NULL == arg) {
+            return OPRT_INVALID_PARM;
+        }
+        // the idle detector counts 32, 64, 128 or 256 bit times, about 10 bits a character
+        idle = *(UINT32_T *)arg;
+        for (sel = 0; sel < 3 && (32u << sel) < idle * 10; sel++) {
+            ;
+        }
+        uart_set_rx_stop_detect_time(port, sel);
+        uart->rx_frame_idle = idle;
+        return OPRT_OK;
+
+    default:
+        break;
+    }
+
     return OPRT_NOT_SUPPORTED;
     // --- END: user implements ---
 }
@@ -10,6 +10,7 @@
  */
 
 // --- BEGIN: user defines and implements ---
+#include <string.h>
 #include "tkl_wifi.h"
 #include "tuya_error_code.h"
 #include "tkl_semaphore.h"
@@ -32,6 +33,7 @@
 #define WIFI_MGNT_FRAME_TX_MSG              (1 << 1)
 
 #define SCAN_MAX_AP 64
+#define SCAN_ASYNC_TIMEOUT_MS 10000
 
 /***********************************************************
 *************************variable define********************
@@ -47,8 +49,17 @@ typedef struct{
     SCHAR_T passwd[64];
 }FAST_WF_CONNECTED_AP_INFO_V2_T;
 
+typedef struct {
+    WF_SCAN_PARAM_S param;
+    SCHAR_T ssid[WIFI_SSID_LEN + 1];
+    UCHAR_T s_len;
+    volatile BOOL_T active;     ///< results go to param.cb
+    SYS_TIME_T start;
+} WIFI_SCAN_ASYNC_S;
+
 static WF_WK_MD_E wf_mode = WWM_POWERDOWN; 
 static TKL_SEM_HANDLE scanHandle = NULL;
+static WIFI_SCAN_ASYNC_S scan_async;
 static SNIFFER_CALLBACK snif_cb = NULL;
 static WIFI_REV_MGNT_CB mgnt_recv_cb = NULL;
 static WIFI_EVENT_CB wifi_event_cb = NULL;
@@ -74,6 +85,7 @@ wifi_country_t country_code[] =
 
 static void tkl_wifi_powersave_disable(void);
 static void tkl_wifi_powersave_enable(void);
+static BOOL_T scan_async_end(VOID_T);
 
 /**
  * @brief ԭ�� scan ������CB
@@ -83,11 +95,112 @@ static void tkl_wifi_powersave_enable(void);
  */
 static void scan_cb(void *ctxt, unsigned char param)
 {
+    scan_async_end();
+
     if(scanHandle) {
         tkl_semaphore_post(scanHandle);
     }
 }
 
+static VOID_T scan_wait_launch(VOID_T)
+{
+    if(first_set_flag) {
+        extern void extended_app_waiting_for_launch(void); 
+        extended_app_waiting_for_launch(); /* wait for wifi init the first time */
+        first_set_flag = FALSE;
+    }
+}
+
+/**
+ * @brief finish the async scan for its user, the wifi core may still be
+ *        scanning if it was stopped early
+ *
+ * @return TRUE if this call finished it
+ */
+static BOOL_T scan_async_end(VOID_T)
+{
+    BOOL_T active;
+
+    TKL_ENTER_CRITICAL();
+    active = scan_async.active;
+    scan_async.active = FALSE;
+    TKL_EXIT_CRITICAL();
+
+    if (!active) {
+        return FALSE;
+    }
+
+    mhdr_scanu_reg_bss_cb(NULL, NULL);
+    scan_async.param.cb(NULL, scan_async.param.arg);
+
+    return TRUE;
+}
+
+/**
+ * @brief per bss scan result, called by the wifi core for every beacon or
+ *        probe response kept in the scan result set
+ */
+static void scan_bss_cb(void *ctxt, SCAN_RST_ITEM_PTR item)
+{
+    AP_IF_S ap;
+    BOOL_T stop;
+
+    if (!scan_async.active) {
+        return;
+    }
+
+    memset(&ap, 0, SIZEOF(AP_IF_S));
+    while (ap.s_len < WIFI_SSID_LEN && item->ssid[ap.s_len]) {
+        ap.s_len++;
+    }
+
+    /* a directed scan still hears other beacons, report the target only */
+    if (scan_async.param.ssid && 
+        (ap.s_len != scan_async.s_len || memcmp(item->ssid, scan_async.ssid, ap.s_len))) {
+        return;
+    }
+
+    memcpy(ap.ssid, item->ssid, ap.s_len);
+    memcpy(ap.bssid, item->bssid, 6);
+    ap.channel = item->channel;
+    ap.rssi = item->level;
+    ap.security = item->security;
+
+    stop = scan_async.param.cb(&ap, scan_async.param.arg);
+    if (scan_async.param.ssid && scan_async.param.stop_on_match) {
+        stop = TRUE;
+    }
+
+    if (stop && scan_async_end()) {
+        rw_msg_send_scan_cancel_req(NULL);
+    }
+}
+
+typedef struct {
+    AP_IF_S *best;
+    BOOL_T found;       // no rssi is too weak to count, however far the ap
+} SCAN_SSID_CTX_S;
+
+/**
+ * @brief result callback of the ssid scan of tkl_wifi_scan_ap, keeps the
+ *        best ap and wakes up the caller
+ */
+static BOOL_T scan_ssid_cb(CONST AP_IF_S *ap, VOID_T *arg)
+{
+    SCAN_SSID_CTX_S *ctx = (SCAN_SSID_CTX_S *)arg;
+
+    if (ap && (!ctx->found || ap->rssi > ctx->best->rssi)) {
+        memcpy(ctx->best, ap, SIZEOF(AP_IF_S));
+        ctx->found = TRUE;
+    }
+
+    if (NULL == ap && scanHandle) {
+        tkl_semaphore_post(scanHandle);
+    }
+
+    return FALSE;
+}
+
 /**
  * @brief scan current environment and obtain all the ap
  *        infos in current environment
@@ -106,7 +219,7 @@ static OPERATE_RET tkl_wifi_all_ap_scan(AP_IF_S **ap_ary, unsigned int *num)
     INT_T ssid_len;
     ScanResult_adv apList;
 
-    if((NULL == ap_ary) || (NULL == num) || NULL != scanHandle) {
+    if((NULL == ap_ary) || (NULL == num) || NULL != scanHandle || scan_async.active) {
         return OPRT_OS_ADAPTER_INVALID_PARM;
     }
     
@@ -118,10 +231,10 @@ static OPERATE_RET tkl_wifi_all_ap_scan(AP_IF_S **ap_ary, unsigned int *num)
     mhdr_scanu_reg_cb(scan_cb, 0);
     if (bk_wlan_start_scan() == 0) {
         ret = tkl_semaphore_wait(scanHandle, 5000);
-        bk_printf("wait sem timeout\r\n");
+        TKL_LOG_ARGS(TKL_LOG_MODULE_WIFI, TKL_LOG_LEVEL_WARN, "wait sem timeout\r\n");
     } else {
         ret = OPRT_COM_ERROR;
-        bk_printf("start scan failed\r\n");
+        TKL_LOG_ARGS(TKL_LOG_MODULE_WIFI, TKL_LOG_LEVEL_ERR, "start scan failed\r\n");
     }    
     tkl_semaphore_release(scanHandle);
     scanHandle = NULL;
@@ -274,12 +387,12 @@ static void tkl_wifi_powersave_disable(void)
 
 void _wifi_station_status_cb(rw_evt_type type)
 {
-    bk_printf(">>> _wifi_station_status_cb %d\r\n", type);
+    TKL_LOG_ARGS(TKL_LOG_MODULE_WIFI, TKL_LOG_LEVEL_INFO, ">>> _wifi_station_status_cb %d\r\n", type);
     if (wifi_event_cb) {
         switch (type) {
             case RW_EVT_STA_GOT_IP:
                 connect_status = type;
-                bk_printf("WFE_CONNECTED %d\r\n", connect_status);
+                TKL_LOG_ARGS(TKL_LOG_MODULE_WIFI, TKL_LOG_LEVEL_INFO, "WFE_CONNECTED %d\r\n", connect_status);
                 wifi_event_cb(WFE_CONNECTED, NULL);
                 break;
 
@@ -288,21 +401,21 @@ void _wifi_station_status_cb(rw_evt_type type)
             case RW_EVT_STA_ASSOC_FULL:
             case RW_EVT_STA_PASSWORD_WRONG:
                 connect_status = type;
-                bk_printf("RW_EVT_STA_CONNECT_FAILED %d\r\n", connect_status);
+                TKL_LOG_ARGS(TKL_LOG_MODULE_WIFI, TKL_LOG_LEVEL_WARN, "RW_EVT_STA_CONNECT_FAILED %d\r\n", connect_status);
                 wifi_event_cb(WFE_CONNECT_FAILED, NULL);
 
                 break;
 
             case RW_EVT_STA_DHCP_FAILED:
                 connect_status = type;
-                bk_printf("RW_EVT_STA_CONNECT_FAILED %d\r\n", connect_status);
+                TKL_LOG_ARGS(TKL_LOG_MODULE_WIFI, TKL_LOG_LEVEL_WARN, "RW_EVT_STA_CONNECT_FAILED %d\r\n", connect_status);
                 wifi_event_cb(WFE_CONNECT_FAILED, NULL);
                 break;
                 
             case RW_EVT_STA_DISCONNECTED:
             case RW_EVT_STA_BEACON_LOSE:
                 connect_status = type;
-                bk_printf("WFE_DISCONNECTED %d\r\n", connect_status);
+                TKL_LOG_ARGS(TKL_LOG_MODULE_WIFI, TKL_LOG_LEVEL_INFO, "WFE_DISCONNECTED %d\r\n", connect_status);
                 wifi_event_cb(WFE_DISCONNECTED, NULL);
 
                 break;
@@ -347,11 +460,7 @@ OPERATE_RET tkl_wifi_init(WIFI_EVENT_CB cb)
 OPERATE_RET tkl_wifi_scan_ap(CONST SCHAR_T *ssid, AP_IF_S **ap_ary, UINT_T *num)
 {
     // --- BEGIN: user implements ---
-    if(first_set_flag) {
-        extern void extended_app_waiting_for_launch(void); 
-        extended_app_waiting_for_launch(); /* �״εȴ�wifi��ʼ��OK */
-        first_set_flag = FALSE;
-    }
+    scan_wait_launch();
     
     if(NULL == ssid)
     {
@@ -360,95 +469,67 @@ OPERATE_RET tkl_wifi_scan_ap(CONST SCHAR_T *ssid, AP_IF_S **ap_ary, UINT_T *num)
 
     AP_IF_S *array = NULL;
     OPERATE_RET ret;
-    INT_T i = 0, j = 0, ssid_len;
-    ScanResult_adv apList;
-
-    memset(&apList, 0, sizeof(ScanResult_adv));
+    WF_SCAN_PARAM_S param;
+    SCAN_SSID_CTX_S ctx;
 
     if((NULL == ssid) || (NULL == ap_ary) ||  NULL != scanHandle) {
         return OPRT_OS_ADAPTER_INVALID_PARM;
     }
 
-    ret = tkl_semaphore_create_init(&scanHandle, 0, 1);
-    if ( ret !=  OPRT_OK ) {
-        return ret;
-    }
-    
-    mhdr_scanu_reg_cb(scan_cb, 0);
-    if (bk_wlan_start_assign_scan((UINT8 **)&ssid, 1) == 0) {
-        ret = tkl_semaphore_wait(scanHandle, 5000);
-        bk_printf("wait sem timeout\r\n");
-    } else {
-        ret = OPRT_COM_ERROR;
-        bk_printf("start scan failed\r\n");
-    }    
-    tkl_semaphore_release(scanHandle);
-    scanHandle = NULL;
-    
-    if (ret !=  OPRT_OK) {
-        return ret;
-    }
-
-    if ((wlan_sta_scan_result(&apList) != 0) || (0 == apList.ApNum)) {
-        tkl_log_output("scan err\r\n");
-        goto SCAN_ERR;
-    }       
-    
     array = (AP_IF_S *)tkl_system_malloc(sizeof(AP_IF_S));
     if(NULL == array) {
-        goto SCAN_ERR;
+        return OPRT_OS_ADAPTER_COM_ERROR;
     }
-    
     memset(array, 0, sizeof(AP_IF_S));
-    array->rssi = -100;
+    ctx.best = array;
+    ctx.found = FALSE;
 
-    for (i = 0; i < apList.ApNum ; i++) {
-        /* skip non-matched ssid */
-        if (os_strcmp(apList.ApList[i].ssid, (char *)ssid))
-            continue;
+    ret = tkl_semaphore_create_init(&scanHandle, 0, 1);
+    if ( ret !=  OPRT_OK ) {
+        tkl_system_free(array);
+        return ret;
+    }
 
-        /* found */
-        if (apList.ApList[i].ApPower < array->rssi) { /* rssi �ź�ǿ�ȱȽ� */
-            continue;
-        }
-        array->channel = apList.ApList[i].channel;
-        array->rssi = apList.ApList[i].ApPower;
-        os_memcpy(array->bssid, apList.ApList[i].bssid, 6);
+    /* sweep every channel and keep the strongest bss of the ssid, stopping
+     * at the first match would pick whichever channel is scanned first */
+    memset(&param, 0, sizeof(param));
+    param.ssid = ssid;
+    param.stop_on_match = FALSE;
+    param.cb = scan_ssid_cb;
+    param.arg = &ctx;
 
-        ssid_len = os_strlen(apList.ApList[i].ssid);
-        if (ssid_len > WIFI_SSID_LEN) {
-            ssid_len = WIFI_SSID_LEN;
+    ret = tkl_wifi_scan_ap_async(&param);
+    if (ret == OPRT_OK) {
+        ret = tkl_semaphore_wait(scanHandle, 5000);
+        if (ret != OPRT_OK) {
+            TKL_LOG_ARGS(TKL_LOG_MODULE_WIFI, TKL_LOG_LEVEL_WARN, "wait sem timeout\r\n");
         }
-
-        memset(array->ssid, 0, ssid_len);
-        os_strncpy((char *)array->ssid, apList.ApList[i].ssid, ssid_len);
-        array->s_len = ssid_len;
-        array->security = apList.ApList[i].security;
-        
-		j++;
+        /* stop feeding the result into array before it is freed */
+        if (scan_async_end()) {
+            rw_msg_send_scan_cancel_req(NULL);
+        }
+    } else {
+        TKL_LOG_ARGS(TKL_LOG_MODULE_WIFI, TKL_LOG_LEVEL_ERR, "start scan failed\r\n");
     }
 
-	if (j == 0) {
-        goto SCAN_ERR;
+    /* a late end of scan must not post a released semaphore */
+    TKL_ENTER_CRITICAL();
+    TKL_SEM_HANDLE sem = scanHandle;
+    scanHandle = NULL;
+    TKL_EXIT_CRITICAL();
+    tkl_semaphore_release(sem);
+
+    if (ret != OPRT_OK || !ctx.found) {
+        tkl_system_free(array);
+        return OPRT_OS_ADAPTER_COM_ERROR;
     }
+
     *ap_ary = array;
-    if (apList.ApList != NULL) {
-        tkl_system_free(apList.ApList);
+    if (num) {
+        *num = 1;
     }
 
     return OPRT_OK;
-    
-SCAN_ERR:
-    if (apList.ApList != NULL) {
-        tkl_system_free(apList.ApList);
-        apList.ApList = NULL;
-    }
-
-    if (array) {
-        tkl_system_free(array);
-        array = NULL;
-    }
-    return OPRT_OS_ADAPTER_COM_ERROR;
     // --- END: user implements ---
 }
 
@@ -474,6 +555,60 @@ OPERATE_RET tkl_wifi_release_ap(AP_IF_S *ap)
     // --- END: user implements ---
 }
 
+/**
+ * @brief start a scan and stream the aps found to param->cb, the
+ *        function returns as soon as the scan is started
+ *
+ * @param[in]       param       the scan param
+ * @return OPRT_OK on success. Others on error, please refer to tuya_error_code.h
+ *
+ * @note dwell_ms is a hint, the bk7231n lmac scans with fixed dwell times
+ */
+OPERATE_RET tkl_wifi_scan_ap_async(CONST WF_SCAN_PARAM_S *param)
+{
+    // --- BEGIN: user implements ---
+    UINT8 *ssid;
+
+    if ((NULL == param) || (NULL == param->cb) || (param->chan_num > CNTSOF(param->chans))) {
+        return OPRT_OS_ADAPTER_INVALID_PARM;
+    }
+
+    scan_wait_launch();
+
+    if (scan_async.active) {
+        if (tkl_system_get_millisecond() - scan_async.start < SCAN_ASYNC_TIMEOUT_MS) {
+            return OPRT_COM_ERROR;
+        }
+        /* the end of the previous scan got lost */
+        scan_async_end();
+    }
+
+    memset(&scan_async, 0, SIZEOF(scan_async));
+    memcpy(&scan_async.param, param, SIZEOF(WF_SCAN_PARAM_S));
+    if (param->ssid) {
+        scan_async.s_len = strnlen((CONST CHAR_T *)param->ssid, WIFI_SSID_LEN);
+        memcpy(scan_async.ssid, param->ssid, scan_async.s_len);
+        scan_async.param.ssid = scan_async.ssid;
+    }
+    scan_async.start = tkl_system_get_millisecond();
+    scan_async.active = TRUE;
+
+    mhdr_scanu_reg_bss_cb(scan_bss_cb, NULL);
+    mhdr_scanu_reg_cb(scan_cb, 0);
+
+    ssid = (UINT8 *)scan_async.ssid;
+    if (bk_wlan_start_chan_scan(&ssid, param->ssid ? 1 : 0, (UINT8 *)param->chans, param->chan_num) != 0) {
+        TKL_ENTER_CRITICAL();
+        scan_async.active = FALSE;
+        TKL_EXIT_CRITICAL();
+        mhdr_scanu_reg_bss_cb(NULL, NULL);
+        return OPRT_COM_ERROR;
+    }
+
+    return OPRT_OK;
+    // --- END: user implements ---
+}
+
 /**
  * @brief start a soft ap
  * 
@@ -764,7 +899,7 @@ OPERATE_RET tkl_wifi_get_work_mode(WF_WK_MD_E *mode)
 OPERATE_RET tkl_wifi_get_connected_ap_info(FAST_WF_CONNECTED_AP_INFO_T **fast_ap_info)
 {
     // --- BEGIN: user implements ---
-    bk_printf("tkl_wifi_get_connected_ap_info\r\n");
+    TKL_LOG_ARGS(TKL_LOG_MODULE_WIFI, TKL_LOG_LEVEL_DEBUG, "tkl_wifi_get_connected_ap_info\r\n");
     extern char wlan_fast_connect_buffer[];
     *fast_ap_info = (FAST_WF_CONNECTED_AP_INFO_T *)wlan_fast_connect_buffer;
     return OPRT_OK;
@@ -894,7 +1029,7 @@ OPERATE_RET tkl_wifi_set_lp_mode(CONST BOOL_T enable, CONST UCHAR_T dtim)
 OPERATE_RET tkl_wifi_station_fast_connect(CONST FAST_WF_CONNECTED_AP_INFO_T *fast_ap_info)
 {
     // --- BEGIN: user implements ---
-    bk_printf("!! tkl_wifi_station_fast_connect\r\n");
+    TKL_LOG_ARGS(TKL_LOG_MODULE_WIFI, TKL_LOG_LEVEL_INFO, "!! tkl_wifi_station_fast_connect\r\n");
 
     //if(wifi_state_get_thread == NULL)
     //    tkl_thread_create(&wifi_state_get_thread, "wifi_state_get_thread", 1024, 4, ty_wifi_state_get_thread, NULL);
@@ -930,7 +1065,7 @@ OPERATE_RET tkl_wifi_station_connect(CONST SCHAR_T *ssid, CONST SCHAR_T *passwd)
     //if(wifi_state_get_thread == NULL)
     //    tkl_thread_create(&wifi_state_get_thread, "wifi_state_get_thread", 1024, 4, ty_wifi_state_get_thread, NULL);
 
-    bk_printf(">>> tkl_wifi_station_connect\r\n");
+    TKL_LOG_ARGS(TKL_LOG_MODULE_WIFI, TKL_LOG_LEVEL_INFO, ">>> tkl_wifi_station_connect\r\n");
     if(!set_station_flag) {
         set_station_flag = TRUE;
         mhdr_set_station_status_cb(_wifi_station_status_cb);
@@ -986,9 +1121,9 @@ OPERATE_RET tkl_wifi_station_get_conn_ap_rssi(SCHAR_T *rssi)
             if (rssi[i] < min_rssi) {
                 min_rssi = tmp_rssi;
             }
-            bk_printf("get rssi: %d\r\n", tmp_rssi);
+            TKL_LOG_ARGS(TKL_LOG_MODULE_WIFI, TKL_LOG_LEVEL_DEBUG, "get rssi: %d\r\n", tmp_rssi);
         } else {
-            bk_printf("get rssi error\r\n");
+            TKL_LOG_ARGS(TKL_LOG_MODULE_WIFI, TKL_LOG_LEVEL_ERR, "get rssi error\r\n");
             error_cnt++;
         }
         sum_rssi += tmp_rssi;
@@ -0,0 +1,305 @@
+/**
+ * @file flash_sim.c
+ * @brief RAM flash with power cut injection, for the host tests
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tkl_flash.h"
+#include "tkl_memory.h"
+#include "tkl_mutex.h"
+#include "tkl_semaphore.h"
+#include "tkl_system.h"
+#include "tkl_thread.h"
+#include "flash_sim.h"
+
+jmp_buf flash_sim_cut_jmp;
+
+static UINT8_T sg_flash[FLASH_SIM_SIZE];
+static UINT32_T sg_erase_cnt[FLASH_SIM_SECTOR_NUM];
+static UINT32_T sg_ops;
+static INT_T sg_ops_left = -1;
+static UINT32_T sg_cut_addr;
+static BOOL_T sg_cut_erase;
+
+static BOOL_T sg_gc_posted;
+static THREAD_FUNC_T sg_gc_func;
+static jmp_buf sg_gc_jmp;
+
+static VOID_T __sim_range(UINT32_T addr, UINT32_T size)
+{
+    if ((addr < FLASH_SIM_BASE) || (addr + size > FLASH_SIM_BASE + FLASH_SIM_SIZE)) {
+        printf("flash_sim: 0x%x+%u outside the partition\n", addr, size);
+        abort();
+    }
+}
+
+/* TRUE when this operation is the one the power is cut in */
+static BOOL_T __sim_op(VOID_T)
+{
+    sg_ops++;
+    if (0 == sg_ops_left) {
+        return TRUE;
+    }
+    if (sg_ops_left > 0) {
+        sg_ops_left--;
+    }
+
+    return FALSE;
+}
+
+VOID_T flash_sim_init(VOID_T)
+{
+    memset(sg_flash, 0xff, sizeof(sg_flash));
+    memset(sg_erase_cnt, 0, sizeof(sg_erase_cnt));
+    sg_ops = 0;
+    sg_ops_left = -1;
+}
+
+UINT8_T *flash_sim_mem(VOID_T)
+{
+    return sg_flash;
+}
+
+VOID_T flash_sim_cut_after(INT_T ops)
+{
+    sg_ops_left = ops;
+}
+
+UINT32_T flash_sim_cut_addr(BOOL_T *erase)
+{
+    *erase = sg_cut_erase;
+    return sg_cut_addr;
+}
+
+UINT32_T flash_sim_ops(VOID_T)
+{
+    return sg_ops;
+}
+
+UINT32_T flash_sim_erase_cnt(UINT32_T sec)
+{
+    return sg_erase_cnt[sec];
+}
+
+VOID_T flash_sim_run_gc(VOID_T)
+{
+    // the task blocks on its semaphore once it is done, that ends the run
+    if (sg_gc_func && sg_gc_posted && !setjmp(sg_gc_jmp)) {
+        sg_gc_func(NULL);
+    }
+}
+
+OPERATE_RET tkl_flash_read(UINT32_T addr, UCHAR_T *dst, UINT32_T size)
+{
+    __sim_range(addr, size);
+    memcpy(dst, &sg_flash[addr - FLASH_SIM_BASE], size);
+
+    return OPRT_OK;
+}
+
+static OPERATE_RET __sim_write(UINT32_T addr, CONST UCHAR_T *src, UINT32_T size)
+{
+    UINT8_T *p;
+    UINT32_T i, n;
+
+    __sim_range(addr, size);
+    p = &sg_flash[addr - FLASH_SIM_BASE];
+    if (!__sim_op()) {
+        for (i = 0; i < size; i++) {
+            p[i] &= src[i];
+        }
+        return OPRT_OK;
+    }
+
+    // a cut programs a prefix, the byte after it may get some of its bits
+    n = rand() % (size + 1);
+    for (i = 0; i < n; i++) {
+        p[i] &= src[i];
+    }
+    if ((n < size) && (rand() % 2)) {
+        p[n] &= src[n] | (UINT8_T)rand();
+    }
+    sg_cut_addr = addr;
+    sg_cut_erase = FALSE;
+    longjmp(flash_sim_cut_jmp, 1);
+
+    return OPRT_COM_ERROR;
+}
+
+static OPERATE_RET __sim_erase(UINT32_T addr, UINT32_T size)
+{
+    UINT8_T *p;
+    UINT32_T i, n;
+
+    __sim_range(addr, size);
+    if ((addr % FLASH_SIM_SECTOR) || (FLASH_SIM_SECTOR != size)) {
+        printf("flash_sim: erase of 0x%x+%u is not one sector\n", addr, size);
+        abort();
+    }
+    p = &sg_flash[addr - FLASH_SIM_BASE];
+    sg_erase_cnt[(addr - FLASH_SIM_BASE) / FLASH_SIM_SECTOR]++;
+    if (!__sim_op()) {
+        memset(p, 0xff, size);
+        return OPRT_OK;
+    }
+
+    // a cut erase leaves the sector done, done up to some point, or done in random bytes
+    switch (rand() % 3) {
+        case 0:
+            memset(p, 0xff, size);
+            break;
+        case 1:
+            memset(p, 0xff, rand() % size);
+            break;
+        default:
+            for (i = 0; i < size; i++) {
+                n = rand();
+                if (n % 2) {
+                    p[i] = 0xff;
+                }
+            }
+            break;
+    }
+    sg_cut_addr = addr;
+    sg_cut_erase = TRUE;
+    longjmp(flash_sim_cut_jmp, 1);
+
+    return OPRT_COM_ERROR;
+}
+
+#ifdef FLASH_SIM_UF
+/* nothing but tkl_fs may write the UF partition */
+static VOID_T __sim_not_uf(CONST CHAR_T *op)
+{
+    printf("flash_sim: %s in the UF partition\n", op);
+    abort();
+}
+
+OPERATE_RET tkl_flash_write(UINT32_T addr, CONST UCHAR_T *src, UINT32_T size)
+{
+    __sim_not_uf("tkl_flash_write");
+    return OPRT_INVALID_PARM;
+}
+
+OPERATE_RET tkl_flash_erase(UINT32_T addr, UINT32_T size)
+{
+    __sim_not_uf("tkl_flash_erase");
+    return OPRT_INVALID_PARM;
+}
+
+OPERATE_RET tkl_flash_uf_write(UINT32_T addr, CONST UCHAR_T *src, UINT32_T size)
+{
+    return __sim_write(addr, src, size);
+}
+
+OPERATE_RET tkl_flash_uf_erase(UINT32_T addr, UINT32_T size)
+{
+    return __sim_erase(addr, size);
+}
+#else
+OPERATE_RET tkl_flash_write(UINT32_T addr, CONST UCHAR_T *src, UINT32_T size)
+{
+    return __sim_write(addr, src, size);
+}
+
+OPERATE_RET tkl_flash_erase(UINT32_T addr, UINT32_T size)
+{
+    return __sim_erase(addr, size);
+}
+#endif
+
+OPERATE_RET tkl_flash_get_one_type_info(TUYA_FLASH_TYPE_E type, TUYA_FLASH_BASE_INFO_T *info)
+{
+    if (TUYA_FLASH_TYPE_UF != type) {
+        return OPRT_NOT_SUPPORTED;
+    }
+    info->partition_num = 1;
+    info->partition[0].start_addr = FLASH_SIM_BASE;
+    info->partition[0].size = FLASH_SIM_SIZE;
+    info->partition[0].block_size = FLASH_SIM_SECTOR;
+
+    return OPRT_OK;
+}
+
+/* one thread, the locks have nothing to do */
+OPERATE_RET tkl_mutex_create_init(TKL_MUTEX_HANDLE *handle)
+{
+    *handle = (TKL_MUTEX_HANDLE)1;
+    return OPRT_OK;
+}
+
+OPERATE_RET tkl_mutex_lock(CONST TKL_MUTEX_HANDLE handle)
+{
+    return OPRT_OK;
+}
+
+OPERATE_RET tkl_mutex_unlock(CONST TKL_MUTEX_HANDLE handle)
+{
+    return OPRT_OK;
+}
+
+OPERATE_RET tkl_mutex_release(CONST TKL_MUTEX_HANDLE handle)
+{
+    return OPRT_OK;
+}
+
+OPERATE_RET tkl_semaphore_create_init(TKL_SEM_HANDLE *handle, UINT_T sem_cnt, UINT_T sem_max)
+{
+    *handle = (TKL_SEM_HANDLE)1;
+    return OPRT_OK;
+}
+
+OPERATE_RET tkl_semaphore_wait(CONST TKL_SEM_HANDLE handle, UINT_T timeout)
+{
+    if (!sg_gc_posted) {
+        longjmp(sg_gc_jmp, 1);
+    }
+    sg_gc_posted = FALSE;
+
+    return OPRT_OK;
+}
+
+OPERATE_RET tkl_semaphore_post(CONST TKL_SEM_HANDLE handle)
+{
+    sg_gc_posted = TRUE;
+    return OPRT_OK;
+}
+
+OPERATE_RET tkl_semaphore_release(CONST TKL_SEM_HANDLE handle)
+{
+    return OPRT_OK;
+}
+
+OPERATE_RET tkl_thread_create(TKL_THREAD_HANDLE *thread, CONST CHAR_T *name, UINT_T stack_size, UINT_T priority,
+                              CONST THREAD_FUNC_T func, VOID_T *CONST arg)
+{
+    sg_gc_func = func;
+    *thread = (TKL_THREAD_HANDLE)1;
+
+    return OPRT_OK;
+}
+
+VOID_T *tkl_system_malloc(SIZE_T size)
+{
+    return malloc(size);
+}
+
+VOID_T tkl_system_free(VOID_T *ptr)
+{
+    free(ptr);
+}
+
+VOID_T *tkl_system_realloc(VOID_T *ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+UINT_T tkl_system_enter_critical(VOID_T)
+{
+    return 0;
+}
+
+VOID_T tkl_system_exit_critical(UINT_T irq_mask)
+{
+}
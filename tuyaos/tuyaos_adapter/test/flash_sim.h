@@ -0,0 +1,51 @@
+/**
+ * @file flash_sim.h
+ * @brief RAM flash with power cut injection, for the host tests
+ *
+ * the UF partition by default, a test of another area builds the simulator
+ * with its own FLASH_SIM_BASE and FLASH_SIM_SIZE. like tkl_flash.c, the UF
+ * partition only takes tkl_flash_uf_write/tkl_flash_uf_erase.
+ *
+ * programming only clears bits and an erase sets a whole sector to 0xff, like
+ * the NOR flash on the board. once a cut is armed the flash takes that many
+ * more program or erase operations, the next one stops part way and the
+ * simulator longjmps to flash_sim_cut_jmp. the os calls tkl_fs needs are
+ * stubbed for a single thread, the gc task only runs from flash_sim_run_gc().
+ */
+#ifndef __FLASH_SIM_H__
+#define __FLASH_SIM_H__
+
+#include <setjmp.h>
+#include "tuya_cloud_types.h"
+
+#ifndef FLASH_SIM_BASE
+#define FLASH_SIM_BASE          0x1D2000
+#define FLASH_SIM_UF            1
+#endif
+#ifndef FLASH_SIM_SIZE
+#define FLASH_SIM_SIZE          0x18000
+#endif
+#define FLASH_SIM_SECTOR        4096
+#define FLASH_SIM_SECTOR_NUM    (FLASH_SIM_SIZE / FLASH_SIM_SECTOR)
+
+extern jmp_buf flash_sim_cut_jmp;
+
+/* all sectors erased, no cut armed */
+VOID_T flash_sim_init(VOID_T);
+
+/* the partition content, to plant data behind the file store */
+UINT8_T *flash_sim_mem(VOID_T);
+
+/* cut the power in the program or erase after the next ops ones, -1 disarms */
+VOID_T flash_sim_cut_after(INT_T ops);
+
+/* address of the operation the last cut hit, erase is TRUE when it was an erase */
+UINT32_T flash_sim_cut_addr(BOOL_T *erase);
+
+UINT32_T flash_sim_ops(VOID_T);
+UINT32_T flash_sim_erase_cnt(UINT32_T sec);
+
+/* run the gc task once if tkl_fs posted it */
+VOID_T flash_sim_run_gc(VOID_T);
+
+#endif
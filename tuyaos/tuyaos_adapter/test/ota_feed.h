@@ -0,0 +1,146 @@
+/**
+ * @file ota_feed.h
+ * @brief packages and the sdk side of tkl_ota for the host tests
+ *
+ * included after ../src/tkl_ota.c and a CHECK macro. packages are fed in
+ * random packet sizes the way the sdk does it, the bytes
+ * tkl_ota_data_process leaves in remain_len are sent again in front of the
+ * next packet.
+ */
+#ifndef __OTA_FEED_H__
+#define __OTA_FEED_H__
+
+#include "flash_sim.h"
+
+#define TEST_HDR_LEN        sizeof(UPDATE_FILE_HDR_S)
+#define TEST_PKG_MAX        (TEST_HDR_LEN + OTA_IMAGE_MAX_SIZE)
+#define TEST_PACKET_MAX     3000
+
+static BOOL_T sg_protect = TRUE;
+static UINT32_T sg_resets;
+
+static UINT8_T sg_pend[TEST_PACKET_MAX + TEST_PKG_MAX];
+
+int tkl_flash_set_protect(const BOOL_T enable)
+{
+    sg_protect = enable;
+    return 0;
+}
+
+VOID_T tkl_log_output(CONST CHAR_T *format, ...)
+{
+}
+
+VOID_T tkl_system_reset(VOID_T)
+{
+    sg_resets++;
+}
+
+static UINT8_T *__flash(UINT32_T addr)
+{
+    return &flash_sim_mem()[addr - FLASH_SIM_BASE];
+}
+
+static VOID_T __put_be32(UINT8_T *p, UINT32_T v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static BOOL_T __erased(UINT32_T addr, UINT32_T len)
+{
+    UINT32_T i;
+
+    for (i = 0; i < len; i++) {
+        if (0xff != *__flash(addr + i)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/* a raw package of the image, as ota_pack.py builds it */
+static UINT32_T __pkg_raw(CONST UINT8_T *image, UINT32_T len, UINT8_T *pkg)
+{
+    UINT32_T i, sum = 0;
+
+    __put_be32(&pkg[0], UG_PKG_HEAD);
+    memset(&pkg[4], 0, 12);
+    memcpy(&pkg[4], "1.0.1", 5);
+    __put_be32(&pkg[16], len);
+    for (i = 0; i < len; i++) {
+        sum += image[i];
+    }
+    __put_be32(&pkg[20], sum);
+    for (sum = 0, i = 0; i < 24; i++) {
+        sum += pkg[i];
+    }
+    __put_be32(&pkg[24], sum);
+    __put_be32(&pkg[28], UG_PKG_TAIL);
+    memcpy(&pkg[TEST_HDR_LEN], image, len);
+
+    return TEST_HDR_LEN + len;
+}
+
+static VOID_T __image_rand(UINT8_T *image, UINT32_T len)
+{
+    UINT32_T i;
+
+    for (i = 0; i < len; i++) {
+        image[i] = rand();
+    }
+}
+
+/*
+ * send pkg[from, len) in packets of 1 to max bytes, pack->offset is the package
+ * offset of the first byte handed over. returns the first error.
+ */
+static OPERATE_RET __feed(CONST UINT8_T *pkg, UINT32_T len, UINT32_T from, UINT32_T max)
+{
+    TUYA_OTA_DATA_T pack;
+    UINT_T remain;
+    UINT32_T pos = from, pend = 0, n;
+    OPERATE_RET ret;
+
+    while ((pos < len) || pend) {
+        n = 1 + rand() % max;
+        if (n > len - pos) {
+            n = len - pos;
+        }
+        memcpy(&sg_pend[pend], &pkg[pos], n);
+        pend += n;
+        pos += n;
+
+        // the sdk hands the rest back while it gets consumed
+        do {
+            memset(&pack, 0, sizeof(pack));
+            pack.total_len = len;
+            pack.offset = pos - pend;
+            pack.data = sg_pend;
+            pack.len = pend;
+            remain = pend;
+            ret = tkl_ota_data_process(&pack, &remain);
+            if (OPRT_OK != ret) {
+                return ret;
+            }
+            CHECK(remain <= pend);
+            if (remain == pend) {
+                break;
+            }
+            memmove(sg_pend, &sg_pend[pend - remain], remain);
+            pend = remain;
+        } while (pend);
+
+        if (pos == len) {
+            // nothing more to come, a partial page stays behind
+            break;
+        }
+    }
+
+    return OPRT_OK;
+}
+
+#endif
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Round trip of ota packages: ota_pack.py builds raw, lz and diff packages of
+made up firmware images and tkl_ota_pack_test writes each of them through
+tkl_ota.c into the flash simulator.
+
+python ota_pack_test.py [seed]
+"""
+
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.dont_write_bytecode = True
+sys.path.insert(0, os.path.join(HERE, '..', '..', '..', 'beken_os', 'tools', 'generate'))
+
+import ota_pack  # noqa: E402
+
+
+def firmware(rnd, size):
+    """code-like bytes: instruction words from a small set, literal pools and strings"""
+    words = [rnd.getrandbits(32).to_bytes(4, 'little') for _ in range(200)]
+    out = bytearray()
+    while len(out) < size:
+        kind = rnd.random()
+        if kind < 0.7:
+            out += b''.join(rnd.choice(words) for _ in range(rnd.randint(1, 16)))
+        elif kind < 0.85:
+            out += bytes(rnd.getrandbits(8) for _ in range(rnd.randint(4, 64)))
+        else:
+            out += b'tkl_ota %d\0' % rnd.randint(0, 999)
+    return bytes(out[:size])
+
+
+def patch(rnd, base):
+    """the next release: some words changed, a block inserted and one removed"""
+    img = bytearray(base)
+    for _ in range(40):
+        p = rnd.randrange(0, len(img) - 4) & ~3
+        img[p:p + 4] = rnd.getrandbits(32).to_bytes(4, 'little')
+    p = rnd.randrange(len(img))
+    img[p:p] = firmware(rnd, 600)
+    p = rnd.randrange(len(img) - 400)
+    del img[p:p + 400]
+    return bytes(img)
+
+
+def run(tmp, name, pkg, image, base=None):
+    files = []
+    for suffix, data in (('pkg', pkg), ('img', image), ('base', base)):
+        if data is None:
+            continue
+        path = os.path.join(tmp, '%s.%s' % (name, suffix))
+        with open(path, 'wb') as f:
+            f.write(data)
+        files.append(path)
+    subprocess.check_call([os.path.join(HERE, 'tkl_ota_pack_test')] + files)
+
+
+def main():
+    rnd = random.Random(int(sys.argv[1]) if len(sys.argv) > 1 else 1)
+    base = firmware(rnd, 60000)
+    new = patch(rnd, base)
+    noise = bytes(rnd.getrandbits(8) for _ in range(9000))
+
+    with tempfile.TemporaryDirectory() as tmp:
+        run(tmp, 'raw', ota_pack.pack(new, '1.0.1', 'raw'), new)
+        for name, image in (('lz_1', new[:1]), ('lz_300', new[:300]), ('lz', new), ('lz_noise', noise)):
+            run(tmp, name, ota_pack.pack(image, '1.0.1', 'lz'), image)
+        run(tmp, 'diff', ota_pack.pack(new, '1.0.1', 'diff', base), new, base)
+        run(tmp, 'diff_self', ota_pack.pack(base, '1.0.1', 'diff', base), base, base)
+        run(tmp, 'diff_new', ota_pack.pack(noise, '1.0.1', 'diff', base), noise, base)
+
+    print('ota_pack_test: ok')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,8 @@
+/**
+ * @file ieee802_11_defs.h
+ * @brief host build of the adapter tests, tkl_wifi takes nothing from the wpa_supplicant header
+ */
+#ifndef IEEE802_11_DEFS_H
+#define IEEE802_11_DEFS_H
+
+#endif
@@ -0,0 +1,21 @@
+/**
+ * @file mcu_ps_pub.h
+ * @brief host build of the adapter tests, the part of beken378/func/include/mcu_ps_pub.h
+ *        tkl_sleep uses
+ */
+#ifndef _MCU_PS_PUB_H_
+#define _MCU_PS_PUB_H_
+
+#include <stdint.h>
+
+#define     MCU_PS_TKL_VOTE        (1UL<<(3))
+
+/* run with interrupts disabled, right before the mcu sleeps and right after it wakes */
+typedef void (*MCU_PS_SLEEP_CB)(void);
+
+extern void mcu_prevent_clear(uint32_t );
+extern void mcu_prevent_set(uint32_t );
+extern uint32_t mcu_prevent_get(void );
+extern void mcu_ps_sleep_cb_register(MCU_PS_SLEEP_CB pre_sleep, MCU_PS_SLEEP_CB post_wakeup);
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ * @file rw_pub.h
+ * @brief host build of the adapter tests, the part of beken378/func/include/rw_pub.h
+ *        tkl_wifi uses. the real header pulls in the whole wifi stack.
+ */
+#ifndef _RW_PUB_H_
+#define _RW_PUB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "uart_pub.h"
+
+typedef unsigned char   UINT8;
+typedef unsigned short  UINT16;
+typedef unsigned int    UINT32;
+typedef uint8_t         u8;
+typedef int             OSStatus;
+
+typedef void (*FUNC_2PARAM_PTR)(void *arg, unsigned char param);
+
+typedef struct sta_scan_res
+{
+    UINT8 bssid[6];
+    char ssid[32];  /**< The SSID of an access point. */
+    char on_channel; // 1: ds IE channel=center_freq, 0: !=
+    char channel;
+    bool is_probersp; // true if scan result is probe response
+    UINT16 beacon_int;
+    UINT16 caps;
+    int level;
+    int security; // security type
+    UINT8 tsf[8];
+    UINT32 ie_len;
+    /* Followed by ie_len of IE data */
+}SCAN_RST_ITEM_T, *SCAN_RST_ITEM_PTR;
+
+typedef void (*SCANU_BSS_CB)(void *ctxt, SCAN_RST_ITEM_PTR item);
+
+typedef enum
+{
+    /* for station mode */
+    RW_EVT_STA_IDLE = 0,
+    RW_EVT_STA_SCANNING,
+    RW_EVT_STA_SCAN_OVER,
+    RW_EVT_STA_CONNECTING,
+    RW_EVT_STA_BEACON_LOSE,
+    RW_EVT_STA_PASSWORD_WRONG,  /* 5 */
+    RW_EVT_STA_NO_AP_FOUND,
+    RW_EVT_STA_ASSOC_FULL,
+    RW_EVT_STA_DISCONNECTED,    /* 8 disconnect with server */
+    RW_EVT_STA_CONNECT_FAILED,  /* 9 authentication failed */
+    RW_EVT_STA_DHCP_FAILED,
+    RW_EVT_STA_CONNECTED,       /* 11 authentication success */
+    RW_EVT_STA_GOT_IP,
+
+    /* for softap mode */
+    RW_EVT_AP_CONNECTED,          /* a client association success */
+    RW_EVT_AP_DISCONNECTED,       /* a client disconnect */
+    RW_EVT_AP_CONNECT_FAILED,     /* a client association failed */
+
+    RW_EVT_MAX
+}rw_evt_type;
+
+typedef enum {
+    WIFI_COUNTRY_POLICY_AUTO,   /**< Country policy is auto, use the country info of AP to which the station is connected */
+    WIFI_COUNTRY_POLICY_MANUAL, /**< Country policy is manual, always use the configured country info */
+} wifi_country_policy_t;
+
+/** @brief Structure describing WiFi country-based regional restrictions. */
+typedef struct {
+    char                  cc[3];   /**< country code string */
+    uint8_t               schan;   /**< start channel */
+    uint8_t               nchan;   /**< total channel number */
+    int8_t                max_tx_power;   /**< maximum tx power */
+    wifi_country_policy_t policy;  /**< country policy */
+} wifi_country_t;
+
+typedef void (*STATION_STATUS_CB)(rw_evt_type type);
+
+/* ip/umac/src/rxu/rxu_cntrl.h */
+typedef void (*mgmt_rx_cb_t)(uint8_t *data, int len, void *param);
+
+/* ip/lmac/src/hal/hal_machw.h and driver/common/reg/reg_mac_core.h */
+#define HW_IDLE         0
+extern uint8_t nxmac_current_state_getf(void);
+
+extern void mhdr_scanu_reg_cb(FUNC_2PARAM_PTR ind_cb, void *ctxt);
+extern void mhdr_scanu_reg_bss_cb(SCANU_BSS_CB ind_cb, void *ctxt);
+extern void mhdr_set_station_status_cb(STATION_STATUS_CB cb);
+extern int rw_msg_send_mm_active_req();
+extern int rw_msg_send_scan_cancel_req(void *cfm);
+
+/* reach tkl_wifi.c through include.h on the target */
+#define os_memcpy       memcpy
+#define os_strlen       strlen
+#define os_strcpy       strcpy
+#define os_strncpy      strncpy
+
+extern OSStatus rtos_delay_milliseconds(uint32_t num_ms);
+
+#endif
@@ -0,0 +1,29 @@
+/**
+ * @file tuya_error_code.h
+ * @brief host build of the adapter tests, the error codes the adapter and its stubs use
+ */
+#ifndef __TUYA_ERROR_CODE_H__
+#define __TUYA_ERROR_CODE_H__
+
+typedef int OPERATE_RET;
+
+#define OPRT_OK                 (0)
+#define OPRT_COM_ERROR          (-1)
+#define OPRT_INVALID_PARM       (-2)
+#define OPRT_MALLOC_FAILED      (-3)
+#define OPRT_NOT_SUPPORTED      (-4)
+#define OPRT_NOT_FOUND          (-6)
+#define OPRT_EXCEED_UPPER_LIMIT (-25)
+
+#define OPRT_OS_ADAPTER_INVALID_PARM        (-0x1000)
+#define OPRT_OS_ADAPTER_COM_ERROR           (-0x1001)
+#define OPRT_OS_ADAPTER_MAC_SET_FAILED      (-0x1002)
+#define OPRT_OS_ADAPTER_CHAN_SET_FAILED     (-0x1003)
+#define OPRT_OS_ADAPTER_MGNT_SEND_FAILED    (-0x1004)
+#define OPRT_OS_ADAPTER_CPU_LPMODE_SET_FAILED (-0x1005)
+#define OPRT_OS_ADAPTER_OTA_START_INFORM_FAILED (-0x1006)
+#define OPRT_OS_ADAPTER_OTA_PKT_SIZE_FAILED (-0x1007)
+#define OPRT_OS_ADAPTER_OTA_PROCESS_FAILED  (-0x1008)
+#define OPRT_OS_ADAPTER_OTA_END_INFORM_FAILED (-0x1009)
+
+#endif
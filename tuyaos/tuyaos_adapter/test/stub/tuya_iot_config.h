@@ -0,0 +1,8 @@
+/**
+ * @file tuya_iot_config.h
+ * @brief host build of the adapter tests, the sdk generates the real one
+ */
+#ifndef __TUYA_IOT_CONFIG_H__
+#define __TUYA_IOT_CONFIG_H__
+
+#endif
@@ -0,0 +1,14 @@
+/**
+ * @file uart_pub.h
+ * @brief host build of the adapter tests, the printf of beken378/driver/include/uart_pub.h
+ */
+#ifndef _UART_PUB_H
+#define _UART_PUB_H
+
+#include <stdio.h>
+
+#define os_printf       bk_printf
+
+extern void bk_printf(const char *fmt, ...);
+
+#endif
@@ -0,0 +1,189 @@
+/**
+ * @file wlan_ui_pub.h
+ * @brief host build of the adapter tests, the part of beken378/func/include/wlan_ui_pub.h
+ *        tkl_wifi uses
+ */
+#ifndef _WLAN_UI_PUB_H_
+#define _WLAN_UI_PUB_H_
+
+#include "rw_pub.h"
+
+#define WiFi_Interface  wlanInterfaceTypedef
+
+#define DHCP_DISABLE  (0)   /**< Disable DHCP service. */
+#define DHCP_CLIENT   (1)   /**< Enable DHCP client which get IP address from DHCP server automatically,
+                                reset Wi-Fi connection if failed. */
+#define DHCP_SERVER   (2)   /**< Enable DHCP server, needs assign a static address as local address. */
+
+/**
+ *  @brief  wlan network interface enumeration definition.
+ */
+typedef enum
+{
+    SOFT_AP,  /**< Act as an access point, and other station can connect, 4 stations Max*/
+    STATION   /**< Act as a station which can connect to an access point*/
+} wlanInterfaceTypedef;
+
+/**
+ *  @brief  Wi-Fi security type enumeration definition.
+ */
+enum wlan_sec_type_e
+{
+    SECURITY_TYPE_NONE,        /**< Open system. */
+    SECURITY_TYPE_WEP,         /**< Wired Equivalent Privacy. WEP security. */
+    SECURITY_TYPE_WPA_TKIP,    /**< WPA /w TKIP */
+    SECURITY_TYPE_WPA_AES,     /**< WPA /w AES */
+    SECURITY_TYPE_WPA2_TKIP,   /**< WPA2 /w TKIP */
+    SECURITY_TYPE_WPA2_AES,    /**< WPA2 /w AES */
+    SECURITY_TYPE_WPA2_MIXED,  /**< WPA2 /w AES or TKIP */
+    SECURITY_TYPE_WPA3_SAE,   /**< WPA3 SAE */
+    SECURITY_TYPE_WPA3_WPA2_MIXED, /** WPA3 SAE or WPA2 AES */
+    SECURITY_TYPE_AUTO,        /**< It is used when calling @ref bkWlanStartAdv, _BK_ read security type from scan result. */
+};
+
+typedef uint8_t wlan_sec_type_t;
+
+/**
+ *  @brief  wlan local IP information structure definition.
+ */
+typedef struct
+{
+    uint8_t dhcp;       /**< DHCP mode: @ref DHCP_Disable, @ref DHCP_Client, @ref DHCP_Server.*/
+    char    ip[16];     /**< Local IP address on the target wlan interface: @ref wlanInterfaceTypedef.*/
+    char    gate[16];   /**< Router IP address on the target wlan interface: @ref wlanInterfaceTypedef.*/
+    char    mask[16];   /**< Netmask on the target wlan interface: @ref wlanInterfaceTypedef.*/
+    char    dns[16];    /**< DNS server IP address.*/
+    char    mac[16];    /**< MAC address, example: "C89346112233".*/
+    char    broadcastip[16];
+} IPStatusTypedef;
+
+/**
+ *  @brief  Scan result using advanced scan.
+ */
+typedef  struct  _ScanResult_adv
+{
+    char ApNum;       /**< The number of access points found in scanning.*/
+    struct ApListStruct
+    {
+        char ssid[33];  /**< The SSID of an access point.*/
+        char ApPower;   /**< Signal strength, min:0, max:100*/
+        uint8_t bssid[6];   /**< The BSSID of an access point.*/
+        char channel;   /**< The RF frequency, 1-13*/
+        wlan_sec_type_t security;   /**< Security type, @ref wlan_sec_type_t*/
+    } *ApList;
+} ScanResult_adv;
+
+/**
+ *  @brief  Input network paras, used in bk_wlan_start function.
+ */
+typedef struct _network_InitTypeDef_st
+{
+    char wifi_mode;               /**< DHCP mode: @ref wlanInterfaceTypedef.*/
+    char wifi_ssid[33];           /**< SSID of the wlan needs to be connected.*/
+    char wifi_key[64];            /**< Security key of the wlan needs to be connected, ignored in an open system.*/
+    char local_ip_addr[16];       /**< Static IP configuration, Local IP address. */
+    char net_mask[16];            /**< Static IP configuration, Netmask. */
+    char gateway_ip_addr[16];     /**< Static IP configuration, Router IP address. */
+    char dns_server_ip_addr[16];   /**< Static IP configuration, DNS server IP address. */
+    char dhcp_mode;                /**< DHCP mode, @ref DHCP_Disable, @ref DHCP_Client and @ref DHCP_Server. */
+    char reserved[32];
+    int  wifi_retry_interval;     /**< Retry interval if an error is occured when connecting an access point,
+                                     time unit is millisecond. */
+} network_InitTypeDef_st;
+
+typedef struct _network_InitTypeDef_ap_st
+{
+    char wifi_ssid[32];
+    char wifi_key[64];
+    uint8_t channel;
+    wlan_sec_type_t security;
+    uint8_t ssid_hidden;
+    uint8_t max_con;
+    char local_ip_addr[16];
+    char net_mask[16];
+    char gateway_ip_addr[16];
+    char dns_server_ip_addr[16];
+    char dhcp_mode;
+    char reserved[32];
+    int  wifi_retry_interval;
+} network_InitTypeDef_ap_st;
+
+/**
+ *  @brief  Current link status in station mode.
+ */
+typedef struct _linkStatus_t
+{
+    int conn_state;       /**< The link to wlan is established or not, 0: disconnected, 1: connected. */
+    int wifi_strength;      /**< Signal strength of the current connected AP */
+    uint8_t  ssid[32];      /**< SSID of the current connected wlan */
+    uint8_t  bssid[6];      /**< BSSID of the current connected wlan */
+    int      channel;       /**< Channel of the current connected wlan */
+    wlan_sec_type_t security;
+} LinkStatusTypeDef;
+
+typedef struct
+{
+    int8_t rssi;
+}hal_wifi_link_info_t;
+
+//same with RL_BSSID_INFO_T{}
+struct wlan_fast_connect_info
+{
+    uint8_t ssid[33];
+    uint8_t bssid[6];
+    uint8_t security;
+    uint8_t channel;
+    uint8_t psk[65];
+    uint8_t pwd[65];
+};
+
+typedef void (*monitor_data_cb_t)(uint8_t *data, int len, hal_wifi_link_info_t *info);
+
+/* wpa_supplicant-2.9/wpa_supplicant/wlan_defs.h */
+typedef struct wlan_ap_sta {
+    uint8_t addr[6];
+    uint32_t ipaddr;
+    uint32_t mask;
+    uint32_t gw;
+    int8_t rssi;
+} wlan_ap_sta_t;
+
+typedef struct wlan_ap_stas {
+    wlan_ap_sta_t *sta;
+    int size;
+    int num;
+} wlan_ap_stas_t;
+
+OSStatus bk_wlan_start(network_InitTypeDef_st* inNetworkInitPara);
+int bk_wlan_start_scan(void);
+int bk_wlan_start_chan_scan(UINT8 **ssid_ary, UINT8 ssid_num, UINT8 *chans, UINT8 chan_num);
+int wlan_sta_scan_result(ScanResult_adv *results);
+OSStatus bk_wlan_start_ap_adv(network_InitTypeDef_ap_st *inNetworkInitParaAP);
+extern int bk_wlan_stop(char mode);
+OSStatus bk_wlan_get_ip_status(IPStatusTypedef *outNetpara, WiFi_Interface inInterface);
+OSStatus bk_wlan_get_link_status(LinkStatusTypeDef *outStatus);
+OSStatus bk_wlan_set_country(const wifi_country_t *country);
+int bk_wlan_start_monitor(void);
+int bk_wlan_stop_monitor(void);
+extern void bk_wlan_register_monitor_cb(monitor_data_cb_t fn);
+int bk_wlan_set_channel(int channel);
+extern int bk_wlan_get_channel(void);
+extern void bk_wlan_set_ap_monitor_coexist(int val);
+int bk_wlan_send_80211_raw_frame(uint8_t *buffer, int len);
+extern int bk_wlan_send_80211_beacon_frame(uint8_t channel, uint8_t *ssid, uint8_t ssid_len);
+uint32_t bk_wlan_reg_rx_mgmt_cb(mgmt_rx_cb_t cb, uint32_t rx_mgmt_flag);
+uint32_t bk_wlan_start_ez_of_sta(void);
+uint32_t bk_wlan_stop_ez_of_sta(void);
+void bk_wlan_phy_open_cca(void);
+void bk_wlan_phy_close_cca(void);
+extern int bk_wlan_mcu_ps_mode_enable(void);
+extern int bk_wlan_mcu_ps_mode_disable(void);
+extern int bk_wlan_dtim_rf_ps_mode_enable(void );
+int bk_wlan_dtim_rf_ps_mode_disable(void);
+extern int bk_wlan_dtim_rf_ps_timer_start(void);
+extern int bk_wlan_dtim_rf_ps_timer_pause(void);
+int wlan_ap_sta_info(wlan_ap_stas_t *stas);
+extern int wifi_set_mac_address(char *mac);
+extern void wifi_get_mac_address(char *mac, u8 type);
+
+#endif
@@ -0,0 +1,344 @@
+/**
+ * @file tkl_fs_cut_test.c
+ * @brief random file operations on tkl_fs against a model, then the same with power cuts
+ *
+ * usage: tkl_fs_cut_test [seed] [rounds]
+ *
+ * every operation is checked against a RAM model of the files. in the cut
+ * phase the power goes in a random program or erase of an operation, or of
+ * the mount after it, and every file must come back with exactly its old or
+ * its new content.
+ */
+#include "../src/tkl_fs.c"
+#include "flash_sim.h"
+
+#define TEST_FILE_NUM       8
+#define TEST_FILE_MAX       5000
+#define TEST_LIVE_MAX       40000   // bytes in all files, leaves the store room to collect
+
+#define CHECK(cond)     do {                                                        \
+                            if (!(cond)) {                                          \
+                                printf("%s:%d: %s failed, seed %u cut %u\n",        \
+                                       __FILE__, __LINE__, #cond, sg_seed, sg_cuts);\
+                                exit(1);                                            \
+                            }                                                       \
+                        } while (0)
+
+typedef struct {
+    BOOL_T exist;
+    UINT32_T len;
+    UINT8_T data[TEST_FILE_MAX + FS_BLOCK_SIZE];
+} TEST_FILE_T;
+
+enum {
+    TEST_OP_WRITE,
+    TEST_OP_APPEND,
+    TEST_OP_PATCH,
+    TEST_OP_TRUNCATE,
+    TEST_OP_REMOVE,
+    TEST_OP_NUM
+};
+
+static TEST_FILE_T sg_model[TEST_FILE_NUM];
+static TEST_FILE_T sg_old;
+static UINT8_T sg_tmp[TEST_FILE_MAX + FS_BLOCK_SIZE];
+static UINT32_T sg_seed, sg_cuts;
+
+static VOID_T __remount(VOID_T)
+{
+    UINT32_T i;
+
+    for (i = 0; i < FS_FILE_MAX; i++) {
+        free(sg_fs.node[i].blk);
+    }
+    for (i = 0; i < FS_OPEN_MAX; i++) {
+        free(sg_fs.fd[i]);
+    }
+    memset(&sg_fs, 0, sizeof(sg_fs));
+}
+
+/* the first half of the files lives in a directory */
+static VOID_T __path(UINT32_T idx, CHAR_T *path)
+{
+    sprintf(path, (idx < TEST_FILE_NUM / 2) ? "/d/f%u" : "f%u", idx);
+}
+
+/* content through the api, -1 when the file is not there */
+static INT_T __read_file(UINT32_T idx, UINT8_T *buf)
+{
+    CHAR_T path[16];
+    TUYA_FILE f;
+    INT_T n, total = 0;
+
+    __path(idx, path);
+    f = tkl_fopen(path, "r");
+    if (NULL == f) {
+        return -1;
+    }
+    while ((n = tkl_fread(buf + total, 97, f)) > 0) {
+        total += n;
+    }
+    CHECK(tkl_feof(f));
+    CHECK(total == tkl_fgetsize(path));
+    CHECK(0 == tkl_fclose(f));
+
+    return total;
+}
+
+static BOOL_T __same(CONST TEST_FILE_T *file, INT_T len, CONST UINT8_T *buf)
+{
+    if (len < 0) {
+        return !file->exist;
+    }
+
+    return file->exist && (file->len == (UINT32_T)len) && (0 == memcmp(file->data, buf, len));
+}
+
+static VOID_T __verify(VOID_T)
+{
+    UINT32_T i;
+
+    for (i = 0; i < TEST_FILE_NUM; i++) {
+        CHECK(__same(&sg_model[i], __read_file(i, sg_tmp), sg_tmp));
+    }
+}
+
+static UINT32_T __live(VOID_T)
+{
+    UINT32_T i, total = 0;
+
+    for (i = 0; i < TEST_FILE_NUM; i++) {
+        total += sg_model[i].exist ? sg_model[i].len : 0;
+    }
+
+    return total;
+}
+
+static VOID_T __fill(UINT8_T *data, UINT32_T len)
+{
+    UINT8_T b = rand();
+    UINT32_T i;
+
+    for (i = 0; i < len; i++) {
+        data[i] = (rand() % 4) ? (UINT8_T)(b + i * 7) : (UINT8_T)rand();
+    }
+}
+
+/* one random operation, the model holds the new content once it returns */
+static VOID_T __op(UINT32_T idx, UINT32_T op)
+{
+    TEST_FILE_T *m = &sg_model[idx];
+    CHAR_T path[16];
+    TUYA_FILE f;
+    UINT32_T n, off, k, chunk;
+
+    __path(idx, path);
+    switch (op) {
+        case TEST_OP_WRITE:
+            n = rand() % TEST_FILE_MAX;
+            if (__live() - m->len + n > TEST_LIVE_MAX) {
+                n = 10;
+            }
+            __fill(m->data, n);
+            m->exist = TRUE;
+            m->len = n;
+            f = tkl_fopen(path, "w");
+            CHECK(f);
+            for (k = 0; k < n; k += chunk) {
+                chunk = 1 + rand() % 700;
+                chunk = (chunk > n - k) ? (n - k) : chunk;
+                CHECK(chunk == tkl_fwrite(m->data + k, chunk, f));
+            }
+            CHECK(0 == tkl_fclose(f));
+            break;
+
+        case TEST_OP_APPEND:
+            n = rand() % 600;
+            if ((m->len + n > TEST_FILE_MAX) || (__live() + n > TEST_LIVE_MAX)) {
+                n = 0;
+            }
+            if (!m->exist) {
+                m->exist = TRUE;
+                m->len = 0;
+            }
+            __fill(m->data + m->len, n);
+            m->len += n;
+            f = tkl_fopen(path, "a");
+            CHECK(f);
+            CHECK((0 == n) || (n == tkl_fwrite(m->data + m->len - n, n, f)));
+            CHECK(0 == tkl_fclose(f));
+            break;
+
+        case TEST_OP_PATCH:
+            // overwrite in place, possibly past the end leaving a hole
+            off = rand() % (m->len + 300);
+            n = 1 + rand() % 400;
+            if (!m->exist || (off + n > TEST_FILE_MAX) || (__live() + 700 > TEST_LIVE_MAX)) {
+                break;
+            }
+            if (off > m->len) {
+                memset(m->data + m->len, 0, off - m->len);
+            }
+            __fill(m->data + off, n);
+            m->len = (off + n > m->len) ? (off + n) : m->len;
+            f = tkl_fopen(path, "r+");
+            CHECK(f);
+            CHECK(0 == tkl_fseek(f, off, TUYA_SEEK_SET));
+            CHECK(n == tkl_fwrite(m->data + off, n, f));
+            CHECK(off + n == tkl_ftell(f));
+            CHECK(0 == tkl_fclose(f));
+            break;
+
+        case TEST_OP_TRUNCATE:
+            if (!m->exist) {
+                break;
+            }
+            n = rand() % (m->len + 300);
+            n = (n > TEST_FILE_MAX) ? TEST_FILE_MAX : n;
+            if (n > m->len) {
+                memset(m->data + m->len, 0, n - m->len);
+            }
+            m->len = n;
+            f = tkl_fopen(path, "r+");
+            CHECK(f);
+            CHECK(0 == tkl_ftruncate(tkl_fileno(f), n));
+            CHECK(0 == tkl_fclose(f));
+            break;
+
+        default:
+            if (!m->exist) {
+                break;
+            }
+            m->exist = FALSE;
+            m->len = 0;
+            CHECK(0 == tkl_fs_remove(path));
+            break;
+    }
+}
+
+static VOID_T __rename(UINT32_T from, UINT32_T to)
+{
+    CHAR_T path_from[16], path_to[16];
+
+    __path(from, path_from);
+    __path(to, path_to);
+    CHECK(0 == tkl_fs_rename(path_from, path_to));
+    sg_model[to] = sg_model[from];
+    sg_model[from].exist = FALSE;
+    sg_model[from].len = 0;
+}
+
+static VOID_T __test_plain(UINT32_T rounds)
+{
+    TUYA_DIR d;
+    TUYA_FILEINFO info;
+    BOOL_T exist;
+    UINT32_T i, j, min = ~0u, max = 0, tomb = 0;
+    INT_T cnt = 0;
+
+    CHECK(0 == tkl_fs_mkdir("/d"));
+    CHECK(0 != tkl_fs_mkdir("/d"));
+    CHECK((0 == tkl_fs_is_exist("/d/", &exist)) && exist);
+
+    for (i = 0; i < rounds; i++) {
+        j = rand() % TEST_FILE_NUM;
+        if ((0 == rand() % 10) && sg_model[j].exist && (j != i % TEST_FILE_NUM)) {
+            __rename(j, i % TEST_FILE_NUM);
+        } else {
+            __op(j, rand() % TEST_OP_NUM);
+        }
+        if (rand() % 3 == 0) {
+            flash_sim_run_gc();
+        }
+        if (rand() % 50 == 0) {
+            __remount();
+        }
+        if (i % 100 == 0) {
+            __verify();
+        }
+        if (__fs_tomb_count() > tomb) {
+            tomb = __fs_tomb_count();
+        }
+    }
+    __verify();
+
+    // the root lists the directory and the files outside it
+    CHECK(0 == tkl_dir_open("/", &d));
+    while (0 == tkl_dir_read(d, &info)) {
+        cnt++;
+    }
+    CHECK(0 == tkl_dir_close(d));
+    for (i = TEST_FILE_NUM / 2; i < TEST_FILE_NUM; i++) {
+        cnt -= sg_model[i].exist;
+    }
+    CHECK(1 == cnt);
+
+    for (i = 0; i < FLASH_SIM_SECTOR_NUM; i++) {
+        min = (flash_sim_erase_cnt(i) < min) ? flash_sim_erase_cnt(i) : min;
+        max = (flash_sim_erase_cnt(i) > max) ? flash_sim_erase_cnt(i) : max;
+    }
+    printf("plain: %u ops, %u flash ops, erase count %u..%u, %u tombstones at most\n",
+           rounds, flash_sim_ops(), min, max, tomb);
+    CHECK(max - min <= 2 * FS_WEAR_DELTA);
+}
+
+static VOID_T __test_cut(UINT32_T rounds)
+{
+    BOOL_T exist;
+    UINT32_T i, idx;
+    INT_T len;
+
+    for (i = 0; i < rounds; i++) {
+        idx = rand() % TEST_FILE_NUM;
+        sg_old = sg_model[idx];
+
+        flash_sim_cut_after(rand() % 12);
+        if (!setjmp(flash_sim_cut_jmp)) {
+            __op(idx, rand() % TEST_OP_NUM);
+            flash_sim_cut_after(-1);
+            flash_sim_run_gc();
+            __verify();
+            continue;
+        }
+        sg_cuts++;
+        flash_sim_cut_after(-1);
+        __remount();
+
+        // the mount may write too, a cut there is one more to survive
+        if (0 == rand() % 4) {
+            flash_sim_cut_after(rand() % 3);
+            if (!setjmp(flash_sim_cut_jmp)) {
+                tkl_fs_is_exist("/", &exist);
+            }
+            flash_sim_cut_after(-1);
+            __remount();
+        }
+
+        // a file created by the cut operation may be left empty
+        len = __read_file(idx, sg_tmp);
+        CHECK(__same(&sg_old, len, sg_tmp) || __same(&sg_model[idx], len, sg_tmp) || (!sg_old.exist && (0 == len)));
+        sg_model[idx].exist = (len >= 0);
+        sg_model[idx].len = (len > 0) ? len : 0;
+        memcpy(sg_model[idx].data, sg_tmp, sg_model[idx].len);
+        __verify();
+    }
+    printf("cut: %u ops, %u power cuts\n", rounds, sg_cuts);
+}
+
+int main(int argc, char *argv[])
+{
+    UINT32_T rounds;
+
+    sg_seed = (argc > 1) ? atoi(argv[1]) : 1;
+    rounds = (argc > 2) ? atoi(argv[2]) : 3000;
+    srand(sg_seed);
+
+    flash_sim_init();
+    __remount();
+    __test_plain(rounds);
+    __test_cut(rounds);
+
+    printf("tkl_fs_cut_test: seed %u ok\n", sg_seed);
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+/**
+ * @file tkl_fs_test.c
+ * @brief host test of the tkl_fs api and of the mount on a blank, foreign or torn partition
+ */
+#include "../src/tkl_fs.c"
+#include "flash_sim.h"
+
+#define CHECK(cond)     do {                                                        \
+                            if (!(cond)) {                                          \
+                                printf("%s:%d: %s failed\n", __FILE__, __LINE__, #cond); \
+                                exit(1);                                            \
+                            }                                                       \
+                        } while (0)
+
+/* forget everything in RAM, the next call mounts again */
+static VOID_T __remount(VOID_T)
+{
+    UINT32_T i;
+
+    for (i = 0; i < FS_FILE_MAX; i++) {
+        free(sg_fs.node[i].blk);
+    }
+    for (i = 0; i < FS_OPEN_MAX; i++) {
+        free(sg_fs.fd[i]);
+    }
+    memset(&sg_fs, 0, sizeof(sg_fs));
+}
+
+static VOID_T __test_api(VOID_T)
+{
+    CHAR_T buf[64];
+    UINT_T mode;
+    TUYA_FILE f, g;
+    BOOL_T exist, dir, reg;
+    TUYA_DIR d;
+    TUYA_FILEINFO info;
+    CONST CHAR_T *name;
+    INT_T n = 0;
+
+    flash_sim_init();
+    __remount();
+
+    CHECK(NULL == tkl_fopen("/cfg/a.txt", "w"));
+    CHECK(0 == tkl_fs_mkdir("cfg"));
+    CHECK(0 != tkl_fs_mkdir("/cfg/"));
+
+    f = tkl_fopen("/cfg/a.txt", "w+");
+    CHECK(f);
+    CHECK(11 == tkl_fwrite("line1\nline2", 11, f));
+    CHECK(0 == tkl_fseek(f, 0, TUYA_SEEK_SET));
+    CHECK(tkl_fgets(buf, sizeof(buf), f) && (0 == strcmp(buf, "line1\n")));
+    CHECK(tkl_fgets(buf, sizeof(buf), f) && (0 == strcmp(buf, "line2")));
+    CHECK((NULL == tkl_fgets(buf, sizeof(buf), f)) && tkl_feof(f));
+    CHECK((0 == tkl_fseek(f, -2, TUYA_SEEK_END)) && (9 == tkl_ftell(f)) && ('e' == tkl_fgetc(f)));
+    CHECK(0 != tkl_fseek(f, -20, TUYA_SEEK_CUR));
+    CHECK(0 == tkl_fsync(tkl_fileno(f)));
+
+    g = tkl_fopen("cfg/a.txt", "r");
+    CHECK(g);
+    CHECK(11 == tkl_fread(buf, sizeof(buf), g));
+    CHECK(0 != tkl_fs_remove("cfg/a.txt"));
+    CHECK(0 != tkl_fs_remove("cfg"));
+    CHECK((0 == tkl_fclose(g)) && (0 == tkl_fclose(f)));
+
+    CHECK((0 == tkl_fs_mode("/cfg", &mode)) && (mode & FS_MODE_DIR));
+    CHECK((0 == tkl_fs_mode("/cfg/a.txt", &mode)) && (mode & FS_MODE_REG));
+    CHECK((0 == tkl_faccess("/cfg/a.txt", TUYA_R_OK)) && (0 != tkl_faccess("/cfg/b", TUYA_R_OK)));
+    CHECK(0 == tkl_fs_rename("/cfg/a.txt", "/b.txt"));
+    CHECK((0 == tkl_fs_is_exist("/cfg/a.txt", &exist)) && !exist);
+    CHECK(11 == tkl_fgetsize("/b.txt"));
+
+    CHECK(0 == tkl_dir_open("/", &d));
+    while (0 == tkl_dir_read(d, &info)) {
+        CHECK(0 == tkl_dir_name(info, &name));
+        CHECK((0 == tkl_dir_is_directory(info, &dir)) && (0 == tkl_dir_is_regular(info, &reg)));
+        CHECK(dir == (0 == strcmp(name, "cfg")) && (reg == !dir));
+        n++;
+    }
+    CHECK(0 == tkl_dir_close(d));
+    CHECK(2 == n);
+    CHECK(0 == tkl_fs_remove("cfg"));
+
+    f = tkl_fopen("/b.txt", "a");
+    CHECK(f);
+    CHECK(2 == tkl_fwrite("!!", 2, f));
+    CHECK(0 == tkl_fclose(f));
+    CHECK(13 == tkl_fgetsize("/b.txt"));
+
+    __remount();
+    CHECK(13 == tkl_fgetsize("/b.txt"));
+    f = tkl_fopen("/b.txt", "r");
+    CHECK(f);
+    CHECK((13 == tkl_fread(buf, sizeof(buf), f)) && (0 == memcmp(buf, "line1\nline2!!", 13)));
+    CHECK(0 == tkl_fclose(f));
+}
+
+static VOID_T __test_mount(VOID_T)
+{
+    UINT8_T *mem = flash_sim_mem();
+    UINT8_T old[FLASH_SIM_SECTOR];
+    BOOL_T exist;
+    UINT32_T i;
+
+    // foreign data in the partition is left alone, however little of it there is
+    flash_sim_init();
+    __remount();
+    mem[FLASH_SIM_SIZE - 1] = 0x5a;
+    CHECK(0 != tkl_fs_is_exist("/", &exist));
+    CHECK(0 != tkl_fs_mkdir("d"));
+    CHECK(0x5a == mem[FLASH_SIM_SIZE - 1]);
+    CHECK(0 == flash_sim_ops());
+
+    flash_sim_init();
+    __remount();
+    memcpy(mem, "not a file store", 16);
+    memcpy(old, mem, sizeof(old));
+    CHECK(0 != tkl_fs_mkdir("d"));
+    CHECK(0 == memcmp(old, mem, sizeof(old)));
+    CHECK(0 == flash_sim_ops());
+
+    // a blank partition gets a header in every sector, no erase
+    flash_sim_init();
+    __remount();
+    CHECK(0 == tkl_fs_mkdir("d"));
+    for (i = 0; i < FLASH_SIM_SECTOR_NUM; i++) {
+        CHECK(0 == flash_sim_erase_cnt(i));
+    }
+
+    // a cut in the first header, the next mount still takes the partition
+    for (i = 0; i < 16; i++) {
+        flash_sim_init();
+        __remount();
+        flash_sim_cut_after(0);
+        if (!setjmp(flash_sim_cut_jmp)) {
+            tkl_fs_is_exist("/", &exist);
+            CHECK(0);
+        }
+        flash_sim_cut_after(-1);
+        __remount();
+        CHECK(0 == tkl_fs_mkdir("d"));
+        __remount();
+        CHECK((0 == tkl_fs_is_exist("d", &exist)) && exist);
+    }
+
+    // with the store in place a sector of garbage is a cut erase and is taken back
+    memset(&mem[3 * FLASH_SIM_SECTOR], 0x00, FLASH_SIM_SECTOR);
+    __remount();
+    CHECK((0 == tkl_fs_is_exist("d", &exist)) && exist);
+    CHECK((1 == flash_sim_erase_cnt(3)) && (FS_SECTOR_MAGIC == *(UINT32_T *)&mem[3 * FLASH_SIM_SECTOR]));
+}
+
+int main(int argc, char *argv[])
+{
+    __test_api();
+    __test_mount();
+
+    printf("tkl_fs_test: ok\n");
+
+    return 0;
+}
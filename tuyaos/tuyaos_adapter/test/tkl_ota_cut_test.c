@@ -0,0 +1,252 @@
+/**
+ * @file tkl_ota_cut_test.c
+ * @brief power cuts during an ota download, then the resume from the progress journal
+ *
+ * usage: tkl_ota_cut_test [seed] [rounds]
+ *
+ * the power goes in a program or an erase of the image, of the journal or of
+ * the head at the end. after the reboot the peer asks for the resume point,
+ * checks its crc32 against the package and sends the rest from there, the
+ * image that ends up in flash must be byte exact. a download that is not the
+ * recorded one must not resume.
+ */
+#include "../src/tkl_ota.c"
+
+#define CHECK(cond)     do {                                                        \
+                            if (!(cond)) {                                          \
+                                printf("%s:%d: %s failed, seed %u cut %u\n",        \
+                                       __FILE__, __LINE__, #cond, sg_seed, sg_cuts);\
+                                exit(1);                                            \
+                            }                                                       \
+                        } while (0)
+
+#define TEST_CUTS_MAX       5       // power cuts in one download
+
+static UINT32_T sg_seed, sg_cuts;
+
+#include "ota_feed.h"
+
+enum {
+    CUT_IMAGE_WRITE,
+    CUT_IMAGE_ERASE,
+    CUT_JOURNAL_WRITE,
+    CUT_JOURNAL_ERASE,
+    CUT_KIND_NUM
+};
+
+static UINT8_T sg_image[OTA_IMAGE_MAX_SIZE];
+static UINT8_T sg_pkg[TEST_PKG_MAX];
+static UINT8_T sg_other[TEST_PKG_MAX];
+static UINT32_T sg_kind[CUT_KIND_NUM];
+static UINT32_T sg_resumes;
+
+/* ram is gone, the flash stays as the cut left it */
+static VOID_T __reboot(VOID_T)
+{
+    flash_sim_cut_after(-1);
+    if (ug_proc) {
+        free(ug_proc->window);
+        free(ug_proc);
+        ug_proc = NULL;
+    }
+    memset(&ota_resume_info, 0, sizeof(ota_resume_info));
+    sg_protect = TRUE;
+}
+
+/* the journal point a reboot after this cut must offer */
+static VOID_T __check_cut(UINT32_T offset)
+{
+    BOOL_T erase;
+    UINT32_T addr = flash_sim_cut_addr(&erase);
+    UINT32_T durable = ug_proc ? ug_proc->jnl.offset : 0;
+
+    sg_cuts++;
+    if (addr < OTA_JOURNAL_ADDR) {
+        sg_kind[erase ? CUT_IMAGE_ERASE : CUT_IMAGE_WRITE]++;
+        CHECK(offset == durable);
+    } else if (erase) {
+        // the other sector holds the newest record
+        sg_kind[CUT_JOURNAL_ERASE]++;
+        CHECK(offset == durable);
+    } else {
+        // the record being written may or may not have made it, the crc32 tells
+        sg_kind[CUT_JOURNAL_WRITE]++;
+    }
+}
+
+/*
+ * what the peer does after a reboot: ask for the resume point and send the rest
+ * of the package from there when its crc32 matches, from the start otherwise
+ */
+static OPERATE_RET __download(CONST UINT8_T *pkg, UINT32_T len, UINT32_T *from)
+{
+    TUYA_OTA_FIRMWARE_INFO_T *info = NULL;
+
+    CHECK((OPRT_OK == tkl_ota_get_old_firmware_info(&info)) && info);
+    *from = 0;
+    if (info->len) {
+        CHECK(info->len < len);
+        CHECK(0 == (info->len - TEST_HDR_LEN) % (OTA_JOURNAL_INTERVAL * OTA_SECTOR_SIZE));
+        if (info->crc32 == __ota_crc32(0, pkg, info->len)) {
+            *from = info->len;
+        }
+    }
+
+    CHECK(OPRT_OK == tkl_ota_start_notify(len, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+    CHECK(OPRT_OK == __feed(pkg, len, *from, TEST_PACKET_MAX));
+
+    return tkl_ota_end_notify(FALSE);
+}
+
+/* a download of the image with up to cuts power cuts, the one after cut_at ops first */
+static VOID_T __run(UINT32_T len, UINT32_T pkg_len, INT_T cut_at, UINT32_T cuts_max)
+{
+    TUYA_OTA_FIRMWARE_INFO_T *info = NULL;
+    volatile UINT32_T cuts = cuts_max;
+    UINT32_T from;
+
+    flash_sim_cut_after(cut_at);
+    while (setjmp(flash_sim_cut_jmp)) {
+        // what the journal offers now must be what the flash holds for sure
+        CHECK((OPRT_OK == tkl_ota_get_old_firmware_info(&info)) && info);
+        __check_cut(info->len ? info->len - TEST_HDR_LEN : 0);
+        if (info->len) {
+            CHECK(info->crc32 == __ota_crc32(0, sg_pkg, info->len));
+        }
+        __reboot();
+        if (--cuts) {
+            flash_sim_cut_after(rand() % 400);
+        }
+    }
+
+    CHECK(OPRT_OK == __download(sg_pkg, pkg_len, &from));
+    flash_sim_cut_after(-1);
+    sg_resumes += (from != 0);
+    CHECK(0 == memcmp(__flash(UG_START_ADDR), sg_image, len));
+    CHECK(sg_protect && (NULL == ug_proc));
+}
+
+/* a cut in every flash operation of one download in turn */
+static VOID_T __test_every_cut(VOID_T)
+{
+    UINT32_T len = (OTA_JOURNAL_INTERVAL * 5 + 2) * OTA_SECTOR_SIZE + 123, pkg_len, ops;
+    INT_T k;
+
+    __image_rand(sg_image, len);
+    pkg_len = __pkg_raw(sg_image, len, sg_pkg);
+
+    flash_sim_init();
+    __run(len, pkg_len, -1, 0);
+    ops = flash_sim_ops();
+
+    for (k = 0; k < ops; k++) {
+        flash_sim_init();
+        __run(len, pkg_len, k, 1);
+    }
+
+    // and over the image and the journal a former download left behind
+    for (k = 0; k < ops; k += 3) {
+        __image_rand(__flash(UG_START_ADDR), OTA_JOURNAL_ADDR - UG_START_ADDR);
+        __run(len, pkg_len, k, 1);
+    }
+
+    CHECK(sg_kind[CUT_IMAGE_WRITE] && sg_kind[CUT_IMAGE_ERASE]);
+    CHECK(sg_kind[CUT_JOURNAL_WRITE] && sg_kind[CUT_JOURNAL_ERASE]);
+    CHECK(sg_resumes > ops / 2);
+    printf("%u ops, cuts: image %u/%u journal %u/%u (write/erase), %u resumed\n", ops,
+           sg_kind[CUT_IMAGE_WRITE], sg_kind[CUT_IMAGE_ERASE],
+           sg_kind[CUT_JOURNAL_WRITE], sg_kind[CUT_JOURNAL_ERASE], sg_resumes);
+}
+
+/* random images with several cuts each */
+static VOID_T __test_random(UINT32_T rounds)
+{
+    UINT32_T r, len, pkg_len;
+
+    flash_sim_init();
+    for (r = 0; r < rounds; r++) {
+        len = 1 + rand() % (200 * 1024);
+        __image_rand(sg_image, len);
+        pkg_len = __pkg_raw(sg_image, len, sg_pkg);
+        __run(len, pkg_len, rand() % 400, 1 + rand() % TEST_CUTS_MAX);
+    }
+}
+
+/* leave a journal behind at a point past the first record, returns the point */
+static UINT32_T __cut_midway(UINT32_T pkg_len)
+{
+    TUYA_OTA_FIRMWARE_INFO_T *info = NULL;
+
+    flash_sim_init();
+    CHECK(OPRT_OK == tkl_ota_start_notify(pkg_len, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+    CHECK(OPRT_OK == __feed(sg_pkg, pkg_len / 2, 0, TEST_PACKET_MAX));
+    __reboot();
+
+    CHECK((OPRT_OK == tkl_ota_get_old_firmware_info(&info)) && info->len);
+    CHECK(info->crc32 == __ota_crc32(0, sg_pkg, info->len));
+    return info->len;
+}
+
+/* only the recorded download resumes, anything else is sent from the start again */
+static VOID_T __test_mismatch(VOID_T)
+{
+    UINT32_T len = 100 * 1024, pkg_len, point, from;
+    TUYA_OTA_FIRMWARE_INFO_T *info = NULL;
+
+    __image_rand(sg_image, len);
+    pkg_len = __pkg_raw(sg_image, len, sg_pkg);
+
+    // the peer never asked for the resume point
+    point = __cut_midway(pkg_len);
+    memset(&ota_resume_info, 0, sizeof(ota_resume_info));
+    CHECK(OPRT_OK == tkl_ota_start_notify(pkg_len, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+    CHECK(OPRT_OS_ADAPTER_OTA_START_INFORM_FAILED == __feed(sg_pkg, pkg_len, point, TEST_PACKET_MAX));
+    CHECK(OPRT_OS_ADAPTER_OTA_END_INFORM_FAILED == tkl_ota_end_notify(FALSE));
+
+    // a package of another size
+    point = __cut_midway(pkg_len);
+    tkl_ota_get_old_firmware_info(&info);
+    CHECK(OPRT_OK == tkl_ota_start_notify(pkg_len + 1, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+    CHECK(OPRT_OS_ADAPTER_OTA_START_INFORM_FAILED == __feed(sg_pkg, pkg_len, point, TEST_PACKET_MAX));
+    CHECK(OPRT_OS_ADAPTER_OTA_END_INFORM_FAILED == tkl_ota_end_notify(FALSE));
+    CHECK(OPRT_OK == tkl_ota_start_notify(pkg_len, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+    memcpy(sg_other, sg_pkg, pkg_len);
+    CHECK(OPRT_OS_ADAPTER_OTA_START_INFORM_FAILED == __feed(sg_other, pkg_len + 1, point, TEST_PACKET_MAX));
+    CHECK(OPRT_OS_ADAPTER_OTA_END_INFORM_FAILED == tkl_ota_end_notify(FALSE));
+
+    // another package of the same size took over the journal after the peer asked
+    point = __cut_midway(pkg_len);
+    tkl_ota_get_old_firmware_info(&info);
+    memcpy(sg_other, sg_pkg, pkg_len);
+    sg_other[TEST_HDR_LEN + 1000] ^= 1;
+    sg_other[TEST_HDR_LEN + 1001] ^= 1;
+    CHECK(OPRT_OK == tkl_ota_start_notify(pkg_len, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+    CHECK(OPRT_OK == __feed(sg_other, pkg_len / 2, 0, TEST_PACKET_MAX));
+    CHECK(OPRT_OK == tkl_ota_start_notify(pkg_len, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+    CHECK((point == TEST_HDR_LEN + ug_proc->jnl.offset) && (info->crc32 != ug_proc->jnl.pkg_crc));
+    CHECK(OPRT_OS_ADAPTER_OTA_START_INFORM_FAILED == __feed(sg_pkg, pkg_len, point, TEST_PACKET_MAX));
+    CHECK(OPRT_OS_ADAPTER_OTA_END_INFORM_FAILED == tkl_ota_end_notify(FALSE));
+
+    // a peer that checks the crc32 starts over, and that goes through
+    CHECK(OPRT_OK == __download(sg_pkg, pkg_len, &from));
+    CHECK(0 == from);
+    CHECK(0 == memcmp(__flash(UG_START_ADDR), sg_image, len));
+
+    // the recorded one resumes
+    point = __cut_midway(pkg_len);
+    CHECK((OPRT_OK == __download(sg_pkg, pkg_len, &from)) && (point == from));
+    CHECK(0 == memcmp(__flash(UG_START_ADDR), sg_image, len));
+}
+
+int main(int argc, char *argv[])
+{
+    sg_seed = (argc > 1) ? atoi(argv[1]) : 1;
+    srand(sg_seed);
+
+    __test_every_cut();
+    __test_random((argc > 2) ? atoi(argv[2]) : 100);
+    __test_mismatch();
+
+    printf("tkl_ota_cut_test: seed %u ok\n", sg_seed);
+    return 0;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file tkl_ota_pack_test.c
+ * @brief a package built by ota_pack.py through tkl_ota, run by ota_pack_test.py
+ *
+ * usage: tkl_ota_pack_test package image [base]
+ *
+ * the base is planted in the app partition, the package is fed in packets of
+ * a few bytes up to a few kilobytes and the image in flash must come out byte
+ * exact. a diff must be refused once a byte of its base changes.
+ */
+#include "../src/tkl_ota.c"
+
+#define CHECK(cond)     do {                                                        \
+                            if (!(cond)) {                                          \
+                                printf("%s:%d: %s failed, %s\n",                    \
+                                       __FILE__, __LINE__, #cond, sg_name);         \
+                                exit(1);                                            \
+                            }                                                       \
+                        } while (0)
+
+static CONST CHAR_T *sg_name;
+
+#include "ota_feed.h"
+
+static UINT8_T sg_image[OTA_IMAGE_MAX_SIZE];
+static UINT8_T sg_pkg[TEST_PKG_MAX];
+static UINT8_T sg_base[OTA_DIFF_BASE_SIZE];
+
+static UINT32_T __load(CONST CHAR_T *path, UINT8_T *buf, UINT32_T max)
+{
+    FILE *f = fopen(path, "rb");
+    size_t n;
+
+    CHECK(f);
+    n = fread(buf, 1, max, f);
+    CHECK(EOF == fgetc(f));
+    fclose(f);
+
+    return n;
+}
+
+static OPERATE_RET __download(UINT32_T pkg_len, UINT32_T max)
+{
+    OPERATE_RET ret;
+
+    CHECK(OPRT_OK == tkl_ota_start_notify(pkg_len, TUYA_OTA_DIFF, TUYA_OTA_PATH_AIR));
+    ret = __feed(sg_pkg, pkg_len, 0, max);
+    if (OPRT_OK != ret) {
+        tkl_ota_end_notify(FALSE);
+        return ret;
+    }
+
+    return tkl_ota_end_notify(FALSE);
+}
+
+int main(int argc, char *argv[])
+{
+    static CONST UINT32_T max[] = { 1, 5, 64, 1500, TEST_PACKET_MAX };
+    UINT32_T i, pkg_len, len, base_len = 0;
+
+    if (argc < 3) {
+        printf("usage: %s package image [base]\n", argv[0]);
+        return 2;
+    }
+    sg_name = argv[1];
+    srand(1);
+
+    pkg_len = __load(argv[1], sg_pkg, sizeof(sg_pkg));
+    len = __load(argv[2], sg_image, sizeof(sg_image));
+    if (argc > 3) {
+        base_len = __load(argv[3], sg_base, sizeof(sg_base));
+    }
+
+    for (i = 0; i < sizeof(max) / sizeof(max[0]); i++) {
+        flash_sim_init();
+        memcpy(__flash(OTA_DIFF_BASE_ADDR), sg_base, base_len);
+        CHECK(OPRT_OK == __download(pkg_len, max[i]));
+        CHECK(0 == memcmp(__flash(UG_START_ADDR), sg_image, len));
+        CHECK(sg_protect && (NULL == ug_proc));
+    }
+
+    // the running firmware is not the one the diff was made against
+    if (base_len) {
+        flash_sim_init();
+        memcpy(__flash(OTA_DIFF_BASE_ADDR), sg_base, base_len);
+        *__flash(OTA_DIFF_BASE_ADDR + base_len / 2) ^= 0x01;
+        CHECK(OPRT_OS_ADAPTER_OTA_START_INFORM_FAILED == __download(pkg_len, TEST_PACKET_MAX));
+        CHECK(__erased(UG_START_ADDR, OTA_SECTOR_SIZE));
+    }
+
+    // the package ends early
+    flash_sim_init();
+    memcpy(__flash(OTA_DIFF_BASE_ADDR), sg_base, base_len);
+    CHECK(OPRT_OS_ADAPTER_OTA_END_INFORM_FAILED == __download(pkg_len - 1, TEST_PACKET_MAX));
+    CHECK(__erased(UG_START_ADDR, (len < RT_IMG_WR_UNIT) ? len : RT_IMG_WR_UNIT));
+
+    printf("%s: package %u bytes, image %u bytes ok\n", strrchr(sg_name, '/') ? strrchr(sg_name, '/') + 1 : sg_name, pkg_len, len);
+    return 0;
+}
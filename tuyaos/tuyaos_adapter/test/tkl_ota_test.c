@@ -0,0 +1,150 @@
+/**
+ * @file tkl_ota_test.c
+ * @brief host test of the tkl_ota image writer on the flash simulator
+ *
+ * usage: tkl_ota_test [seed]
+ *
+ * packages go through tkl_ota_data_process as ota_feed.h sends them, the
+ * simulator covers the app partition and the ota area.
+ */
+#include "../src/tkl_ota.c"
+
+#define CHECK(cond)     do {                                                        \
+                            if (!(cond)) {                                          \
+                                printf("%s:%d: %s failed, seed %u\n",               \
+                                       __FILE__, __LINE__, #cond, sg_seed);         \
+                                exit(1);                                            \
+                            }                                                       \
+                        } while (0)
+
+static UINT32_T sg_seed;
+
+#include "ota_feed.h"
+
+static UINT8_T sg_image[OTA_IMAGE_MAX_SIZE];
+static UINT8_T sg_pkg[TEST_PKG_MAX];
+
+/* only the sectors the image covers are erased, each once */
+static VOID_T __check_erase(UINT32_T len)
+{
+    UINT32_T addr, cnt, end = UG_START_ADDR + (len + OTA_SECTOR_SIZE - 1) / OTA_SECTOR_SIZE * OTA_SECTOR_SIZE;
+
+    for (addr = FLASH_SIM_BASE; addr < OTA_JOURNAL_ADDR; addr += OTA_SECTOR_SIZE) {
+        cnt = flash_sim_erase_cnt((addr - FLASH_SIM_BASE) / FLASH_SIM_SECTOR);
+        CHECK(cnt == ((addr >= UG_START_ADDR) && (addr < end)));
+    }
+}
+
+static VOID_T __test_stream(VOID_T)
+{
+    static CONST UINT32_T lens[] = {
+        1, 100, RT_IMG_WR_UNIT - 1, RT_IMG_WR_UNIT, RT_IMG_WR_UNIT + 1, OTA_PAGE_SIZE * 3 + 7,
+        OTA_SECTOR_SIZE, OTA_SECTOR_SIZE + 1, 40001, 123457, OTA_IMAGE_MAX_SIZE - 1
+    };
+    UINT32_T i, len, pkg_len, head;
+    UINT_T size;
+    TUYA_OTA_TYPE_E type;
+
+    CHECK((OPRT_OK == tkl_ota_get_ability(&size, &type)) && (OTA_IMAGE_MAX_SIZE == size));
+    CHECK(TUYA_OTA_DIFF == type);
+
+    for (i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        len = lens[i];
+        head = (len < RT_IMG_WR_UNIT) ? len : RT_IMG_WR_UNIT;
+        flash_sim_init();
+        __image_rand(sg_image, len);
+        pkg_len = __pkg_raw(sg_image, len, sg_pkg);
+
+        CHECK(OPRT_OK == tkl_ota_start_notify(pkg_len, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+        CHECK(sg_protect);
+        CHECK(OPRT_OK == __feed(sg_pkg, pkg_len, 0, (i & 1) ? 7 : TEST_PACKET_MAX));
+        CHECK(!sg_protect);
+
+        // everything but the head is in flash, the head waits for the check
+        CHECK(0 == memcmp(__flash(UG_START_ADDR + head), &sg_image[head], len - head));
+        CHECK(__erased(UG_START_ADDR, head));
+
+        CHECK(OPRT_OK == tkl_ota_end_notify(FALSE));
+        CHECK(0 == memcmp(__flash(UG_START_ADDR), sg_image, len));
+        CHECK(sg_protect && (NULL == ug_proc) && (0 == sg_resets));
+        __check_erase(len);
+    }
+
+    // bytes after the image are dropped, reset on request
+    flash_sim_init();
+    len = 5000;
+    pkg_len = __pkg_raw(sg_image, len, sg_pkg);
+    memset(&sg_pkg[pkg_len], 0x5a, OTA_PAGE_SIZE);
+    CHECK(OPRT_OK == tkl_ota_start_notify(pkg_len, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+    CHECK(OPRT_OK == __feed(sg_pkg, pkg_len + OTA_PAGE_SIZE, 0, TEST_PACKET_MAX));
+    CHECK((OPRT_OK == tkl_ota_end_notify(TRUE)) && (1 == sg_resets));
+    CHECK(0 == memcmp(__flash(UG_START_ADDR), sg_image, len));
+    CHECK(__erased(UG_START_ADDR + len, OTA_SECTOR_SIZE * 2 - len));
+    sg_resets = 0;
+}
+
+static VOID_T __test_reject(VOID_T)
+{
+    UINT32_T len = 20000, pkg_len;
+    TUYA_OTA_DATA_T pack = {0};
+    UINT_T remain;
+
+    CHECK(OPRT_OS_ADAPTER_INVALID_PARM == tkl_ota_end_notify(FALSE));
+    CHECK(OPRT_COM_ERROR == tkl_ota_data_process(&pack, &remain));
+    CHECK(OPRT_OS_ADAPTER_INVALID_PARM == tkl_ota_start_notify(0, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+
+    flash_sim_init();
+    __image_rand(sg_image, len);
+    pkg_len = __pkg_raw(sg_image, len, sg_pkg);
+
+    // a broken header
+    sg_pkg[3] ^= 1;
+    CHECK(OPRT_OK == tkl_ota_start_notify(pkg_len, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+    CHECK(OPRT_OS_ADAPTER_OTA_START_INFORM_FAILED == __feed(sg_pkg, pkg_len, 0, TEST_PACKET_MAX));
+    sg_pkg[3] ^= 1;
+    sg_pkg[25] ^= 1;
+    CHECK(OPRT_OK == tkl_ota_start_notify(pkg_len, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+    CHECK(OPRT_OS_ADAPTER_OTA_START_INFORM_FAILED == __feed(sg_pkg, pkg_len, 0, TEST_PACKET_MAX));
+    sg_pkg[25] ^= 1;
+    CHECK(OPRT_OS_ADAPTER_OTA_END_INFORM_FAILED == tkl_ota_end_notify(FALSE));
+    CHECK(sg_protect && (0 == flash_sim_ops()));
+
+    // an image too large for the area
+    __pkg_raw(sg_image, OTA_IMAGE_MAX_SIZE, sg_pkg);
+    CHECK(OPRT_OK == tkl_ota_start_notify(TEST_PKG_MAX, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+    CHECK(OPRT_OS_ADAPTER_OTA_PKT_SIZE_FAILED == __feed(sg_pkg, TEST_HDR_LEN, 0, TEST_PACKET_MAX));
+    CHECK(OPRT_OS_ADAPTER_OTA_END_INFORM_FAILED == tkl_ota_end_notify(FALSE));
+
+    // one byte off, the sum does not match and the head is never written
+    pkg_len = __pkg_raw(sg_image, len, sg_pkg);
+    sg_pkg[TEST_HDR_LEN + len - 2] ^= 0x10;
+    CHECK(OPRT_OK == tkl_ota_start_notify(pkg_len, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+    CHECK(OPRT_OK == __feed(sg_pkg, pkg_len, 0, TEST_PACKET_MAX));
+    CHECK(OPRT_OS_ADAPTER_OTA_END_INFORM_FAILED == tkl_ota_end_notify(FALSE));
+    CHECK(__erased(UG_START_ADDR, RT_IMG_WR_UNIT) && sg_protect && (NULL == ug_proc));
+
+    // the image ends early
+    pkg_len = __pkg_raw(sg_image, len, sg_pkg);
+    CHECK(OPRT_OK == tkl_ota_start_notify(pkg_len, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+    CHECK(OPRT_OK == __feed(sg_pkg, pkg_len - OTA_PAGE_SIZE, 0, TEST_PACKET_MAX));
+    CHECK(OPRT_OS_ADAPTER_OTA_END_INFORM_FAILED == tkl_ota_end_notify(FALSE));
+    CHECK(__erased(UG_START_ADDR, RT_IMG_WR_UNIT) && sg_protect);
+
+    // a good one still goes through after all that
+    CHECK(OPRT_OK == tkl_ota_start_notify(pkg_len, TUYA_OTA_FULL, TUYA_OTA_PATH_AIR));
+    CHECK(OPRT_OK == __feed(sg_pkg, pkg_len, 0, TEST_PACKET_MAX));
+    CHECK(OPRT_OK == tkl_ota_end_notify(FALSE));
+    CHECK(0 == memcmp(__flash(UG_START_ADDR), sg_image, len));
+}
+
+int main(int argc, char *argv[])
+{
+    sg_seed = (argc > 1) ? atoi(argv[1]) : 1;
+    srand(sg_seed);
+
+    __test_stream();
+    __test_reject();
+
+    printf("tkl_ota_test: seed %u ok\n", sg_seed);
+    return 0;
+}
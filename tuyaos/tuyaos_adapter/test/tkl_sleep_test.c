@@ -0,0 +1,299 @@
+/**
+ * @file tkl_sleep_test.c
+ * @brief host test of the tkl_sleep voters and sleep callbacks
+ *
+ * mcu_prevent and the sleep hooks of mcu_ps are faked below, the clock only
+ * moves when the test moves it. after every call the MCU_PS_TKL_VOTE bit must
+ * be set exactly while some voter holds a vote.
+ */
+#include <stdlib.h>
+#include "../src/tkl_sleep.c"
+
+#define CHECK(cond)     do {                                                        \
+                            if (!(cond)) {                                          \
+                                printf("%s:%d: %s failed\n", __FILE__, __LINE__, #cond); \
+                                exit(1);                                            \
+                            }                                                       \
+                        } while (0)
+
+static SYS_TIME_T sg_now;
+static INT_T sg_int_depth;
+static uint32_t sg_prevent;
+static MCU_PS_SLEEP_CB sg_pre, sg_post;
+static UINT_T sg_hook_regs;
+static UINT_T sg_ps_enable, sg_ps_disable;
+static CHAR_T sg_order[32];
+static UINT_T sg_order_len;
+
+SYS_TIME_T tkl_system_get_millisecond(VOID_T)
+{
+    return sg_now;
+}
+
+UINT_T tkl_system_enter_critical(VOID_T)
+{
+    return sg_int_depth++;
+}
+
+VOID_T tkl_system_exit_critical(UINT_T irq_mask)
+{
+    CHECK(irq_mask == --sg_int_depth);
+}
+
+void mcu_prevent_set(uint32_t prevent)
+{
+    CHECK(sg_int_depth > 0);
+    sg_prevent |= prevent;
+}
+
+void mcu_prevent_clear(uint32_t prevent)
+{
+    CHECK(sg_int_depth > 0);
+    sg_prevent &= ~prevent;
+}
+
+uint32_t mcu_prevent_get(void)
+{
+    return sg_prevent;
+}
+
+void mcu_ps_sleep_cb_register(MCU_PS_SLEEP_CB pre_sleep, MCU_PS_SLEEP_CB post_wakeup)
+{
+    sg_pre = pre_sleep;
+    sg_post = post_wakeup;
+    sg_hook_regs++;
+}
+
+int bk_wlan_mcu_ps_mode_enable(void)
+{
+    sg_ps_enable++;
+    return 0;
+}
+
+int bk_wlan_mcu_ps_mode_disable(void)
+{
+    sg_ps_disable++;
+    return 0;
+}
+
+void bk_printf(const char *fmt, ...)
+{
+}
+
+static VOID_T __cb_a(VOID_T)
+{
+    sg_order[sg_order_len++] = 'a';
+}
+
+static VOID_T __cb_b(VOID_T)
+{
+    sg_order[sg_order_len++] = 'b';
+}
+
+static VOID_T __cb_c(VOID_T)
+{
+    sg_order[sg_order_len++] = 'c';
+}
+
+/* the vote bit follows the voters holding a vote, the critical section is balanced */
+static VOID_T __check_held(VOID_T)
+{
+    TKL_SLEEP_VOTER_STAT_T st;
+    UINT_T i, held = 0;
+
+    for (i = 0; OPRT_OK == tkl_cpu_sleep_voter_stat(i, &st); i++) {
+        held += (st.votes != 0);
+    }
+    CHECK(i == sg_voter_num);
+    CHECK((0 != held) == (0 != (sg_prevent & MCU_PS_TKL_VOTE)));
+    CHECK(0 == sg_int_depth);
+}
+
+static VOID_T __test_register(VOID_T)
+{
+    UINT_T wifi, again, uart, v;
+    static CHAR_T name[TKL_SLEEP_VOTER_MAX][8];     // the table keeps the pointers
+    TKL_SLEEP_VOTER_STAT_T st;
+    INT_T i;
+
+    CHECK(OPRT_INVALID_PARM == tkl_cpu_sleep_voter_register(NULL, &v));
+    CHECK(OPRT_INVALID_PARM == tkl_cpu_sleep_voter_register("wifi", NULL));
+
+    CHECK((OPRT_OK == tkl_cpu_sleep_voter_register("cpu", &v)) && (TKL_SLEEP_VOTER_CPU == v));
+    CHECK((OPRT_OK == tkl_cpu_sleep_voter_register("wifi", &wifi)) && (1 == wifi));
+    CHECK((OPRT_OK == tkl_cpu_sleep_voter_register("wifi", &again)) && (again == wifi));
+    CHECK((OPRT_OK == tkl_cpu_sleep_voter_register("uart", &uart)) && (2 == uart));
+
+    CHECK((OPRT_OK == tkl_cpu_sleep_voter_stat(uart, &st)) && (0 == strcmp(st.name, "uart")));
+    CHECK((0 == st.votes) && (0 == st.blocks) && (0 == st.blocked_ms));
+    CHECK(OPRT_INVALID_PARM == tkl_cpu_sleep_voter_stat(3, &st));
+    CHECK(OPRT_INVALID_PARM == tkl_cpu_sleep_voter_stat(uart, NULL));
+
+    /* fill the table, a new name is refused but known ones still resolve */
+    for (i = 3; i < TKL_SLEEP_VOTER_MAX; i++) {
+        sprintf(name[i], "v%d", i);
+        CHECK((OPRT_OK == tkl_cpu_sleep_voter_register(name[i], &v)) && (i == v));
+    }
+    CHECK(OPRT_COM_ERROR == tkl_cpu_sleep_voter_register("full", &v));
+    CHECK(TKL_SLEEP_VOTER_MAX == sg_voter_num);
+    CHECK((OPRT_OK == tkl_cpu_sleep_voter_register("uart", &v)) && (uart == v));
+    CHECK(OPRT_INVALID_PARM == tkl_cpu_sleep_vote(TKL_SLEEP_VOTER_MAX, TRUE));
+    __check_held();
+}
+
+static VOID_T __test_vote(VOID_T)
+{
+    UINT_T wifi, uart;
+    TKL_SLEEP_VOTER_STAT_T st;
+
+    tkl_cpu_sleep_voter_register("wifi", &wifi);
+    tkl_cpu_sleep_voter_register("uart", &uart);
+
+    /* nothing to release yet */
+    CHECK(OPRT_COM_ERROR == tkl_cpu_sleep_vote(wifi, FALSE));
+    CHECK(0 == sg_prevent);
+    __check_held();
+
+    /* nested votes of one voter and an overlapping voter */
+    sg_now = 100;
+    CHECK(OPRT_OK == tkl_cpu_sleep_vote(wifi, TRUE));
+    CHECK(MCU_PS_TKL_VOTE == sg_prevent);
+    sg_now = 110;
+    tkl_cpu_sleep_vote(wifi, TRUE);
+    tkl_cpu_sleep_vote(uart, TRUE);
+    __check_held();
+
+    sg_now = 150;
+    tkl_cpu_sleep_vote(wifi, FALSE);
+    CHECK(MCU_PS_TKL_VOTE == sg_prevent);
+    /* the block in progress counts up to now */
+    CHECK((OPRT_OK == tkl_cpu_sleep_voter_stat(wifi, &st)) && (1 == st.votes) && (1 == st.blocks));
+    CHECK((100 == st.since) && (50 == st.blocked_ms) && (50 == st.max_ms));
+    /* and is not folded into the table */
+    CHECK((0 == sg_voter[wifi].blocked_ms) && (0 == sg_voter[wifi].max_ms));
+
+    sg_now = 200;
+    tkl_cpu_sleep_vote(wifi, FALSE);
+    CHECK(MCU_PS_TKL_VOTE == sg_prevent);
+    CHECK(OPRT_COM_ERROR == tkl_cpu_sleep_vote(wifi, FALSE));
+    __check_held();
+
+    sg_now = 260;
+    tkl_cpu_sleep_vote(uart, FALSE);
+    CHECK(0 == sg_prevent);
+    __check_held();
+
+    sg_now = 1000;
+    tkl_cpu_sleep_voter_stat(wifi, &st);
+    CHECK((0 == st.votes) && (1 == st.blocks) && (100 == st.blocked_ms) && (100 == st.max_ms));
+    tkl_cpu_sleep_voter_stat(uart, &st);
+    CHECK((0 == st.votes) && (1 == st.blocks) && (150 == st.blocked_ms) && (150 == st.max_ms));
+
+    /* a shorter second block adds up but leaves the longest alone */
+    sg_now = 1100;
+    tkl_cpu_sleep_vote(wifi, TRUE);
+    sg_now = 1110;
+    tkl_cpu_sleep_vote(wifi, FALSE);
+    tkl_cpu_sleep_voter_stat(wifi, &st);
+    CHECK((2 == st.blocks) && (110 == st.blocked_ms) && (100 == st.max_ms));
+    __check_held();
+
+    /* tkl_cpu_force_wakeup sets voter 0 and does not nest, one tkl_cpu_allow_sleep clears it */
+    sg_now = 2000;
+    tkl_cpu_force_wakeup();
+    sg_now = 2005;
+    tkl_cpu_force_wakeup();
+    tkl_cpu_sleep_vote(wifi, TRUE);
+    CHECK(2 == sg_voter_held);
+    tkl_cpu_sleep_voter_stat(TKL_SLEEP_VOTER_CPU, &st);
+    CHECK((1 == st.votes) && (1 == st.blocks) && (2000 == st.since));
+    sg_now = 2020;
+    tkl_cpu_allow_sleep();
+    CHECK((1 == sg_voter_held) && (MCU_PS_TKL_VOTE == sg_prevent));
+    __check_held();
+    /* a spare tkl_cpu_allow_sleep is harmless and leaves the other voters alone */
+    tkl_cpu_allow_sleep();
+    CHECK(MCU_PS_TKL_VOTE == sg_prevent);
+    sg_now = 2030;
+    tkl_cpu_sleep_vote(wifi, FALSE);
+    CHECK(0 == sg_prevent);
+    tkl_cpu_allow_sleep();
+    CHECK(0 == sg_prevent);
+    __check_held();
+
+    tkl_cpu_sleep_voter_stat(TKL_SLEEP_VOTER_CPU, &st);
+    CHECK((0 == strcmp(st.name, "cpu")) && (0 == st.votes) && (1 == st.blocks) && (20 == st.blocked_ms));
+
+    /* the counted votes of tkl_cpu_sleep_vote on voter 0 are cleared at once too */
+    sg_now = 3000;
+    tkl_cpu_sleep_vote(TKL_SLEEP_VOTER_CPU, TRUE);
+    tkl_cpu_sleep_vote(TKL_SLEEP_VOTER_CPU, TRUE);
+    tkl_cpu_force_wakeup();
+    tkl_cpu_sleep_voter_stat(TKL_SLEEP_VOTER_CPU, &st);
+    CHECK(2 == st.votes);
+    sg_now = 3010;
+    tkl_cpu_allow_sleep();
+    CHECK(0 == sg_prevent);
+    __check_held();
+    tkl_cpu_sleep_voter_stat(TKL_SLEEP_VOTER_CPU, &st);
+    CHECK((0 == st.votes) && (2 == st.blocks) && (30 == st.blocked_ms));
+}
+
+static VOID_T __test_callback(VOID_T)
+{
+    TUYA_SLEEP_CB_T ab = {__cb_a, __cb_b};
+    TUYA_SLEEP_CB_T c = {__cb_c, NULL};
+    TUYA_SLEEP_CB_T b = {NULL, __cb_b};
+    TUYA_SLEEP_CB_T none = {NULL, NULL};
+    INT_T i;
+
+    CHECK(OPRT_INVALID_PARM == tkl_cpu_sleep_callback_register(NULL));
+    CHECK(OPRT_INVALID_PARM == tkl_cpu_sleep_callback_register(&none));
+    CHECK((0 == sg_hook_regs) && (NULL == sg_pre));
+
+    /* the first callback hooks the chain into mcu_ps, only once */
+    CHECK(OPRT_OK == tkl_cpu_sleep_callback_register(&ab));
+    CHECK((1 == sg_hook_regs) && sg_pre && sg_post);
+    CHECK(OPRT_OK == tkl_cpu_sleep_callback_register(&c));
+    CHECK(OPRT_OK == tkl_cpu_sleep_callback_register(&b));
+    CHECK(1 == sg_hook_regs);
+
+    /* registration order, a missing half is skipped */
+    sg_pre();
+    sg_post();
+    CHECK(0 == strcmp(sg_order, "acbb"));
+    CHECK(0 == sg_int_depth);
+
+    for (i = 3; i < TKL_SLEEP_CB_MAX; i++) {
+        CHECK(OPRT_OK == tkl_cpu_sleep_callback_register(&c));
+    }
+    CHECK(OPRT_COM_ERROR == tkl_cpu_sleep_callback_register(&ab));
+    CHECK((TKL_SLEEP_CB_MAX == sg_sleep_cb_num) && (1 == sg_hook_regs));
+
+    memset(sg_order, 0, sizeof(sg_order));
+    sg_order_len = 0;
+    sg_pre();
+    CHECK(0 == strcmp(sg_order, "acccccc"));
+    CHECK(0 == sg_int_depth);
+}
+
+static VOID_T __test_mode(VOID_T)
+{
+    CHECK(OPRT_OK == tkl_cpu_sleep_mode_set(TRUE, TUYA_CPU_SLEEP));
+    CHECK((1 == cpu_lp_flag) && (1 == sg_ps_enable));
+    CHECK(OPRT_OK == tkl_cpu_sleep_mode_set(FALSE, TUYA_CPU_SLEEP));
+    CHECK(1 == sg_ps_disable);
+    CHECK(OPRT_OS_ADAPTER_CPU_LPMODE_SET_FAILED == tkl_cpu_sleep_mode_set(TRUE, TUYA_CPU_DEEP_SLEEP));
+    CHECK((1 == sg_ps_enable) && (1 == sg_ps_disable));
+}
+
+int main(int argc, char *argv[])
+{
+    __test_register();
+    __test_vote();
+    __test_callback();
+    __test_mode();
+
+    printf("tkl_sleep_test: ok\n");
+    return 0;
+}
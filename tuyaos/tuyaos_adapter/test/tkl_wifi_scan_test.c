@@ -0,0 +1,315 @@
+/**
+ * @file tkl_wifi_scan_test.c
+ * @brief host test of tkl_wifi_scan_ap_async and tkl_wifi_scan_ap against a fake wifi core
+ */
+#include "../src/tkl_wifi.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include "wifi_sim.h"
+
+#define CHECK(cond)     do {                                                        \
+                            if (!(cond)) {                                          \
+                                printf("%s:%d: %s failed\n", __FILE__, __LINE__, #cond); \
+                                exit(1);                                            \
+                            }                                                       \
+                        } while (0)
+
+#define TEST_LONG_SSID  "0123456789abcdef0123456789ABCDEF"
+#define TEST_ALL_CHANS  0x3ffe
+
+typedef struct {
+    CONST CHAR_T *ssid;
+    UCHAR_T channel;
+    SCHAR_T rssi;
+} TEST_BSS_S;
+
+/* three of home, the strongest neither first nor last, a longer ssid starting with it, and a far one */
+static CONST TEST_BSS_S sg_air[] = {
+    {"home",            1,  -70},
+    {"home",            6,  -40},
+    {"home",            11, -60},
+    {"homes",           6,  -30},
+    {"cafe",            6,  -50},
+    {TEST_LONG_SSID,    3,  -55},
+    {"",                9,  -80},
+    {"cafe",            13, -65},
+    {"far",             12, -104},
+    {"far",             13, -100},
+};
+
+typedef struct {
+    AP_IF_S ap[16];
+    UINT_T num;
+    UINT_T ends;
+    UINT_T stop_after;          // return TRUE at this many results, 0 never
+} TEST_REC_S;
+
+static BOOL_T __rec_cb(CONST AP_IF_S *ap, VOID_T *arg)
+{
+    TEST_REC_S *rec = (TEST_REC_S *)arg;
+
+    // nothing after the end
+    CHECK(0 == rec->ends);
+    if (NULL == ap) {
+        rec->ends++;
+        return FALSE;
+    }
+    CHECK(rec->num < CNTSOF(rec->ap));
+    rec->ap[rec->num++] = *ap;
+
+    return rec->stop_after && (rec->num >= rec->stop_after);
+}
+
+static VOID_T __param(WF_SCAN_PARAM_S *param, CONST CHAR_T *ssid, TEST_REC_S *rec)
+{
+    memset(param, 0, sizeof(*param));
+    memset(rec, 0, sizeof(*rec));
+    param->ssid = (CONST SCHAR_T *)ssid;
+    param->cb = __rec_cb;
+    param->arg = rec;
+}
+
+/* the ap as the core has it in the air */
+static VOID_T __check_ap(CONST AP_IF_S *ap)
+{
+    CONST TEST_BSS_S *bss;
+
+    CHECK(ap->bssid[5] < CNTSOF(sg_air));
+    bss = &sg_air[ap->bssid[5]];
+    CHECK(ap->s_len == strlen(bss->ssid));
+    CHECK(0 == memcmp(ap->ssid, bss->ssid, ap->s_len) && (0 == ap->ssid[ap->s_len]));
+    CHECK((ap->channel == bss->channel) && (ap->rssi == bss->rssi));
+    CHECK(ap->security == ap->bssid[5] % 4);
+}
+
+static VOID_T __test_async(VOID_T)
+{
+    WF_SCAN_PARAM_S param;
+    TEST_REC_S rec;
+    UINT_T i, seen = 0;
+
+    // every bss once, then one end
+    __param(&param, NULL, &rec);
+    CHECK(OPRT_OK == tkl_wifi_scan_ap_async(&param));
+    CHECK(0 == strcmp(wifi_sim_probe_ssid(), ""));
+    CHECK(wifi_sim_run());
+    CHECK((CNTSOF(sg_air) == rec.num) && (1 == rec.ends));
+    CHECK(TEST_ALL_CHANS == wifi_sim_chan_mask());
+    for (i = 0; i < rec.num; i++) {
+        __check_ap(&rec.ap[i]);
+        seen |= 1u << rec.ap[i].bssid[5];
+    }
+    CHECK(((1u << CNTSOF(sg_air)) - 1) == seen);
+    CHECK(!wifi_sim_run());
+
+    // only the channels asked for
+    __param(&param, NULL, &rec);
+    param.chan_num = 2;
+    param.chans[0] = 13;
+    param.chans[1] = 6;
+    CHECK(OPRT_OK == tkl_wifi_scan_ap_async(&param));
+    CHECK(wifi_sim_run());
+    CHECK(((1u << 6) | (1u << 13)) == wifi_sim_chan_mask());
+    CHECK((5 == rec.num) && (1 == rec.ends));
+    for (i = 0; i < rec.num; i++) {
+        __check_ap(&rec.ap[i]);
+    }
+
+    // a directed scan probes for the ssid and reports it alone, not its prefix or extension
+    __param(&param, "home", &rec);
+    CHECK(OPRT_OK == tkl_wifi_scan_ap_async(&param));
+    CHECK(0 == strcmp(wifi_sim_probe_ssid(), "home"));
+    CHECK(wifi_sim_run());
+    CHECK((3 == rec.num) && (1 == rec.ends));
+    for (i = 0; i < rec.num; i++) {
+        __check_ap(&rec.ap[i]);
+        CHECK(0 == strcmp((CHAR_T *)rec.ap[i].ssid, "home"));
+    }
+    __param(&param, "hom", &rec);
+    CHECK(OPRT_OK == tkl_wifi_scan_ap_async(&param));
+    CHECK(wifi_sim_run());
+    CHECK((0 == rec.num) && (1 == rec.ends));
+
+    // a 32 byte ssid has no NUL in the core
+    __param(&param, TEST_LONG_SSID, &rec);
+    CHECK(OPRT_OK == tkl_wifi_scan_ap_async(&param));
+    CHECK(wifi_sim_run());
+    CHECK((1 == rec.num) && (WIFI_SSID_LEN == rec.ap[0].s_len));
+    __check_ap(&rec.ap[0]);
+}
+
+static VOID_T __test_stop(VOID_T)
+{
+    WF_SCAN_PARAM_S param;
+    TEST_REC_S rec;
+    UINT_T cancels = wifi_sim_cancels();
+
+    // the callback stops at the second bss, on channel 3
+    __param(&param, NULL, &rec);
+    rec.stop_after = 2;
+    CHECK(OPRT_OK == tkl_wifi_scan_ap_async(&param));
+    CHECK(wifi_sim_run());
+    CHECK((2 == rec.num) && (1 == rec.ends));
+    CHECK(cancels + 1 == wifi_sim_cancels());
+    CHECK(((1u << 1) | (1u << 2) | (1u << 3)) == wifi_sim_chan_mask());
+
+    // results still queued in the channel are dropped
+    __param(&param, NULL, &rec);
+    rec.stop_after = 1;
+    param.chan_num = 1;
+    param.chans[0] = 6;
+    CHECK(OPRT_OK == tkl_wifi_scan_ap_async(&param));
+    CHECK(wifi_sim_run());
+    CHECK((1 == rec.num) && (1 == rec.ends));
+    CHECK(cancels + 2 == wifi_sim_cancels());
+
+    // stop_on_match takes the first bss of the ssid
+    __param(&param, "cafe", &rec);
+    param.stop_on_match = TRUE;
+    CHECK(OPRT_OK == tkl_wifi_scan_ap_async(&param));
+    CHECK(wifi_sim_run());
+    CHECK((1 == rec.num) && (1 == rec.ends) && (4 == rec.ap[0].bssid[5]));
+    CHECK(cancels + 3 == wifi_sim_cancels());
+
+    // and means nothing without one
+    __param(&param, NULL, &rec);
+    param.stop_on_match = TRUE;
+    CHECK(OPRT_OK == tkl_wifi_scan_ap_async(&param));
+    CHECK(wifi_sim_run());
+    CHECK((CNTSOF(sg_air) == rec.num) && (1 == rec.ends));
+    CHECK(cancels + 3 == wifi_sim_cancels());
+}
+
+static VOID_T __test_reject(VOID_T)
+{
+    WF_SCAN_PARAM_S param;
+    TEST_REC_S rec, other;
+    AP_IF_S *ap;
+    UINT_T num;
+
+    __param(&param, NULL, &rec);
+    CHECK(OPRT_OS_ADAPTER_INVALID_PARM == tkl_wifi_scan_ap_async(NULL));
+    param.chan_num = CNTSOF(param.chans) + 1;
+    CHECK(OPRT_OS_ADAPTER_INVALID_PARM == tkl_wifi_scan_ap_async(&param));
+    param.chan_num = 0;
+    param.cb = NULL;
+    CHECK(OPRT_OS_ADAPTER_INVALID_PARM == tkl_wifi_scan_ap_async(&param));
+    CHECK(!wifi_sim_run());
+
+    // one scan at a time, the second leaves the first alone
+    __param(&param, NULL, &rec);
+    CHECK(OPRT_OK == tkl_wifi_scan_ap_async(&param));
+    __param(&param, "cafe", &other);
+    CHECK(OPRT_COM_ERROR == tkl_wifi_scan_ap_async(&param));
+    CHECK(OPRT_OK != tkl_wifi_scan_ap(NULL, &ap, &num));
+    CHECK(OPRT_OK != tkl_wifi_scan_ap((CONST SCHAR_T *)"home", &ap, &num));
+    CHECK(wifi_sim_run());
+    CHECK((CNTSOF(sg_air) == rec.num) && (1 == rec.ends));
+    CHECK((0 == other.num) && (0 == other.ends));
+    CHECK(0 == wifi_sim_sems());
+
+    // a core that does not start the scan does not block the next one
+    wifi_sim_busy(TRUE);
+    __param(&param, NULL, &rec);
+    CHECK(OPRT_COM_ERROR == tkl_wifi_scan_ap_async(&param));
+    CHECK(0 == rec.ends);
+    wifi_sim_busy(FALSE);
+    CHECK(OPRT_OK == tkl_wifi_scan_ap_async(&param));
+    CHECK(wifi_sim_run());
+    CHECK((CNTSOF(sg_air) == rec.num) && (1 == rec.ends));
+}
+
+static VOID_T __test_lost_end(VOID_T)
+{
+    WF_SCAN_PARAM_S param;
+    TEST_REC_S rec, next;
+    SYS_TIME_T start = tkl_system_get_millisecond();
+
+    __param(&param, NULL, &rec);
+    wifi_sim_lose_end();
+    CHECK(OPRT_OK == tkl_wifi_scan_ap_async(&param));
+    CHECK(wifi_sim_run());
+    CHECK((CNTSOF(sg_air) == rec.num) && (0 == rec.ends));
+
+    // taken as running until it times out, then ended for its user before the next starts
+    __param(&param, NULL, &next);
+    tkl_system_sleep(SCAN_ASYNC_TIMEOUT_MS - 1 - (tkl_system_get_millisecond() - start));
+    CHECK(OPRT_COM_ERROR == tkl_wifi_scan_ap_async(&param));
+    tkl_system_sleep(1);
+    CHECK(OPRT_OK == tkl_wifi_scan_ap_async(&param));
+    CHECK(1 == rec.ends);
+    CHECK(wifi_sim_run());
+    CHECK((CNTSOF(sg_air) == next.num) && (1 == next.ends) && (1 == rec.ends));
+}
+
+static VOID_T __test_scan_ap(VOID_T)
+{
+    AP_IF_S *ap;
+    UINT_T num, i;
+
+    // the strongest bss of the ssid over all channels
+    num = 0;
+    CHECK(OPRT_OK == tkl_wifi_scan_ap((CONST SCHAR_T *)"home", &ap, &num));
+    CHECK((1 == num) && (1 == ap->bssid[5]));
+    __check_ap(ap);
+    CHECK(TEST_ALL_CHANS == wifi_sim_chan_mask());
+    CHECK(0 == strcmp(wifi_sim_probe_ssid(), "home"));
+    CHECK(OPRT_OK == tkl_wifi_release_ap(ap));
+    CHECK(0 == wifi_sim_sems());
+
+    CHECK(OPRT_OK == tkl_wifi_scan_ap((CONST SCHAR_T *)TEST_LONG_SSID, &ap, &num));
+    CHECK((1 == num) && (5 == ap->bssid[5]));
+    CHECK(OPRT_OK == tkl_wifi_release_ap(ap));
+
+    // found however weak, -100 dBm is no floor
+    CHECK(OPRT_OK == tkl_wifi_scan_ap((CONST SCHAR_T *)"far", &ap, &num));
+    CHECK((1 == num) && (9 == ap->bssid[5]) && (-100 == ap->rssi));
+    CHECK(OPRT_OK == tkl_wifi_release_ap(ap));
+
+    CHECK(OPRT_OK != tkl_wifi_scan_ap((CONST SCHAR_T *)"hom", &ap, &num));
+    CHECK(OPRT_OK != tkl_wifi_scan_ap((CONST SCHAR_T *)"nowhere", &ap, &num));
+    CHECK(0 == wifi_sim_sems());
+
+    // a lost end times out the wait and does not hold up the next scan
+    wifi_sim_lose_end();
+    CHECK(OPRT_OK != tkl_wifi_scan_ap((CONST SCHAR_T *)"home", &ap, &num));
+    CHECK(0 == wifi_sim_sems());
+    CHECK((OPRT_OK == tkl_wifi_scan_ap((CONST SCHAR_T *)"cafe", &ap, &num)) && (4 == ap->bssid[5]));
+    CHECK(OPRT_OK == tkl_wifi_release_ap(ap));
+
+    // an end that comes after the wait gave up finds no semaphore to post
+    wifi_sim_hold_end();
+    CHECK(OPRT_OK != tkl_wifi_scan_ap((CONST SCHAR_T *)"home", &ap, &num));
+    CHECK(0 == wifi_sim_sems());
+    wifi_sim_end();
+
+    // every bss in the air through the blocking scan
+    CHECK(OPRT_OK == tkl_wifi_scan_ap(NULL, &ap, &num));
+    CHECK(CNTSOF(sg_air) == num);
+    for (i = 0; i < num; i++) {
+        CHECK((ap[i].bssid[5] == i) && (ap[i].channel == sg_air[i].channel) && (ap[i].rssi == sg_air[i].rssi));
+        CHECK((ap[i].s_len == strlen(sg_air[i].ssid)) && (0 == memcmp(ap[i].ssid, sg_air[i].ssid, ap[i].s_len)));
+    }
+    CHECK(OPRT_OK == tkl_wifi_release_ap(ap));
+    CHECK(0 == wifi_sim_sems());
+}
+
+int main(int argc, char *argv[])
+{
+    UINT_T i;
+
+    wifi_sim_init();
+    for (i = 0; i < CNTSOF(sg_air); i++) {
+        wifi_sim_add_bss(sg_air[i].ssid, sg_air[i].channel, sg_air[i].rssi);
+    }
+
+    __test_async();
+    __test_stop();
+    __test_reject();
+    __test_lost_end();
+    __test_scan_ap();
+
+    printf("tkl_wifi_scan_test: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,393 @@
+/**
+ * @file tuya_hashmap_test.c
+ * @brief host test and benchmark of tuya_hashmap
+ *
+ * usage: tuya_hashmap_test [seed]
+ *
+ * built once with the element pool and once without it
+ * (HASHMAP_POOL_CHUNK=0). random puts, removes and traversals are checked
+ * against a model that keeps the values of every key newest first.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "../include/utilities/src/tuya_hashmap.c"
+
+#define CHECK(cond)     do {                                                        \
+                            if (!(cond)) {                                          \
+                                printf("%s:%d: %s failed, seed %u\n",               \
+                                       __FILE__, __LINE__, #cond, sg_seed);         \
+                                exit(1);                                            \
+                            }                                                       \
+                        } while (0)
+
+#if HASHMAP_POOL_CHUNK
+#define TEST_NAME           "tuya_hashmap_test"
+#else
+#define TEST_NAME           "tuya_hashmap_nopool_test"
+#endif
+
+#define TEST_KEY_NUM        (40)
+#define TEST_DATA_MAX       (16)        // values kept per key by the model
+#define TEST_BENCH_KEYS     (2000)
+
+typedef struct {
+    CHAR_T key[16];
+    UINT_T num;
+    uintptr_t data[TEST_DATA_MAX];      // newest first, as the map returns them
+} TEST_KEY_T;
+
+static UINT32_T sg_seed;
+static INT_T sg_blocks;                 // heap blocks the map holds
+static BOOL_T sg_malloc_fail;
+static uintptr_t sg_next = 1;
+
+/* FNV-1a 32 bit collisions, each pair shares the full hash and so the bucket */
+static CONST CHAR_T *sg_collide[] = { "costarring", "liquid", "declinate", "macallums", "altarage", "zinke" };
+
+static TEST_KEY_T sg_key[TEST_KEY_NUM];
+
+VOID_T *tkl_system_malloc(SIZE_T size)
+{
+    if (sg_malloc_fail) {
+        return NULL;
+    }
+    sg_blocks++;
+    return malloc(size);
+}
+
+VOID_T tkl_system_free(VOID_T *ptr)
+{
+    sg_blocks--;
+    free(ptr);
+}
+
+/* the values of the key in the order the iterator gives them */
+static VOID_T __check_key(MAP_T map, TEST_KEY_T *k)
+{
+    ANY_T *iter = NULL;
+    ANY_T data = NULL;
+    UINT_T i = 0;
+
+    TUYA_HASHMAP_FOR_EACH_DATA(map, k->key, iter) {
+        CHECK(i < k->num);
+        CHECK((uintptr_t)*iter == k->data[i]);
+        i++;
+    }
+    CHECK(i == k->num);
+
+    if (k->num) {
+        CHECK(MAP_OK == tuya_hashmap_get(map, k->key, &data));
+        CHECK((uintptr_t)data == k->data[0]);
+    } else {
+        CHECK(MAP_MISSING == tuya_hashmap_get(map, k->key, &data));
+        CHECK(NULL == data);
+    }
+}
+
+static VOID_T __check_all(MAP_T map)
+{
+    HASHMAP_T *m = (HASHMAP_T *)map;
+    INT_T i, num = 0, chain = 0;
+    HLIST_NODE *pos = NULL;
+
+    for (i = 0; i < TEST_KEY_NUM; i++) {
+        __check_key(map, &sg_key[i]);
+        num += sg_key[i].num;
+    }
+    CHECK(num == tuya_hashmap_length(map));
+
+    // every element sits in the bucket of its hash
+    for (i = 0; i < m->table_size; i++) {
+        HLIST_FOR_EACH(pos, &(m->list[i])) {
+            CHECK(i == (INT_T)(HLIST_ENTRY(pos, HASHMAP_ELEMENT_T, node)->hash & m->mask));
+            chain++;
+        }
+    }
+    CHECK(chain == num);
+}
+
+static VOID_T __model_put(TEST_KEY_T *k, uintptr_t data)
+{
+    memmove(&k->data[1], &k->data[0], k->num * sizeof(k->data[0]));
+    k->data[0] = data;
+    k->num++;
+}
+
+static VOID_T __model_remove(TEST_KEY_T *k, UINT_T idx)
+{
+    k->num--;
+    memmove(&k->data[idx], &k->data[idx + 1], (k->num - idx) * sizeof(k->data[0]));
+}
+
+static VOID_T __keys_init(VOID_T)
+{
+    INT_T i;
+
+    memset(sg_key, 0, sizeof(sg_key));
+    for (i = 0; i < TEST_KEY_NUM; i++) {
+        if (i < (INT_T)CNTSOF(sg_collide)) {
+            strcpy(sg_key[i].key, sg_collide[i]);
+        } else {
+            sprintf(sg_key[i].key, "dp_%d", i);
+        }
+    }
+}
+
+/* keys with the same full hash are told apart by the key itself */
+static VOID_T __test_collision(VOID_T)
+{
+    MAP_T map;
+    INT_T i;
+
+    for (i = 0; i < (INT_T)CNTSOF(sg_collide); i += 2) {
+        CHECK(__hashmap_hash(sg_collide[i]) == __hashmap_hash(sg_collide[i + 1]));
+    }
+
+    __keys_init();
+    map = tuya_hashmap_new(1);
+    CHECK(map);
+    for (i = 0; i < (INT_T)CNTSOF(sg_collide); i++) {
+        CHECK(MAP_OK == tuya_hashmap_put(map, sg_key[i].key, (ANY_T)sg_next));
+        __model_put(&sg_key[i], sg_next++);
+    }
+    __check_all(map);
+
+    // the older key of each pair goes, its twin stays
+    for (i = 0; i < (INT_T)CNTSOF(sg_collide); i += 2) {
+        CHECK(MAP_MISSING == tuya_hashmap_remove(map, sg_key[i].key, (ANY_T)sg_key[i + 1].data[0]));
+        CHECK(MAP_OK == tuya_hashmap_remove(map, sg_key[i].key, NULL));
+        __model_remove(&sg_key[i], 0);
+        __check_all(map);
+        CHECK(MAP_MISSING == tuya_hashmap_remove(map, sg_key[i].key, NULL));
+    }
+
+    for (i = 1; i < (INT_T)CNTSOF(sg_collide); i += 2) {
+        CHECK(MAP_OK == tuya_hashmap_remove(map, sg_key[i].key, NULL));
+        sg_key[i].num = 0;
+    }
+    CHECK(0 == tuya_hashmap_length(map));
+    tuya_hashmap_free(map);
+    CHECK(0 == sg_blocks);
+}
+
+/* values of one key come newest first, a delete from the middle keeps the rest in order */
+static VOID_T __test_reinsert(VOID_T)
+{
+    TEST_KEY_T *k = &sg_key[CNTSOF(sg_collide)];
+    MAP_T map;
+    INT_T i, blocks;
+
+    __keys_init();
+    map = tuya_hashmap_new(4);
+    CHECK(map);
+    for (i = 0; i < 5; i++) {
+        CHECK(MAP_OK == tuya_hashmap_put(map, k->key, (ANY_T)sg_next));
+        __model_put(k, sg_next++);
+    }
+    __check_key(map, k);
+
+    // a value that is not there removes nothing
+    CHECK(MAP_MISSING == tuya_hashmap_remove(map, k->key, (ANY_T)sg_next));
+    __check_key(map, k);
+
+    CHECK(MAP_OK == tuya_hashmap_remove(map, k->key, (ANY_T)k->data[2]));
+    __model_remove(k, 2);
+    __check_key(map, k);
+    CHECK(MAP_OK == tuya_hashmap_remove(map, k->key, NULL));
+    __model_remove(k, 0);
+    __check_key(map, k);
+    CHECK(MAP_OK == tuya_hashmap_remove(map, k->key, (ANY_T)k->data[k->num - 1]));
+    __model_remove(k, k->num - 1);
+    __check_key(map, k);
+
+    // the freed elements come back without going to the heap
+    blocks = sg_blocks;
+    for (i = 0; i < 3; i++) {
+        CHECK(MAP_OK == tuya_hashmap_put(map, k->key, (ANY_T)sg_next));
+        __model_put(k, sg_next++);
+        __check_key(map, k);
+    }
+    CHECK(sg_blocks == blocks + (HASHMAP_POOL_CHUNK ? 0 : 3));
+    __check_all(map);
+
+    while (k->num) {
+        CHECK(MAP_OK == tuya_hashmap_remove(map, k->key, NULL));
+        __model_remove(k, 0);
+    }
+    __check_all(map);
+    tuya_hashmap_free(map);
+    CHECK(0 == sg_blocks);
+}
+
+/* no heap: a put takes a recycled element or fails cleanly, a failed grow keeps the table */
+static VOID_T __test_exhaust(VOID_T)
+{
+    HASHMAP_T *m;
+    MAP_T map;
+    INT_T i, table_size;
+
+    __keys_init();
+    map = tuya_hashmap_new(4);
+    CHECK(map);
+    m = (HASHMAP_T *)map;
+
+    // one element in use, the rest of its chunk idle
+    CHECK(MAP_OK == tuya_hashmap_put(map, sg_key[0].key, (ANY_T)sg_next));
+    __model_put(&sg_key[0], sg_next++);
+
+    sg_malloc_fail = TRUE;
+    for (i = 1; i < HASHMAP_POOL_CHUNK; i++) {
+        CHECK(MAP_OK == tuya_hashmap_put(map, sg_key[i].key, (ANY_T)sg_next));
+        __model_put(&sg_key[i], sg_next++);
+    }
+    CHECK(MAP_OMEM == tuya_hashmap_put(map, sg_key[TEST_KEY_NUM - 1].key, (ANY_T)sg_next));
+    __check_all(map);
+
+    // past the load factor the bucket array can not grow, the chains just get longer
+    table_size = m->table_size;
+    CHECK(tuya_hashmap_length(map) >= table_size * HASHMAP_LOAD_FACTOR || !HASHMAP_POOL_CHUNK);
+
+    // a removed element is the only one left to hand out
+    CHECK(MAP_OK == tuya_hashmap_remove(map, sg_key[0].key, NULL));
+    __model_remove(&sg_key[0], 0);
+    CHECK(((HASHMAP_POOL_CHUNK) ? MAP_OK : MAP_OMEM) == tuya_hashmap_put(map, sg_key[TEST_KEY_NUM - 1].key, (ANY_T)sg_next));
+    if (HASHMAP_POOL_CHUNK) {
+        __model_put(&sg_key[TEST_KEY_NUM - 1], sg_next++);
+    }
+    CHECK(MAP_OMEM == tuya_hashmap_put(map, sg_key[TEST_KEY_NUM - 2].key, (ANY_T)sg_next));
+    CHECK(table_size == m->table_size);
+    __check_all(map);
+
+    // heap back, the table catches up with the element count
+    sg_malloc_fail = FALSE;
+    for (i = 0; i < TEST_KEY_NUM; i++) {
+        CHECK(MAP_OK == tuya_hashmap_put(map, sg_key[i].key, (ANY_T)sg_next));
+        __model_put(&sg_key[i], sg_next++);
+    }
+    CHECK(tuya_hashmap_length(map) <= m->table_size * HASHMAP_LOAD_FACTOR);
+    __check_all(map);
+
+    for (i = 0; i < TEST_KEY_NUM; i++) {
+        while (sg_key[i].num) {
+            CHECK(MAP_OK == tuya_hashmap_remove(map, sg_key[i].key, NULL));
+            __model_remove(&sg_key[i], 0);
+        }
+    }
+    __check_all(map);
+    tuya_hashmap_free(map);
+    CHECK(0 == sg_blocks);
+}
+
+/* random puts and removes, walks of every key in between */
+static VOID_T __test_random(UINT32_T rounds)
+{
+    TEST_KEY_T *k;
+    MAP_T map;
+    UINT32_T r;
+    UINT_T idx;
+    INT_T i;
+
+    __keys_init();
+    map = tuya_hashmap_new(1 + rand() % 8);
+    CHECK(map);
+
+    for (r = 0; r < rounds; r++) {
+        k = &sg_key[rand() % TEST_KEY_NUM];
+
+        switch (rand() % 4) {
+        case 0:
+        case 1:
+            if (k->num == TEST_DATA_MAX) {
+                break;
+            }
+            CHECK(MAP_OK == tuya_hashmap_put(map, k->key, (ANY_T)sg_next));
+            __model_put(k, sg_next++);
+            break;
+
+        case 2:
+            CHECK((k->num ? MAP_OK : MAP_MISSING) == tuya_hashmap_remove(map, k->key, NULL));
+            if (k->num) {
+                __model_remove(k, 0);
+            }
+            break;
+
+        default:
+            if (0 == k->num) {
+                CHECK(MAP_MISSING == tuya_hashmap_remove(map, k->key, (ANY_T)sg_next));
+                break;
+            }
+            idx = rand() % k->num;
+            CHECK(MAP_OK == tuya_hashmap_remove(map, k->key, (ANY_T)k->data[idx]));
+            __model_remove(k, idx);
+            break;
+        }
+
+        __check_key(map, k);
+        if (0 == r % 61) {
+            __check_all(map);
+        }
+    }
+
+    __check_all(map);
+    for (i = 0; i < TEST_KEY_NUM; i++) {
+        while (sg_key[i].num) {
+            CHECK(MAP_OK == tuya_hashmap_remove(map, sg_key[i].key, NULL));
+            __model_remove(&sg_key[i], 0);
+        }
+    }
+    tuya_hashmap_free(map);
+    CHECK(0 == sg_blocks);
+}
+
+/* gets of dp style keys on a table that grew from its initial size */
+static VOID_T __bench(UINT32_T gets)
+{
+    static CHAR_T keys[TEST_BENCH_KEYS][16];
+    struct timespec t0, t1;
+    uintptr_t sum = 0;
+    ANY_T data;
+    MAP_T map;
+    UINT32_T i;
+    double ns;
+
+    map = tuya_hashmap_new(16);
+    CHECK(map);
+    for (i = 0; i < TEST_BENCH_KEYS; i++) {
+        sprintf(keys[i], "dp_%u", i);
+        CHECK(MAP_OK == tuya_hashmap_put(map, keys[i], (ANY_T)(uintptr_t)(i + 1)));
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < gets; i++) {
+        tuya_hashmap_get(map, keys[(i * 7919) % TEST_BENCH_KEYS], &data);
+        sum += (uintptr_t)data;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    CHECK(sum);
+
+    for (i = 0; i < TEST_BENCH_KEYS; i++) {
+        CHECK(MAP_OK == tuya_hashmap_remove(map, keys[i], NULL));
+    }
+    tuya_hashmap_free(map);
+    CHECK(0 == sg_blocks);
+
+    printf("%s: %.1f ns per get, %d keys\n", TEST_NAME, ns / gets, TEST_BENCH_KEYS);
+}
+
+int main(int argc, char *argv[])
+{
+    sg_seed = (argc > 1) ? atoi(argv[1]) : 1;
+    srand(sg_seed);
+
+    __test_collision();
+    __test_reinsert();
+    __test_exhaust();
+    __test_random(200000);
+    __bench(4000000);
+
+    printf("%s: seed %u ok\n", TEST_NAME, sg_seed);
+    return 0;
+}
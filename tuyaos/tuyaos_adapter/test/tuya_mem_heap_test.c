@@ -0,0 +1,338 @@
+/**
+ * @file tuya_mem_heap_test.c
+ * @brief host test and benchmark of the tuya_mem_heap allocator
+ *
+ * usage: tuya_mem_heap_test [seed]
+ *
+ * built once with the size class cache and once without it
+ * (MEM_SIZE_CLASS_ENABLE=0), the benchmark at the end prints the cost of a
+ * small malloc/free pair on a fragmented heap for both.
+ */
+#include <time.h>
+#include "../include/utilities/src/tuya_mem_heap.c"
+
+#define CHECK(cond)     do {                                                        \
+                            if (!(cond)) {                                          \
+                                printf("%s:%d: %s failed, seed %u\n",               \
+                                       __FILE__, __LINE__, #cond, sg_seed);         \
+                                exit(1);                                            \
+                            }                                                       \
+                        } while (0)
+
+#define TEST_HEAP_SIZE      (64 * 1024)
+#define TEST_SLOT_NUM       (256)
+
+#if defined(MEM_SIZE_CLASS_ENABLE) && (MEM_SIZE_CLASS_ENABLE == 1)
+#define TEST_NAME           "tuya_mem_heap_test"
+#else
+#define TEST_NAME           "tuya_mem_heap_nocache_test"
+#endif
+
+typedef struct {
+    UINT8_T *ptr;
+    UINT32_T size;
+    UINT8_T fill;
+} TEST_SLOT_T;
+
+static UINT32_T sg_seed;
+static INT_T sg_int_depth;
+static unsigned long sg_heap_buf[TEST_HEAP_SIZE / sizeof(unsigned long)];
+static HEAP_HANDLE sg_heap;
+static unsigned long sg_heap_free;      // free size of the empty heap
+static unsigned long sg_heap_largest;   // largest block of the empty heap
+static TEST_SLOT_T sg_slot[TEST_SLOT_NUM];
+
+static void __enter_critical(void)
+{
+    sg_int_depth++;
+}
+
+static void __exit_critical(void)
+{
+    CHECK(--sg_int_depth >= 0);
+}
+
+static void __dbg_output(char *format, ...)
+{
+}
+
+static unsigned long __block_size(VOID_T *ptr)
+{
+    return ((MEM_HeapBlock_t *)((unsigned long)(intptr_t)ptr - MEM_BLOCK_HEAD_SIZE))->size;
+}
+
+/* the telemetry and the full walk of the heap must tell the same story */
+static VOID_T __check_state(VOID_T)
+{
+    heap_state_t state;
+    MEM_HeapStatus_t st;
+    unsigned long num = 0;
+    INT_T i;
+
+    tuya_mem_heap_state(sg_heap, &state);
+    MEM_HeapStatus((MEM_Heap_t *)sg_heap, &st);
+    CHECK(st.valid && (0 == sg_int_depth));
+    CHECK(0 == st.cache_block);
+    CHECK(state.free_block_num == st.free_block);
+    CHECK(state.max_free_block_size == st.free_largest);
+    CHECK(state.free_size == st.free + st.free_block * (MEM_BLOCK_HEAD_SIZE + 1));
+    CHECK(state.free_size == (unsigned long)tuya_mem_heap_available(sg_heap));
+    CHECK(state.free_watermark <= state.free_size);
+
+    for (i = 0; i < MEM_HEAP_HIST_NUM; i++) {
+        num += state.free_block_hist[i];
+    }
+    CHECK(num == state.free_block_num);
+}
+
+/* everything given back, the heap is one block again */
+static VOID_T __check_empty(VOID_T)
+{
+    heap_state_t state;
+
+    tuya_mem_heap_state(sg_heap, &state);
+    CHECK(sg_heap_free == state.free_size);
+    CHECK(1 == state.free_block_num);
+    CHECK(sg_heap_largest == state.max_free_block_size);
+    __check_state();
+}
+
+static VOID_T __test_init(VOID_T)
+{
+    heap_context_t ctx = { __enter_critical, __exit_critical, __dbg_output };
+    heap_state_t state;
+
+    CHECK(0 == tuya_mem_heap_init(&ctx));
+    CHECK(0 == tuya_mem_heap_create(sg_heap_buf, sizeof(sg_heap_buf), &sg_heap));
+
+    tuya_mem_heap_state(sg_heap, &state);
+    CHECK((TEST_HEAP_SIZE == state.total_size) && (1 == state.free_block_num));
+    CHECK(1 == state.free_block_hist[MEM_HEAP_HIST_NUM - 1]);
+    sg_heap_free = state.free_size;
+    sg_heap_largest = state.max_free_block_size;
+    CHECK(sg_heap_largest == sg_heap_free - MEM_BLOCK_HEAD_SIZE - 1);
+}
+
+/* a small block freed is handed out again, the blocks cached meanwhile still show as free */
+static VOID_T __test_cache(VOID_T)
+{
+    VOID_T *p, *q;
+    heap_state_t state;
+
+    p = tuya_mem_heap_malloc(sg_heap, 20);
+    CHECK(p);
+    tuya_mem_heap_free(sg_heap, p);
+#if defined(MEM_SIZE_CLASS_ENABLE) && (MEM_SIZE_CLASS_ENABLE == 1)
+    CHECK(((MEM_Heap_t *)sg_heap)->class_cnt[mem_class_index(__block_size(p))] > 0);
+#endif
+    q = tuya_mem_heap_malloc(sg_heap, 20);
+    CHECK(p == q);
+
+    // the cache holds the rest of the carved run, none of it is lost to the telemetry
+    tuya_mem_heap_state(sg_heap, &state);
+    CHECK(sg_heap_free - __block_size(q) == state.free_size);
+    CHECK(state.free_block_num <= 2);
+    __check_state();
+
+    tuya_mem_heap_free(sg_heap, q);
+    __check_empty();
+}
+
+/* the heap filled with small blocks and emptied, the cache must not keep a large request out */
+static VOID_T __test_full(VOID_T)
+{
+    heap_state_t state;
+    unsigned long fail_cnt;
+    INT_T i, num = 0;
+    VOID_T *p;
+
+    tuya_mem_heap_state(sg_heap, &state);
+    fail_cnt = state.fail_cnt;
+
+    while (NULL != (p = tuya_mem_heap_malloc(sg_heap, 100 + (num % 5) * 100))) {
+        CHECK(num < TEST_SLOT_NUM * 4);
+        // the slot table is too small, the blocks are chained through their payload
+        *(VOID_T **)p = (num > 0) ? sg_slot[0].ptr : NULL;
+        sg_slot[0].ptr = p;
+        num++;
+    }
+    tuya_mem_heap_state(sg_heap, &state);
+    CHECK(fail_cnt + 1 == state.fail_cnt);
+    CHECK(state.free_size < 600);
+    __check_state();
+
+    for (i = 0; i < num; i++) {
+        p = sg_slot[0].ptr;
+        sg_slot[0].ptr = *(VOID_T **)p;
+        tuya_mem_heap_free(sg_heap, p);
+    }
+    CHECK(NULL == sg_slot[0].ptr);
+
+    // no telemetry in between, the allocation itself has to flush the cache
+    p = tuya_mem_heap_malloc(sg_heap, sg_heap_largest - MEM_ALIGN_NUM);
+    CHECK(p);
+    tuya_mem_heap_free(sg_heap, p);
+    __check_empty();
+}
+
+/* debug allocations are booked per site, a site without a file name (wolfssl XMALLOC) included */
+static VOID_T __test_site(VOID_T)
+{
+    static CHAR_T file_a[] = "a.c";
+    heap_site_state_t site;
+    VOID_T *p, *q, *r;
+
+    p = tuya_mem_heap_debug_malloc(sg_heap, 100, NULL, 343);
+    q = tuya_mem_heap_debug_malloc(sg_heap, 100, NULL, 343);
+    r = tuya_mem_heap_debug_malloc(sg_heap, 50, file_a, 10);
+    CHECK(p && q && r);
+    tuya_mem_heap_free(sg_heap, q);
+
+    CHECK(0 == tuya_mem_heap_site_state(0, &site));
+    CHECK((NULL == site.filename) && (343 == site.line));
+    CHECK((100 == site.cur_size) && (200 == site.peak_size) && (2 == site.malloc_cnt));
+    CHECK(0 == tuya_mem_heap_site_state(1, &site));
+    CHECK((file_a == site.filename) && (10 == site.line) && (50 == site.cur_size));
+    CHECK(0 != tuya_mem_heap_site_state(2, &site));
+
+    // a site that gave everything back keeps its slot
+    tuya_mem_heap_free(sg_heap, p);
+    tuya_mem_heap_free(sg_heap, r);
+    CHECK(0 == tuya_mem_heap_site_state(0, &site));
+    CHECK((NULL == site.filename) && (0 == site.cur_size) && (2 == site.malloc_cnt));
+    CHECK(0 == tuya_mem_heap_site_state(1, &site));
+    CHECK((file_a == site.filename) && (0 == site.cur_size));
+    __check_empty();
+}
+
+static VOID_T __slot_free(TEST_SLOT_T *slot)
+{
+    UINT32_T i;
+
+    for (i = 0; i < slot->size; i++) {
+        CHECK(slot->ptr[i] == (UINT8_T)(slot->fill + i));
+    }
+    tuya_mem_heap_free(sg_heap, slot->ptr);
+    slot->ptr = NULL;
+}
+
+static UINT32_T __rand_size(VOID_T)
+{
+    // mostly what the class cache serves, some larger ones to fragment the free list
+    return (rand() % 8) ? (1 + rand() % 600) : (600 + rand() % 4000);
+}
+
+/* random malloc, realloc and free, payloads checked and the books balanced */
+static VOID_T __test_random(UINT32_T rounds)
+{
+    TEST_SLOT_T *slot;
+    unsigned long held = 0;
+    UINT32_T r, i, size;
+    UINT8_T *p;
+
+    for (r = 0; r < rounds; r++) {
+        slot = &sg_slot[rand() % TEST_SLOT_NUM];
+
+        if (slot->ptr && (rand() % 4)) {
+            held -= __block_size(slot->ptr);
+            __slot_free(slot);
+        } else if (slot->ptr) {
+            size = __rand_size();
+            held -= __block_size(slot->ptr);
+            p = tuya_mem_heap_realloc(sg_heap, slot->ptr, size);
+            if (NULL == p) {
+                held += __block_size(slot->ptr);
+                continue;
+            }
+            for (i = 0; i < size && i < slot->size; i++) {
+                CHECK(p[i] == (UINT8_T)(slot->fill + i));
+            }
+            for (; i < size; i++) {
+                p[i] = (UINT8_T)(slot->fill + i);
+            }
+            slot->ptr = p;
+            slot->size = size;
+            held += __block_size(p);
+        } else {
+            size = __rand_size();
+            slot->ptr = tuya_mem_heap_malloc(sg_heap, size);
+            if (NULL == slot->ptr) {
+                continue;
+            }
+            slot->size = size;
+            slot->fill = (UINT8_T)rand();
+            for (i = 0; i < size; i++) {
+                slot->ptr[i] = (UINT8_T)(slot->fill + i);
+            }
+            held += __block_size(slot->ptr);
+        }
+
+        CHECK(sg_heap_free == held + tuya_mem_heap_available(sg_heap));
+        if (0 == r % 97) {
+            __check_state();
+        }
+    }
+
+    for (i = 0; i < TEST_SLOT_NUM; i++) {
+        if (sg_slot[i].ptr) {
+            __slot_free(&sg_slot[i]);
+        }
+    }
+    __check_empty();
+}
+
+/* small pairs on a heap left fragmented by long lived blocks of mixed sizes */
+static VOID_T __bench(UINT32_T pairs)
+{
+    struct timespec t0, t1;
+    VOID_T *p[8];
+    UINT32_T r, i;
+    double ns;
+
+    for (i = 0; i < TEST_SLOT_NUM; i++) {
+        sg_slot[i].ptr = tuya_mem_heap_malloc(sg_heap, (i & 1) ? 40 + i : 300 + i * 7);
+        sg_slot[i].size = 0;
+    }
+    for (i = 0; i < TEST_SLOT_NUM; i += 3) {
+        tuya_mem_heap_free(sg_heap, sg_slot[i].ptr);
+        sg_slot[i].ptr = NULL;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (r = 0; r < pairs / 8; r++) {
+        for (i = 0; i < 8; i++) {
+            p[i] = tuya_mem_heap_malloc(sg_heap, 16 << (i % 5));
+        }
+        for (i = 0; i < 8; i++) {
+            tuya_mem_heap_free(sg_heap, p[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+
+    for (i = 0; i < TEST_SLOT_NUM; i++) {
+        if (sg_slot[i].ptr) {
+            tuya_mem_heap_free(sg_heap, sg_slot[i].ptr);
+            sg_slot[i].ptr = NULL;
+        }
+    }
+    __check_empty();
+
+    printf("%s: %.1f ns per malloc/free pair\n", TEST_NAME, ns / (pairs / 8 * 8));
+}
+
+int main(int argc, char *argv[])
+{
+    sg_seed = (argc > 1) ? atoi(argv[1]) : 1;
+    srand(sg_seed);
+
+    __test_init();
+    __test_cache();
+    __test_full();
+    __test_site();
+    __test_random(200000);
+    __bench(1000000);
+
+    printf("%s: seed %u ok\n", TEST_NAME, sg_seed);
+    return 0;
+}
@@ -0,0 +1,316 @@
+/**
+ * @file tuya_queue_test.c
+ * @brief host test and benchmark of tuya_queue, list and array store
+ *
+ * usage: tuya_queue_test [seed]
+ *
+ * random operations on both stores are checked against a plain array model.
+ * the queue never blocks: full and empty come back at once with
+ * OPRT_EXCEED_UPPER_LIMIT and OPRT_NOT_FOUND and the mutex released.
+ */
+#include <time.h>
+
+/* what tuya_iot_config.h of an rtos build sets, the queue takes a mutex */
+#define SYSTEM_NON_OS       3
+#define SYSTEM_FREERTOS     98
+#define OPERATING_SYSTEM    SYSTEM_FREERTOS
+
+#include "../include/utilities/src/tuya_queue.c"
+
+#define CHECK(cond)     do {                                                        \
+                            if (!(cond)) {                                          \
+                                printf("%s:%d: %s failed, seed %u\n",               \
+                                       __FILE__, __LINE__, #cond, sg_seed);         \
+                                exit(1);                                            \
+                            }                                                       \
+                        } while (0)
+
+#define TEST_QUEUE_LEN      (7)
+#define TEST_ITEM_SIZE      (13)
+
+static UINT32_T sg_seed;
+static INT_T sg_lock_depth;
+static INT_T sg_mutex_num;
+static UINT32_T sg_mallocs;
+static UINT32_T sg_last_malloc;
+static BOOL_T sg_malloc_fail;
+
+/* the model: items are numbers, an item is its number repeated over TEST_ITEM_SIZE bytes */
+static UINT32_T sg_model[TEST_QUEUE_LEN];
+static UINT32_T sg_model_num;
+static UINT32_T sg_next;
+
+VOID_T *tkl_system_malloc(SIZE_T size)
+{
+    if (sg_malloc_fail) {
+        return NULL;
+    }
+    sg_mallocs++;
+    sg_last_malloc = size;
+    return malloc(size);
+}
+
+VOID_T tkl_system_free(VOID_T *ptr)
+{
+    free(ptr);
+}
+
+OPERATE_RET tkl_mutex_create_init(TKL_MUTEX_HANDLE *handle)
+{
+    *handle = (TKL_MUTEX_HANDLE)&sg_lock_depth;
+    sg_mutex_num++;
+    return OPRT_OK;
+}
+
+OPERATE_RET tkl_mutex_lock(CONST TKL_MUTEX_HANDLE handle)
+{
+    CHECK(0 == sg_lock_depth++);
+    return OPRT_OK;
+}
+
+OPERATE_RET tkl_mutex_unlock(CONST TKL_MUTEX_HANDLE handle)
+{
+    CHECK(1 == sg_lock_depth--);
+    return OPRT_OK;
+}
+
+OPERATE_RET tkl_mutex_release(CONST TKL_MUTEX_HANDLE handle)
+{
+    CHECK(0 == sg_lock_depth);
+    sg_mutex_num--;
+    return OPRT_OK;
+}
+
+static VOID_T __item_make(UINT8_T *item, UINT32_T num)
+{
+    memset(item, (UINT8_T)num, TEST_ITEM_SIZE);
+    memcpy(item, &num, sizeof(num));
+}
+
+static UINT32_T __item_num(CONST UINT8_T *item)
+{
+    UINT32_T num, i;
+
+    memcpy(&num, item, sizeof(num));
+    for (i = sizeof(num); i < TEST_ITEM_SIZE; i++) {
+        CHECK(item[i] == (UINT8_T)num);
+    }
+
+    return num;
+}
+
+static BOOL_T __traverse_cb(VOID_T *item, VOID_T *ctx)
+{
+    UINT32_T *pos = ctx;
+
+    CHECK(*pos < sg_model_num);
+    CHECK(__item_num(item) == sg_model[*pos]);
+    (*pos)++;
+
+    return (*pos < 3);
+}
+
+/* used, free and every item in order */
+static VOID_T __check_model(TUYA_QUEUE_HANDLE queue)
+{
+    UINT8_T items[TEST_QUEUE_LEN * TEST_ITEM_SIZE];
+    UINT32_T i;
+
+    CHECK(sg_model_num == tuya_queue_get_used_num(queue));
+    CHECK(TEST_QUEUE_LEN - sg_model_num == tuya_queue_get_free_num(queue));
+    if (sg_model_num) {
+        CHECK(OPRT_OK == tuya_queue_get_batch(queue, 0, items, sg_model_num));
+        for (i = 0; i < sg_model_num; i++) {
+            CHECK(__item_num(&items[i * TEST_ITEM_SIZE]) == sg_model[i]);
+        }
+    }
+    CHECK(0 == sg_lock_depth);
+}
+
+/* the array slots wrap many times under back and front inserts, batch reads and deletes */
+static VOID_T __test_random(QUEUE_STORE_E store, UINT32_T rounds)
+{
+    TUYA_QUEUE_HANDLE queue;
+    UINT8_T item[TEST_ITEM_SIZE], items[TEST_QUEUE_LEN * TEST_ITEM_SIZE];
+    UINT32_T r, i, start, num, pos;
+    OPERATE_RET ret;
+
+    CHECK(OPRT_OK == tuya_queue_create_ex(TEST_QUEUE_LEN, TEST_ITEM_SIZE, store, &queue));
+    CHECK(TEST_QUEUE_LEN == tuya_queue_get_max_num(queue));
+    sg_model_num = 0;
+
+    for (r = 0; r < rounds; r++) {
+        switch (rand() % 8) {
+        case 0:
+        case 1:
+            __item_make(item, sg_next);
+            ret = tuya_queue_input(queue, item);
+            if (sg_model_num == TEST_QUEUE_LEN) {
+                CHECK(OPRT_EXCEED_UPPER_LIMIT == ret);
+                break;
+            }
+            CHECK(OPRT_OK == ret);
+            sg_model[sg_model_num++] = sg_next++;
+            break;
+
+        case 2:
+            __item_make(item, sg_next);
+            ret = tuya_queue_input_instant(queue, item);
+            if (sg_model_num == TEST_QUEUE_LEN) {
+                CHECK(OPRT_EXCEED_UPPER_LIMIT == ret);
+                break;
+            }
+            CHECK(OPRT_OK == ret);
+            memmove(&sg_model[1], &sg_model[0], sg_model_num * sizeof(sg_model[0]));
+            sg_model[0] = sg_next++;
+            sg_model_num++;
+            break;
+
+        case 3:
+            ret = tuya_queue_peek(queue, item);
+            CHECK((OPRT_OK == ret) == (sg_model_num > 0));
+            CHECK((OPRT_OK != ret) || (__item_num(item) == sg_model[0]));
+            break;
+
+        case 4:
+            ret = tuya_queue_output(queue, item);
+            if (0 == sg_model_num) {
+                CHECK(OPRT_NOT_FOUND == ret);
+                break;
+            }
+            CHECK(OPRT_OK == ret);
+            CHECK(__item_num(item) == sg_model[0]);
+            memmove(&sg_model[0], &sg_model[1], --sg_model_num * sizeof(sg_model[0]));
+            break;
+
+        case 5:
+            start = rand() % (TEST_QUEUE_LEN + 1);
+            num = 1 + rand() % TEST_QUEUE_LEN;
+            ret = tuya_queue_get_batch(queue, start, items, num);
+            CHECK((OPRT_OK == ret) == (start + num <= sg_model_num));
+            for (i = 0; (OPRT_OK == ret) && (i < num); i++) {
+                CHECK(__item_num(&items[i * TEST_ITEM_SIZE]) == sg_model[start + i]);
+            }
+            break;
+
+        case 6:
+            num = 1 + rand() % 3;
+            ret = tuya_queue_delete_batch(queue, num);
+            CHECK((OPRT_OK == ret) == (num <= sg_model_num));
+            num = (num < sg_model_num) ? num : sg_model_num;
+            memmove(&sg_model[0], &sg_model[num], (sg_model_num - num) * sizeof(sg_model[0]));
+            sg_model_num -= num;
+            break;
+
+        default:
+            if (0 == rand() % 16) {
+                CHECK(OPRT_OK == tuya_queue_clear(queue));
+                sg_model_num = 0;
+            } else {
+                pos = 0;
+                CHECK(OPRT_OK == tuya_queue_traverse(queue, __traverse_cb, &pos));
+                CHECK(pos == ((sg_model_num < 3) ? sg_model_num : 3));
+            }
+            break;
+        }
+
+        __check_model(queue);
+    }
+
+    CHECK(OPRT_OK == tuya_queue_release(queue));
+    CHECK(0 == sg_mutex_num);
+}
+
+/* full and empty return at once, what each store asks of the heap */
+static VOID_T __test_full_empty(QUEUE_STORE_E store)
+{
+    TUYA_QUEUE_HANDLE queue;
+    UINT8_T item[TEST_ITEM_SIZE];
+    UINT32_T i, mallocs;
+
+    sg_mallocs = 0;
+    CHECK(OPRT_OK == tuya_queue_create_ex(TEST_QUEUE_LEN, TEST_ITEM_SIZE, store, &queue));
+    CHECK(1 == sg_mallocs);
+    CHECK(sg_last_malloc == SIZEOF(TUYA_QUEUE_T) + ((QUEUE_STORE_ARRAY == store) ? TEST_QUEUE_LEN * TEST_ITEM_SIZE : 0));
+
+    CHECK(OPRT_NOT_FOUND == tuya_queue_output(queue, item));
+    CHECK(OPRT_NOT_FOUND == tuya_queue_output(queue, NULL));
+    CHECK(OPRT_NOT_FOUND == tuya_queue_peek(queue, item));
+    CHECK(OPRT_NOT_FOUND == tuya_queue_delete_batch(queue, 1));
+    CHECK(OPRT_NOT_FOUND == tuya_queue_get_batch(queue, 0, item, 1));
+    CHECK(0 == sg_lock_depth);
+
+    mallocs = sg_mallocs;
+    for (i = 0; i < TEST_QUEUE_LEN; i++) {
+        __item_make(item, i);
+        CHECK(OPRT_OK == tuya_queue_input(queue, item));
+    }
+    CHECK(sg_mallocs == mallocs + ((QUEUE_STORE_ARRAY == store) ? 0 : TEST_QUEUE_LEN));
+    CHECK(OPRT_EXCEED_UPPER_LIMIT == tuya_queue_input(queue, item));
+    CHECK(OPRT_EXCEED_UPPER_LIMIT == tuya_queue_input_instant(queue, item));
+    CHECK((0 == tuya_queue_get_free_num(queue)) && (0 == sg_lock_depth));
+
+    // no heap left: the list store can not take an item, the array store does not need any
+    CHECK(OPRT_OK == tuya_queue_output(queue, NULL));
+    sg_malloc_fail = TRUE;
+    CHECK(((QUEUE_STORE_ARRAY == store) ? OPRT_OK : OPRT_MALLOC_FAILED) == tuya_queue_input(queue, item));
+    sg_malloc_fail = FALSE;
+
+    CHECK(OPRT_OK == tuya_queue_release(queue));
+    CHECK(OPRT_INVALID_PARM == tuya_queue_create_ex(TEST_QUEUE_LEN, TEST_ITEM_SIZE, QUEUE_STORE_MAX, &queue));
+    CHECK(OPRT_INVALID_PARM == tuya_queue_create_ex(0x10000, 0x10000, QUEUE_STORE_ARRAY, &queue));
+}
+
+/* a queue kept half full, one item in and one out per round */
+static VOID_T __bench(QUEUE_STORE_E store, UINT32_T pairs)
+{
+    TUYA_QUEUE_HANDLE queue;
+    UINT8_T item[32] = {0};
+    struct timespec t0, t1;
+    UINT32_T i;
+    double ns;
+
+    CHECK(OPRT_OK == tuya_queue_create_ex(16, sizeof(item), store, &queue));
+    for (i = 0; i < 8; i++) {
+        CHECK(OPRT_OK == tuya_queue_input(queue, item));
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < pairs; i++) {
+        item[0] = (UINT8_T)i;
+        tuya_queue_input(queue, item);
+        tuya_queue_output(queue, item);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    CHECK(8 == tuya_queue_get_used_num(queue));
+    CHECK(OPRT_OK == tuya_queue_release(queue));
+
+    printf("tuya_queue_test: %s store %.1f ns per input/output pair\n",
+           (QUEUE_STORE_ARRAY == store) ? "array" : "list", ns / pairs);
+}
+
+int main(int argc, char *argv[])
+{
+    TUYA_QUEUE_HANDLE queue;
+    UINT32_T store;
+
+    sg_seed = (argc > 1) ? atoi(argv[1]) : 1;
+    srand(sg_seed);
+
+    // tuya_queue_create keeps the list store
+    CHECK(OPRT_OK == tuya_queue_create(TEST_QUEUE_LEN, TEST_ITEM_SIZE, &queue));
+    CHECK(QUEUE_STORE_LIST == ((TUYA_QUEUE_T *)queue)->store);
+    CHECK(OPRT_OK == tuya_queue_release(queue));
+
+    for (store = QUEUE_STORE_LIST; store < QUEUE_STORE_MAX; store++) {
+        __test_full_empty(store);
+        __test_random(store, 100000);
+    }
+    for (store = QUEUE_STORE_LIST; store < QUEUE_STORE_MAX; store++) {
+        __bench(store, 1000000);
+    }
+
+    printf("tuya_queue_test: seed %u ok\n", sg_seed);
+    return 0;
+}
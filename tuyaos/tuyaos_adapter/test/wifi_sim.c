@@ -0,0 +1,396 @@
+/**
+ * @file wifi_sim.c
+ * @brief fake bk7231n wifi core for the host tests of the tkl_wifi scan path
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tuya_error_code.h"
+#include "tkl_memory.h"
+#include "tkl_output.h"
+#include "tkl_semaphore.h"
+#include "tkl_system.h"
+#include "rw_pub.h"
+#include "wlan_ui_pub.h"
+#include "wifi_sim.h"
+
+#define WIFI_SIM_BSS_MAX        32
+#define WIFI_SIM_SEM_MAX        4
+#define WIFI_SIM_CHAN_ALL       13
+
+typedef struct {
+    CHAR_T ssid[32];            // no NUL at 32 bytes, as in the core
+    UCHAR_T channel;
+    SCHAR_T rssi;
+} WIFI_SIM_BSS_S;
+
+typedef struct {
+    BOOL_T alive;
+    UINT_T cnt;
+    UINT_T max;
+} WIFI_SIM_SEM_S;
+
+enum {
+    WIFI_SIM_END_NORMAL,
+    WIFI_SIM_END_LOSE,
+    WIFI_SIM_END_HOLD,
+};
+
+static WIFI_SIM_BSS_S sg_bss[WIFI_SIM_BSS_MAX];
+static UINT_T sg_bss_num;
+static WIFI_SIM_SEM_S sg_sem[WIFI_SIM_SEM_MAX];
+static SYS_TIME_T sg_now;
+
+static SCANU_BSS_CB sg_bss_cb;
+static VOID_T *sg_bss_ctxt;
+static FUNC_2PARAM_PTR sg_end_cb;
+static VOID_T *sg_end_ctxt;
+
+static BOOL_T sg_busy;
+static BOOL_T sg_pending;
+static BOOL_T sg_cancel;
+static BOOL_T sg_held;
+static INT_T sg_end_mode;
+static UCHAR_T sg_chans[WIFI_SIM_CHAN_ALL + 1];
+static UCHAR_T sg_chan_num;
+static CHAR_T sg_probe[33];
+static UINT_T sg_mask;
+static UINT_T sg_cancels;
+
+unsigned char cpu_lp_flag;
+char wlan_fast_connect_buffer[sizeof(struct wlan_fast_connect_info)];
+
+VOID_T wifi_sim_init(VOID_T)
+{
+    memset(sg_bss, 0, sizeof(sg_bss));
+    sg_bss_num = 0;
+    sg_now = 0;
+    sg_busy = FALSE;
+    sg_pending = FALSE;
+    sg_held = FALSE;
+    sg_end_mode = WIFI_SIM_END_NORMAL;
+    sg_mask = 0;
+    sg_cancels = 0;
+    sg_probe[0] = '\0';
+}
+
+UINT_T wifi_sim_add_bss(CONST CHAR_T *ssid, UCHAR_T channel, SCHAR_T rssi)
+{
+    WIFI_SIM_BSS_S *bss = &sg_bss[sg_bss_num];
+
+    strncpy(bss->ssid, ssid, sizeof(bss->ssid));
+    bss->channel = channel;
+    bss->rssi = rssi;
+
+    return sg_bss_num++;
+}
+
+BOOL_T wifi_sim_run(VOID_T)
+{
+    SCAN_RST_ITEM_T item;
+    UINT_T i, j;
+
+    if (!sg_pending) {
+        return FALSE;
+    }
+    sg_pending = FALSE;
+    sg_cancel = FALSE;
+    sg_mask = 0;
+
+    // a cancel lets the channel in progress finish
+    for (i = 0; (i < sg_chan_num) && !sg_cancel; i++) {
+        sg_mask |= 1u << sg_chans[i];
+        sg_now += WIFI_SIM_DWELL_MS;
+        for (j = 0; j < sg_bss_num; j++) {
+            if ((sg_bss[j].channel != sg_chans[i]) || (NULL == sg_bss_cb)) {
+                continue;
+            }
+            memset(&item, 0, sizeof(item));
+            memcpy(item.ssid, sg_bss[j].ssid, sizeof(item.ssid));
+            item.bssid[0] = 0x02;
+            item.bssid[5] = j;
+            item.channel = sg_bss[j].channel;
+            item.level = sg_bss[j].rssi;
+            item.security = j % 4;
+            sg_bss_cb(sg_bss_ctxt, &item);
+        }
+    }
+
+    if (WIFI_SIM_END_HOLD == sg_end_mode) {
+        sg_held = TRUE;
+    } else if ((WIFI_SIM_END_NORMAL == sg_end_mode) && sg_end_cb) {
+        sg_end_cb(sg_end_ctxt, 0);
+    }
+    sg_end_mode = WIFI_SIM_END_NORMAL;
+
+    return TRUE;
+}
+
+VOID_T wifi_sim_busy(BOOL_T busy)
+{
+    sg_busy = busy;
+}
+
+VOID_T wifi_sim_lose_end(VOID_T)
+{
+    sg_end_mode = WIFI_SIM_END_LOSE;
+}
+
+VOID_T wifi_sim_hold_end(VOID_T)
+{
+    sg_end_mode = WIFI_SIM_END_HOLD;
+}
+
+VOID_T wifi_sim_end(VOID_T)
+{
+    if (sg_held && sg_end_cb) {
+        sg_end_cb(sg_end_ctxt, 0);
+    }
+    sg_held = FALSE;
+}
+
+UINT_T wifi_sim_chan_mask(VOID_T)
+{
+    return sg_mask;
+}
+
+CONST CHAR_T *wifi_sim_probe_ssid(VOID_T)
+{
+    return sg_probe;
+}
+
+UINT_T wifi_sim_cancels(VOID_T)
+{
+    return sg_cancels;
+}
+
+UINT_T wifi_sim_sems(VOID_T)
+{
+    UINT_T i, n = 0;
+
+    for (i = 0; i < WIFI_SIM_SEM_MAX; i++) {
+        n += sg_sem[i].alive;
+    }
+
+    return n;
+}
+
+/* the core */
+void mhdr_scanu_reg_cb(FUNC_2PARAM_PTR ind_cb, void *ctxt)
+{
+    sg_end_cb = ind_cb;
+    sg_end_ctxt = ctxt;
+}
+
+void mhdr_scanu_reg_bss_cb(SCANU_BSS_CB ind_cb, void *ctxt)
+{
+    sg_bss_cb = ind_cb;
+    sg_bss_ctxt = ctxt;
+}
+
+int bk_wlan_start_chan_scan(UINT8 **ssid_ary, UINT8 ssid_num, UINT8 *chans, UINT8 chan_num)
+{
+    UINT_T i;
+
+    if (sg_busy || sg_pending) {
+        return -1;
+    }
+
+    if (0 == chan_num) {
+        for (i = 0; i < WIFI_SIM_CHAN_ALL; i++) {
+            sg_chans[i] = i + 1;
+        }
+        chan_num = WIFI_SIM_CHAN_ALL;
+    } else {
+        memcpy(sg_chans, chans, chan_num);
+    }
+    sg_chan_num = chan_num;
+
+    memset(sg_probe, 0, sizeof(sg_probe));
+    if (ssid_num) {
+        strncpy(sg_probe, (CHAR_T *)ssid_ary[0], sizeof(sg_probe) - 1);
+    }
+    sg_pending = TRUE;
+
+    return 0;
+}
+
+int bk_wlan_start_scan(void)
+{
+    return bk_wlan_start_chan_scan(NULL, 0, NULL, 0);
+}
+
+int rw_msg_send_scan_cancel_req(void *cfm)
+{
+    sg_cancel = TRUE;
+    sg_cancels++;
+
+    return 0;
+}
+
+/* the result set of the last scan, what bk_wlan_start_scan() leaves for the caller */
+int wlan_sta_scan_result(ScanResult_adv *results)
+{
+    struct ApListStruct *ap;
+    UINT_T i;
+
+    results->ApNum = 0;
+    results->ApList = malloc(sizeof(*results->ApList) * WIFI_SIM_BSS_MAX);
+    for (i = 0; i < sg_bss_num; i++) {
+        if (!(sg_mask & (1u << sg_bss[i].channel))) {
+            continue;
+        }
+        ap = &results->ApList[(UCHAR_T)results->ApNum++];
+        memset(ap, 0, sizeof(*ap));
+        memcpy(ap->ssid, sg_bss[i].ssid, sizeof(sg_bss[i].ssid));
+        ap->ApPower = sg_bss[i].rssi;
+        ap->channel = sg_bss[i].channel;
+        ap->bssid[5] = i;
+    }
+
+    return 0;
+}
+
+/* one thread, the semaphore wait is where the core gets to run */
+OPERATE_RET tkl_semaphore_create_init(TKL_SEM_HANDLE *handle, UINT_T sem_cnt, UINT_T sem_max)
+{
+    UINT_T i;
+
+    for (i = 0; i < WIFI_SIM_SEM_MAX; i++) {
+        if (!sg_sem[i].alive) {
+            sg_sem[i].alive = TRUE;
+            sg_sem[i].cnt = sem_cnt;
+            sg_sem[i].max = sem_max;
+            *handle = &sg_sem[i];
+            return OPRT_OK;
+        }
+    }
+
+    return OPRT_COM_ERROR;
+}
+
+static WIFI_SIM_SEM_S *__sim_sem(CONST TKL_SEM_HANDLE handle)
+{
+    WIFI_SIM_SEM_S *sem = (WIFI_SIM_SEM_S *)handle;
+
+    if ((NULL == sem) || !sem->alive) {
+        printf("wifi_sim: semaphore %p used after release\n", handle);
+        fflush(stdout);
+        abort();
+    }
+
+    return sem;
+}
+
+OPERATE_RET tkl_semaphore_wait(CONST TKL_SEM_HANDLE handle, UINT_T timeout)
+{
+    WIFI_SIM_SEM_S *sem = __sim_sem(handle);
+
+    wifi_sim_run();
+    if (0 == sem->cnt) {
+        sg_now += timeout;
+        return OPRT_COM_ERROR;
+    }
+    sem->cnt--;
+
+    return OPRT_OK;
+}
+
+OPERATE_RET tkl_semaphore_post(CONST TKL_SEM_HANDLE handle)
+{
+    WIFI_SIM_SEM_S *sem = __sim_sem(handle);
+
+    if (sem->cnt < sem->max) {
+        sem->cnt++;
+    }
+
+    return OPRT_OK;
+}
+
+OPERATE_RET tkl_semaphore_release(CONST TKL_SEM_HANDLE handle)
+{
+    __sim_sem(handle)->alive = FALSE;
+    return OPRT_OK;
+}
+
+SYS_TIME_T tkl_system_get_millisecond(VOID_T)
+{
+    return sg_now;
+}
+
+VOID_T tkl_system_sleep(UINT_T num_ms)
+{
+    sg_now += num_ms;
+}
+
+OSStatus rtos_delay_milliseconds(uint32_t num_ms)
+{
+    sg_now += num_ms;
+    return 0;
+}
+
+VOID_T *tkl_system_malloc(SIZE_T size)
+{
+    return malloc(size);
+}
+
+VOID_T tkl_system_free(VOID_T *ptr)
+{
+    free(ptr);
+}
+
+UINT_T tkl_system_enter_critical(VOID_T)
+{
+    return 0;
+}
+
+VOID_T tkl_system_exit_critical(UINT_T irq_mask)
+{
+}
+
+VOID_T tkl_log_output(CONST CHAR_T *format, ...)
+{
+}
+
+VOID_T tkl_log_output_args(UINT8_T module, UINT8_T level, CONST CHAR_T *format, UINT8_T argc, ...)
+{
+}
+
+void bk_printf(const char *fmt, ...)
+{
+}
+
+/* the parts of the core the scan path does not reach */
+void extended_app_waiting_for_launch(void) {}
+int manual_cal_rfcali_status(void) { return 0; }
+uint8_t nxmac_current_state_getf(void) { return HW_IDLE; }
+void mhdr_set_station_status_cb(STATION_STATUS_CB cb) {}
+int rw_msg_send_mm_active_req() { return 0; }
+OSStatus bk_wlan_start(network_InitTypeDef_st *inNetworkInitPara) { return 0; }
+OSStatus bk_wlan_start_sta_fast(struct wlan_fast_connect_info *fci) { return 0; }
+OSStatus bk_wlan_start_ap_adv(network_InitTypeDef_ap_st *inNetworkInitParaAP) { return 0; }
+int bk_wlan_stop(char mode) { return 0; }
+OSStatus bk_wlan_get_ip_status(IPStatusTypedef *outNetpara, WiFi_Interface inInterface) { return 0; }
+OSStatus bk_wlan_get_link_status(LinkStatusTypeDef *outStatus) { return 0; }
+OSStatus bk_wlan_set_country(const wifi_country_t *country) { return 0; }
+int bk_wlan_start_monitor(void) { return 0; }
+int bk_wlan_stop_monitor(void) { return 0; }
+void bk_wlan_register_monitor_cb(monitor_data_cb_t fn) {}
+int bk_wlan_set_channel(int channel) { return 0; }
+int bk_wlan_get_channel(void) { return 1; }
+void bk_wlan_set_ap_monitor_coexist(int val) {}
+int bk_wlan_send_80211_raw_frame(uint8_t *buffer, int len) { return len; }
+int bk_wlan_send_80211_beacon_frame(uint8_t channel, uint8_t *ssid, uint8_t ssid_len) { return 0; }
+uint32_t bk_wlan_reg_rx_mgmt_cb(mgmt_rx_cb_t cb, uint32_t rx_mgmt_flag) { return 0; }
+uint32_t bk_wlan_start_ez_of_sta(void) { return 0; }
+uint32_t bk_wlan_stop_ez_of_sta(void) { return 0; }
+void bk_wlan_phy_open_cca(void) {}
+void bk_wlan_phy_close_cca(void) {}
+int bk_wlan_mcu_ps_mode_enable(void) { return 0; }
+int bk_wlan_dtim_rf_ps_mode_enable(void) { return 0; }
+int bk_wlan_dtim_rf_ps_mode_disable(void) { return 0; }
+int bk_wlan_dtim_rf_ps_timer_start(void) { return 0; }
+int bk_wlan_dtim_rf_ps_timer_pause(void) { return 0; }
+int wlan_ap_sta_info(wlan_ap_stas_t *stas) { return -1; }
+int wifi_set_mac_address(char *mac) { return 0; }
+void wifi_get_mac_address(char *mac, u8 type) { memset(mac, 0, 6); }
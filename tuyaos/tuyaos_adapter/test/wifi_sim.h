@@ -0,0 +1,48 @@
+/**
+ * @file wifi_sim.h
+ * @brief fake bk7231n wifi core for the host tests of the tkl_wifi scan path
+ *
+ * the air holds a list of bss. a scan the adapter starts is delivered by
+ * wifi_sim_run(), or by tkl_semaphore_wait() when the adapter blocks on it:
+ * every bss on each scanned channel goes to the registered bss callback, a
+ * cancel request stops the sweep after the current channel, then the end of
+ * scan callback runs unless the test asked to lose or hold it. the clock
+ * moves by the dwell time of each channel and by every wait that times out.
+ * the rest of the core and the os calls tkl_wifi.c needs are stubbed for a
+ * single thread.
+ */
+#ifndef __WIFI_SIM_H__
+#define __WIFI_SIM_H__
+
+#include "tuya_cloud_types.h"
+
+#define WIFI_SIM_DWELL_MS       100
+
+/* no bss in the air, the core idle, the clock at 0 */
+VOID_T wifi_sim_init(VOID_T);
+
+/* a bss in the air, ssid up to 32 bytes, returns its index, which is also the last byte of its bssid */
+UINT_T wifi_sim_add_bss(CONST CHAR_T *ssid, UCHAR_T channel, SCHAR_T rssi);
+
+/* deliver the scan the adapter started, FALSE if there was none */
+BOOL_T wifi_sim_run(VOID_T);
+
+/* the core refuses to start a scan */
+VOID_T wifi_sim_busy(BOOL_T busy);
+
+/* the next scan ends without its end of scan callback */
+VOID_T wifi_sim_lose_end(VOID_T);
+
+/* the next scan keeps its end of scan callback until wifi_sim_end() */
+VOID_T wifi_sim_hold_end(VOID_T);
+VOID_T wifi_sim_end(VOID_T);
+
+/* what the last scan was asked for and what it did */
+UINT_T wifi_sim_chan_mask(VOID_T);          // bit n for channel n scanned
+CONST CHAR_T *wifi_sim_probe_ssid(VOID_T);  // "" for a wildcard scan
+UINT_T wifi_sim_cancels(VOID_T);            // cancel requests since init
+
+/* semaphores created and not released */
+UINT_T wifi_sim_sems(VOID_T);
+
+#endif